@@ -1,12 +1,66 @@
 #include "cris/core/sched/job_runner.h"
+#include "cris/core/sched/parallel.h"
+#include "cris/core/sched/spin_impl.h"
+#include "cris/core/utils/time.h"
 
 #include <benchmark/benchmark.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <thread>
 #include <vector>
 
+// Count heap allocations per thread, so that the allocations on the producer side can be reported.
+static thread_local std::size_t kCurrentThreadAllocations = 0;
+
+void* operator new(std::size_t size) {
+    ++kCurrentThreadAllocations;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) [[likely]] {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC does not see that `operator new` above is replaced as well.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
 namespace cris::core {
 
+static void WaitUntil(const std::atomic<bool>& flag) {
+    while (!flag.load()) {
+        std::this_thread::yield();
+    }
+}
+
+static void ReportAllocationsPerJob(benchmark::State& state, std::size_t allocations_before) {
+    state.counters["allocs_per_job"] = benchmark::Counter(
+        static_cast<double>(kCurrentThreadAllocations - allocations_before),
+        benchmark::Counter::kAvgIterations);
+}
+
 static void BM_AddJob(benchmark::State& state) {
     auto job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
     for ([[maybe_unused]] const auto s : state) {
@@ -31,15 +85,121 @@ static void BM_AddJobBatch(benchmark::State& state) {
     job_runner->Stop().Join();
 }
 
+// Jobs capturing up to 64 bytes are expected to be added without any allocation.
+template<std::size_t kCaptureSize>
+static void BM_AddJobAllocations(benchmark::State& state) {
+    auto                           job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+    std::array<char, kCaptureSize> payload{};
+    const auto                     allocations_before = kCurrentThreadAllocations;
+    for ([[maybe_unused]] const auto s : state) {
+        job_runner->AddJob([payload]() { benchmark::DoNotOptimize(payload); });
+    }
+    ReportAllocationsPerJob(state, allocations_before);
+    job_runner->Stop().Join();
+}
+
 static void BM_AddJobWithStrand(benchmark::State& state) {
-    auto job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
-    auto strand     = job_runner->MakeStrand();
+    auto       job_runner         = JobRunner::MakeJobRunner({.thread_num_ = 2});
+    auto       strand             = job_runner->MakeStrand();
+    const auto allocations_before = kCurrentThreadAllocations;
     for ([[maybe_unused]] const auto s : state) {
         job_runner->AddJob([]() {}, strand);
     }
+    ReportAllocationsPerJob(state, allocations_before);
     job_runner->Stop().Join();
 }
 
+// Jobs of one strand running back-to-back, the cost of serializing them is all that is measured.
+static void BM_StrandThroughput(benchmark::State& state) {
+    const std::size_t job_num    = static_cast<std::size_t>(state.range(0));
+    const std::size_t max_batch  = static_cast<std::size_t>(state.range(1));
+    auto              job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+    auto              strand     = job_runner->MakeStrand({.max_batch_ = max_batch});
+
+    for ([[maybe_unused]] const auto s : state) {
+        std::size_t       counter = 0;
+        std::atomic<bool> done{false};
+        for (std::size_t i = 0; i < job_num; ++i) {
+            // Not atomic on purpose, jobs in the same strand never run concurrently.
+            job_runner->AddJob(
+                [&counter, &done, job_num]() {
+                    if (++counter == job_num) {
+                        done.store(true);
+                    }
+                },
+                strand);
+        }
+        WaitUntil(done);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * job_num));
+    job_runner->Stop().Join();
+}
+
+// From adding a job to an idle strand to the job starting.
+static void BM_StrandLatency(benchmark::State& state) {
+    auto job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2, .always_active_thread_num_ = 2});
+    auto strand     = job_runner->MakeStrand();
+
+    for ([[maybe_unused]] const auto s : state) {
+        std::atomic<bool> done{false};
+        job_runner->AddJob([&done]() { done.store(true); }, strand);
+        WaitUntil(done);
+    }
+    job_runner->Stop().Join();
+}
+
+// From adding a probe job to the job starting, while the workers are flooded by low priority jobs.
+static void BM_PriorityLatencyUnderFlood(benchmark::State& state) {
+    constexpr std::size_t kFloodBacklog  = 256;
+    const auto            probe_priority = static_cast<JobRunner::Priority>(state.range(0));
+    auto                  job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2, .always_active_thread_num_ = 2});
+
+    std::atomic<bool>        flooding{true};
+    std::atomic<std::size_t> backlog{0};
+
+    std::thread flooder([&job_runner, &flooding, &backlog]() {
+        while (flooding.load()) {
+            if (backlog.load() >= kFloodBacklog) {
+                std::this_thread::yield();
+                continue;
+            }
+            backlog.fetch_add(1);
+            job_runner->AddJob(
+                [&backlog]() {
+                    impl::SpinForApprox1us();
+                    backlog.fetch_sub(1);
+                },
+                JobRunner::Priority::kLow);
+        }
+    });
+
+    std::vector<cr_timestamp_nsec_t> latencies;
+    for ([[maybe_unused]] const auto s : state) {
+        std::atomic<cr_timestamp_nsec_t> started_at{0};
+        const auto                       added_at = GetSystemTimestampNsec();
+        job_runner->AddJob([&started_at]() { started_at.store(GetSystemTimestampNsec()); }, probe_priority);
+        while (started_at.load() == 0) {
+            std::this_thread::yield();
+        }
+        latencies.push_back(started_at.load() - added_at);
+    }
+
+    flooding.store(false);
+    flooder.join();
+    job_runner->Stop().Join();
+
+    if (latencies.empty()) {
+        return;
+    }
+    const auto percentile_us = [&latencies](double percentile) {
+        const auto idx = static_cast<std::size_t>(percentile * static_cast<double>(latencies.size() - 1));
+        std::nth_element(latencies.begin(), latencies.begin() + static_cast<long>(idx), latencies.end());
+        return static_cast<double>(latencies[idx]) / 1000.;
+    };
+    state.counters["p50_us"] = percentile_us(0.5);
+    state.counters["p99_us"] = percentile_us(0.99);
+}
+
 static void BM_AddJobTryImmediately(benchmark::State& state) {
     auto job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
     auto strand     = job_runner->MakeStrand();
@@ -49,9 +209,259 @@ static void BM_AddJobTryImmediately(benchmark::State& state) {
     job_runner->Stop().Join();
 }
 
+// One root job spawns a batch of small jobs and the last finished one signals completion.
+static void BM_FanOutFanIn(benchmark::State& state) {
+    const auto        queue_type = static_cast<JobRunner::QueueType>(state.range(0));
+    const std::size_t fan_out    = static_cast<std::size_t>(state.range(1));
+    auto              job_runner = JobRunner::MakeJobRunner({.thread_num_ = 4, .queue_type_ = queue_type});
+
+    for ([[maybe_unused]] const auto s : state) {
+        std::atomic<std::size_t> remaining{fan_out};
+        std::atomic<bool>        done{false};
+        job_runner->AddJob([&job_runner, &remaining, &done, fan_out]() {
+            for (std::size_t i = 0; i < fan_out; ++i) {
+                job_runner->AddJob([&remaining, &done]() {
+                    if (remaining.fetch_sub(1) == 1) {
+                        done.store(true);
+                    }
+                });
+            }
+        });
+        WaitUntil(done);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * fan_out));
+    job_runner->Stop().Join();
+}
+
+static void SpawnRecursively(
+    const std::shared_ptr<JobRunner>& job_runner,
+    std::size_t                       depth,
+    std::atomic<std::size_t>&         remaining_leaves,
+    std::atomic<bool>&                done) {
+    if (depth == 0) {
+        if (remaining_leaves.fetch_sub(1) == 1) {
+            done.store(true);
+        }
+        return;
+    }
+    for (std::size_t i = 0; i < 2; ++i) {
+        job_runner->AddJob([&job_runner, depth, &remaining_leaves, &done]() {
+            SpawnRecursively(job_runner, depth - 1, remaining_leaves, done);
+        });
+    }
+}
+
+// Binary-tree shaped spawning, every job spawns 2 jobs until reaching the leaves.
+static void BM_RecursiveSpawn(benchmark::State& state) {
+    const auto        queue_type = static_cast<JobRunner::QueueType>(state.range(0));
+    const std::size_t depth      = static_cast<std::size_t>(state.range(1));
+    const std::size_t leaves     = std::size_t{1} << depth;
+    auto              job_runner = JobRunner::MakeJobRunner({.thread_num_ = 4, .queue_type_ = queue_type});
+
+    for ([[maybe_unused]] const auto s : state) {
+        std::atomic<std::size_t> remaining_leaves{leaves};
+        std::atomic<bool>        done{false};
+        job_runner->AddJob([&job_runner, depth, &remaining_leaves, &done]() {
+            SpawnRecursively(job_runner, depth, remaining_leaves, done);
+        });
+        WaitUntil(done);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * (2 * leaves - 1)));
+    job_runner->Stop().Join();
+}
+
+// All the jobs are added to one worker, and the others have to steal them.
+static void BM_StealScaling(benchmark::State& state) {
+    constexpr std::size_t   kJobNum    = 4096;
+    const std::size_t       thread_num = static_cast<std::size_t>(state.range(0));
+    const JobRunner::Config config{.thread_num_ = thread_num, .always_active_thread_num_ = thread_num};
+    auto                    job_runner = JobRunner::MakeJobRunner(config);
+
+    for ([[maybe_unused]] const auto s : state) {
+        std::atomic<std::size_t> remaining{kJobNum};
+        std::atomic<bool>        done{false};
+        for (std::size_t i = 0; i < kJobNum; ++i) {
+            job_runner->AddJob(
+                [&remaining, &done]() {
+                    impl::SpinForApprox1us();
+                    if (remaining.fetch_sub(1) == 1) {
+                        done.store(true);
+                    }
+                },
+                std::size_t{0});
+        }
+        WaitUntil(done);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kJobNum));
+    job_runner->Stop().Join();
+}
+
+// The cost on the producer side while workers are spinning, no syscall is expected for waking them up.
+static void BM_AddJobSpinningWorkers(benchmark::State& state) {
+    const JobRunner::Config config{.thread_num_ = 2, .always_active_thread_num_ = 2};
+    auto                    job_runner = JobRunner::MakeJobRunner(config);
+    for ([[maybe_unused]] const auto s : state) {
+        job_runner->AddJob([]() {});
+    }
+    job_runner->Stop().Join();
+}
+
+// From adding a job to it starting running on a parked worker.
+static void BM_WakeToRunLatency(benchmark::State& state) {
+    auto job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+
+    for ([[maybe_unused]] const auto s : state) {
+        // Wait for the workers to go through spinning and park.
+        state.PauseTiming();
+        while (job_runner->ActiveThreadNum() > 0) {
+            std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        state.ResumeTiming();
+
+        std::atomic<cr_timestamp_nsec_t> started_at{0};
+        const auto                       added_at = GetSystemTimestampNsec();
+        job_runner->AddJob([&started_at]() { started_at.store(GetSystemTimestampNsec()); });
+        while (started_at.load() == 0) {
+            std::this_thread::yield();
+        }
+        state.SetIterationTime(static_cast<double>(started_at.load() - added_at) / 1e9);
+    }
+    job_runner->Stop().Join();
+}
+
+// The cost on the worker side of running queued jobs, with the always-on counters, and optionally with the per-job
+// timing reported to timer sections. Timed from the worker starting on the queued jobs to finishing them.
+static void BM_RunJobs(benchmark::State& state) {
+    constexpr std::size_t   kJobNum = 1000;
+    const JobRunner::Config config{.thread_num_ = 1, .job_timing_ = state.range(0) != 0};
+    auto                    job_runner = JobRunner::MakeJobRunner(config);
+
+    for ([[maybe_unused]] const auto s : state) {
+        std::atomic<bool>   released{false};
+        std::atomic<bool>   done{false};
+        cr_timestamp_nsec_t start_timestamp = 0;
+        cr_timestamp_nsec_t end_timestamp   = 0;
+        job_runner->AddJob([&released, &start_timestamp]() {
+            WaitUntil(released);
+            start_timestamp = GetSystemTimestampNsec();
+        });
+        // Not atomic on purpose, there is only one worker.
+        std::size_t counter = 0;
+        for (std::size_t i = 0; i < kJobNum; ++i) {
+            job_runner->AddJob([&counter, &done, &end_timestamp]() {
+                if (++counter == kJobNum) {
+                    end_timestamp = GetSystemTimestampNsec();
+                    done.store(true);
+                }
+            });
+        }
+        released.store(true);
+        WaitUntil(done);
+        state.SetIterationTime(static_cast<double>(end_timestamp - start_timestamp) / 1e9);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kJobNum));
+    job_runner->Stop().Join();
+}
+
+static void BM_GetStats(benchmark::State& state) {
+    auto job_runner = JobRunner::MakeJobRunner({.thread_num_ = static_cast<std::size_t>(state.range(0))});
+    for ([[maybe_unused]] const auto s : state) {
+        benchmark::DoNotOptimize(job_runner->GetStats());
+    }
+    job_runner->Stop().Join();
+}
+
+static void BM_AddJobAfter(benchmark::State& state) {
+    static constexpr auto kFarDelay = std::chrono::hours(1);
+    static constexpr auto kDelay    = std::chrono::milliseconds(1);
+
+    auto job_runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+    // Timers pending far in the future, which adding more should not be slowed down by.
+    for (long i = 0; i < state.range(0); ++i) {
+        job_runner->AddJobAfter([]() {}, kFarDelay);
+    }
+    for ([[maybe_unused]] const auto s : state) {
+        job_runner->AddJobAfter([]() {}, kDelay);
+    }
+    state.SetItemsProcessed(state.iterations());
+    job_runner->Stop().Join();
+}
+
+// Fork-join sorting, where the calling thread helps the workers. Zero threads is `std::sort` alone, as the baseline.
+static void BM_ParallelSort(benchmark::State& state) {
+    constexpr std::size_t   kElementNum = 1 << 20;
+    const std::size_t       thread_num  = static_cast<std::size_t>(state.range(0));
+    const JobRunner::Config config{.thread_num_ = std::max<std::size_t>(thread_num, 1)};
+    auto                    job_runner = JobRunner::MakeJobRunner(config);
+
+    std::minstd_rand           random_engine(42);
+    std::vector<std::uint32_t> values(kElementNum);
+    for (auto& value : values) {
+        value = static_cast<std::uint32_t>(random_engine());
+    }
+    std::vector<std::uint32_t> sorting(kElementNum);
+    for ([[maybe_unused]] const auto s : state) {
+        state.PauseTiming();
+        sorting = values;
+        state.ResumeTiming();
+        if (thread_num == 0) {
+            std::sort(sorting.begin(), sorting.end());
+        } else {
+            ParallelSort(job_runner, sorting.begin(), sorting.end());
+        }
+        benchmark::DoNotOptimize(sorting.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kElementNum));
+    job_runner->Stop().Join();
+}
+
+// From 1 worker to one per core, doubling.
+static void AllCoresThreadNums(benchmark::internal::Benchmark* benchmark) {
+    const auto core_num = static_cast<long>(std::max(1U, std::thread::hardware_concurrency()));
+    for (long thread_num = 1; thread_num < core_num; thread_num *= 2) {
+        benchmark->Arg(thread_num);
+    }
+    benchmark->Arg(core_num);
+}
+
 BENCHMARK(BM_AddJob)->ThreadRange(1, 4);
 BENCHMARK(BM_AddJobBatch)->ThreadRange(1, 4)->Arg(50)->Arg(100)->Arg(1000)->Arg(2000);
+BENCHMARK_TEMPLATE(BM_AddJobAllocations, 8)->ThreadRange(1, 4);
+BENCHMARK_TEMPLATE(BM_AddJobAllocations, 48)->ThreadRange(1, 4);
+BENCHMARK_TEMPLATE(BM_AddJobAllocations, 128)->ThreadRange(1, 4);
 BENCHMARK(BM_AddJobWithStrand)->ThreadRange(1, 4);
+BENCHMARK(BM_StrandThroughput)
+    ->ArgNames({"jobs", "max_batch"})
+    ->ArgsProduct({{1000}, {1, 16, 256}})
+    ->UseRealTime();
+BENCHMARK(BM_StrandLatency)->UseRealTime();
+BENCHMARK(BM_PriorityLatencyUnderFlood)
+    ->ArgNames({"probe_priority"})
+    ->Arg(static_cast<long>(JobRunner::Priority::kHigh))
+    ->Arg(static_cast<long>(JobRunner::Priority::kLow))
+    ->UseRealTime();
 BENCHMARK(BM_AddJobTryImmediately);
+BENCHMARK(BM_AddJobSpinningWorkers);
+BENCHMARK(BM_WakeToRunLatency)->UseManualTime();
+BENCHMARK(BM_RunJobs)->ArgNames({"job_timing"})->Arg(0)->Arg(1)->UseManualTime();
+BENCHMARK(BM_GetStats)->ArgNames({"threads"})->Arg(1)->Arg(8);
+BENCHMARK(BM_AddJobAfter)->ArgNames({"pending"})->Arg(0)->Arg(1 << 20);
+BENCHMARK(BM_StealScaling)->ArgNames({"threads"})->Apply(AllCoresThreadNums)->UseRealTime();
+BENCHMARK(BM_ParallelSort)->ArgNames({"threads"})->Arg(0)->Apply(AllCoresThreadNums)->UseRealTime();
+BENCHMARK(BM_FanOutFanIn)
+    ->ArgNames({"queue_type", "fan_out"})
+    ->ArgsProduct({
+        {static_cast<long>(JobRunner::QueueType::kLockFree), static_cast<long>(JobRunner::QueueType::kWorkStealing)},
+        {64, 1024},
+    })
+    ->UseRealTime();
+BENCHMARK(BM_RecursiveSpawn)
+    ->ArgNames({"queue_type", "depth"})
+    ->ArgsProduct({
+        {static_cast<long>(JobRunner::QueueType::kLockFree), static_cast<long>(JobRunner::QueueType::kWorkStealing)},
+        {8, 12},
+    })
+    ->UseRealTime();
 
 }  // namespace cris::core
@@ -0,0 +1,307 @@
+#include "cris/core/msg/message.h"
+#include "cris/core/msg/message_pool.h"
+#include "cris/core/msg/node.h"
+#include "cris/core/sched/job_runner.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Count heap allocations per thread, so that the allocations on the publisher side can be reported.
+static thread_local std::size_t kCurrentThreadAllocations = 0;
+
+void* operator new(std::size_t size) {
+    ++kCurrentThreadAllocations;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) [[likely]] {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC does not see that `operator new` above is replaced as well.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace cris::core {
+
+using std::chrono::steady_clock;
+
+// Counts the messages alive, i.e. published but not yet handled, or waiting to be handled.
+struct BenchmarkStateMessage : public CRMessage<BenchmarkStateMessage> {
+    explicit BenchmarkStateMessage(std::size_t seq) : seq_(seq) {
+        const auto live_num = live_num_.fetch_add(1) + 1;
+        auto       peak_num = peak_live_num_.load();
+        while (live_num > peak_num && !peak_live_num_.compare_exchange_weak(peak_num, live_num)) {
+        }
+    }
+
+    BenchmarkStateMessage(const BenchmarkStateMessage&)            = delete;
+    BenchmarkStateMessage(BenchmarkStateMessage&&)                 = delete;
+    BenchmarkStateMessage& operator=(const BenchmarkStateMessage&) = delete;
+    BenchmarkStateMessage& operator=(BenchmarkStateMessage&&)      = delete;
+
+    ~BenchmarkStateMessage() override { live_num_.fetch_sub(1); }
+
+    const std::size_t              seq_;
+    const steady_clock::time_point publish_time_{steady_clock::now()};
+
+    static inline std::atomic<std::size_t> live_num_{0};
+    static inline std::atomic<std::size_t> peak_live_num_{0};
+};
+
+static void SpinFor(std::chrono::nanoseconds duration) {
+    const auto until = steady_clock::now() + duration;
+    while (steady_clock::now() < until) {
+    }
+}
+
+// A subscriber taking 10us for each message, of a publisher publishing every 1us. Reported are the average latency
+// from publishing to handling, and the peak number of messages alive, i.e. the backlog.
+static void BM_SlowSubscriber(benchmark::State& state) {
+    constexpr std::size_t             kMessageNum      = 1000;
+    constexpr CRNode::channel_subid_t kChannelSubId    = 1;
+    constexpr auto                    kPublishInterval = std::chrono::microseconds(1);
+    constexpr auto                    kHandleDuration  = std::chrono::microseconds(10);
+
+    auto   runner = JobRunner::MakeJobRunner({.thread_num_ = 1});
+    CRNode publisher;
+    CRNode subscriber(runner);
+
+    std::atomic<std::size_t> last_handled_seq{0};
+    std::size_t              handled_num      = 0;
+    std::int64_t             total_latency_ns = 0;
+    subscriber.Subscribe<BenchmarkStateMessage>(
+        kChannelSubId,
+        [&](const std::shared_ptr<BenchmarkStateMessage>& message) {
+            total_latency_ns +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - message->publish_time_)
+                    .count();
+            ++handled_num;
+            SpinFor(kHandleDuration);
+            last_handled_seq.store(message->seq_);
+        },
+        CRNode::SubscriptionOptions{.allow_concurrency_ = false, .latest_only_ = state.range(0) != 0});
+
+    BenchmarkStateMessage::peak_live_num_.store(0);
+    std::size_t seq = 0;
+    for ([[maybe_unused]] const auto s : state) {
+        for (std::size_t i = 0; i < kMessageNum; ++i) {
+            publisher.Publish(kChannelSubId, std::make_shared<BenchmarkStateMessage>(++seq));
+            SpinFor(kPublishInterval);
+        }
+        // The latest message is always handled.
+        while (last_handled_seq.load() != seq) {
+            std::this_thread::yield();
+        }
+    }
+    runner->Stop().Join();
+
+    state.counters["avg_latency_us"] =
+        static_cast<double>(total_latency_ns) / 1000. / static_cast<double>(std::max<std::size_t>(handled_num, 1));
+    state.counters["peak_live_messages"] = static_cast<double>(BenchmarkStateMessage::peak_live_num_.load());
+    state.counters["handled_ratio"]      = static_cast<double>(handled_num) / static_cast<double>(seq);
+}
+
+// Threads publishing concurrently to channels without subscribers, while other channels are subscribed, i.e. the cost
+// of looking up the subscriptions alone, which should not grow with the number of threads.
+static void BM_ConcurrentPublish(benchmark::State& state) {
+    constexpr CRNode::channel_subid_t kSubscribedChannelNum = 64;
+
+    struct Subscriptions {
+        Subscriptions() {
+            for (CRNode::channel_subid_t subid = 0; subid < kSubscribedChannelNum; ++subid) {
+                subscriber_.Subscribe<BenchmarkStateMessage>(subid, [](const auto&) {});
+            }
+        }
+
+        ~Subscriptions() { runner_->Stop().Join(); }
+
+        std::shared_ptr<JobRunner> runner_ = JobRunner::MakeJobRunner({.thread_num_ = 1});
+        CRNode                     subscriber_{runner_};
+    };
+    static Subscriptions subscriptions;
+
+    CRNode     publisher;
+    const auto subid   = kSubscribedChannelNum + static_cast<CRNode::channel_subid_t>(state.thread_index());
+    auto       message = std::make_shared<BenchmarkStateMessage>(0);
+    for ([[maybe_unused]] const auto s : state) {
+        publisher.Publish(subid, CRMessageBasePtr(message));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// One message to each of the subscribers, through `CRNode::Publish` or a `CRPublisher`. Reported are the average
+// latency from publishing to the callbacks, and the allocations of publishing besides the message.
+static void BM_FanOut(benchmark::State& state) {
+    constexpr CRNode::channel_subid_t kChannelSubId = 2;
+
+    const auto subscriber_num = static_cast<std::size_t>(state.range(0));
+    const bool use_publisher  = state.range(1) != 0;
+
+    auto                      runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+    std::atomic<std::size_t>  remaining_num{0};
+    std::atomic<std::int64_t> total_latency_ns{0};
+
+    std::vector<std::unique_ptr<CRNode>> subscribers;
+    for (std::size_t i = 0; i < subscriber_num; ++i) {
+        subscribers.push_back(std::make_unique<CRNode>(runner));
+        subscribers.back()->Subscribe<BenchmarkStateMessage>(
+            kChannelSubId,
+            [&remaining_num, &total_latency_ns](const std::shared_ptr<BenchmarkStateMessage>& message) {
+                total_latency_ns.fetch_add(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - message->publish_time_)
+                        .count());
+                remaining_num.fetch_sub(1);
+            });
+    }
+
+    CRNode      publisher;
+    const auto  typed_publisher = CRNode::MakePublisher<BenchmarkStateMessage>(kChannelSubId);
+    std::size_t allocations     = 0;
+    for ([[maybe_unused]] const auto s : state) {
+        remaining_num.store(subscriber_num);
+        auto       message            = std::make_shared<BenchmarkStateMessage>(0);
+        const auto allocations_before = kCurrentThreadAllocations;
+        if (use_publisher) {
+            typed_publisher.Publish(std::move(message));
+        } else {
+            publisher.Publish(kChannelSubId, std::move(message));
+        }
+        allocations += kCurrentThreadAllocations - allocations_before;
+        while (remaining_num.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+    runner->Stop().Join();
+
+    const auto delivered_num = static_cast<double>(state.iterations()) * static_cast<double>(subscriber_num);
+    state.SetItemsProcessed(static_cast<std::int64_t>(delivered_num));
+    state.counters["avg_latency_us"]     = static_cast<double>(total_latency_ns.load()) / 1000. / delivered_num;
+    state.counters["allocs_per_publish"] = benchmark::Counter(
+        static_cast<double>(allocations),
+        benchmark::Counter::kAvgIterations);
+}
+
+template<std::size_t payload_size>
+struct BenchmarkLargeMessage : public CRMessage<BenchmarkLargeMessage<payload_size>> {
+    std::array<char, payload_size> payload_;
+};
+
+// Publishing messages of `payload_size` bytes, each filled by the publisher and read by one subscriber, allocated
+// with `std::make_shared` (pool=0), or acquired from a `CRMessagePool` (pool=1), backed by hugepages (pool=2).
+template<std::size_t payload_size>
+static void BM_MessagePool(benchmark::State& state) {
+    using message_t = BenchmarkLargeMessage<payload_size>;
+
+    constexpr CRNode::channel_subid_t kChannelSubId = 3;
+
+    const auto pool_mode = state.range(0);
+
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 1});
+    auto pool   = pool_mode == 0 ? nullptr
+                                 : CRMessagePool<message_t>::MakeMessagePool({
+                                     .capacity_      = 4,
+                                     .use_hugepages_ = pool_mode == 2,
+                                 });
+    CRNode publisher;
+    CRNode subscriber(runner);
+
+    std::atomic<bool> handled{false};
+    std::size_t       checksum = 0;
+    subscriber.Subscribe<message_t>(kChannelSubId, [&](const std::shared_ptr<message_t>& message) {
+        checksum += static_cast<std::size_t>(message->payload_.back());
+        handled.store(true);
+    });
+
+    std::size_t allocations = 0;
+    for ([[maybe_unused]] const auto s : state) {
+        handled.store(false);
+        const auto allocations_before = kCurrentThreadAllocations;
+        auto       message            = pool ? pool->Acquire() : std::make_shared<message_t>();
+        std::memset(message->payload_.data(), static_cast<int>(state.iterations()), payload_size);
+        publisher.Publish(kChannelSubId, std::move(message));
+        allocations += kCurrentThreadAllocations - allocations_before;
+        while (!handled.load()) {
+            std::this_thread::yield();
+        }
+    }
+    runner->Stop().Join();
+    benchmark::DoNotOptimize(checksum);
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(payload_size));
+    state.counters["allocs_per_publish"] =
+        benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+    if (pool) {
+        state.counters["hugepage_backed"] = pool->IsHugepageBacked() ? 1 : 0;
+    }
+}
+
+template<int idx>
+struct BenchmarkDispatchMessage : public CRMessage<BenchmarkDispatchMessage<idx>> {};
+
+template<int... idx>
+static void AddDispatchChannels(CRNode::channel_subid_t subid_num, std::integer_sequence<int, idx...>) {
+    for (CRNode::channel_subid_t subid = 0; subid < subid_num; ++subid) {
+        (CRNode::MakePublisher<BenchmarkDispatchMessage<idx>>(subid), ...);
+    }
+}
+
+// Looking up channels, i.e. publishing through `CRNode::Publish` to a channel without subscribers, and reading its
+// latest delivered time, among `channels` channels of 16 message types.
+static void BM_Dispatch(benchmark::State& state) {
+    constexpr int                     kTypeNum      = 16;
+    constexpr CRNode::channel_subid_t kChannelSubId = 0;
+
+    using message_t = BenchmarkDispatchMessage<kTypeNum / 2>;
+
+    AddDispatchChannels(
+        std::max<CRNode::channel_subid_t>(static_cast<CRNode::channel_subid_t>(state.range(0)) / kTypeNum, 1),
+        std::make_integer_sequence<int, kTypeNum>());
+
+    CRNode                 publisher;
+    const CRMessageBasePtr message = std::make_shared<message_t>();
+    for ([[maybe_unused]] const auto s : state) {
+        publisher.Publish(kChannelSubId, CRMessageBasePtr(message));
+        benchmark::DoNotOptimize(CRMessageBase::GetLatestDeliveredTime<message_t>(kChannelSubId));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_FanOut)
+    ->ArgNames({"subscribers", "publisher"})
+    ->ArgsProduct({{1, 8, 64}, {0, 1}})
+    ->UseRealTime();
+BENCHMARK(BM_Dispatch)->ArgNames({"channels"})->Arg(16)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_ConcurrentPublish)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_SlowSubscriber)->ArgNames({"latest_only"})->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MessagePool, 4096)->ArgNames({"pool"})->DenseRange(0, 2)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MessagePool, 4 << 20)->ArgNames({"pool"})->DenseRange(0, 2)->UseRealTime();
+
+}  // namespace cris::core
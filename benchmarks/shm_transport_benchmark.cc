@@ -0,0 +1,230 @@
+#include "cris/core/msg/node.h"
+#include "cris/core/msg_shm/ring.h"
+#include "cris/core/msg_shm/transport.h"
+#include "cris/core/sched/job_runner.h"
+
+#include <benchmark/benchmark.h>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace cris::core {
+
+template<std::size_t data_size>
+struct ShmBenchmarkMessage : public CRMessage<ShmBenchmarkMessage<data_size>> {
+    struct Payload {
+        std::int64_t seq_;
+        // Of pings, whether a pong is requested. Of pongs, the number of pings received.
+        std::int64_t value_;
+        char         data_[data_size];
+    };
+
+    Payload payload_{};
+};
+
+// Pings go from this process to a forked one, which replies pongs when requested, both through `ShmTransport`.
+template<std::size_t data_size>
+class ShmPingPong {
+   public:
+    using message_t = ShmBenchmarkMessage<data_size>;
+
+    static constexpr CRNode::channel_subid_t kPingSubId = 1;
+    static constexpr CRNode::channel_subid_t kPongSubId = 2;
+
+    ShmPingPong() {
+        if (pid_ <= 0) {
+            return;
+        }
+        char ready = 0;
+        ready_     = read(ready_pipe_[0], &ready, 1) == 1 && ready;
+        close(ready_pipe_[0]);
+        close(ready_pipe_[1]);
+
+        ready_ = ready_ && transport_.Export<message_t>(kPingSubId) && transport_.Import<message_t>(kPongSubId);
+        node_.Subscribe<message_t>(kPongSubId, [this](const std::shared_ptr<message_t>& pong) {
+            pong_received_num_.store(pong->payload_.value_);
+            pong_seq_.store(pong->payload_.seq_);
+        });
+    }
+
+    ShmPingPong(const ShmPingPong&)            = delete;
+    ShmPingPong(ShmPingPong&&)                 = delete;
+    ShmPingPong& operator=(const ShmPingPong&) = delete;
+    ShmPingPong& operator=(ShmPingPong&&)      = delete;
+
+    ~ShmPingPong() {
+        if (pid_ > 0) {
+            if (ready_) {
+                Ping(-1, false);
+            } else {
+                kill(pid_, SIGKILL);
+            }
+            waitpid(pid_, nullptr, 0);
+        }
+        transport_.StopMainLoop();
+        runner_->Stop().Join();
+        ShmRing::Unlink(transport_.GetRingName<message_t>(kPingSubId));
+        ShmRing::Unlink(transport_.GetRingName<message_t>(kPongSubId));
+    }
+
+    bool IsReady() const { return ready_; }
+
+    void Ping(std::int64_t seq, bool request_pong) {
+        auto ping             = std::make_shared<message_t>();
+        ping->payload_.seq_   = seq;
+        ping->payload_.value_ = request_pong ? 1 : 0;
+        node_.Publish(kPingSubId, std::move(ping));
+    }
+
+    // Returns false if no pong of the sequence number or after arrived in time.
+    bool WaitForPong(std::int64_t seq) const {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (pong_seq_.load() < seq) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    std::int64_t GetPongSeq() const { return pong_seq_.load(); }
+
+    std::int64_t GetPongReceivedNum() const { return pong_received_num_.load(); }
+
+   private:
+    // Both processes name the rings after the pid of this process.
+    static ShmTransport::Config GetConfig(pid_t pid) {
+        return {.name_prefix_ = "cris_benchmark." + std::to_string(pid)};
+    }
+
+    // Forked before this process starts any thread.
+    static pid_t StartPonger(int (&ready_pipe)[2]) {
+        if (pipe(ready_pipe) != 0) {
+            return -1;
+        }
+        const auto parent_pid = getpid();
+        const auto pid        = fork();
+        if (pid == 0) {
+            RunPonger(parent_pid, ready_pipe[1]);
+        }
+        return pid;
+    }
+
+    [[noreturn]] static void RunPonger(pid_t parent_pid, int ready_fd) {
+        auto         runner = JobRunner::MakeJobRunner({.thread_num_ = 1});
+        ShmTransport transport(GetConfig(parent_pid), runner);
+        CRNode       node(runner);
+
+        std::atomic<bool> stopped{false};
+        std::int64_t      received_num = 0;
+        node.Subscribe<message_t>(
+            kPingSubId,
+            [&](const std::shared_ptr<message_t>& ping) {
+                if (ping->payload_.seq_ < 0) {
+                    stopped.store(true);
+                    return;
+                }
+                ++received_num;
+                if (ping->payload_.value_) {
+                    auto pong             = std::make_shared<message_t>();
+                    pong->payload_.seq_   = ping->payload_.seq_;
+                    pong->payload_.value_ = received_num;
+                    node.Publish(kPongSubId, std::move(pong));
+                }
+            },
+            CRNode::SubscriptionOptions{.allow_concurrency_ = false});
+        const char ready =
+            transport.Import<message_t>(kPingSubId) && transport.Export<message_t>(kPongSubId) ? 1 : 0;
+        [[maybe_unused]] const auto written = write(ready_fd, &ready, 1);
+
+        while (!stopped.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        transport.StopMainLoop();
+        runner->Stop().Join();
+        _exit(0);
+    }
+
+    int                        ready_pipe_[2]{-1, -1};
+    const pid_t                pid_    = StartPonger(ready_pipe_);
+    std::shared_ptr<JobRunner> runner_ = JobRunner::MakeJobRunner({.thread_num_ = 1});
+    ShmTransport               transport_{GetConfig(getpid()), runner_};
+    CRNode                     node_{runner_};
+    bool                       ready_{false};
+    std::atomic<std::int64_t>  pong_seq_{-1};
+    std::atomic<std::int64_t>  pong_received_num_{0};
+};
+
+// A ping and its pong per iteration. Reported is the one-way latency, from publishing in one process to the callback
+// in the other, i.e. half of the round trip.
+template<std::size_t data_size>
+static void BM_ShmRoundTrip(benchmark::State& state) {
+    ShmPingPong<data_size> ping_pong;
+    if (!ping_pong.IsReady()) {
+        state.SkipWithError("Failed to start the other process.");
+        return;
+    }
+    std::int64_t seq   = 0;
+    const auto   start = std::chrono::steady_clock::now();
+    for ([[maybe_unused]] const auto s : state) {
+        ping_pong.Ping(seq, true);
+        if (!ping_pong.WaitForPong(seq)) {
+            state.SkipWithError("Pong timed out.");
+            break;
+        }
+        ++seq;
+    }
+    const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+    state.counters["one_way_latency_us"] = elapsed.count() / 2. / static_cast<double>(std::max<std::int64_t>(seq, 1));
+}
+
+// Pings as fast as possible, with at most `kWindow` of them in flight, well within the ring. Reported is the rate of
+// the pings received by the other process.
+template<std::size_t data_size>
+static void BM_ShmThroughput(benchmark::State& state) {
+    constexpr std::int64_t kAckInterval = 64;
+    constexpr std::int64_t kWindow      = 512;
+
+    ShmPingPong<data_size> ping_pong;
+    if (!ping_pong.IsReady()) {
+        state.SkipWithError("Failed to start the other process.");
+        return;
+    }
+    std::int64_t seq = 0;
+    for ([[maybe_unused]] const auto s : state) {
+        while (seq - ping_pong.GetPongSeq() > kWindow) {
+            std::this_thread::yield();
+        }
+        ping_pong.Ping(seq, seq % kAckInterval == 0);
+        ++seq;
+    }
+    ping_pong.Ping(seq, true);
+    if (!ping_pong.WaitForPong(seq)) {
+        state.SkipWithError("Pong timed out.");
+        return;
+    }
+    // Excluding the last one.
+    const auto received_num = ping_pong.GetPongReceivedNum() - 1;
+    state.SetItemsProcessed(received_num);
+    state.SetBytesProcessed(
+        received_num * static_cast<std::int64_t>(sizeof(typename ShmBenchmarkMessage<data_size>::Payload)));
+    state.counters["received_ratio"] = static_cast<double>(received_num) / static_cast<double>(seq);
+}
+
+BENCHMARK_TEMPLATE(BM_ShmRoundTrip, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ShmRoundTrip, 4096)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ShmThroughput, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ShmThroughput, 4096)->UseRealTime();
+
+}  // namespace cris::core
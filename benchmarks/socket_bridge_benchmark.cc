@@ -0,0 +1,169 @@
+#include "cris/core/msg/node.h"
+#include "cris/core/msg_bridge/socket_bridge.h"
+#include "cris/core/sched/job_runner.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace cris::core {
+
+struct BridgeBenchmarkMessage : public CRMessage<BridgeBenchmarkMessage> {
+    std::int64_t seq_{0};
+    std::string  data_;
+};
+
+std::string MessageToStr(const BridgeBenchmarkMessage& message) {
+    std::string serialized_message(sizeof(message.seq_), '\0');
+    std::memcpy(serialized_message.data(), &message.seq_, sizeof(message.seq_));
+    return serialized_message + message.data_;
+}
+
+void MessageFromStr(BridgeBenchmarkMessage& message, const std::string& serialized_message) {
+    std::memcpy(&message.seq_, serialized_message.data(), sizeof(message.seq_));
+    message.data_ = serialized_message.substr(sizeof(message.seq_));
+}
+
+// Two bridges in this process, connected through the loopback interface. Messages published to `kSendSubId` come
+// back to `kReceiveSubId`.
+class BridgeLoopback {
+   public:
+    static constexpr CRNode::channel_subid_t kSendSubId    = 1;
+    static constexpr CRNode::channel_subid_t kReceiveSubId = 2;
+
+    explicit BridgeLoopback(std::size_t max_batch_bytes)
+        : sender_({.max_batch_bytes_ = max_batch_bytes}, runner_),
+          receiver_({.max_batch_bytes_ = max_batch_bytes}, runner_) {
+        node_.Subscribe<BridgeBenchmarkMessage>(
+            kReceiveSubId,
+            [this](const std::shared_ptr<BridgeBenchmarkMessage>& message) {
+                received_num_.fetch_add(1);
+                received_seq_.store(message->seq_);
+            },
+            CRNode::SubscriptionOptions{.allow_concurrency_ = false});
+        sender_.Export<BridgeBenchmarkMessage>(kSendSubId);
+        receiver_.Import<BridgeBenchmarkMessage>(kSendSubId, kReceiveSubId);
+        ready_ = sender_.Listen("tcp://127.0.0.1:0") && receiver_.Connect(sender_.GetListenAddress());
+    }
+
+    BridgeLoopback(const BridgeLoopback&)            = delete;
+    BridgeLoopback(BridgeLoopback&&)                 = delete;
+    BridgeLoopback& operator=(const BridgeLoopback&) = delete;
+    BridgeLoopback& operator=(BridgeLoopback&&)      = delete;
+
+    ~BridgeLoopback() {
+        sender_.StopMainLoop();
+        receiver_.StopMainLoop();
+        runner_->Stop().Join();
+    }
+
+    bool IsReady() const { return ready_; }
+
+    void Send(std::int64_t seq, const std::string& data) {
+        auto message   = std::make_shared<BridgeBenchmarkMessage>();
+        message->seq_  = seq;
+        message->data_ = data;
+        node_.Publish(kSendSubId, std::move(message));
+    }
+
+    // Returns false if the message of the sequence number did not arrive in time.
+    bool WaitFor(std::int64_t seq) const {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (received_seq_.load() < seq) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    std::int64_t GetReceivedSeq() const { return received_seq_.load(); }
+
+    std::int64_t GetReceivedNum() const { return received_num_.load(); }
+
+    SocketBridge::Stats GetStats() const { return sender_.GetStats(); }
+
+   private:
+    std::shared_ptr<JobRunner> runner_ = JobRunner::MakeJobRunner({.thread_num_ = 2});
+    SocketBridge               sender_;
+    SocketBridge               receiver_;
+    CRNode                     node_{runner_};
+    bool                       ready_{false};
+    std::atomic<std::int64_t>  received_seq_{-1};
+    std::atomic<std::int64_t>  received_num_{0};
+};
+
+// One message in flight. Reported is the latency through both bridges, which is up to `max_batch_delay_` longer for
+// batching bridges, unless the batch fills up first.
+static void BM_SocketBridgeLatency(benchmark::State& state) {
+    BridgeLoopback loopback(static_cast<std::size_t>(state.range(0)));
+    if (!loopback.IsReady()) {
+        state.SkipWithError("Failed to connect the bridges.");
+        return;
+    }
+    const std::string data(static_cast<std::size_t>(state.range(1)), 'x');
+    std::int64_t      seq   = 0;
+    const auto        start = std::chrono::steady_clock::now();
+    for ([[maybe_unused]] const auto s : state) {
+        loopback.Send(seq, data);
+        if (!loopback.WaitFor(seq)) {
+            state.SkipWithError("Message timed out.");
+            break;
+        }
+        ++seq;
+    }
+    const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+    state.counters["latency_us"] = elapsed.count() / static_cast<double>(std::max<std::int64_t>(seq, 1));
+}
+
+// Messages as fast as possible, with at most `kWindow` of them in flight. Reported are the rate of the messages
+// received, and the average number of messages per frame.
+static void BM_SocketBridgeThroughput(benchmark::State& state) {
+    constexpr std::int64_t kWindow = 4096;
+
+    BridgeLoopback loopback(static_cast<std::size_t>(state.range(0)));
+    if (!loopback.IsReady()) {
+        state.SkipWithError("Failed to connect the bridges.");
+        return;
+    }
+    const std::string data(static_cast<std::size_t>(state.range(1)), 'x');
+    std::int64_t      seq = 0;
+    for ([[maybe_unused]] const auto s : state) {
+        while (seq - loopback.GetReceivedSeq() > kWindow) {
+            std::this_thread::yield();
+        }
+        loopback.Send(seq, data);
+        ++seq;
+    }
+    if (seq > 0 && !loopback.WaitFor(seq - 1)) {
+        state.SkipWithError("Message timed out.");
+        return;
+    }
+    const auto received_num = loopback.GetReceivedNum();
+    const auto stats        = loopback.GetStats();
+    state.SetItemsProcessed(received_num);
+    state.SetBytesProcessed(received_num * state.range(1));
+    state.counters["messages_per_frame"] = static_cast<double>(stats.sent_message_num_) /
+                                           static_cast<double>(std::max<std::size_t>(stats.sent_frame_num_, 1));
+}
+
+// Batch sizes of none, 1 KiB, 16 KiB and 64 KiB, with messages of 64 bytes and 4 KiB.
+BENCHMARK(BM_SocketBridgeLatency)
+    ->ArgsProduct({{0, 1 << 10, 16 << 10, 64 << 10}, {64, 4096}})
+    ->ArgNames({"batch_bytes", "message_bytes"})
+    ->UseRealTime();
+BENCHMARK(BM_SocketBridgeThroughput)
+    ->ArgsProduct({{0, 1 << 10, 16 << 10, 64 << 10}, {64, 4096}})
+    ->ArgNames({"batch_bytes", "message_bytes"})
+    ->UseRealTime();
+
+}  // namespace cris::core
@@ -1,153 +1,593 @@
 #include "cris/core/msg/message.h"
 
 #include "cris/core/msg/node.h"
+#include "cris/core/sched/rcu.h"
 #include "cris/core/utils/logging.h"
 
-#include <boost/functional/hash.hpp>
-
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <typeindex>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace cris::core {
 
-using channel_id_t = CRMessageBase::channel_id_t;
-
-namespace {
+using channel_id_t      = CRMessageBase::channel_id_t;
+using channel_subid_t   = CRMessageBase::channel_subid_t;
+using message_type_id_t = CRMessageBase::message_type_id_t;
 
-class SubscriptionInfo {
+class CRMessageBase::Channel {
    public:
-    std::atomic<cr_timestamp_nsec_t> latest_delivered_time_{0};
-    std::vector<CRNode*>             sub_list_;
-};
+    static constexpr std::size_t kCacheLineSize = 64;
+    static constexpr std::size_t kStatShardNum  = 16;
+
+    // See `ChannelStats`. Counted with relaxed atomics, not consistent with each other while being updated. Threads
+    // are spread over the shards, so that the counters are hardly ever written by more than one of them.
+    struct alignas(kCacheLineSize) StatShard {
+        std::atomic<std::size_t>                                              published_num_{0};
+        std::atomic<std::size_t>                                              delivered_num_{0};
+        std::atomic<std::size_t>                                              failed_delivery_num_{0};
+        std::atomic<std::size_t>                                              serialized_bytes_{0};
+        std::array<std::atomic<unsigned long long>, impl::kDurationBucketNum> latency_hits_{};
+        std::array<std::atomic<cr_duration_nsec_t>, impl::kDurationBucketNum> latency_total_ns_{};
+        std::atomic<cr_duration_nsec_t>                                       max_latency_ns_{0};
+    };
+
+    Channel() = default;
+
+    explicit Channel(std::unique_ptr<const std::vector<Subscriber>> subscribers)
+        : subscribers_(std::move(subscribers)) {}
+
+    Channel(const Channel&)            = delete;
+    Channel(Channel&&)                 = delete;
+    Channel& operator=(const Channel&) = delete;
+    Channel& operator=(Channel&&)      = delete;
+
+    ~Channel() {
+        for (auto& shard : stat_shards_) {
+            delete shard.load(std::memory_order::acquire);
+        }
+    }
 
-class SubscriptionMap {
-   public:
-    bool Subscribe(const channel_id_t channel, CRNode* node);
+    // The shard of the calling thread, added on its first use, so that a channel used by a few threads stays small.
+    StatShard& GetStatShard() {
+        static std::atomic<std::size_t>       next_shard_idx{0};
+        static thread_local const std::size_t kThreadShardIdx =
+            next_shard_idx.fetch_add(1, std::memory_order::relaxed) % kStatShardNum;
+
+        auto& shard_ptr = stat_shards_[kThreadShardIdx];
+        auto* shard     = shard_ptr.load(std::memory_order::acquire);
+        if (!shard) [[unlikely]] {
+            auto new_shard = std::make_unique<StatShard>();
+            if (shard_ptr.compare_exchange_strong(shard, new_shard.get(), std::memory_order::acq_rel)) {
+                shard = new_shard.release();
+            }
+        }
+        return *shard;
+    }
 
-    void Unsubscribe(const channel_id_t channel, CRNode* node);
+    void GetStats(ChannelStats& stats) const {
+        for (const auto& shard_ptr : stat_shards_) {
+            const auto* shard = shard_ptr.load(std::memory_order::acquire);
+            if (!shard) {
+                continue;
+            }
+            stats.published_num_ += shard->published_num_.load(std::memory_order::relaxed);
+            stats.delivered_num_ += shard->delivered_num_.load(std::memory_order::relaxed);
+            stats.failed_delivery_num_ += shard->failed_delivery_num_.load(std::memory_order::relaxed);
+            stats.serialized_bytes_ += shard->serialized_bytes_.load(std::memory_order::relaxed);
+            for (std::size_t i = 0; i < impl::kDurationBucketNum; ++i) {
+                auto& bucket = stats.latency_buckets_[i];
+                bucket.hits_ += shard->latency_hits_[i].load(std::memory_order::relaxed);
+                bucket.total_duration_ns_ += shard->latency_total_ns_[i].load(std::memory_order::relaxed);
+            }
+            stats.max_latency_ns_ =
+                std::max(stats.max_latency_ns_, shard->max_latency_ns_.load(std::memory_order::relaxed));
+        }
+    }
 
-    void Dispatch(const CRMessageBasePtr& message);
+    std::atomic<cr_timestamp_nsec_t>                   latest_delivered_time_{0};
+    std::array<std::atomic<StatShard*>, kStatShardNum> stat_shards_{};
 
-    cr_timestamp_nsec_t GetLatestDeliveredTime(const channel_id_t channel);
+    // Read by dispatching in read-side critical sections, and copied with the changes by subscribing and unsubscribing,
+    // which are serialized by `CRMessageBase::SubscriptionWriteLock`.
+    RcuPtr<std::vector<Subscriber>> subscribers_;
+};
 
-    static SubscriptionMap& GetInstance();
+class CRMessageBase::TypeChannels {
+   public:
+    std::unordered_map<channel_subid_t, std::shared_ptr<Channel>> channels_;
+    // Looked up only when a channel is added, or published to before being added.
+    std::vector<RangeSubscriber> ranges_;
+
+    bool IsInSubscribedRange(const channel_id_t channel) const {
+        return std::any_of(ranges_.begin(), ranges_.end(), [channel](const RangeSubscriber& range_subscriber) {
+            return range_subscriber.range_.Contains(channel);
+        });
+    }
 
-   private:
-    std::unordered_map<channel_id_t, SubscriptionInfo, boost::hash<channel_id_t>> map_;
+    // Subscribed by the ranges containing it, the first of them for each node.
+    std::shared_ptr<Channel> AddChannel(const channel_id_t channel) {
+        auto subscribers = std::make_unique<std::vector<Subscriber>>();
+        for (const auto& range_subscriber : ranges_) {
+            if (range_subscriber.range_.Contains(channel) &&
+                std::none_of(subscribers->begin(), subscribers->end(), [&range_subscriber](const Subscriber& added) {
+                    return added.node_ == range_subscriber.node_;
+                })) {
+                subscribers->push_back({.node_ = range_subscriber.node_, .info_ = range_subscriber.make_info_()});
+            }
+        }
+        auto new_channel = std::make_shared<Channel>(std::move(subscribers));
+        channels_.emplace(channel.second, new_channel);
+        return new_channel;
+    }
 };
 
-SubscriptionMap& SubscriptionMap::GetInstance() {
-    static SubscriptionMap subscription_map;
-    return subscription_map;
+namespace {
+
+// Indexed by message type IDs, which are dense. Null for the message types without channels or ranges. Each update
+// copies the channels of one message type, and shares the others with the old map.
+using channel_map_t = std::vector<std::shared_ptr<const CRMessageBase::TypeChannels>>;
+
+struct MessageTypeRegistry {
+    std::mutex                                             mtx_;
+    std::unordered_map<std::type_index, message_type_id_t> type_ids_;
+    std::vector<std::type_index>                           types_;
+    std::vector<std::string>                               type_names_;
 };
 
-bool SubscriptionMap::Subscribe(const channel_id_t channel, CRNode* node) {
-    auto& subscription_list = map_[channel].sub_list_;
+MessageTypeRegistry& GetMessageTypeRegistry() {
+    static MessageTypeRegistry registry;
+    return registry;
+}
 
-    if (std::find(subscription_list.begin(), subscription_list.end(), node) != subscription_list.end()) {
-        LOG(WARNING) << __func__ << ": Channel (" << channel.first.name() << ", " << channel.second << ") "
-                     << "is subscribed by the node " << node << ", skipping subscription.";
-        return false;
-    }
-    subscription_list.emplace_back(node);
-    return true;
+// Channels are only added, never removed, so that publishers can hold them. Updated like the subscribers.
+RcuPtr<channel_map_t>& ChannelMap() {
+    static RcuPtr<channel_map_t> channel_map;
+    return channel_map;
 }
 
-void SubscriptionMap::Unsubscribe(const channel_id_t channel, CRNode* node) {
-    auto subscription_map_search = map_.find(channel);
-    if (subscription_map_search == map_.end()) {
-        LOG(WARNING) << __func__ << ": Channel (" << channel.first.name() << ", " << channel.second << ") is unknown";
-        return;
+std::mutex& SubscriptionMutex() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+// Null if not found.
+const CRMessageBase::TypeChannels* FindTypeChannels(
+    const channel_map_t&    channel_map,
+    const message_type_id_t type_id) {
+    return type_id < channel_map.size() ? channel_map[type_id].get() : nullptr;
+}
+
+// Null if not found.
+const std::shared_ptr<CRMessageBase::Channel>* FindChannel(
+    const channel_map_t& channel_map,
+    const channel_id_t   channel) {
+    const auto* type_channels = FindTypeChannels(channel_map, channel.first);
+    if (!type_channels) {
+        return nullptr;
     }
+    const auto& channels     = type_channels->channels_;
+    const auto  channel_find = channels.find(channel.second);
+    return channel_find == channels.end() ? nullptr : &channel_find->second;
+}
+
+// Must be called with SubscriptionWriteLock. Returns the copy of the channels of the message type to update.
+std::unique_ptr<CRMessageBase::TypeChannels> CopyTypeChannelsUnsafe(const message_type_id_t type_id) {
+    const auto* type_channels = FindTypeChannels(ChannelMap().Get(), type_id);
+    return type_channels ? std::make_unique<CRMessageBase::TypeChannels>(*type_channels)
+                         : std::make_unique<CRMessageBase::TypeChannels>();
+}
 
-    if (!std::erase(subscription_map_search->second.sub_list_, node)) {
-        LOG(WARNING) << __func__ << ": Channel (" << channel.first.name() << ", " << channel.second << ") "
-                     << "is not subscribed by node " << node;
+// Must be called with SubscriptionWriteLock. Returns the channel map to update with, with the updated channels of the
+// message type.
+std::unique_ptr<const channel_map_t> MakeChannelMapUnsafe(
+    const message_type_id_t                        type_id,
+    std::unique_ptr<CRMessageBase::TypeChannels>&& type_channels) {
+    auto new_channel_map = std::make_unique<channel_map_t>(ChannelMap().Get());
+    if (type_id >= new_channel_map->size()) {
+        new_channel_map->resize(type_id + 1);
     }
+    (*new_channel_map)[type_id] = std::move(type_channels);
+    return new_channel_map;
 }
 
-void SubscriptionMap::Dispatch(const CRMessageBasePtr& message) {
-    auto subscription_find = map_.find(message->GetChannelId());
-    if (subscription_find == map_.end()) {
-        return;
+// Must be called with SubscriptionWriteLock. Called when publishing to a channel in a subscribed range for the first
+// time, so the old channel map is freed without waiting for a grace period.
+std::shared_ptr<CRMessageBase::Channel> FindOrAddChannelUnsafe(const channel_id_t channel) {
+    if (const auto* channel_ptr = FindChannel(ChannelMap().Get(), channel)) {
+        return *channel_ptr;
     }
-    auto& subscription_info = subscription_find->second;
-    for (auto& node : subscription_info.sub_list_) {
-        const bool success = node->AddMessageToRunner(message);
-        LOG_IF(ERROR, !success) << __func__ << ": Failed to send message to node " << node->GetName();
+    auto type_channels = CopyTypeChannelsUnsafe(channel.first);
+    auto new_channel   = type_channels->AddChannel(channel);
+    ChannelMap().UpdateDeferred(MakeChannelMapUnsafe(channel.first, std::move(type_channels)));
+    return new_channel;
+}
+
+}  // namespace
+
+message_type_id_t CRMessageBase::RegisterMessageType(const std::type_index type, std::string&& type_name) {
+    auto&           registry = GetMessageTypeRegistry();
+    std::lock_guard lck(registry.mtx_);
+    const auto [type_id_itr, inserted] =
+        registry.type_ids_.try_emplace(type, static_cast<message_type_id_t>(registry.types_.size()));
+    if (inserted) {
+        registry.types_.push_back(type);
+        registry.type_names_.push_back(std::move(type_name));
     }
-    subscription_info.latest_delivered_time_.store(GetSystemTimestampNsec());
+    return type_id_itr->second;
 }
 
-cr_timestamp_nsec_t SubscriptionMap::GetLatestDeliveredTime(const channel_id_t channel) {
-    constexpr cr_timestamp_nsec_t kDefaultDeliveredTime = 0;
+std::type_index CRMessageBase::GetRegisteredMessageType(const message_type_id_t type_id) {
+    auto&           registry = GetMessageTypeRegistry();
+    std::lock_guard lck(registry.mtx_);
+    return type_id < registry.types_.size() ? registry.types_[type_id] : std::type_index(typeid(void));
+}
 
-    const auto subscription_find = map_.find(channel);
-    if (subscription_find == map_.end()) {
-        LOG(WARNING) << __func__ << ": Channel (" << channel.first.name() << ", " << channel.second << ") is unknown";
-        return kDefaultDeliveredTime;
+std::string CRMessageBase::GetRegisteredMessageTypeName(const message_type_id_t type_id) {
+    auto&           registry = GetMessageTypeRegistry();
+    std::lock_guard lck(registry.mtx_);
+    return type_id < registry.type_names_.size() ? registry.type_names_[type_id] : std::string();
+}
+
+void CRMessageBase::Dispatch(const CRMessageBasePtr& message) {
+    const auto channel            = message->GetChannelId();
+    Channel*   subscribed_channel = nullptr;
+    {
+        RcuReadGuard guard;
+        const auto&  channel_map = ChannelMap().Read();
+        if (const auto* channel_ptr = FindChannel(channel_map, channel)) {
+            subscribed_channel = channel_ptr->get();
+        } else if (const auto* type_channels = FindTypeChannels(channel_map, channel.first);
+                   !type_channels || !type_channels->IsInSubscribedRange(channel)) {
+            return;
+        }
+    }
+    // Channels are never removed, so dispatching goes on outside of the read-side critical section.
+    if (subscribed_channel) [[likely]] {
+        Dispatch(*subscribed_channel, message);
+        return;
     }
-    return subscription_find->second.latest_delivered_time_.load();
+    // The first message of a channel in a subscribed range. The channel is added outside of the read-side critical
+    // section, which must not wait for the update.
+    Dispatch(*GetChannel(channel), message);
 }
 
-}  // namespace
+void CRMessageBase::Dispatch(Channel& channel, const CRMessageBasePtr& message) {
+    static constexpr int kFailureLogInterval = 1000;
+
+    // One timestamp for both the latencies of the message and the latest delivered time of the channel.
+    const auto         published_time = GetSystemTimestampNsec();
+    const DispatchInfo dispatch{.channel_ = &channel, .published_time_ = published_time};
+    auto&              stats = channel.GetStatShard();
+    stats.published_num_.fetch_add(1, std::memory_order::relaxed);
+
+    std::size_t delivered_num = 0;
+    auto        on_failure    = [&stats](const Subscriber& subscriber) {
+        stats.failed_delivery_num_.fetch_add(1, std::memory_order::relaxed);
+        LOG_EVERY_N(ERROR, kFailureLogInterval) << "CRMessageBase::Dispatch: Failed to send message to node "
+                                                << subscriber.node_->GetName() << ", logged every "
+                                                << kFailureLogInterval << " failures.";
+    };
+    // Subscribers full with `JobRunner::OverflowPolicy::kBlock`, waited for after the read-side critical section,
+    // which must not wait. Allocated only if there are any.
+    std::vector<Subscriber> full_subscribers;
+    {
+        RcuReadGuard guard;
+        for (const auto& subscriber : channel.subscribers_.Read()) {
+            // Failures come in bursts when subscribers are overloaded and drop messages, see `SubscriptionOptions`.
+            switch (CRNode::DeliverMessage(message, dispatch, subscriber.info_)) {
+                case JobRunner::NoWait::State::ENQUEUED:
+                    ++delivered_num;
+                    break;
+                case JobRunner::NoWait::State::FULL:
+                    full_subscribers.push_back(subscriber);
+                    break;
+                case JobRunner::NoWait::State::FAILED:
+                    on_failure(subscriber);
+                    break;
+            }
+        }
+    }
+    for (const auto& subscriber : full_subscribers) {
+        // Not delivered if the node unsubscribes meanwhile, since it may be gone.
+        const auto state = CRNode::DeliverMessageWhenRoom(message, dispatch, subscriber.info_, [&channel, &subscriber] {
+            const auto& subscribers = channel.subscribers_.Read();
+            return std::any_of(subscribers.begin(), subscribers.end(), [&subscriber](const Subscriber& subscribed) {
+                return subscribed.info_ == subscriber.info_;
+            });
+        });
+        if (state == JobRunner::NoWait::State::ENQUEUED) {
+            ++delivered_num;
+        } else {
+            on_failure(subscriber);
+        }
+    }
+    if (delivered_num) {
+        stats.delivered_num_.fetch_add(delivered_num, std::memory_order::relaxed);
+    }
+    channel.latest_delivered_time_.store(published_time);
+}
 
-static std::shared_mutex& SubscriptionMutex() {
-    static std::shared_mutex mtx;
-    return mtx;
+void CRMessageBase::RecordCallbackStart(const DispatchInfo& dispatch) {
+    auto* channel = dispatch.channel_;
+    if (!channel) [[unlikely]] {
+        return;
+    }
+    // The monotonic clock may differ slightly across CPUs.
+    const auto latency    = std::max<cr_duration_nsec_t>(GetSystemTimestampNsec() - dispatch.published_time_, 0);
+    const auto bucket_idx = impl::GetDurationBucketIndex<ChannelStats::kLatencyBucketBaseNsec>(latency);
+    auto&      stats      = channel->GetStatShard();
+    stats.latency_hits_[bucket_idx].fetch_add(1, std::memory_order::relaxed);
+    stats.latency_total_ns_[bucket_idx].fetch_add(latency, std::memory_order::relaxed);
+    auto max_latency = stats.max_latency_ns_.load(std::memory_order::relaxed);
+    while (latency > max_latency &&
+           !stats.max_latency_ns_.compare_exchange_weak(max_latency, latency, std::memory_order::relaxed)) {
+    }
 }
 
-channel_id_t CRMessageBase::GetChannelId() const {
-    return std::make_pair(GetMessageTypeIndex(), GetChannelSubId());
+CRMessageBase::Channel& CRMessageBase::ResolveChannel(const channel_id_t channel) {
+    return *GetChannel(channel);
 }
 
-void CRMessageBase::Dispatch(const CRMessageBasePtr& message) {
-    auto lck = SubscriptionReadLock();
-    return SubscriptionMap::GetInstance().Dispatch(message);
+void CRMessageBase::AddSerializedBytes(Channel& channel, const std::size_t bytes) {
+    channel.GetStatShard().serialized_bytes_.fetch_add(bytes, std::memory_order::relaxed);
 }
 
-std::shared_lock<std::shared_mutex> CRMessageBase::SubscriptionReadLock() {
-    return std::shared_lock(SubscriptionMutex());
+std::shared_ptr<CRMessageBase::Channel> CRMessageBase::GetChannel(const channel_id_t channel) {
+    {
+        RcuReadGuard guard;
+        if (const auto* channel_ptr = FindChannel(ChannelMap().Read(), channel)) [[likely]] {
+            return *channel_ptr;
+        }
+    }
+    auto lck = SubscriptionWriteLock();
+    return FindOrAddChannelUnsafe(channel);
 }
 
-std::unique_lock<std::shared_mutex> CRMessageBase::SubscriptionWriteLock() {
+std::unique_lock<std::mutex> CRMessageBase::SubscriptionWriteLock() {
     return std::unique_lock(SubscriptionMutex());
 }
 
 bool CRMessageBase::SubscribeUnsafe(
-    const channel_id_t                         channel,
-    CRNode*                                    node,
-    const std::unique_lock<std::shared_mutex>& lck) {
+    const channel_id_t                  channel,
+    Subscriber&&                        subscriber,
+    const std::unique_lock<std::mutex>& lck) {
     if (!lck.owns_lock()) [[unlikely]] {
         LOG(ERROR) << __func__ << ": Must be called with owning lock.";
         return false;
     }
-    return SubscriptionMap::GetInstance().Subscribe(channel, node);
+
+    const auto  channel_ptr = FindOrAddChannelUnsafe(channel);
+    const auto& subscribers = channel_ptr->subscribers_.Get();
+    if (std::any_of(subscribers.begin(), subscribers.end(), [&subscriber](const Subscriber& subscribed) {
+            return subscribed.node_ == subscriber.node_;
+        })) {
+        LOG(WARNING) << __func__ << ": Channel (" << GetRegisteredMessageType(channel.first).name() << ", "
+                     << channel.second << ") is subscribed by the node " << subscriber.node_
+                     << ", skipping subscription.";
+        return false;
+    }
+    auto new_subscribers = std::make_unique<std::vector<Subscriber>>(subscribers);
+    new_subscribers->push_back(std::move(subscriber));
+    channel_ptr->subscribers_.Update(std::move(new_subscribers));
+    return true;
 }
 
 void CRMessageBase::UnsubscribeUnsafe(
-    const channel_id_t                         channel,
-    CRNode*                                    node,
-    const std::unique_lock<std::shared_mutex>& lck) {
+    const channel_id_t                  channel,
+    CRNode*                             node,
+    const std::unique_lock<std::mutex>& lck) {
     if (!lck.owns_lock()) [[unlikely]] {
         LOG(ERROR) << __func__ << ": Must be called with owning lock.";
         return;
     }
-    return SubscriptionMap::GetInstance().Unsubscribe(channel, node);
+
+    const auto* channel_ptr = FindChannel(ChannelMap().Get(), channel);
+    if (!channel_ptr) {
+        LOG(WARNING) << __func__ << ": Channel (" << GetRegisteredMessageType(channel.first).name() << ", "
+                     << channel.second << ") is unknown";
+        return;
+    }
+
+    auto& subscribers     = (*channel_ptr)->subscribers_;
+    auto  new_subscribers = std::make_unique<std::vector<Subscriber>>(subscribers.Get());
+    if (!std::erase_if(*new_subscribers, [node](const Subscriber& subscriber) { return subscriber.node_ == node; })) {
+        LOG(WARNING) << __func__ << ": Channel (" << GetRegisteredMessageType(channel.first).name() << ", "
+                     << channel.second << ") is not subscribed by node " << node;
+        return;
+    }
+    // The node may go away after returning, so wait until no dispatching sees it.
+    subscribers.Update(std::move(new_subscribers));
 }
 
-bool CRMessageBase::Subscribe(const channel_id_t channel, CRNode* node) {
-    return SubscribeUnsafe(channel, node, SubscriptionWriteLock());
+bool CRMessageBase::Subscribe(const channel_id_t channel, Subscriber&& subscriber) {
+    return SubscribeUnsafe(channel, std::move(subscriber), SubscriptionWriteLock());
 }
 
 void CRMessageBase::Unsubscribe(const channel_id_t channel, CRNode* node) {
     return UnsubscribeUnsafe(channel, node, SubscriptionWriteLock());
 }
 
+void CRMessageBase::SubscribeRangeUnsafe(RangeSubscriber&& subscriber, const std::unique_lock<std::mutex>& lck) {
+    if (!lck.owns_lock()) [[unlikely]] {
+        LOG(ERROR) << __func__ << ": Must be called with owning lock.";
+        return;
+    }
+
+    const auto range         = subscriber.range_;
+    auto       type_channels = CopyTypeChannelsUnsafe(range.type_id_);
+
+    // The channels added already. Their old subscriber lists are freed after one grace period for all, without waiting
+    // for it, since no node goes away.
+    std::vector<std::unique_ptr<const std::vector<Subscriber>>> old_subscribers;
+    for (const auto& [subid, channel_ptr] : type_channels->channels_) {
+        if (!range.Contains(std::make_pair(range.type_id_, subid))) {
+            continue;
+        }
+        const auto& subscribers = channel_ptr->subscribers_.Get();
+        if (std::any_of(subscribers.begin(), subscribers.end(), [&subscriber](const Subscriber& subscribed) {
+                return subscribed.node_ == subscriber.node_;
+            })) {
+            continue;
+        }
+        auto new_subscribers = std::make_unique<std::vector<Subscriber>>(subscribers);
+        new_subscribers->push_back({.node_ = subscriber.node_, .info_ = subscriber.make_info_()});
+        old_subscribers.push_back(channel_ptr->subscribers_.Exchange(std::move(new_subscribers)));
+    }
+    // The channels added later.
+    type_channels->ranges_.push_back(std::move(subscriber));
+    ChannelMap().UpdateDeferred(MakeChannelMapUnsafe(range.type_id_, std::move(type_channels)));
+    if (!old_subscribers.empty()) {
+        RcuCall([old_subscribers = std::move(old_subscribers)]() mutable { old_subscribers.clear(); });
+    }
+}
+
+void CRMessageBase::UnsubscribeRangeUnsafe(
+    const ChannelRange                  range,
+    CRNode*                             node,
+    const std::unique_lock<std::mutex>& lck) {
+    if (!lck.owns_lock()) [[unlikely]] {
+        LOG(ERROR) << __func__ << ": Must be called with owning lock.";
+        return;
+    }
+
+    auto type_channels = CopyTypeChannelsUnsafe(range.type_id_);
+    if (!std::erase_if(type_channels->ranges_, [range, node](const RangeSubscriber& range_subscriber) {
+            return range_subscriber.node_ == node && range_subscriber.range_ == range;
+        })) {
+        LOG(WARNING) << __func__ << ": Channels (" << GetRegisteredMessageType(range.type_id_).name() << ", ["
+                     << range.first_subid_ << ", " << range.last_subid_ << "]) are not subscribed by node " << node;
+        return;
+    }
+
+    std::vector<std::unique_ptr<const std::vector<Subscriber>>> old_subscribers;
+    for (const auto& [subid, channel_ptr] : type_channels->channels_) {
+        if (!range.Contains(std::make_pair(range.type_id_, subid))) {
+            continue;
+        }
+        auto new_subscribers = std::make_unique<std::vector<Subscriber>>(channel_ptr->subscribers_.Get());
+        if (std::erase_if(*new_subscribers, [node](const Subscriber& other) { return other.node_ == node; })) {
+            old_subscribers.push_back(channel_ptr->subscribers_.Exchange(std::move(new_subscribers)));
+        }
+    }
+    // The node may go away after returning, so wait until no dispatching sees it, in any of the channels.
+    ChannelMap().Update(MakeChannelMapUnsafe(range.type_id_, std::move(type_channels)));
+}
+
+void CRMessageBase::UnsubscribeRange(const ChannelRange range, CRNode* node) {
+    UnsubscribeRangeUnsafe(range, node, SubscriptionWriteLock());
+}
+
+const CRMessageBase::Subscriber* CRMessageBase::FindSubscriber(const channel_id_t channel, const CRNode* node) {
+    const auto* channel_ptr = FindChannel(ChannelMap().Read(), channel);
+    if (!channel_ptr) {
+        return nullptr;
+    }
+    const auto& subscribers = (*channel_ptr)->subscribers_.Read();
+    const auto  subscriber_find =
+        std::find_if(subscribers.begin(), subscribers.end(), [node](const Subscriber& subscriber) {
+            return subscriber.node_ == node;
+        });
+    return subscriber_find == subscribers.end() ? nullptr : &*subscriber_find;
+}
+
 cr_timestamp_nsec_t CRMessageBase::GetLatestDeliveredTime(const channel_id_t channel) {
-    auto lck = SubscriptionReadLock();
-    return SubscriptionMap::GetInstance().GetLatestDeliveredTime(channel);
+    constexpr cr_timestamp_nsec_t kDefaultDeliveredTime = 0;
+
+    RcuReadGuard guard;
+    const auto*  channel_ptr = FindChannel(ChannelMap().Read(), channel);
+    if (!channel_ptr) {
+        LOG(WARNING) << __func__ << ": Channel (" << GetRegisteredMessageType(channel.first).name() << ", "
+                     << channel.second << ") is unknown";
+        return kDefaultDeliveredTime;
+    }
+    return (*channel_ptr)->latest_delivered_time_.load();
+}
+
+std::vector<CRMessageBase::ChannelStats> CRMessageBase::GetChannelStats() {
+    std::vector<std::pair<channel_id_t, const Channel*>> channels;
+    {
+        RcuReadGuard guard;
+        const auto&  channel_map = ChannelMap().Read();
+        for (std::size_t type_id = 0; type_id < channel_map.size(); ++type_id) {
+            if (!channel_map[type_id]) {
+                continue;
+            }
+            for (const auto& [subid, channel_ptr] : channel_map[type_id]->channels_) {
+                channels.emplace_back(
+                    std::make_pair(static_cast<message_type_id_t>(type_id), subid),
+                    channel_ptr.get());
+            }
+        }
+    }
+    std::sort(channels.begin(), channels.end());
+
+    std::vector<ChannelStats> all_stats;
+    all_stats.reserve(channels.size());
+    for (const auto& [channel, channel_ptr] : channels) {
+        auto& stats = all_stats.emplace_back();
+        channel_ptr->GetStats(stats);
+        stats.message_type_  = GetRegisteredMessageTypeName(channel.first);
+        stats.channel_subid_ = channel.second;
+    }
+    return all_stats;
+}
+
+CRMessageBase::ChannelStats CRMessageBase::GetChannelStats(const channel_id_t channel) {
+    ChannelStats stats;
+    {
+        RcuReadGuard guard;
+        if (const auto* channel_ptr = FindChannel(ChannelMap().Read(), channel)) {
+            (*channel_ptr)->GetStats(stats);
+        }
+    }
+    stats.message_type_  = GetRegisteredMessageTypeName(channel.first);
+    stats.channel_subid_ = channel.second;
+    return stats;
+}
+
+cr_duration_nsec_t CRMessageBase::ChannelStats::GetPercentileLatencyNsec(int percent) const {
+    if (percent < 0) [[unlikely]] {
+        LOG(ERROR) << __func__ << ": percent less than 0: " << percent;
+        percent = 0;
+    }
+    if (percent > 100) [[unlikely]] {
+        LOG(ERROR) << __func__ << ": percent greater than 100: " << percent;
+        percent = 100;
+    }
+    if (percent == 100) {
+        return max_latency_ns_;
+    }
+
+    unsigned long long total_hits = 0;
+    for (const auto& bucket : latency_buckets_) {
+        total_hits += bucket.hits_;
+    }
+    const auto target_hits = static_cast<unsigned long long>(
+        std::round(static_cast<double>(total_hits) * static_cast<double>(percent) / 100.));
+    if (target_hits == 0) {
+        return 0;
+    }
+
+    unsigned long long current_hits = 0;
+    for (const auto& bucket : latency_buckets_) {
+        current_hits += bucket.hits_;
+        if (current_hits >= target_hits) {
+            return static_cast<cr_duration_nsec_t>(
+                static_cast<unsigned long long>(bucket.total_duration_ns_) / bucket.hits_);
+        }
+    }
+    // The buckets may be copied while the hits are being added.
+    return max_latency_ns_;
 }
 
 }  // namespace cris::core
@@ -1,14 +1,18 @@
 #pragma once
 
+#include "cris/core/timer/timer.h"
 #include "cris/core/utils/defs.h"
 #include "cris/core/utils/time.h"
 
+#include <array>
 #include <atomic>
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <mutex>
-#include <shared_mutex>
 #include <string>
+#include <type_traits>
 #include <typeindex>
 #include <typeinfo>
 #include <utility>
@@ -22,12 +26,25 @@ class CRNode;
 template<class message_t>
 concept CRMessageType = std::is_base_of_v<CRMessageBase, message_t>;
 
+// Messages serialized with `MessageToStr` and `MessageFromStr`, found by argument-dependent lookup, e.g. for recording
+// and for sending to other processes or hosts.
+template<class message_t>
+concept CRSerializableMessageType = CRMessageType<message_t> && std::is_default_constructible_v<message_t> &&
+    requires(message_t& message, const std::string& serialized_message) {
+        { MessageToStr(std::as_const(message)) } -> std::convertible_to<std::string>;
+        MessageFromStr(message, serialized_message);
+    };
+
+template<CRMessageType message_t>
+class CRPublisher;
+
 class CRMessageBase {
    public:
-    using channel_subid_t = std::uint64_t;
-    using channel_id_t    = std::pair<std::type_index, channel_subid_t>;
-
-    CRMessageBase() = default;
+    using channel_subid_t   = std::uint64_t;
+    // Message types are interned into dense IDs when first used, in the order of first use in the process. They are
+    // cheap to hash and compare, unlike `std::type_index`, whose hash may hash the type name.
+    using message_type_id_t = std::uint32_t;
+    using channel_id_t      = std::pair<message_type_id_t, channel_subid_t>;
 
     CRMessageBase(const CRMessageBase&) = delete;
 
@@ -45,43 +62,173 @@ class CRMessageBase {
 
     channel_subid_t GetChannelSubId() const { return sub_id_; }
 
-    channel_id_t GetChannelId() const;
+    channel_id_t GetChannelId() const { return std::make_pair(type_id_, sub_id_); }
+
+    template<CRMessageType message_t>
+    static message_type_id_t GetMessageTypeId() {
+        static const message_type_id_t type_id = RegisterMessageType(typeid(message_t), GetTypeName<message_t>());
+        return type_id;
+    }
+
+    template<CRMessageType message_t>
+    static channel_id_t MakeChannelId(const channel_subid_t channel_subid) {
+        return std::make_pair(GetMessageTypeId<message_t>(), channel_subid);
+    }
+
+    // The type of an interned ID, e.g. for logging.
+    static std::type_index GetRegisteredMessageType(const message_type_id_t type_id);
 
     template<CRMessageType message_t>
     static cr_timestamp_nsec_t GetLatestDeliveredTime(const channel_subid_t channel_subid);
 
     static cr_timestamp_nsec_t GetLatestDeliveredTime(const channel_id_t channel);
 
+    // Counted per channel since it is added, at the cost of a few relaxed atomic additions per message and per
+    // delivery to counters of the calling thread, e.g. to find slow subscribers.
+    struct ChannelStats {
+        // The first bucket of latencies is from 0 to 1 us, see `impl::UpperNsecOfBucket`.
+        static constexpr cr_duration_nsec_t kLatencyBucketBaseNsec = 1000;
+
+        using latency_buckets_t = std::array<impl::TimerStatEntryBucket, impl::kDurationBucketNum>;
+
+        // Average latency of the bucket reaching the percentile, and the max latency for 100.
+        cr_duration_nsec_t GetPercentileLatencyNsec(int percent) const;
+
+        std::string        message_type_;
+        channel_subid_t    channel_subid_{kDefaultChannelSubID};
+        std::size_t        published_num_{0};
+        // Messages handed to the subscribers, once for each subscriber. Deliveries fail when the runner of the
+        // subscriber is gone, or does not take more jobs, see `JobRunner::AddJob`.
+        std::size_t        delivered_num_{0};
+        std::size_t        failed_delivery_num_{0};
+        // Of the messages serialized by transports and recorders, which do not serialize them for this alone.
+        std::size_t        serialized_bytes_{0};
+        // From being published to the start of each callback, where a callback may run long after being delivered.
+        latency_buckets_t  latency_buckets_{};
+        cr_duration_nsec_t max_latency_ns_{0};
+    };
+
+    // Of all channels added, by subscribing or publishing.
+    static std::vector<ChannelStats> GetChannelStats();
+
+    template<CRMessageType message_t>
+    static ChannelStats GetChannelStats(const channel_subid_t channel_subid);
+
+    // All zero if the channel is unknown.
+    static ChannelStats GetChannelStats(const channel_id_t channel);
+
     constexpr static channel_subid_t kDefaultChannelSubID = 0;
 
+    // The subscribers of a channel, resolved once by `CRPublisher`.
+    class Channel;
+
+    // Resolve the channel once, e.g. when subscribing, for `AddSerializedBytes`. It is created if unknown, and never
+    // goes away.
+    template<CRMessageType message_t>
+    static Channel& ResolveChannel(const channel_subid_t channel_subid) {
+        return ResolveChannel(MakeChannelId<message_t>(channel_subid));
+    }
+
+    static Channel& ResolveChannel(const channel_id_t channel);
+
+    // Counts the bytes of messages of the channel serialized by its subscriber, see `ChannelStats::serialized_bytes_`.
+    static void AddSerializedBytes(Channel& channel, const std::size_t bytes);
+
+    // Where and when a message is dispatched. The message is shared by all of its deliveries, and may be dispatched
+    // again, so this is passed along with each delivery instead, for the stats of the channel.
+    struct DispatchInfo {
+        // Null if the message is handed to a node without being dispatched, see `CRNode::AddMessageToRunner`.
+        Channel*            channel_{nullptr};
+        cr_timestamp_nsec_t published_time_{0};
+    };
+
+    // The channels of a message type, with the ranges of them subscribed.
+    class TypeChannels;
+
+   protected:
+    // Messages derive from `CRMessage`, which interns their types.
+    explicit CRMessageBase(const message_type_id_t type_id) : type_id_(type_id) {}
+
    private:
-    void SetChannelSubId(const channel_subid_t sub_id) { sub_id_ = sub_id; }
+    // A node subscribing to a channel, with how it handles the messages. Defined along with `CRNode`.
+    struct Subscriber;
+
+    // The channels of a message type with sub IDs in [first_subid_, last_subid_].
+    struct ChannelRange {
+        message_type_id_t type_id_;
+        channel_subid_t   first_subid_;
+        channel_subid_t   last_subid_;
+
+        bool Contains(const channel_id_t channel) const {
+            return channel.first == type_id_ && channel.second >= first_subid_ && channel.second <= last_subid_;
+        }
+
+        bool operator==(const ChannelRange&) const = default;
+    };
+
+    // A node subscribing to a range of channels. Kept in an index per message type, and added to the subscribers of
+    // each channel in the range, including the channels added later, so that dispatching is the same as for channels
+    // subscribed one by one. Defined along with `CRNode`.
+    struct RangeSubscriber;
+
+    // The same ID for the same type, even if registered from different shared libraries.
+    static message_type_id_t RegisterMessageType(const std::type_index type, std::string&& type_name);
 
-    static std::shared_lock<std::shared_mutex> SubscriptionReadLock();
+    static std::string GetRegisteredMessageTypeName(const message_type_id_t type_id);
 
-    static std::unique_lock<std::shared_mutex> SubscriptionWriteLock();
+    // Called by the subscriber before running its callback with a message of the dispatch.
+    static void RecordCallbackStart(const DispatchInfo& dispatch);
+
+    void SetChannelSubId(const channel_subid_t sub_id) { sub_id_ = sub_id; }
+
+    // Serializes the updates of subscriptions. Dispatching takes no lock, but reads the subscriptions in read-side
+    // critical sections, see `RcuReadGuard`.
+    static std::unique_lock<std::mutex> SubscriptionWriteLock();
 
     static void Dispatch(const std::shared_ptr<CRMessageBase>& message);
 
+    static void Dispatch(Channel& channel, const std::shared_ptr<CRMessageBase>& message);
+
+    // The channel is created if unknown, and never goes away.
+    static std::shared_ptr<Channel> GetChannel(const channel_id_t channel);
+
     // Must be called with SubscriptionWriteLock.
     static bool SubscribeUnsafe(
-        const channel_id_t                         channel,
-        CRNode*                                    node,
-        const std::unique_lock<std::shared_mutex>& lck);
+        const channel_id_t                  channel,
+        Subscriber&&                        subscriber,
+        const std::unique_lock<std::mutex>& lck);
 
     // Must be called with SubscriptionWriteLock.
     static void UnsubscribeUnsafe(
-        const channel_id_t                         channel,
-        CRNode*                                    node,
-        const std::unique_lock<std::shared_mutex>& lck);
+        const channel_id_t                  channel,
+        CRNode*                             node,
+        const std::unique_lock<std::mutex>& lck);
 
-    static bool Subscribe(const channel_id_t channel, CRNode* node);
+    static bool Subscribe(const channel_id_t channel, Subscriber&& subscriber);
 
     static void Unsubscribe(const channel_id_t channel, CRNode* node);
 
+    // Must be called with SubscriptionWriteLock. Channels of the range subscribed by the node already are skipped.
+    static void SubscribeRangeUnsafe(RangeSubscriber&& subscriber, const std::unique_lock<std::mutex>& lck);
+
+    // Must be called with SubscriptionWriteLock. The node is removed from all channels of the range.
+    static void UnsubscribeRangeUnsafe(
+        const ChannelRange                  range,
+        CRNode*                             node,
+        const std::unique_lock<std::mutex>& lck);
+
+    static void UnsubscribeRange(const ChannelRange range, CRNode* node);
+
+    // In a read-side critical section. Null if the channel is unknown, or not subscribed by the node.
+    static const Subscriber* FindSubscriber(const channel_id_t channel, const CRNode* node);
+
     friend class CRNode;
 
-    channel_subid_t sub_id_{kDefaultChannelSubID};
+    template<CRMessageType message_t>
+    friend class CRPublisher;
+
+    message_type_id_t type_id_{0};
+    channel_subid_t   sub_id_{kDefaultChannelSubID};
 };
 
 using CRMessageBasePtr = std::shared_ptr<CRMessageBase>;
@@ -89,6 +236,8 @@ using CRMessageBasePtr = std::shared_ptr<CRMessageBase>;
 template<class message_t>
 class CRMessage : public CRMessageBase {
    public:
+    CRMessage() : CRMessageBase(GetMessageTypeId<message_t>()) {}
+
     std::type_index GetMessageTypeIndex() const override { return static_cast<std::type_index>(typeid(message_t)); }
 
     std::string GetMessageTypeName() const override { return GetTypeName<message_t>(); }
@@ -96,7 +245,12 @@ class CRMessage : public CRMessageBase {
 
 template<CRMessageType message_t>
 cr_timestamp_nsec_t CRMessageBase::GetLatestDeliveredTime(const CRMessageBase::channel_subid_t channel_subid) {
-    return GetLatestDeliveredTime(std::make_pair(static_cast<std::type_index>(typeid(message_t)), channel_subid));
+    return GetLatestDeliveredTime(MakeChannelId<message_t>(channel_subid));
+}
+
+template<CRMessageType message_t>
+CRMessageBase::ChannelStats CRMessageBase::GetChannelStats(const CRMessageBase::channel_subid_t channel_subid) {
+    return GetChannelStats(MakeChannelId<message_t>(channel_subid));
 }
 
 }  // namespace cris::core
@@ -0,0 +1,95 @@
+#include "cris/core/msg/message_pool.h"
+
+#include "cris/core/utils/logging.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace cris::core {
+
+namespace {
+
+#if defined(__linux__)
+constexpr std::size_t kHugepageSize = std::size_t{2} << 20;
+#endif
+
+std::size_t RoundUp(std::size_t size, std::size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void* MapMemory(std::size_t size, int extra_flags) {
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return data == MAP_FAILED ? nullptr : data;
+}
+
+// Touch every page, for the ones not populated by mmap.
+void FaultIn(void* data, std::size_t size) {
+    const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto*      bytes     = static_cast<volatile char*>(data);
+    for (std::size_t offset = 0; offset < size; offset += page_size) {
+        bytes[offset] = 0;
+    }
+}
+
+#if defined(__linux__)
+// Transparent hugepages only back ranges aligned to hugepages, so it maps more and trims the unaligned ends.
+void* MapTransparentHugepages(std::size_t size) {
+    auto* data = static_cast<char*>(MapMemory(size + kHugepageSize, 0));
+    if (!data) {
+        return nullptr;
+    }
+    auto* aligned_data = reinterpret_cast<char*>(RoundUp(reinterpret_cast<std::uintptr_t>(data), kHugepageSize));
+    if (aligned_data != data) {
+        munmap(data, static_cast<std::size_t>(aligned_data - data));
+    }
+    munmap(aligned_data + size, static_cast<std::size_t>(data + kHugepageSize - aligned_data));
+    // Advised before faulting in, otherwise the pages are already small ones.
+    if (madvise(aligned_data, size, MADV_HUGEPAGE) != 0) {
+        PLOG(WARNING) << __func__ << ": Failed to use transparent hugepages.";
+    }
+    FaultIn(aligned_data, size);
+    return aligned_data;
+}
+#endif
+
+}  // namespace
+
+MessagePoolArena::MessagePoolArena(std::size_t size, [[maybe_unused]] bool use_hugepages) {
+    if (size == 0) {
+        return;
+    }
+#if defined(__linux__)
+    if (use_hugepages) {
+        size_ = RoundUp(size, kHugepageSize);
+        data_ = MapMemory(size_, MAP_HUGETLB | MAP_POPULATE);
+        if (data_) {
+            hugepage_backed_ = true;
+            return;
+        }
+        LOG(INFO) << __func__ << ": No hugepages reserved for " << size_ << " bytes, use transparent ones instead.";
+        data_ = MapTransparentHugepages(size_);
+        if (data_) {
+            return;
+        }
+    }
+#endif
+    size_ = RoundUp(size, static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+    data_ = MapMemory(size_, 0);
+    if (!data_) {
+        PLOG(ERROR) << __func__ << ": Failed to map " << size_ << " bytes.";
+        throw std::bad_alloc();
+    }
+    FaultIn(data_, size_);
+}
+
+MessagePoolArena::~MessagePoolArena() {
+    if (data_) {
+        munmap(data_, size_);
+    }
+}
+
+}  // namespace cris::core
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "cris/core/msg/message.h"
+#include "cris/core/sched/spin_mutex.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace cris::core {
+
+// Memory mapped and faulted in up front, so that using it later does not page fault.
+class MessagePoolArena {
+   public:
+    // With `use_hugepages`, reserved hugepages are preferred, and transparent hugepages are requested otherwise.
+    MessagePoolArena(std::size_t size, bool use_hugepages);
+
+    MessagePoolArena(const MessagePoolArena&)            = delete;
+    MessagePoolArena(MessagePoolArena&&)                 = delete;
+    MessagePoolArena& operator=(const MessagePoolArena&) = delete;
+    MessagePoolArena& operator=(MessagePoolArena&&)      = delete;
+
+    ~MessagePoolArena();
+
+    void* Data() const { return data_; }
+
+    std::size_t Size() const { return size_; }
+
+    // Whether it is backed by reserved hugepages.
+    bool IsHugepageBacked() const { return hugepage_backed_; }
+
+   private:
+    void*       data_{nullptr};
+    std::size_t size_{0};
+    bool        hugepage_backed_{false};
+};
+
+// Preallocated messages of one type, for publishing large messages at high rates without allocating or page faulting
+// for each of them. A message acquired from the pool goes back to it, instead of being freed, when the last reference
+// to it is released, e.g. by the last subscriber. The reference count lives in the same slot of the pool, so neither
+// acquiring nor releasing allocates.
+//
+// Messages are recycled as they are, not reconstructed, so that their buffers are reused as well. Publishers are
+// expected to overwrite what they publish. The pool stays alive until all the messages acquired from it are released.
+template<CRMessageType message_t>
+class CRMessagePool : public std::enable_shared_from_this<CRMessagePool<message_t>> {
+   public:
+    using Self = CRMessagePool;
+
+    struct Config {
+        // The number of preallocated messages.
+        std::size_t capacity_{16};
+        bool        use_hugepages_{false};
+    };
+
+    CRMessagePool(const Self&)   = delete;
+    CRMessagePool(Self&&)        = delete;
+    Self& operator=(const Self&) = delete;
+    Self& operator=(Self&&)      = delete;
+
+    ~CRMessagePool();
+
+    // A free message of the pool, or a new one not from the pool if all are in use.
+    std::shared_ptr<message_t> Acquire();
+
+    std::size_t Capacity() const { return capacity_; }
+
+    // The number of messages of the pool not in use.
+    std::size_t FreeNum() const;
+
+    bool IsHugepageBacked() const { return arena_.IsHugepageBacked(); }
+
+    static std::shared_ptr<Self> MakeMessagePool(Config config);
+
+   private:
+    // Enough for the control blocks of `std::shared_ptr` with the empty deleter and the allocator below.
+    static constexpr std::size_t kControlBlockSize = 64;
+
+    struct Slot {
+        message_t                           message_{};
+        alignas(std::max_align_t) std::byte control_block_[kControlBlockSize];
+        CRMessagePool*                      pool_{nullptr};
+    };
+
+    // Messages go back to the pool when their control blocks are freed, i.e. not until the weak references are gone
+    // as well, so that a slot is never reused while its control block is still alive.
+    struct KeepMessage {
+        void operator()(message_t* /* message */) const noexcept {}
+    };
+
+    template<class value_t>
+    struct SlotAllocator {
+        using value_type = value_t;
+
+        explicit SlotAllocator(Slot* slot) : slot_(slot) {}
+
+        template<class other_value_t>
+        SlotAllocator(const SlotAllocator<other_value_t>& other) : slot_(other.slot_) {}
+
+        value_t* allocate(std::size_t n) {
+            static_assert(sizeof(value_t) <= kControlBlockSize && alignof(value_t) <= alignof(std::max_align_t));
+            if (n != 1) [[unlikely]] {
+                throw std::bad_alloc();
+            }
+            return reinterpret_cast<value_t*>(slot_->control_block_);
+        }
+
+        void deallocate(value_t* /* ptr */, std::size_t /* n */) { slot_->pool_->Release(slot_); }
+
+        template<class other_value_t>
+        bool operator==(const SlotAllocator<other_value_t>& other) const {
+            return slot_ == other.slot_;
+        }
+
+        Slot* slot_;
+    };
+
+    explicit CRMessagePool(Config config);
+
+    void Release(Slot* slot);
+
+    const std::size_t       capacity_;
+    MessagePoolArena        arena_;
+    Slot* const             slots_;
+    mutable HybridSpinMutex free_slots_mtx_;
+    std::vector<Slot*>      free_slots_;
+    // Held while any message of the pool is in use.
+    std::shared_ptr<Self> keep_alive_;
+};
+
+template<CRMessageType message_t>
+CRMessagePool<message_t>::CRMessagePool(Config config)
+    : capacity_(config.capacity_),
+      arena_(config.capacity_ * sizeof(Slot), config.use_hugepages_),
+      slots_(static_cast<Slot*>(arena_.Data())) {
+    free_slots_.reserve(capacity_);
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        auto* slot  = new (&slots_[i]) Slot;
+        slot->pool_ = this;
+        free_slots_.push_back(slot);
+    }
+}
+
+template<CRMessageType message_t>
+CRMessagePool<message_t>::~CRMessagePool() {
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        slots_[i].~Slot();
+    }
+}
+
+template<CRMessageType message_t>
+std::shared_ptr<message_t> CRMessagePool<message_t>::Acquire() {
+    Slot* slot = nullptr;
+    {
+        std::lock_guard lck(free_slots_mtx_);
+        if (free_slots_.empty()) [[unlikely]] {
+            return std::make_shared<message_t>();
+        }
+        if (free_slots_.size() == capacity_) {
+            keep_alive_ = this->shared_from_this();
+        }
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    return std::shared_ptr<message_t>(&slot->message_, KeepMessage{}, SlotAllocator<message_t>(slot));
+}
+
+template<CRMessageType message_t>
+std::size_t CRMessagePool<message_t>::FreeNum() const {
+    std::lock_guard lck(free_slots_mtx_);
+    return free_slots_.size();
+}
+
+template<CRMessageType message_t>
+void CRMessagePool<message_t>::Release(Slot* slot) {
+    std::shared_ptr<Self> keep_alive;
+    std::lock_guard       lck(free_slots_mtx_);
+    free_slots_.push_back(slot);
+    if (free_slots_.size() == capacity_) {
+        // Released after unlocking, since it may destroy the pool along with the mutex.
+        keep_alive = std::move(keep_alive_);
+    }
+}
+
+template<CRMessageType message_t>
+std::shared_ptr<CRMessagePool<message_t>> CRMessagePool<message_t>::MakeMessagePool(Config config) {
+    return std::shared_ptr<Self>(new Self(std::move(config)));
+}
+
+}  // namespace cris::core
@@ -4,7 +4,9 @@
 #include "cris/core/utils/logging.h"
 
 #include <cstdint>
+#include <functional>
 #include <ios>
+#include <memory>
 #include <utility>
 
 namespace cris::core {
@@ -25,26 +27,157 @@ CRNode::~CRNode() {
     for (const auto& subscribed : subscribed_) {
         CRMessageBase::Unsubscribe(subscribed, this);
     }
+    for (const auto& subscribed_range : subscribed_ranges_) {
+        CRMessageBase::UnsubscribeRange(subscribed_range, this);
+    }
 }
 
 bool CRNode::AddMessageToRunner(const CRMessageBasePtr& message) {
-    if (auto subscription_info_opt = GetSubscriptionInfo(message)) {
-        auto job = [callback = std::move(subscription_info_opt->callback_), message](JobAliveTokenPtr&& token) {
-            callback(message, std::move(token));
-        };
-        return AddJobToRunner(std::move(job), std::move(subscription_info_opt->strand_));
+    std::shared_ptr<const SubscriptionInfo> info;
+    {
+        RcuReadGuard guard;
+        info = GetSubscriptionInfo(message);
+        if (!info) {
+            return false;
+        }
+        // Not dispatched, so not counted in the stats of the channel.
+        const auto state = DeliverMessage(message, {}, info);
+        if (state != JobRunner::NoWait::State::FULL) [[likely]] {
+            return state == JobRunner::NoWait::State::ENQUEUED;
+        }
+    }
+    // The node is alive, since it is the caller.
+    return DeliverMessageWhenRoom(message, {}, info, [] { return true; }) == JobRunner::NoWait::State::ENQUEUED;
+}
+
+JobRunner::NoWait::State CRNode::DeliverMessage(
+    const CRMessageBasePtr&                        message,
+    const CRMessageBase::DispatchInfo&             dispatch,
+    const std::shared_ptr<const SubscriptionInfo>& info) {
+    auto runner = info->runner_weak_.lock();
+    if (!runner) [[unlikely]] {
+        return JobRunner::NoWait::State::FAILED;
+    }
+    return DeliverMessage(message, dispatch, info, *runner, runner->DefaultSchedulerHint());
+}
+
+JobRunner::NoWait::State CRNode::DeliverMessage(
+    const CRMessageBasePtr&                        message,
+    const CRMessageBase::DispatchInfo&             dispatch,
+    const std::shared_ptr<const SubscriptionInfo>& info,
+    JobRunner&                                     runner,
+    std::size_t                                    scheduler_hint) {
+    if (info->latest_slot_) {
+        return AddLatestMessageToRunner(info, message, dispatch, runner, scheduler_hint);
+    }
+    if (!info->strand_) {
+        // Added as a plain job, not wrapped into one by the runner, which would not fit in the inline storage.
+        return runner.AddJob(
+            [info, message, dispatch]() { RunCallback(*info, message, dispatch, nullptr); },
+            scheduler_hint,
+            info->priority_,
+            JobRunner::NoWait());
+    }
+    return runner.AddJob(
+        [info, message, dispatch](JobAliveTokenPtr&& token) {
+            RunCallback(*info, message, dispatch, std::move(token));
+        },
+        info->strand_,
+        scheduler_hint,
+        info->priority_,
+        JobRunner::NoWait());
+}
+
+JobRunner::NoWait::State CRNode::DeliverMessageWhenRoom(
+    const CRMessageBasePtr&                        message,
+    const CRMessageBase::DispatchInfo&             dispatch,
+    const std::shared_ptr<const SubscriptionInfo>& info,
+    const std::function<bool()>&                   is_subscribed) {
+    auto runner = info->runner_weak_.lock();
+    if (!runner) [[unlikely]] {
+        return JobRunner::NoWait::State::FAILED;
     }
+    for (;;) {
+        const auto scheduler_hint = runner->DefaultSchedulerHint();
+        if (!runner->WaitForRoom(info->strand_, scheduler_hint)) {
+            return JobRunner::NoWait::State::FAILED;
+        }
+        RcuReadGuard guard;
+        if (!is_subscribed()) {
+            return JobRunner::NoWait::State::FAILED;
+        }
+        // The message left in the slot may have been taken, or replaced by a newer one, in the meantime.
+        const auto state = info->latest_slot_ ? ScheduleLatestMessage(info, *runner, scheduler_hint)
+                                              : DeliverMessage(message, dispatch, info, *runner, scheduler_hint);
+        if (state != JobRunner::NoWait::State::FULL) {
+            return state;
+        }
+    }
+}
+
+JobRunner::NoWait::State CRNode::AddLatestMessageToRunner(
+    const std::shared_ptr<const SubscriptionInfo>& info,
+    const CRMessageBasePtr&                        message,
+    const CRMessageBase::DispatchInfo&             dispatch,
+    JobRunner&                                     runner,
+    std::size_t                                    scheduler_hint) {
+    info->latest_slot_->ExchangeLatest({.message_ = message, .dispatch_ = dispatch});
+    return ScheduleLatestMessage(info, runner, scheduler_hint);
+}
+
+JobRunner::NoWait::State CRNode::ScheduleLatestMessage(
+    const std::shared_ptr<const SubscriptionInfo>& info,
+    JobRunner&                                     runner,
+    std::size_t                                    scheduler_hint) {
+    auto* slot = info->latest_slot_.get();
+    if (!slot->HasLatest() || slot->scheduled_.exchange(true)) {
+        // Taken already, or the job in flight takes the message, or the one replacing it.
+        return JobRunner::NoWait::State::ENQUEUED;
+    }
+    const auto state = runner.AddJob(
+        [info](JobAliveTokenPtr&& token) { RunLatestMessage(info, std::move(token)); },
+        info->strand_,
+        scheduler_hint,
+        info->priority_,
+        JobRunner::NoWait());
+    if (state != JobRunner::NoWait::State::ENQUEUED) [[unlikely]] {
+        slot->scheduled_.store(false);
+    }
+    return state;
+}
+
+bool CRNode::ScheduleLatestMessage(const std::shared_ptr<const SubscriptionInfo>& info) {
+    auto runner = info->runner_weak_.lock();
+    if (runner && runner->AddJob(
+                      [info](JobAliveTokenPtr&& token) { RunLatestMessage(info, std::move(token)); },
+                      info->strand_,
+                      info->priority_)) [[likely]] {
+        return true;
+    }
+    info->latest_slot_->scheduled_.store(false);
     return false;
 }
 
+void CRNode::RunLatestMessage(const std::shared_ptr<const SubscriptionInfo>& info, JobAliveTokenPtr&& token) {
+    auto* slot = info->latest_slot_.get();
+    if (auto latest = slot->ExchangeLatest({}); latest.message_) [[likely]] {
+        RunCallback(*info, latest.message_, latest.dispatch_, std::move(token));
+    }
+    slot->scheduled_.store(false);
+    // A message stored after the exchange above may have seen the job in flight, and left it to the job.
+    if (slot->HasLatest() && !slot->scheduled_.exchange(true)) {
+        ScheduleLatestMessage(info);
+    }
+}
+
 void CRNode::Publish(const CRNode::channel_subid_t channel_subid, CRMessageBasePtr&& message) {
     message->SetChannelSubId(channel_subid);
     CRMessageBase::Dispatch(message);
 }
 
-JobRunnerStrandPtr CRNode::MakeStrand() {
+JobRunnerStrandPtr CRNode::MakeStrand(JobRunner::StrandConfig config) {
     if (auto runner = runner_weak_.lock()) [[likely]] {
-        return runner->MakeStrand();
+        return runner->MakeStrand(config);
     } else {
         LOG(WARNING) << __func__ << ": Node \"" << GetName() << "\"(at 0x" << std::hex
                      << reinterpret_cast<std::uintptr_t>(this) << ") has not bound with a runner yet." << std::dec;
@@ -52,45 +185,114 @@ JobRunnerStrandPtr CRNode::MakeStrand() {
     }
 }
 
-std::optional<CRNode::SubscriptionInfo> CRNode::GetSubscriptionInfo(const CRMessageBasePtr& message) {
+std::shared_ptr<const CRNode::SubscriptionInfo> CRNode::GetSubscriptionInfo(const CRMessageBasePtr& message) {
     if (!message) {
-        return std::nullopt;
+        return nullptr;
     }
 
     const auto channel = message->GetChannelId();
 
-    const auto callback_search_result = callbacks_.find(channel);
-    if (callback_search_result == callbacks_.end()) {
-        LOG(ERROR) << __func__ << ": message channel (" << channel.first.name() << ", " << channel.second << ") "
+    const auto& callbacks              = callbacks_.Read();
+    const auto  callback_search_result = callbacks.find(channel);
+    if (callback_search_result == callbacks.end()) {
+        // Subscribed in a range.
+        if (const auto* subscriber = CRMessageBase::FindSubscriber(channel, this)) {
+            return subscriber->info_;
+        }
+        LOG(ERROR) << __func__ << ": message channel ("
+                   << CRMessageBase::GetRegisteredMessageType(channel.first).name() << ", " << channel.second << ") "
                    << "is not subscribed by node \"" << GetName() << "\"'(" << this << ").";
-        return std::nullopt;
+        return nullptr;
     }
     return callback_search_result->second;
 }
 
 void CRNode::SubscribeImpl(
-    const channel_id_t                                                 channel,
-    std::function<void(const CRMessageBasePtr&, JobAliveTokenPtr&&)>&& callback,
-    JobRunnerStrandPtr                                                 strand) {
+    const channel_id_t  channel,
+    erased_callback_t&& callback,
+    JobRunnerStrandPtr  strand,
+    JobRunner::Priority priority,
+    const bool          latest_only) {
     auto lck = CRMessageBase::SubscriptionWriteLock();
     CHECK(can_subscribe_) << __func__ << ": Node \"" << GetName() << "\"(at 0x" << std::hex
                           << reinterpret_cast<std::uintptr_t>(this) << ") has not bound with any runner." << std::dec;
 
-    if (!CRMessageBase::SubscribeUnsafe(channel, this, lck)) {
+    if (callbacks_.Get().contains(channel)) {
+        LOG(ERROR) << __func__ << ": channel (" << CRMessageBase::GetRegisteredMessageType(channel.first).name()
+                   << ", " << channel.second << ") "
+                   << "is subscribed. The new callback is ignored. Node: \"" << GetName() << "\"(" << this << ").";
+        return;
+    }
+
+    // The callback is ready before messages are dispatched to it.
+    auto info = std::make_shared<const SubscriptionInfo>(SubscriptionInfo{
+        .callback_    = std::move(callback),
+        .strand_      = std::move(strand),
+        .priority_    = priority,
+        .runner_weak_ = runner_weak_,
+        .latest_slot_ = latest_only ? std::make_unique<LatestMessageSlot>() : nullptr,
+    });
+    CRMessageBase::Subscriber subscriber{.node_ = this, .info_ = info};
+    if (!CRMessageBase::SubscribeUnsafe(channel, std::move(subscriber), lck)) {
+        // E.g. a range subscribed by the node covers the channel already, whose callback stays.
         return;
     }
     subscribed_.push_back(channel);
-    auto callback_insert = callbacks_.emplace(
-        channel,
-        SubscriptionInfo{
-            .callback_ = std::move(callback),
-            .strand_   = std::move(strand),
-        });
-    if (!callback_insert.second) {
-        LOG(ERROR) << __func__ << ": channel (" << channel.first.name() << ", " << channel.second << ") "
-                   << "is subscribed. The new callback is ignored. Node: \"" << GetName() << "\"(" << this << ").";
+
+    auto new_callbacks = std::make_unique<callback_map_t>(callbacks_.Get());
+    new_callbacks->emplace(channel, std::move(info));
+    callbacks_.Update(std::move(new_callbacks));
+}
+
+void CRNode::SubscribeRangeImpl(
+    const channel_range_t      range,
+    erased_callback_t&&        callback,
+    const SubscriptionOptions& options) {
+    auto lck = CRMessageBase::SubscriptionWriteLock();
+    CHECK(can_subscribe_) << __func__ << ": Node \"" << GetName() << "\"(at 0x" << std::hex
+                          << reinterpret_cast<std::uintptr_t>(this) << ") has not bound with any runner." << std::dec;
+
+    if (range.first_subid_ > range.last_subid_) {
+        LOG(ERROR) << __func__ << ": Range [" << range.first_subid_ << ", " << range.last_subid_ << "] is empty. "
+                   << "Node: \"" << GetName() << "\"(" << this << ").";
         return;
     }
+
+    const JobRunner::StrandConfig strand_config{
+        .priority_        = options.priority_,
+        .max_pending_     = options.max_pending_,
+        .overflow_policy_ = options.overflow_policy_,
+    };
+    const bool strand_per_channel = !options.allow_concurrency_ && options.strand_per_channel_;
+    const bool latest_only        = options.latest_only_;
+
+    auto info = std::make_shared<const SubscriptionInfo>(SubscriptionInfo{
+        .callback_    = std::move(callback),
+        .strand_      = options.allow_concurrency_ || strand_per_channel ? nullptr : MakeStrand(strand_config),
+        .priority_    = options.priority_,
+        .runner_weak_ = runner_weak_,
+    });
+    std::function<std::shared_ptr<const SubscriptionInfo>()> make_info;
+    if (strand_per_channel || latest_only) {
+        // The channels share the callback, instead of copies of it.
+        make_info = [info, strand_config, strand_per_channel, latest_only]() {
+            erased_callback_t shared_callback = [info](const CRMessageBasePtr& message, JobAliveTokenPtr&& token) {
+                info->callback_(message, std::move(token));
+            };
+            auto runner = info->runner_weak_.lock();
+            return std::make_shared<const SubscriptionInfo>(SubscriptionInfo{
+                .callback_    = std::move(shared_callback),
+                .strand_      = strand_per_channel && runner ? runner->MakeStrand(strand_config) : info->strand_,
+                .priority_    = info->priority_,
+                .runner_weak_ = info->runner_weak_,
+                .latest_slot_ = latest_only ? std::make_unique<LatestMessageSlot>() : nullptr,
+            });
+        };
+    } else {
+        make_info = [info]() { return info; };
+    }
+    CRMessageBase::SubscribeRangeUnsafe({.node_ = this, .range_ = range, .make_info_ = std::move(make_info)}, lck);
+    subscribed_ranges_.push_back(range);
 }
 
 }  // namespace cris::core
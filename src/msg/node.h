@@ -2,16 +2,21 @@
 
 #include "cris/core/msg/message.h"
 #include "cris/core/sched/job_runner.h"
+#include "cris/core/sched/rcu.h"
+#include "cris/core/sched/spin_mutex.h"
+#include "cris/core/sched/task.h"
 #include "cris/core/utils/logging.h"
 
 #include <boost/functional/hash.hpp>
 
+#include <atomic>
 #include <cstddef>
 #include <functional>
+#include <limits>
 #include <memory>
-#include <optional>
+#include <mutex>
 #include <string>
-#include <typeindex>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -29,9 +34,15 @@ concept CRMessageWithAliveTokenCallbackType =
         std::declval<const std::shared_ptr<message_t>&>(),
         std::declval<JobAliveTokenPtr>()))>;
 
+// Coroutine callbacks, see `Task`. They are considered running until the coroutines finish, e.g. the next message of a
+// channel without concurrency is not handled until then, so they must not await the strand of the channel.
 template<class callback_t, class message_t = CRMessageBase>
-concept CRMessageCallbackType =
-    CRSingleMessageCallbackType<callback_t, message_t> || CRMessageWithAliveTokenCallbackType<callback_t, message_t>;
+concept CRCoroutineMessageCallbackType = std::is_base_of_v<CRMessageBase, message_t> &&
+    std::is_same_v<decltype(std::declval<callback_t>()(std::declval<const std::shared_ptr<message_t>&>())), Task<void>>;
+
+template<class callback_t, class message_t = CRMessageBase>
+concept CRMessageCallbackType = CRSingleMessageCallbackType<callback_t, message_t> ||
+    CRMessageWithAliveTokenCallbackType<callback_t, message_t> || CRCoroutineMessageCallbackType<callback_t, message_t>;
 
 class CRNode {
    public:
@@ -62,64 +73,340 @@ class CRNode {
     std::string GetName() const { return name_; }
 
     template<class strand_job_t>
-    bool AddJobToRunner(strand_job_t&& job, JobRunnerStrandPtr strand);
+    bool AddJobToRunner(strand_job_t&& job, JobRunnerStrandPtr strand, JobRunner::Priority priority);
+
+    template<class strand_job_t>
+    bool AddJobToRunner(strand_job_t&& job, JobRunnerStrandPtr strand) {
+        return AddJobToRunner(std::forward<strand_job_t>(job), std::move(strand), JobRunner::Priority::kNormal);
+    }
 
     bool AddJobToRunner(job_t&& job) { return AddJobToRunner(std::move(job), nullptr); }
 
     bool AddMessageToRunner(const CRMessageBasePtr& message);
 
-    template<CRMessageType message_t, CRSingleMessageCallbackType<message_t> callback_t>
-    void Subscribe(const channel_subid_t channel_subid, callback_t&& callback, JobRunnerStrandPtr strand);
+    template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
+    void Subscribe(const channel_subid_t channel_subid, callback_t&& callback, JobRunnerStrandPtr strand) {
+        Subscribe<message_t>(
+            channel_subid,
+            std::forward<callback_t>(callback),
+            std::move(strand),
+            JobRunner::Priority::kNormal);
+    }
 
-    template<CRMessageType message_t, CRMessageWithAliveTokenCallbackType<message_t> callback_t>
-    void Subscribe(const channel_subid_t channel_subid, callback_t&& callback, JobRunnerStrandPtr strand);
+    struct SubscriptionOptions {
+        // Without concurrency, callbacks of the channel run sequentially in a strand of their own.
+        bool allow_concurrency_{true};
+        // Callbacks of the channel run with this priority.
+        JobRunner::Priority priority_{JobRunner::Priority::kNormal};
+        // The maximum number of messages waiting in the strand of the channel, zero for no limit, and what to do when
+        // it is full, see `JobRunner::StrandConfig`. Only without concurrency, otherwise messages wait in the queues of
+        // the runner, limited by its config. E.g. a limit of 1 with `OverflowPolicy::kDropOldest` delivers the latest
+        // message only, for channels of states.
+        std::size_t               max_pending_{0};
+        JobRunner::OverflowPolicy overflow_policy_{JobRunner::OverflowPolicy::kBlock};
+        // Deliver the latest message only, for channels of states. The channel keeps a slot for the latest message,
+        // and at most one job in flight for it, so a new message replaces the one not yet delivered instead of adding
+        // a job. A coroutine callback is in flight until its first suspension only.
+        bool latest_only_{false};
+        // For range subscriptions without concurrency, a strand for each channel instead of one for all of them, so
+        // that each channel, e.g. each sensor of an array, is in order, while different channels run in parallel.
+        bool strand_per_channel_{false};
+    };
+
+    template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
+    void Subscribe(
+        const channel_subid_t channel_subid,
+        callback_t&&          callback,
+        JobRunnerStrandPtr    strand,
+        JobRunner::Priority   priority) {
+        SubscribeImpl(
+            CRMessageBase::MakeChannelId<message_t>(channel_subid),
+            EraseCallback<message_t>(std::forward<callback_t>(callback)),
+            std::move(strand),
+            priority,
+            /* latest_only = */ false);
+    }
+
+    template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
+    void Subscribe(const channel_subid_t channel_subid, callback_t&& callback, const SubscriptionOptions& options) {
+        JobRunnerStrandPtr strand;
+        if (!options.allow_concurrency_) {
+            strand = MakeStrand({
+                .priority_        = options.priority_,
+                .max_pending_     = options.max_pending_,
+                .overflow_policy_ = options.overflow_policy_,
+            });
+        }
+        SubscribeImpl(
+            CRMessageBase::MakeChannelId<message_t>(channel_subid),
+            EraseCallback<message_t>(std::forward<callback_t>(callback)),
+            std::move(strand),
+            options.priority_,
+            options.latest_only_);
+    }
 
     template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
     void Subscribe(const channel_subid_t channel_subid, callback_t&& callback, const bool allow_concurrency) {
         Subscribe<message_t>(
             channel_subid,
             std::forward<callback_t>(callback),
-            allow_concurrency ? nullptr : MakeStrand());
+            SubscriptionOptions{.allow_concurrency_ = allow_concurrency});
     }
 
     template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
     void Subscribe(const channel_subid_t channel_subid, callback_t&& callback) {
-        return Subscribe<message_t>(channel_subid, std::forward<callback_t>(callback), /* allow_concurrency = */ true);
+        return Subscribe<message_t>(channel_subid, std::forward<callback_t>(callback), SubscriptionOptions{});
+    }
+
+    // Subscribe to the channels of `message_t` with sub IDs in [first_subid, last_subid] with one callback, e.g. for
+    // an array of sensors, without subscribing to each of them. It applies to the channels published to later as well,
+    // and delivering to them costs the same as to channels subscribed one by one. A channel subscribed by the node
+    // both alone and in a range, or in overlapping ranges, is delivered to the subscription made first.
+    template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
+    void SubscribeRange(
+        const channel_subid_t      first_subid,
+        const channel_subid_t      last_subid,
+        callback_t&&               callback,
+        const SubscriptionOptions& options) {
+        SubscribeRangeImpl(
+            {
+                .type_id_     = CRMessageBase::GetMessageTypeId<message_t>(),
+                .first_subid_ = first_subid,
+                .last_subid_  = last_subid,
+            },
+            EraseCallback<message_t>(std::forward<callback_t>(callback)),
+            options);
+    }
+
+    template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
+    void SubscribeRange(const channel_subid_t first_subid, const channel_subid_t last_subid, callback_t&& callback) {
+        SubscribeRange<message_t>(first_subid, last_subid, std::forward<callback_t>(callback), SubscriptionOptions{});
+    }
+
+    // Subscribe to the channels of `message_t` of all sub IDs.
+    template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
+    void SubscribeAll(callback_t&& callback, const SubscriptionOptions& options) {
+        SubscribeRange<message_t>(
+            std::numeric_limits<channel_subid_t>::min(),
+            std::numeric_limits<channel_subid_t>::max(),
+            std::forward<callback_t>(callback),
+            options);
+    }
+
+    template<CRMessageType message_t, CRMessageCallbackType<message_t> callback_t>
+    void SubscribeAll(callback_t&& callback) {
+        SubscribeAll<message_t>(std::forward<callback_t>(callback), SubscriptionOptions{});
     }
 
     void Publish(const channel_subid_t channel_subid, CRMessageBasePtr&& message);
 
+    // Resolve the channel once for publishing to it repeatedly. See `CRPublisher`.
+    template<CRMessageType message_t>
+    static CRPublisher<message_t> MakePublisher(const channel_subid_t channel_subid);
+
    protected:
+    friend class CRMessageBase;
+
+    using erased_callback_t = std::function<void(const CRMessageBasePtr&, JobAliveTokenPtr&&)>;
+
+    struct LatestMessage {
+        CRMessageBasePtr            message_;
+        CRMessageBase::DispatchInfo dispatch_;
+    };
+
+    // The latest message of a channel subscribed with `SubscriptionOptions::latest_only_`.
+    struct LatestMessageSlot {
+        // Whether a job is in flight, which takes the latest message when it runs.
+        std::atomic<bool> scheduled_{false};
+
+        // Returns the message replaced, to be released outside of the lock.
+        LatestMessage ExchangeLatest(LatestMessage latest) {
+            std::lock_guard lck(latest_mtx_);
+            std::swap(latest_, latest);
+            return latest;
+        }
+
+        bool HasLatest() {
+            std::lock_guard lck(latest_mtx_);
+            return static_cast<bool>(latest_.message_);
+        }
+
+       private:
+        // Held only to swap the message.
+        HybridSpinMutex latest_mtx_;
+        LatestMessage   latest_;
+    };
+
+    // Made once for each subscription, and referenced by the jobs delivering messages to it.
     struct SubscriptionInfo {
-        std::function<void(const CRMessageBasePtr&, JobAliveTokenPtr&&)> callback_;
-        JobRunnerStrandPtr                                               strand_;
+        erased_callback_t                  callback_;
+        JobRunnerStrandPtr                 strand_;
+        JobRunner::Priority                priority_{JobRunner::Priority::kNormal};
+        std::weak_ptr<JobRunner>           runner_weak_;
+        std::unique_ptr<LatestMessageSlot> latest_slot_{};
     };
 
-    using callback_map_t = std::unordered_map<channel_id_t, SubscriptionInfo, boost::hash<channel_id_t>>;
+    // Shared with the subscriber lists of messages, see `CRMessageBase::Subscriber`.
+    using callback_map_t =
+        std::unordered_map<channel_id_t, std::shared_ptr<const SubscriptionInfo>, boost::hash<channel_id_t>>;
+
+    JobRunnerStrandPtr MakeStrand(JobRunner::StrandConfig config = {});
+
+    using channel_range_t = CRMessageBase::ChannelRange;
+
+    // In a read-side critical section. Null if the channel of the message is not subscribed.
+    std::shared_ptr<const SubscriptionInfo> GetSubscriptionInfo(const CRMessageBasePtr& message);
+
+    // The job references the subscription instead of copying the callback, and fits in the inline storage of jobs, so
+    // delivering a message allocates nothing. It never waits, as it is called in read-side critical sections. FULL if
+    // the subscription is full with `JobRunner::OverflowPolicy::kBlock`, see `DeliverMessageWhenRoom`.
+    static JobRunner::NoWait::State DeliverMessage(
+        const CRMessageBasePtr&                        message,
+        const CRMessageBase::DispatchInfo&             dispatch,
+        const std::shared_ptr<const SubscriptionInfo>& info);
+
+    // Outside of read-side critical sections, after `DeliverMessage` returns FULL. It waits for room, and delivers the
+    // message unless `is_subscribed()`, checked in a read-side critical section right before delivering, turns false
+    // meanwhile, so that nodes get no message after unsubscribing.
+    static JobRunner::NoWait::State DeliverMessageWhenRoom(
+        const CRMessageBasePtr&                        message,
+        const CRMessageBase::DispatchInfo&             dispatch,
+        const std::shared_ptr<const SubscriptionInfo>& info,
+        const std::function<bool()>&                   is_subscribed);
+
+    static JobRunner::NoWait::State DeliverMessage(
+        const CRMessageBasePtr&                        message,
+        const CRMessageBase::DispatchInfo&             dispatch,
+        const std::shared_ptr<const SubscriptionInfo>& info,
+        JobRunner&                                     runner,
+        std::size_t                                    scheduler_hint);
+
+    // Records the latency of the message in the stats of its channel, see `CRMessageBase::ChannelStats`.
+    static void RunCallback(
+        const SubscriptionInfo&            info,
+        const CRMessageBasePtr&            message,
+        const CRMessageBase::DispatchInfo& dispatch,
+        JobAliveTokenPtr&&                 token) {
+        CRMessageBase::RecordCallbackStart(dispatch);
+        info.callback_(message, std::move(token));
+    }
+
+    // The callback and the message are kept alive until the coroutine finishes, and so is the alive token.
+    template<class callback_t, class message_t>
+    static Task<void> RunCoroutineCallback(
+        std::shared_ptr<callback_t>       callback,
+        std::shared_ptr<message_t>        message,
+        [[maybe_unused]] JobAliveTokenPtr alive_token) {
+        co_await (*callback)(message);
+    }
+
+    template<CRMessageType message_t, CRSingleMessageCallbackType<message_t> callback_t>
+    static erased_callback_t EraseCallback(callback_t&& callback);
+
+    template<CRMessageType message_t, CRMessageWithAliveTokenCallbackType<message_t> callback_t>
+    static erased_callback_t EraseCallback(callback_t&& callback);
+
+    template<CRMessageType message_t, CRCoroutineMessageCallbackType<message_t> callback_t>
+    static erased_callback_t EraseCallback(callback_t&& callback);
 
-    JobRunnerStrandPtr MakeStrand();
+    // Replace the message in the slot, and add a job to deliver it unless there is one in flight. The message stays in
+    // the slot if it returns FULL.
+    static JobRunner::NoWait::State AddLatestMessageToRunner(
+        const std::shared_ptr<const SubscriptionInfo>& info,
+        const CRMessageBasePtr&                        message,
+        const CRMessageBase::DispatchInfo&             dispatch,
+        JobRunner&                                     runner,
+        std::size_t                                    scheduler_hint);
 
-    std::optional<SubscriptionInfo> GetSubscriptionInfo(const CRMessageBasePtr& message);
+    // Add a job for the message in the slot unless there is one in flight, without waiting for room.
+    static JobRunner::NoWait::State ScheduleLatestMessage(
+        const std::shared_ptr<const SubscriptionInfo>& info,
+        JobRunner&                                     runner,
+        std::size_t                                    scheduler_hint);
+
+    // By the job in flight, which may wait for room.
+    static bool ScheduleLatestMessage(const std::shared_ptr<const SubscriptionInfo>& info);
+
+    static void RunLatestMessage(const std::shared_ptr<const SubscriptionInfo>& info, JobAliveTokenPtr&& token);
 
     void SubscribeImpl(
-        const channel_id_t                                                 channel,
-        std::function<void(const CRMessageBasePtr&, JobAliveTokenPtr&&)>&& callback,
-        JobRunnerStrandPtr                                                 strand);
-
-    std::string               name_;
-    bool                      can_subscribe_{false};
-    std::vector<channel_id_t> subscribed_;
-    callback_map_t            callbacks_;
-    std::weak_ptr<JobRunner>  runner_weak_;
+        const channel_id_t  channel,
+        erased_callback_t&& callback,
+        JobRunnerStrandPtr  strand,
+        JobRunner::Priority priority,
+        bool                latest_only);
+
+    void SubscribeRangeImpl(
+        const channel_range_t      range,
+        erased_callback_t&&        callback,
+        const SubscriptionOptions& options);
+
+    std::string                  name_;
+    bool                         can_subscribe_{false};
+    std::vector<channel_id_t>    subscribed_;
+    std::vector<channel_range_t> subscribed_ranges_;
+    // Updated like the subscription map of messages, see `CRMessageBase::SubscriptionWriteLock`.
+    RcuPtr<callback_map_t>       callbacks_;
+    std::weak_ptr<JobRunner>     runner_weak_;
 };
 
+struct CRMessageBase::Subscriber {
+    CRNode*                                         node_;
+    std::shared_ptr<const CRNode::SubscriptionInfo> info_;
+};
+
+struct CRMessageBase::RangeSubscriber {
+    CRNode*      node_;
+    ChannelRange range_;
+    // The subscription of each channel in the range, shared by them unless each has a strand or a latest message slot
+    // of its own.
+    std::function<std::shared_ptr<const CRNode::SubscriptionInfo>()> make_info_;
+};
+
+// A handle to publish messages of exactly `message_t` to a channel. The channel and its subscribers are resolved when
+// the handle is made, so publishing looks up nothing, and makes no virtual call. Subscriptions made or removed later
+// still apply. Handles are cheap to copy, and may be used concurrently.
+template<CRMessageType message_t>
+class CRPublisher {
+   public:
+    using channel_subid_t = CRMessageBase::channel_subid_t;
+
+    CRPublisher() = default;
+
+    explicit operator bool() const { return static_cast<bool>(channel_); }
+
+    channel_subid_t GetChannelSubId() const { return channel_subid_; }
+
+    void Publish(std::shared_ptr<message_t>&& message) const {
+        message->SetChannelSubId(channel_subid_);
+        CRMessageBase::Dispatch(*channel_, CRMessageBasePtr(std::move(message)));
+    }
+
+   private:
+    friend class CRNode;
+
+    CRPublisher(const channel_subid_t channel_subid, std::shared_ptr<CRMessageBase::Channel> channel)
+        : channel_subid_(channel_subid)
+        , channel_(std::move(channel)) {}
+
+    channel_subid_t                         channel_subid_{CRMessageBase::kDefaultChannelSubID};
+    std::shared_ptr<CRMessageBase::Channel> channel_;
+};
+
+template<CRMessageType message_t>
+CRPublisher<message_t> CRNode::MakePublisher(const channel_subid_t channel_subid) {
+    return CRPublisher<message_t>(
+        channel_subid,
+        CRMessageBase::GetChannel(CRMessageBase::MakeChannelId<message_t>(channel_subid)));
+}
+
 template<class node_t>
 concept CRNodeType = std::is_base_of_v<CRNode, node_t>;
 
 template<class strand_job_t>
-bool CRNode::AddJobToRunner(strand_job_t&& job, JobRunnerStrandPtr strand) {
+bool CRNode::AddJobToRunner(strand_job_t&& job, JobRunnerStrandPtr strand, JobRunner::Priority priority) {
     if (auto runner = runner_weak_.lock()) [[likely]] {
-        return runner->AddJob(std::forward<strand_job_t>(job), std::move(strand));
+        return runner->AddJob(std::forward<strand_job_t>(job), std::move(strand), priority);
     } else {
         LOG(ERROR) << __func__ << ": Node \"" << GetName() << "\"(at 0x" << std::hex
                    << reinterpret_cast<std::uintptr_t>(this) << ") has not bound with any runner." << std::dec;
@@ -127,24 +414,32 @@ bool CRNode::AddJobToRunner(strand_job_t&& job, JobRunnerStrandPtr strand) {
     }
 }
 
+template<CRMessageType message_t, CRSingleMessageCallbackType<message_t> callback_t>
+CRNode::erased_callback_t CRNode::EraseCallback(callback_t&& callback) {
+    return [callback = std::forward<callback_t>(callback)](const CRMessageBasePtr& message, JobAliveTokenPtr&&) {
+        callback(reinterpret_cast<const std::shared_ptr<message_t>&>(message));
+    };
+}
+
 template<CRMessageType message_t, CRMessageWithAliveTokenCallbackType<message_t> callback_t>
-void CRNode::Subscribe(const channel_subid_t channel_subid, callback_t&& callback, JobRunnerStrandPtr strand) {
-    return SubscribeImpl(
-        std::make_pair(static_cast<std::type_index>(typeid(message_t)), channel_subid),
-        [callback = std::forward<callback_t>(callback)](const CRMessageBasePtr& message, JobAliveTokenPtr&& token) {
-            callback(reinterpret_cast<const std::shared_ptr<message_t>&>(message), std::move(token));
-        },
-        std::move(strand));
+CRNode::erased_callback_t CRNode::EraseCallback(callback_t&& callback) {
+    return [callback = std::forward<callback_t>(callback)](const CRMessageBasePtr& message, JobAliveTokenPtr&& token) {
+        callback(reinterpret_cast<const std::shared_ptr<message_t>&>(message), std::move(token));
+    };
 }
 
-template<CRMessageType message_t, CRSingleMessageCallbackType<message_t> callback_t>
-void CRNode::Subscribe(const channel_subid_t channel_subid, callback_t&& callback, JobRunnerStrandPtr strand) {
-    return SubscribeImpl(
-        std::make_pair(static_cast<std::type_index>(typeid(message_t)), channel_subid),
-        [callback = std::forward<callback_t>(callback)](const CRMessageBasePtr& message, JobAliveTokenPtr&&) {
-            callback(reinterpret_cast<const std::shared_ptr<message_t>&>(message));
-        },
-        std::move(strand));
+template<CRMessageType message_t, CRCoroutineMessageCallbackType<message_t> callback_t>
+CRNode::erased_callback_t CRNode::EraseCallback(callback_t&& callback) {
+    // Shared by the running coroutines, since a coroutine may outlive the job starting it, which keeps the subscription
+    // entry, along with the callback, only until it returns.
+    auto shared_callback = std::make_shared<std::decay_t<callback_t>>(std::forward<callback_t>(callback));
+    return [shared_callback = std::move(shared_callback)](const CRMessageBasePtr& message, JobAliveTokenPtr&& token) {
+        RunCoroutineCallback(
+            shared_callback,
+            reinterpret_cast<const std::shared_ptr<message_t>&>(message),
+            std::move(token))
+            .Detach();
+    };
 }
 
 template<class node_t, CRNodeType base_t = CRNode>
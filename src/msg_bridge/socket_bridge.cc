@@ -0,0 +1,476 @@
+#include "cris/core/msg_bridge/socket_bridge.h"
+
+#include "cris/core/utils/logging.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cris::core {
+
+namespace {
+
+// Frames are "<body size: u32><message num: u32>", followed by the messages, each of which is
+// "<channel key: u64><size: u32><serialized message>". Integers are little-endian.
+constexpr std::size_t kFrameHeaderSize   = 8;
+constexpr std::size_t kMessageHeaderSize = 12;
+
+constexpr std::string_view kTcpScheme  = "tcp://";
+constexpr std::string_view kUnixScheme = "unix://";
+
+template<class int_t>
+void PutInt(char* data, int_t value) {
+    for (std::size_t i = 0; i < sizeof(int_t); ++i) {
+        data[i] = static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+}
+
+template<class int_t>
+int_t GetInt(const char* data) {
+    int_t value = 0;
+    for (std::size_t i = 0; i < sizeof(int_t); ++i) {
+        value |= static_cast<int_t>(static_cast<unsigned char>(data[i])) << (i * 8);
+    }
+    return value;
+}
+
+struct SocketAddress {
+    sockaddr_storage addr_{};
+    socklen_t        addr_len_{0};
+    bool             is_tcp_{false};
+};
+
+std::optional<SocketAddress> ParseAddress(const std::string& address) {
+    SocketAddress socket_address;
+    if (address.starts_with(kUnixScheme)) {
+        const auto path = address.substr(kUnixScheme.size());
+        auto&      addr = reinterpret_cast<sockaddr_un&>(socket_address.addr_);
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            LOG(ERROR) << __func__ << ": Invalid Unix socket path " << path << ".";
+            return std::nullopt;
+        }
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        socket_address.addr_len_ = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+        return socket_address;
+    }
+    if (address.starts_with(kTcpScheme)) {
+        const auto host_port = address.substr(kTcpScheme.size());
+        const auto colon     = host_port.rfind(':');
+        if (colon == std::string::npos) {
+            LOG(ERROR) << __func__ << ": No port in address " << address << ".";
+            return std::nullopt;
+        }
+        auto host = host_port.substr(0, colon);
+        // IPv6 addresses are in brackets.
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2);
+        }
+        const auto port  = host_port.substr(colon + 1);
+        addrinfo   hints = {};
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result  = nullptr;
+        if (const int err = getaddrinfo(host.c_str(), port.c_str(), &hints, &result); err != 0) {
+            LOG(ERROR) << __func__ << ": Failed to resolve address " << address << ", error: " << gai_strerror(err);
+            return std::nullopt;
+        }
+        std::memcpy(&socket_address.addr_, result->ai_addr, result->ai_addrlen);
+        socket_address.addr_len_ = result->ai_addrlen;
+        socket_address.is_tcp_   = true;
+        freeaddrinfo(result);
+        return socket_address;
+    }
+    LOG(ERROR) << __func__ << ": Unknown scheme of address " << address << ".";
+    return std::nullopt;
+}
+
+std::string FormatAddress(const sockaddr_storage& addr) {
+    if (addr.ss_family == AF_UNIX) {
+        return std::string(kUnixScheme) + reinterpret_cast<const sockaddr_un&>(addr).sun_path;
+    }
+    char host[INET6_ADDRSTRLEN] = {};
+    if (addr.ss_family == AF_INET) {
+        const auto& addr_in = reinterpret_cast<const sockaddr_in&>(addr);
+        inet_ntop(AF_INET, &addr_in.sin_addr, host, sizeof(host));
+        return std::string(kTcpScheme) + host + ":" + std::to_string(ntohs(addr_in.sin_port));
+    }
+    const auto& addr_in6 = reinterpret_cast<const sockaddr_in6&>(addr);
+    inet_ntop(AF_INET6, &addr_in6.sin6_addr, host, sizeof(host));
+    return std::string(kTcpScheme) + "[" + host + "]:" + std::to_string(ntohs(addr_in6.sin6_port));
+}
+
+void SetNoDelay(int fd) {
+    const int enabled = 1;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled)) != 0) {
+        PLOG(WARNING) << __func__ << ": Failed to set TCP_NODELAY.";
+    }
+}
+
+bool SendAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        const auto sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+bool ReceiveAll(int fd, char* data, std::size_t size) {
+    while (size > 0) {
+        const auto received = recv(fd, data, size, 0);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+}  // namespace
+
+SocketBridge::SocketBridge(Config config, std::shared_ptr<JobRunner> runner)
+    : Base(std::move(runner)),
+      config_(config),
+      pending_frame_(kFrameHeaderSize) {
+    send_thread_ = std::thread([this]() { SendFrames(); });
+}
+
+SocketBridge::~SocketBridge() {
+    StopMainLoop();
+}
+
+SocketBridge::channel_key_t SocketBridge::GetChannelKey(
+    const std::string&    message_type,
+    const channel_subid_t subid) {
+    // FNV-1a, stable across hosts and builds.
+    channel_key_t key = 0xcbf29ce484222325;
+    for (const auto c : message_type + "#" + std::to_string(subid)) {
+        key = (key ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    return key;
+}
+
+bool SocketBridge::Listen(const std::string& address) {
+    const auto socket_address = ParseAddress(address);
+    if (!socket_address) {
+        return false;
+    }
+    const int fd = socket(socket_address->addr_.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        PLOG(ERROR) << __func__ << ": Failed to create socket.";
+        return false;
+    }
+    if (socket_address->is_tcp_) {
+        const int enabled = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+    }
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&socket_address->addr_), socket_address->addr_len_) != 0 ||
+        listen(fd, 1) != 0) {
+        PLOG(ERROR) << __func__ << ": Failed to listen on " << address << ".";
+        close(fd);
+        return false;
+    }
+    sockaddr_storage bound_addr     = {};
+    socklen_t        bound_addr_len = sizeof(bound_addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&bound_addr), &bound_addr_len);
+
+    std::unique_lock lck(conn_mtx_);
+    WaitForClosingConnection(lck);
+    if (listen_fd_ >= 0 || conn_fd_ >= 0) {
+        LOG(ERROR) << __func__ << ": Bridge is listening or connected already.";
+        close(fd);
+        return false;
+    }
+    listen_fd_      = fd;
+    listen_address_ = FormatAddress(bound_addr);
+    accept_thread_  = std::thread([this, fd]() {
+        while (true) {
+            const int conn_fd = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (conn_fd < 0) {
+                if (!shutdown_flag_.load()) {
+                    PLOG(ERROR) << "SocketBridge: Failed to accept.";
+                }
+                return;
+            }
+            std::unique_lock conn_lck(conn_mtx_);
+            if (!StartConnection(conn_fd)) {
+                return;
+            }
+            // One peer at a time, and the next one is accepted once the connection is closed.
+            pending_cv_.wait(conn_lck, [this]() { return shutdown_flag_.load() || conn_fd_ < 0; });
+        }
+    });
+    return true;
+}
+
+std::string SocketBridge::GetListenAddress() const {
+    std::lock_guard lck(conn_mtx_);
+    return listen_address_;
+}
+
+bool SocketBridge::Connect(const std::string& address) {
+    const auto socket_address = ParseAddress(address);
+    if (!socket_address) {
+        return false;
+    }
+    const int fd = socket(socket_address->addr_.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        PLOG(ERROR) << __func__ << ": Failed to create socket.";
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&socket_address->addr_), socket_address->addr_len_) != 0) {
+        PLOG(ERROR) << __func__ << ": Failed to connect to " << address << ".";
+        close(fd);
+        return false;
+    }
+    // Checked along with starting the connection, against concurrent calls.
+    std::unique_lock lck(conn_mtx_);
+    WaitForClosingConnection(lck);
+    if (listen_fd_ >= 0 || conn_fd_ >= 0) {
+        LOG(ERROR) << __func__ << ": Bridge is listening or connected already.";
+        close(fd);
+        return false;
+    }
+    return StartConnection(fd);
+}
+
+void SocketBridge::WaitForClosingConnection(std::unique_lock<std::mutex>& lck) {
+    // Released by the receiving thread shortly, see `ReceiveFrames`.
+    pending_cv_.wait(lck, [this]() { return conn_fd_ < 0 || connected_.load(); });
+}
+
+bool SocketBridge::StartConnection(int fd) {
+    if (shutdown_flag_.load()) {
+        close(fd);
+        return false;
+    }
+    sockaddr_storage addr     = {};
+    socklen_t        addr_len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0 && addr.ss_family != AF_UNIX) {
+        SetNoDelay(fd);
+    }
+    if (receive_thread_.joinable()) {
+        // The previous connection is closed, whose receiving thread exits right after resetting `conn_fd_`.
+        receive_thread_.join();
+    }
+    conn_fd_ = fd;
+    connected_.store(true);
+    receive_thread_ = std::thread([this, fd]() { ReceiveFrames(fd); });
+    pending_cv_.notify_all();
+    return true;
+}
+
+void SocketBridge::AddPendingMessage(const channel_key_t channel_key, const std::string& serialized_message) {
+    std::unique_lock lck(conn_mtx_);
+    const auto       offset = pending_frame_.size();
+    if (offset + kMessageHeaderSize + serialized_message.size() > config_.max_pending_bytes_) {
+        lck.unlock();
+        const auto dropped_message_num = dropped_message_num_.fetch_add(1, std::memory_order::relaxed) + 1;
+        LOG_EVERY_N(WARNING, 1000) << "SocketBridge: Too many messages pending, dropped " << dropped_message_num
+                                   << " in total.";
+        return;
+    }
+    pending_frame_.resize(offset + kMessageHeaderSize + serialized_message.size());
+    PutInt<std::uint64_t>(&pending_frame_[offset], channel_key);
+    PutInt<std::uint32_t>(&pending_frame_[offset + 8], static_cast<std::uint32_t>(serialized_message.size()));
+    std::memcpy(&pending_frame_[offset + kMessageHeaderSize], serialized_message.data(), serialized_message.size());
+    if (pending_message_num_++ == 0) {
+        first_pending_time_ = std::chrono::steady_clock::now();
+        pending_cv_.notify_all();
+    } else if (pending_frame_.size() - kFrameHeaderSize >= config_.max_batch_bytes_) {
+        pending_cv_.notify_all();
+    }
+}
+
+void SocketBridge::SendFrames() {
+    std::vector<char> frame(kFrameHeaderSize);
+    std::unique_lock  lck(conn_mtx_);
+    while (true) {
+        pending_cv_.wait(lck, [this]() {
+            return shutdown_flag_.load() || (connected_.load() && pending_message_num_ > 0);
+        });
+        if (shutdown_flag_.load()) {
+            return;
+        }
+        // Wait for more messages to batch, until the frame is full, or the oldest message is due.
+        pending_cv_.wait_until(lck, first_pending_time_ + config_.max_batch_delay_, [this]() {
+            return shutdown_flag_.load() || pending_frame_.size() - kFrameHeaderSize >= config_.max_batch_bytes_;
+        });
+        if (shutdown_flag_.load()) {
+            return;
+        }
+        // Reuse the buffers of both frames.
+        frame.swap(pending_frame_);
+        pending_frame_.resize(kFrameHeaderSize);
+        const auto message_num = pending_message_num_;
+        pending_message_num_   = 0;
+        const int  fd          = conn_fd_;
+        // The socket stays open while being sent to, see `ReceiveFrames`.
+        sending_ = true;
+        lck.unlock();
+
+        PutInt<std::uint32_t>(&frame[0], static_cast<std::uint32_t>(frame.size() - kFrameHeaderSize));
+        PutInt<std::uint32_t>(&frame[4], message_num);
+        if (SendAll(fd, frame.data(), frame.size())) {
+            sent_message_num_.fetch_add(message_num, std::memory_order::relaxed);
+            sent_frame_num_.fetch_add(1, std::memory_order::relaxed);
+        } else {
+            if (!shutdown_flag_.load()) {
+                PLOG(ERROR) << __func__ << ": Failed to send, the connection is closed.";
+            }
+            dropped_message_num_.fetch_add(message_num, std::memory_order::relaxed);
+            CloseConnection();
+        }
+        frame.resize(kFrameHeaderSize);
+        lck.lock();
+        sending_ = false;
+        pending_cv_.notify_all();
+    }
+}
+
+void SocketBridge::ReceiveFrames(int fd) {
+    struct ReceivedMessage {
+        std::shared_ptr<const receive_t> receive_;
+        std::size_t                      offset_;
+        std::size_t                      size_;
+    };
+
+    std::vector<char>            frame;
+    std::vector<ReceivedMessage> received_messages;
+    char                         frame_header[kFrameHeaderSize];
+    while (ReceiveAll(fd, frame_header, kFrameHeaderSize)) {
+        const auto frame_size  = GetInt<std::uint32_t>(&frame_header[0]);
+        const auto message_num = GetInt<std::uint32_t>(&frame_header[4]);
+        if (frame_size > config_.max_pending_bytes_) [[unlikely]] {
+            LOG(ERROR) << __func__ << ": Frame of " << frame_size << " bytes is larger than "
+                       << config_.max_pending_bytes_ << " bytes, closing the connection.";
+            break;
+        }
+        frame.resize(frame_size);
+        if (!ReceiveAll(fd, frame.data(), frame_size)) {
+            break;
+        }
+        // The imported channels are looked up under the lock, and published after it is released.
+        std::unique_lock lck(imports_mtx_);
+        std::size_t      offset     = 0;
+        std::size_t      parsed_num = 0;
+        for (std::uint32_t i = 0; i < message_num; ++i) {
+            if (offset + kMessageHeaderSize > frame_size) [[unlikely]] {
+                LOG(ERROR) << __func__ << ": Malformed frame.";
+                break;
+            }
+            const auto channel_key  = GetInt<std::uint64_t>(&frame[offset]);
+            const auto message_size = GetInt<std::uint32_t>(&frame[offset + 8]);
+            offset += kMessageHeaderSize;
+            if (offset + message_size > frame_size) [[unlikely]] {
+                LOG(ERROR) << __func__ << ": Malformed frame.";
+                break;
+            }
+            if (const auto itr = imports_.find(channel_key); itr != imports_.end()) {
+                received_messages.push_back({.receive_ = itr->second, .offset_ = offset, .size_ = message_size});
+            }
+            offset += message_size;
+            ++parsed_num;
+        }
+        lck.unlock();
+        for (const auto& message : received_messages) {
+            (*message.receive_)(std::string(&frame[message.offset_], message.size_));
+        }
+        received_messages.clear();
+        received_message_num_.fetch_add(parsed_num, std::memory_order::relaxed);
+    }
+    if (!shutdown_flag_.load()) {
+        LOG(INFO) << __func__ << ": The connection is closed.";
+    }
+
+    std::unique_lock lck(conn_mtx_);
+    // Wakes up the sending thread, which gives up the socket before it is closed, since the descriptor may be reused
+    // by the next connection.
+    shutdown(fd, SHUT_RDWR);
+    connected_.store(false);
+    pending_cv_.wait(lck, [this]() { return !sending_; });
+    close(fd);
+    conn_fd_ = -1;
+    pending_cv_.notify_all();
+}
+
+void SocketBridge::AddImport(const channel_key_t channel_key, receive_t&& receive) {
+    auto            shared_receive = std::make_shared<const receive_t>(std::move(receive));
+    std::lock_guard lck(imports_mtx_);
+    imports_[channel_key] = std::move(shared_receive);
+}
+
+void SocketBridge::CloseConnection() {
+    std::lock_guard lck(conn_mtx_);
+    if (conn_fd_ >= 0) {
+        // Wakes up the receiving thread, which closes the socket, see `ReceiveFrames`.
+        shutdown(conn_fd_, SHUT_RDWR);
+    }
+    connected_.store(false);
+}
+
+void SocketBridge::StopMainLoop() {
+    {
+        std::lock_guard lck(conn_mtx_);
+        shutdown_flag_.store(true);
+        if (listen_fd_ >= 0) {
+            shutdown(listen_fd_, SHUT_RDWR);
+        }
+        if (conn_fd_ >= 0) {
+            shutdown(conn_fd_, SHUT_RDWR);
+        }
+        pending_cv_.notify_all();
+    }
+    for (auto* thread : {&send_thread_, &accept_thread_, &receive_thread_}) {
+        if (thread->joinable()) {
+            thread->join();
+        }
+    }
+    std::lock_guard lck(conn_mtx_);
+    for (auto* fd : {&listen_fd_, &conn_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    connected_.store(false);
+}
+
+SocketBridge::Stats SocketBridge::GetStats() const {
+    return {
+        .sent_message_num_     = sent_message_num_.load(std::memory_order::relaxed),
+        .sent_frame_num_       = sent_frame_num_.load(std::memory_order::relaxed),
+        .received_message_num_ = received_message_num_.load(std::memory_order::relaxed),
+        .dropped_message_num_  = dropped_message_num_.load(std::memory_order::relaxed),
+    };
+}
+
+}  // namespace cris::core
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "cris/core/msg/message.h"
+#include "cris/core/msg/node.h"
+#include "cris/core/sched/job_runner.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cris::core {
+
+// Forward messages to a peer bridge over a TCP or Unix socket, e.g. to another host, where they are published again.
+// Messages are serialized with `MessageToStr` and `MessageFromStr`, see `CRSerializableMessageType`.
+//
+// Messages of the exported channels are batched into frames, which are sent once they reach `max_batch_bytes_`, or the
+// oldest message in them has waited for `max_batch_delay_`, whichever comes first. Sockets are TCP_NODELAY, so the
+// batching here decides the latency instead of Nagle's algorithm. Frames are received by a thread of the bridge, and
+// the messages of the imported channels are published in this process.
+//
+// A bridge talks to one peer at a time, either connected to it, or accepted from it. Once the connection is closed,
+// the bridge connects again with `Connect`, or accepts the next peer if listening. Messages exported while not
+// connected wait, up to `max_pending_bytes_`.
+class SocketBridge : public CRNamedNode<SocketBridge> {
+   public:
+    using Base = CRNamedNode<SocketBridge>;
+
+    struct Config {
+        // Zero for sending each message on its own, unless more are waiting while the previous frame is being sent.
+        std::size_t              max_batch_bytes_{64 << 10};
+        std::chrono::nanoseconds max_batch_delay_{std::chrono::microseconds(100)};
+        // Messages exported beyond this are dropped, while not connected or when the peer is not keeping up. Also the
+        // limit of frames received, beyond which the connection is closed, so it should be the same on both sides.
+        std::size_t max_pending_bytes_{16 << 20};
+    };
+
+    struct Stats {
+        std::size_t sent_message_num_{0};
+        std::size_t sent_frame_num_{0};
+        std::size_t received_message_num_{0};
+        std::size_t dropped_message_num_{0};
+    };
+
+    explicit SocketBridge(Config config, std::shared_ptr<JobRunner> runner);
+
+    SocketBridge(const SocketBridge&)            = delete;
+    SocketBridge(SocketBridge&&)                 = delete;
+    SocketBridge& operator=(const SocketBridge&) = delete;
+    SocketBridge& operator=(SocketBridge&&)      = delete;
+
+    ~SocketBridge() override;
+
+    // Addresses are "tcp://<host>:<port>" or "unix://<path>".
+    //
+    // Listen on the address, and accept the first peer in the background. With port 0, a free port is picked, see
+    // `GetListenAddress`.
+    bool Listen(const std::string& address);
+
+    // The address listened on, with the actual port.
+    std::string GetListenAddress() const;
+
+    bool Connect(const std::string& address);
+
+    bool IsConnected() const { return connected_.load(); }
+
+    // Send the messages of the channel published in this process to the peer.
+    template<CRSerializableMessageType message_t>
+    void Export(const channel_subid_t subid);
+
+    // Publish the messages of the channel from the peer to `local_subid` in this process. A channel must not be both
+    // exported and imported to the same sub ID, otherwise the messages would go back and forth.
+    template<CRSerializableMessageType message_t>
+    void Import(const channel_subid_t subid, const channel_subid_t local_subid);
+
+    template<CRSerializableMessageType message_t>
+    void Import(const channel_subid_t subid) {
+        Import<message_t>(subid, subid);
+    }
+
+    // Stop sending and receiving, and close the sockets.
+    void StopMainLoop() override;
+
+    Stats GetStats() const;
+
+   private:
+    using channel_key_t = std::uint64_t;
+    using receive_t     = std::function<void(std::string&& serialized_message)>;
+
+    // Identifies a channel on both sides, without sending the type name with each message.
+    static channel_key_t GetChannelKey(const std::string& message_type, const channel_subid_t subid);
+
+    void AddPendingMessage(const channel_key_t channel_key, const std::string& serialized_message);
+
+    void AddImport(const channel_key_t channel_key, receive_t&& receive);
+
+    // The connection may be closed but not released yet, while not connected any more.
+    void WaitForClosingConnection(std::unique_lock<std::mutex>& lck);
+
+    // Once connected, with `conn_mtx_` held. The socket is closed if the bridge is stopping.
+    bool StartConnection(int fd);
+
+    void SendFrames();
+
+    void ReceiveFrames(int fd);
+
+    void CloseConnection();
+
+    const Config config_;
+
+    mutable std::mutex      conn_mtx_;
+    int                     listen_fd_{-1};
+    int                     conn_fd_{-1};
+    std::string             listen_address_;
+    std::atomic<bool>       connected_{false};
+    std::atomic<bool>       shutdown_flag_{false};
+    std::thread             accept_thread_;
+    std::thread             receive_thread_;
+    std::thread             send_thread_;
+    std::condition_variable pending_cv_;
+
+    // Guarded by `conn_mtx_`. The frame being batched, starting with the space for its header.
+    std::vector<char>                     pending_frame_;
+    std::uint32_t                         pending_message_num_{0};
+    std::chrono::steady_clock::time_point first_pending_time_;
+    // Guarded by `conn_mtx_`. Whether the sending thread is using the socket, which is not closed meanwhile.
+    bool                                  sending_{false};
+
+    // Shared, so that messages are published without holding `imports_mtx_`.
+    std::mutex                                                          imports_mtx_;
+    std::unordered_map<channel_key_t, std::shared_ptr<const receive_t>> imports_;
+
+    std::atomic<std::size_t> sent_message_num_{0};
+    std::atomic<std::size_t> sent_frame_num_{0};
+    std::atomic<std::size_t> received_message_num_{0};
+    std::atomic<std::size_t> dropped_message_num_{0};
+};
+
+template<CRSerializableMessageType message_t>
+void SocketBridge::Export(const channel_subid_t subid) {
+    const auto channel_key = GetChannelKey(GetTypeName<message_t>(), subid);
+    // Sequentially, so that the messages are sent in order.
+    Subscribe<message_t>(
+        subid,
+        [this, channel_key, &channel = CRMessageBase::ResolveChannel<message_t>(subid)](
+            const std::shared_ptr<message_t>& message) {
+            const std::string serialized_message = MessageToStr(*message);
+            CRMessageBase::AddSerializedBytes(channel, serialized_message.size());
+            AddPendingMessage(channel_key, serialized_message);
+        },
+        SubscriptionOptions{.allow_concurrency_ = false});
+}
+
+template<CRSerializableMessageType message_t>
+void SocketBridge::Import(const channel_subid_t subid, const channel_subid_t local_subid) {
+    AddImport(
+        GetChannelKey(GetTypeName<message_t>(), subid),
+        [publisher = MakePublisher<message_t>(local_subid)](std::string&& serialized_message) {
+            auto message = std::make_shared<message_t>();
+            MessageFromStr(*message, serialized_message);
+            publisher.Publish(std::move(message));
+        });
+}
+
+}  // namespace cris::core
@@ -31,7 +31,7 @@ namespace cris::core {
 MessageRecorder::MessageRecorder(RecorderConfig recorder_config, std::shared_ptr<JobRunner> runner)
     : Base(std::move(runner))
     , recorder_config_(std::move(recorder_config))
-    , record_strand_(MakeStrand())
+    , record_strand_(MakeStrand({.max_batch_ = kRecordStrandMaxBatch, .max_time_ = kRecordStrandMaxTime}))
     , snapshot_thread_(std::thread([this] { SnapshotWorker(); })) {
 }
 
@@ -74,6 +74,10 @@ class MessageRecorder : public CRNamedNode<MessageRecorder> {
 
     static std::string SnapshotDirNameGenerator();
 
+    // Messages come in bursts, let the worker write a batch of them in a row.
+    static constexpr std::size_t              kRecordStrandMaxBatch = 64;
+    static constexpr std::chrono::nanoseconds kRecordStrandMaxTime  = std::chrono::milliseconds(1);
+
     const RecorderConfig                         recorder_config_;
     std::vector<std::unique_ptr<RecordFile>>     files_;
     std::shared_ptr<cris::core::JobRunnerStrand> record_strand_;
@@ -94,7 +98,12 @@ void MessageRecorder::RegisterChannel(const MessageRecorder::channel_subid_t sub
     auto* record_file = CreateFile(GetTypeName<message_t>(), subid, alias);
     this->Subscribe<message_t>(
         subid,
-        [record_file](const std::shared_ptr<message_t>& message) { record_file->Write(MessageToStr(*message)); },
+        [record_file, &channel = CRMessageBase::ResolveChannel<message_t>(subid)](
+            const std::shared_ptr<message_t>& message) {
+            auto serialized_message = MessageToStr(*message);
+            CRMessageBase::AddSerializedBytes(channel, serialized_message.size());
+            record_file->Write(std::move(serialized_message));
+        },
         record_strand_);
 }
 
@@ -0,0 +1,203 @@
+#include "cris/core/msg_shm/ring.h"
+
+#include "cris/core/utils/logging.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace cris::core {
+
+// Initialized by the process creating the ring, while holding the file lock, with the magic number written last.
+struct ShmRing::Header {
+    std::uint64_t magic_;
+    std::uint64_t slot_num_;
+    std::uint64_t slot_size_;
+
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> write_position_;
+
+    // The futex word, increased by each message written.
+    alignas(kCacheLineSize) std::atomic<std::uint32_t> notify_seq_;
+    std::atomic<std::uint32_t> waiter_num_;
+};
+
+namespace {
+
+// "CRISRNG" and the version of the layout.
+constexpr std::uint64_t kShmRingMagic = 0x43524953524e4701;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free);
+
+std::size_t RoundUp(std::size_t size, std::size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+std::string GetShmName(const std::string& name) {
+    return name.starts_with('/') ? name : "/" + name;
+}
+
+// Unlocks and closes the file on destruction. Closing alone does not release the lock while the file is mapped.
+struct FileCloser {
+    ~FileCloser() {
+        flock(fd_, LOCK_UN);
+        close(fd_);
+    }
+
+    int fd_;
+};
+
+}  // namespace
+
+ShmRing::ShmRing(Config config, void* data, std::size_t size) : config_(config), data_(data), size_(size) {
+}
+
+ShmRing::~ShmRing() {
+    munmap(data_, size_);
+}
+
+std::unique_ptr<ShmRing> ShmRing::Open(const std::string& name, Config config) {
+    if (config.slot_num_ == 0) {
+        LOG(ERROR) << __func__ << ": Ring " << name << " has no slot.";
+        return nullptr;
+    }
+    const auto slot_stride = sizeof(Slot) + RoundUp(config.slot_size_, kCacheLineSize);
+    const auto size        = RoundUp(sizeof(Header), kCacheLineSize) + slot_stride * config.slot_num_;
+
+    const auto shm_name = GetShmName(name);
+    const int  fd       = shm_open(shm_name.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0) {
+        PLOG(ERROR) << __func__ << ": Failed to open shared memory " << shm_name << ".";
+        return nullptr;
+    }
+    FileCloser closer{.fd_ = fd};
+    if (flock(fd, LOCK_EX) != 0) {
+        PLOG(ERROR) << __func__ << ": Failed to lock shared memory " << shm_name << ".";
+        return nullptr;
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0) {
+        PLOG(ERROR) << __func__ << ": Failed to stat shared memory " << shm_name << ".";
+        return nullptr;
+    }
+    const bool created = file_stat.st_size == 0;
+    if (created && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        PLOG(ERROR) << __func__ << ": Failed to resize shared memory " << shm_name << ".";
+        return nullptr;
+    }
+    if (!created && static_cast<std::size_t>(file_stat.st_size) != size) {
+        LOG(ERROR) << __func__ << ": Shared memory " << shm_name << " has " << file_stat.st_size
+                   << " bytes, instead of " << size << " bytes of the config.";
+        return nullptr;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        PLOG(ERROR) << __func__ << ": Failed to map shared memory " << shm_name << ".";
+        return nullptr;
+    }
+    std::unique_ptr<ShmRing> ring(new ShmRing(config, data, size));
+
+    // The file is zero-filled when resized, i.e. the atomics are initialized as well.
+    auto* header = static_cast<Header*>(data);
+    if (created) {
+        header->slot_num_  = config.slot_num_;
+        header->slot_size_ = config.slot_size_;
+        header->magic_     = kShmRingMagic;
+    } else if (
+        header->magic_ != kShmRingMagic || header->slot_num_ != config.slot_num_ ||
+        header->slot_size_ != config.slot_size_) {
+        LOG(ERROR) << __func__ << ": Shared memory " << shm_name << " is not a ring of the config.";
+        return nullptr;
+    }
+    return ring;
+}
+
+bool ShmRing::Unlink(const std::string& name) {
+    const auto shm_name = GetShmName(name);
+    if (shm_unlink(shm_name.c_str()) != 0) {
+        PLOG(WARNING) << __func__ << ": Failed to unlink shared memory " << shm_name << ".";
+        return false;
+    }
+    return true;
+}
+
+ShmRing::Slot& ShmRing::GetSlot(std::uint64_t position) const {
+    const auto slot_stride = sizeof(Slot) + RoundUp(config_.slot_size_, kCacheLineSize);
+    const auto offset      = RoundUp(sizeof(Header), kCacheLineSize) + slot_stride * (position % config_.slot_num_);
+    return *reinterpret_cast<Slot*>(static_cast<std::byte*>(data_) + offset);
+}
+
+std::uint64_t ShmRing::GetWritePosition() const {
+    return static_cast<const Header*>(data_)->write_position_.load(std::memory_order::acquire);
+}
+
+std::uint64_t ShmRing::ClaimWritePosition() {
+    return static_cast<Header*>(data_)->write_position_.fetch_add(1, std::memory_order::relaxed);
+}
+
+std::uint32_t ShmRing::GetNotifySeq() const {
+    return static_cast<const Header*>(data_)->notify_seq_.load(std::memory_order::seq_cst);
+}
+
+void ShmRing::Notify() {
+    auto* header = static_cast<Header*>(data_);
+    // Pairs with `Wait`. Either the reader sees the new sequence, or the writer sees the reader waiting.
+    header->notify_seq_.fetch_add(1, std::memory_order::seq_cst);
+    if (header->waiter_num_.load(std::memory_order::seq_cst) > 0) {
+        Wake();
+    }
+}
+
+void ShmRing::WakeAll() {
+    // Also for the readers about to sleep.
+    static_cast<Header*>(data_)->notify_seq_.fetch_add(1, std::memory_order::seq_cst);
+    Wake();
+}
+
+void ShmRing::Wake() {
+#if defined(__linux__)
+    auto* header = static_cast<Header*>(data_);
+    syscall(SYS_futex, &header->notify_seq_, FUTEX_WAKE, std::numeric_limits<int>::max(), nullptr, nullptr, 0);
+#endif
+}
+
+void ShmRing::Wait(std::uint32_t notify_seq, std::chrono::nanoseconds timeout) {
+    auto* header = static_cast<Header*>(data_);
+    header->waiter_num_.fetch_add(1, std::memory_order::seq_cst);
+    if (header->notify_seq_.load(std::memory_order::seq_cst) == notify_seq) {
+#if defined(__linux__)
+        // Not a private futex, which would only work within the process.
+        const auto     seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        const timespec futex_timeout{
+            .tv_sec  = static_cast<std::time_t>(seconds.count()),
+            .tv_nsec = static_cast<long>((timeout - seconds).count()),
+        };
+        syscall(SYS_futex, &header->notify_seq_, FUTEX_WAIT, notify_seq, &futex_timeout, nullptr, 0);
+#else
+        constexpr auto kPollInterval = std::chrono::microseconds(100);
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, kPollInterval));
+#endif
+    }
+    header->waiter_num_.fetch_sub(1, std::memory_order::relaxed);
+}
+
+}  // namespace cris::core
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace cris::core {
+
+// A ring of fixed-size slots in named shared memory, i.e. /dev/shm on Linux, written by any number of processes, and
+// read by any number of readers, each of which sees every message on its own. Writers never wait for readers, so a
+// reader falling more than a ring behind loses the messages overwritten meanwhile.
+//
+// Slots are versioned like seqlocks. A reader copies a message out of its slot, then checks that the slot was not
+// overwritten during the copy. Idle readers sleep on a futex in the shared memory, and writers make the syscall to
+// wake them up only if any of them is sleeping.
+//
+// Writers claim positions in turn, and write the slots without locks. A writer falling a whole ring behind, e.g.
+// preempted in the middle of writing, may claim the same slot as a writer a ring ahead. Only one of them writes it, and
+// the other drops its message, see `Write`.
+//
+// A writer dying in the middle of writing, or dropping a message that way, stalls the readers at its position, until
+// the slot is overwritten a ring later.
+class ShmRing {
+   public:
+    struct Config {
+        std::size_t slot_num_{1024};
+        // The maximum size of messages.
+        std::size_t slot_size_{4096};
+    };
+
+    enum class ReadStatus {
+        kRead = 0,
+        // No message written at the position yet.
+        kNoMessage,
+        // The message at the position is still being written.
+        kWriting,
+        // The message at the position was overwritten before or during reading. The position is moved forward to the
+        // oldest message still in the ring.
+        kOverwritten,
+    };
+
+    ShmRing(const ShmRing&)            = delete;
+    ShmRing(ShmRing&&)                 = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+    ShmRing& operator=(ShmRing&&)      = delete;
+
+    ~ShmRing();
+
+    // Open the ring of the name, or create it if it does not exist. Null if failed, e.g. it exists with another config.
+    static std::unique_ptr<ShmRing> Open(const std::string& name, Config config);
+
+    // Remove the name, so that it is created again when opened next time. Opened rings stay valid.
+    static bool Unlink(const std::string& name);
+
+    const Config& GetConfig() const { return config_; }
+
+    // Write a message of `size` bytes by `fill(void* data)`, and wake up the sleeping readers. Returns false if it does
+    // not fit in a slot, or if the slot is taken by a writer a ring apart.
+    template<class fill_t>
+    bool Write(std::size_t size, fill_t&& fill);
+
+    // Where a new reader starts, i.e. the position of the next message to be written.
+    std::uint64_t GetWritePosition() const;
+
+    // Read the message at the position by `read(const void* data, std::size_t size)`, and move the position to the
+    // next one. The slot may be overwritten while it is being read, so `read` may only copy the data, and must discard
+    // the copy unless `kRead` is returned.
+    template<class read_t>
+    ReadStatus Read(std::uint64_t& position, read_t&& read) const;
+
+    // Taken before checking for messages, and then passed to `Wait`, so that no message written in between is missed.
+    std::uint32_t GetNotifySeq() const;
+
+    // Sleep until any message is written after the notify sequence was taken, or `WakeAll`, or the timeout.
+    void Wait(std::uint32_t notify_seq, std::chrono::nanoseconds timeout);
+
+    // Wake up all the sleeping readers of the ring, in all processes.
+    void WakeAll();
+
+   private:
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    struct Header;
+
+    // Followed by the data of the message.
+    struct alignas(kCacheLineSize) Slot {
+        // Odd while being written, and even after, so that readers can tell both the state and the position of it.
+        std::atomic<std::uint64_t> seq_;
+        // Read while it may be written, like the data.
+        std::atomic<std::uint64_t> size_;
+
+        std::byte* GetData() { return reinterpret_cast<std::byte*>(this + 1); }
+    };
+
+    ShmRing(Config config, void* data, std::size_t size);
+
+    Slot& GetSlot(std::uint64_t position) const;
+
+    std::uint64_t ClaimWritePosition();
+
+    void Notify();
+
+    void Wake();
+
+    const Config      config_;
+    void* const       data_;
+    const std::size_t size_;
+};
+
+template<class fill_t>
+bool ShmRing::Write(std::size_t size, fill_t&& fill) {
+    if (size > config_.slot_size_) [[unlikely]] {
+        return false;
+    }
+    const auto position = ClaimWritePosition();
+    auto&      slot     = GetSlot(position);
+    // The slot is taken if it is being written by a writer a ring behind, or has been written by one a ring ahead.
+    auto seq = slot.seq_.load(std::memory_order::relaxed);
+    if (seq % 2 == 1 || seq > position * 2 ||
+        !slot.seq_.compare_exchange_strong(seq, position * 2 + 1, std::memory_order::relaxed)) [[unlikely]] {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order::release);
+    slot.size_.store(size, std::memory_order::relaxed);
+    std::forward<fill_t>(fill)(static_cast<void*>(slot.GetData()));
+    slot.seq_.store(position * 2 + 2, std::memory_order::release);
+    Notify();
+    return true;
+}
+
+template<class read_t>
+ShmRing::ReadStatus ShmRing::Read(std::uint64_t& position, read_t&& read) const {
+    auto&      slot         = GetSlot(position);
+    const auto expected_seq = position * 2 + 2;
+    const auto seq_before   = slot.seq_.load(std::memory_order::acquire);
+    if (seq_before < expected_seq) {
+        // Claimed by a writer, which may have not yet marked the slot.
+        if (seq_before + 1 == expected_seq || position < GetWritePosition()) {
+            return ReadStatus::kWriting;
+        }
+        return ReadStatus::kNoMessage;
+    }
+    if (seq_before == expected_seq) {
+        const auto size = slot.size_.load(std::memory_order::relaxed);
+        if (size <= config_.slot_size_) [[likely]] {
+            std::forward<read_t>(read)(static_cast<const void*>(slot.GetData()), static_cast<std::size_t>(size));
+        }
+        std::atomic_thread_fence(std::memory_order::acquire);
+        if (slot.seq_.load(std::memory_order::relaxed) == expected_seq && size <= config_.slot_size_) [[likely]] {
+            ++position;
+            return ReadStatus::kRead;
+        }
+    }
+    const auto write_position = GetWritePosition();
+    const auto oldest_position = write_position > config_.slot_num_ ? write_position - config_.slot_num_ : 0;
+    position                   = std::max<std::uint64_t>(position + 1, oldest_position);
+    return ReadStatus::kOverwritten;
+}
+
+}  // namespace cris::core
@@ -0,0 +1,119 @@
+#include "cris/core/msg_shm/transport.h"
+
+#include "cris/core/utils/logging.h"
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace cris::core {
+
+namespace {
+
+// Within NAME_MAX along with the prefix and the hash.
+constexpr std::size_t kMaxTypeNameLength = 128;
+
+// FNV-1a, stable across processes and builds.
+std::uint64_t HashTypeName(const std::string& type_name) {
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (const auto c : type_name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    return hash;
+}
+
+}  // namespace
+
+ShmTransport::ShmTransport(Config config, std::shared_ptr<JobRunner> runner)
+    : Base(std::move(runner)),
+      config_(std::move(config)) {
+}
+
+ShmTransport::~ShmTransport() {
+    StopMainLoop();
+}
+
+std::string ShmTransport::GetRingName(const std::string& message_type, const channel_subid_t subid) const {
+    // Type names have characters like "::", "<" and spaces, and may be too long for a file name. They are hashed to
+    // tell apart the ones sanitized or truncated to the same.
+    std::ostringstream name;
+    name << config_.name_prefix_ << '.';
+    for (std::size_t i = 0; i < message_type.size() && i < kMaxTypeNameLength; ++i) {
+        const auto c = message_type[i];
+        name << (std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+    }
+    name << '.' << std::hex << std::setw(16) << std::setfill('0') << HashTypeName(message_type) << std::dec << '.'
+         << subid;
+    return name.str();
+}
+
+std::shared_ptr<ShmRing> ShmTransport::OpenRing(
+    const channel_id_t channel,
+    const std::string& name,
+    std::size_t        slot_size) {
+    std::lock_guard lck(rings_mtx_);
+    if (rings_.contains(channel)) {
+        LOG(ERROR) << __func__ << ": Ring " << name << " is exported or imported already.";
+        return nullptr;
+    }
+    std::shared_ptr<ShmRing> ring = ShmRing::Open(name, {.slot_num_ = config_.slot_num_, .slot_size_ = slot_size});
+    if (ring) {
+        rings_.emplace(channel, ring);
+    }
+    return ring;
+}
+
+void ShmTransport::StartReceiving(std::shared_ptr<ShmRing> ring, receive_t&& receive) {
+    // Only the messages written from now on.
+    const auto      position = ring->GetWritePosition();
+    std::lock_guard lck(rings_mtx_);
+    receivers_.emplace_back([this, ring = std::move(ring), position, receive = std::move(receive)]() {
+        ReceiveMessages(*ring, position, receive);
+    });
+}
+
+void ShmTransport::ReceiveMessages(ShmRing& ring, std::uint64_t position, const receive_t& receive) {
+    while (!shutdown_flag_.load(std::memory_order::relaxed)) {
+        const auto notify_seq    = ring.GetNotifySeq();
+        const auto prev_position = position;
+        switch (receive(ring, position)) {
+            case ShmRing::ReadStatus::kRead:
+                break;
+            case ShmRing::ReadStatus::kNoMessage:
+                ring.Wait(notify_seq, config_.wait_timeout_);
+                break;
+            case ShmRing::ReadStatus::kWriting:
+                std::this_thread::yield();
+                break;
+            case ShmRing::ReadStatus::kOverwritten:
+                lost_message_num_.fetch_add(
+                    static_cast<std::size_t>(position - prev_position),
+                    std::memory_order::relaxed);
+                break;
+        }
+    }
+}
+
+void ShmTransport::StopMainLoop() {
+    shutdown_flag_.store(true);
+    std::vector<std::thread> receivers;
+    {
+        std::lock_guard lck(rings_mtx_);
+        for (auto& [channel, ring] : rings_) {
+            ring->WakeAll();
+        }
+        receivers.swap(receivers_);
+    }
+    for (auto& receiver : receivers) {
+        receiver.join();
+    }
+}
+
+}  // namespace cris::core
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "cris/core/msg/message.h"
+#include "cris/core/msg/message_pool.h"
+#include "cris/core/msg/node.h"
+#include "cris/core/msg_shm/ring.h"
+#include "cris/core/utils/logging.h"
+
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cris::core {
+
+// Messages keeping all their data in a trivially copyable `payload_`. They are copied into and out of shared memory
+// as they are, without serialization, and received into a `CRMessagePool`.
+template<class message_t>
+concept CRTrivialMessageType = CRMessageType<message_t> && std::is_default_constructible_v<message_t> &&
+    std::is_trivially_copyable_v<decltype(message_t::payload_)>;
+
+// Publish and subscribe across processes on the same host, through a ring in shared memory per channel, see
+// `ShmRing`. The messages of an exported channel published in this process are written to the ring, and the messages
+// in the ring of an imported channel are published in this process, so that nodes on both sides publish and
+// subscribe as usual.
+//
+// Each imported channel has a thread of its own, sleeping on the futex of the ring when there is no message. A
+// process must not both export and import a channel, otherwise the messages would go around in circles.
+//
+// Messages are copied twice, into the ring when exported, and out of it when imported. Subscribers do not get a view
+// into the slot, since a slot may be overwritten at any time by writers, which never wait for readers. So this
+// transport saves the sockets and the syscalls of the others, but not the copies.
+class ShmTransport : public CRNamedNode<ShmTransport> {
+   public:
+    using Base = CRNamedNode<ShmTransport>;
+
+    struct Config {
+        // Rings are named "<prefix>.<channel>", i.e. processes talk through the transports of the same prefix.
+        std::string name_prefix_{"cris"};
+        std::size_t slot_num_{1024};
+        // The maximum size of serialized messages, while the slots of trivial messages fit their payloads.
+        std::size_t slot_size_{4096};
+        // Received trivial messages are acquired from a pool of this capacity per channel.
+        std::size_t pool_capacity_{64};
+        // The receiving threads wake up at least this often, to see if they are stopped.
+        std::chrono::nanoseconds wait_timeout_{std::chrono::milliseconds(100)};
+    };
+
+    explicit ShmTransport(Config config, std::shared_ptr<JobRunner> runner);
+
+    ShmTransport(const ShmTransport&)            = delete;
+    ShmTransport(ShmTransport&&)                 = delete;
+    ShmTransport& operator=(const ShmTransport&) = delete;
+    ShmTransport& operator=(ShmTransport&&)      = delete;
+
+    ~ShmTransport() override;
+
+    // Write the messages of the channel published in this process to its ring.
+    template<CRMessageType message_t>
+        requires CRTrivialMessageType<message_t> || CRSerializableMessageType<message_t>
+    bool Export(const channel_subid_t subid);
+
+    // Publish the messages written to the ring of the channel by other processes in this process.
+    template<CRMessageType message_t>
+        requires CRTrivialMessageType<message_t> || CRSerializableMessageType<message_t>
+    bool Import(const channel_subid_t subid);
+
+    // Stop receiving the imported channels.
+    void StopMainLoop() override;
+
+    // The number of messages of the imported channels overwritten before being received.
+    std::size_t GetLostMessageNum() const { return lost_message_num_.load(std::memory_order::relaxed); }
+
+    // The name of the ring of the channel, in /dev/shm on Linux. The ring outlives the processes using it, until
+    // removed with `ShmRing::Unlink`.
+    template<CRMessageType message_t>
+    std::string GetRingName(const channel_subid_t subid) const {
+        return GetRingName(GetTypeName<message_t>(), subid);
+    }
+
+   private:
+    using receive_t  = std::function<ShmRing::ReadStatus(ShmRing& ring, std::uint64_t& position)>;
+    using ring_map_t = std::unordered_map<channel_id_t, std::shared_ptr<ShmRing>, boost::hash<channel_id_t>>;
+
+    std::string GetRingName(const std::string& message_type, const channel_subid_t subid) const;
+
+    template<CRMessageType message_t>
+    std::size_t GetSlotSize() const {
+        if constexpr (CRTrivialMessageType<message_t>) {
+            return sizeof(message_t::payload_);
+        } else {
+            return config_.slot_size_;
+        }
+    }
+
+    // Null if the channel is exported or imported already, or the ring fails to open.
+    std::shared_ptr<ShmRing> OpenRing(const channel_id_t channel, const std::string& name, std::size_t slot_size);
+
+    void StartReceiving(std::shared_ptr<ShmRing> ring, receive_t&& receive);
+
+    void ReceiveMessages(ShmRing& ring, std::uint64_t position, const receive_t& receive);
+
+    const Config             config_;
+    std::mutex               rings_mtx_;
+    ring_map_t               rings_;
+    std::vector<std::thread> receivers_;
+    std::atomic<bool>        shutdown_flag_{false};
+    std::atomic<std::size_t> lost_message_num_{0};
+};
+
+template<CRMessageType message_t>
+    requires CRTrivialMessageType<message_t> || CRSerializableMessageType<message_t>
+bool ShmTransport::Export(const channel_subid_t subid) {
+    constexpr bool kIsTrivial = CRTrivialMessageType<message_t>;
+    const auto     channel    = CRMessageBase::MakeChannelId<message_t>(subid);
+    auto           ring       = OpenRing(channel, GetRingName<message_t>(subid), GetSlotSize<message_t>());
+    if (!ring) {
+        return false;
+    }
+    // Sequentially, so that the messages are written in order.
+    Subscribe<message_t>(
+        subid,
+        [ring = std::move(ring), &stats_channel = CRMessageBase::ResolveChannel(channel)](
+            const std::shared_ptr<message_t>& message) {
+            if constexpr (kIsTrivial) {
+                ring->Write(sizeof(message->payload_), [&message](void* data) {
+                    std::memcpy(data, &message->payload_, sizeof(message->payload_));
+                });
+                CRMessageBase::AddSerializedBytes(stats_channel, sizeof(message->payload_));
+            } else {
+                const std::string serialized_message = MessageToStr(*message);
+                CRMessageBase::AddSerializedBytes(stats_channel, serialized_message.size());
+                if (serialized_message.size() > ring->GetConfig().slot_size_) [[unlikely]] {
+                    LOG_EVERY_N(ERROR, 1000) << "ShmTransport::Export: Message of " << serialized_message.size()
+                                             << " bytes does not fit in a slot of " << GetTypeName<message_t>() << ".";
+                    return;
+                }
+                ring->Write(serialized_message.size(), [&serialized_message](void* data) {
+                    std::memcpy(data, serialized_message.data(), serialized_message.size());
+                });
+            }
+        },
+        SubscriptionOptions{.allow_concurrency_ = false});
+    return true;
+}
+
+template<CRMessageType message_t>
+    requires CRTrivialMessageType<message_t> || CRSerializableMessageType<message_t>
+bool ShmTransport::Import(const channel_subid_t subid) {
+    constexpr bool kIsTrivial = CRTrivialMessageType<message_t>;
+    const auto     channel    = CRMessageBase::MakeChannelId<message_t>(subid);
+    auto           ring       = OpenRing(channel, GetRingName<message_t>(subid), GetSlotSize<message_t>());
+    if (!ring) {
+        return false;
+    }
+    auto publisher = MakePublisher<message_t>(subid);
+    if constexpr (kIsTrivial) {
+        auto pool = CRMessagePool<message_t>::MakeMessagePool({.capacity_ = config_.pool_capacity_});
+        StartReceiving(
+            std::move(ring),
+            [publisher = std::move(publisher),
+             pool = std::move(pool),
+             message = std::shared_ptr<message_t>()](ShmRing& shm_ring, std::uint64_t& position) mutable {
+                // Acquired only when there is a message to read, and kept for the next one if the read is discarded.
+                const auto status = shm_ring.Read(position, [&message, &pool](const void* data, std::size_t size) {
+                    if (!message) {
+                        message = pool->Acquire();
+                    }
+                    std::memcpy(&message->payload_, data, std::min(size, sizeof(message->payload_)));
+                });
+                if (status == ShmRing::ReadStatus::kRead) {
+                    publisher.Publish(std::move(message));
+                }
+                return status;
+            });
+    } else {
+        StartReceiving(
+            std::move(ring),
+            [publisher = std::move(publisher),
+             serialized_message = std::string()](ShmRing& shm_ring, std::uint64_t& position) mutable {
+                const auto status = shm_ring.Read(position, [&serialized_message](const void* data, std::size_t size) {
+                    serialized_message.assign(static_cast<const char*>(data), size);
+                });
+                if (status == ShmRing::ReadStatus::kRead) {
+                    auto message = std::make_shared<message_t>();
+                    MessageFromStr(*message, serialized_message);
+                    publisher.Publish(std::move(message));
+                }
+                return status;
+            });
+    }
+    return true;
+}
+
+}  // namespace cris::core
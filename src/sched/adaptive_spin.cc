@@ -0,0 +1,28 @@
+#include "cris/core/sched/adaptive_spin.h"
+
+#include "cris/core/utils/time.h"
+
+#include <algorithm>
+
+namespace cris::core {
+
+AdaptiveSpinPolicy::AdaptiveSpinPolicy(cr_duration_nsec_t max_spin_nsec)
+    : max_spin_nsec_(std::max<cr_duration_nsec_t>(max_spin_nsec, 0))
+    , spin_limit_nsec_(max_spin_nsec_) {
+}
+
+void AdaptiveSpinPolicy::OnIdleEnd(cr_duration_nsec_t idle_nsec) {
+    // Long sleeps say nothing more than that spinning would not have helped, so do not let them dominate the average.
+    idle_nsec = std::clamp<cr_duration_nsec_t>(idle_nsec, 0, 2 * max_spin_nsec_);
+    if (avg_idle_nsec_ < 0) {
+        avg_idle_nsec_ = idle_nsec;
+    } else {
+        avg_idle_nsec_ += (idle_nsec - avg_idle_nsec_) / (1 << kAverageShift);
+    }
+
+    // Jobs usually arrive within the limit, cover most of them by spinning for twice the average. Otherwise park soon.
+    const auto wanted_nsec = avg_idle_nsec_ <= max_spin_nsec_ ? 2 * avg_idle_nsec_ : kMinSpinNsec;
+    spin_limit_nsec_       = std::min(std::max(wanted_nsec, kMinSpinNsec), max_spin_nsec_);
+}
+
+}  // namespace cris::core
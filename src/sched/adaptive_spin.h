@@ -0,0 +1,34 @@
+#pragma once
+
+#include "cris/core/utils/time.h"
+
+namespace cris::core {
+
+// Decides how long an idle worker keeps spinning before parking, from how soon jobs arrived after it went idle
+// recently. Spinning pays off only if the next job arrives before the limit, otherwise it burns the CPU for nothing,
+// and parking right away is cheaper.
+//
+// Not thread-safe, each worker owns one.
+class AdaptiveSpinPolicy {
+   public:
+    // Never spin for longer than `max_spin_nsec`. Until any idle period is observed, spin for that long.
+    explicit AdaptiveSpinPolicy(cr_duration_nsec_t max_spin_nsec);
+
+    // An idle period of `idle_nsec` just ended with a new job, including the time parked.
+    void OnIdleEnd(cr_duration_nsec_t idle_nsec);
+
+    cr_duration_nsec_t SpinLimitNsec() const { return spin_limit_nsec_; }
+
+   private:
+    // Spinning shorter than this is hardly worth it, given the cost of parking and being woken up again.
+    static constexpr cr_duration_nsec_t kMinSpinNsec = 2000;
+
+    // The weight of the latest sample in the moving average is 1/2^kAverageShift.
+    static constexpr int kAverageShift = 3;
+
+    const cr_duration_nsec_t max_spin_nsec_;
+    cr_duration_nsec_t       avg_idle_nsec_{-1};
+    cr_duration_nsec_t       spin_limit_nsec_;
+};
+
+}  // namespace cris::core
@@ -0,0 +1,301 @@
+#include "cris/core/sched/cpu_topology.h"
+
+#include "cris/core/utils/logging.h"
+
+#if defined(CRIS_USE_NUMA) && CRIS_USE_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace cris::core {
+
+namespace fs = std::filesystem;
+
+static std::optional<std::string> ReadFirstLine(const fs::path& path) {
+    std::ifstream file(path);
+    std::string   line;
+    if (!file || !std::getline(file, line)) {
+        return std::nullopt;
+    }
+    return line;
+}
+
+template<class int_t>
+static std::optional<int_t> ParseInt(std::string_view str) {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t' || str.back() == '\n')) {
+        str.remove_suffix(1);
+    }
+    int_t      value{};
+    const auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (result.ec != std::errc() || result.ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// The smallest CPU in the list file, for identifying the group of CPUs sharing something.
+static std::optional<std::size_t> ReadCpuGroup(const fs::path& path) {
+    const auto line = ReadFirstLine(path);
+    if (!line) {
+        return std::nullopt;
+    }
+    const auto cpus = CpuTopology::ParseCpuList(*line);
+    if (cpus.empty()) {
+        return std::nullopt;
+    }
+    return cpus.front();
+}
+
+static std::optional<std::size_t> ReadL3Group(const fs::path& cpu_dir) {
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(cpu_dir / "cache", ec)) {
+        if (entry.path().filename().string().starts_with("index") &&
+            ReadFirstLine(entry.path() / "level") == std::optional<std::string>("3")) {
+            return ReadCpuGroup(entry.path() / "shared_cpu_list");
+        }
+    }
+    return std::nullopt;
+}
+
+static std::optional<int> ReadNumaNode(const fs::path& cpu_dir) {
+    static constexpr std::string_view kNodePrefix = "node";
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(cpu_dir, ec)) {
+        const auto name = entry.path().filename().string();
+        if (name.starts_with(kNodePrefix)) {
+            if (const auto node = ParseInt<int>(std::string_view(name).substr(kNodePrefix.size()))) {
+                return node;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+CpuTopology CpuTopology::Read(const std::string& sysfs_cpu_root) {
+    const fs::path root(sysfs_cpu_root);
+
+    std::vector<std::size_t> cpu_ids;
+    if (const auto online = ReadFirstLine(root / "online")) {
+        cpu_ids = ParseCpuList(*online);
+    } else {
+        static constexpr std::string_view kCpuPrefix = "cpu";
+
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(root, ec)) {
+            const auto name = entry.path().filename().string();
+            if (!name.starts_with(kCpuPrefix)) {
+                continue;
+            }
+            if (const auto cpu_id = ParseInt<std::size_t>(std::string_view(name).substr(kCpuPrefix.size()))) {
+                cpu_ids.push_back(*cpu_id);
+            }
+        }
+        std::sort(cpu_ids.begin(), cpu_ids.end());
+    }
+
+    CpuTopology topology;
+    topology.cpus_.reserve(cpu_ids.size());
+    for (const auto cpu_id : cpu_ids) {
+        const auto cpu_dir = root / ("cpu" + std::to_string(cpu_id));
+
+        Cpu cpu{.id_ = cpu_id};
+        cpu.core_group_ = ReadCpuGroup(cpu_dir / "topology" / "core_cpus_list");
+        if (!cpu.core_group_) {
+            cpu.core_group_ = ReadCpuGroup(cpu_dir / "topology" / "thread_siblings_list");
+        }
+        cpu.l3_group_ = ReadL3Group(cpu_dir);
+        if (const auto package_line = ReadFirstLine(cpu_dir / "topology" / "physical_package_id")) {
+            // Some virtual machines report -1.
+            if (const auto package = ParseInt<int>(*package_line); package && *package >= 0) {
+                cpu.package_ = static_cast<std::size_t>(*package);
+            }
+        }
+        cpu.numa_node_ = ReadNumaNode(cpu_dir);
+        topology.cpus_.push_back(cpu);
+    }
+    return topology;
+}
+
+const CpuTopology& CpuTopology::Get() {
+    static const CpuTopology topology = Read();
+    return topology;
+}
+
+const CpuTopology::Cpu* CpuTopology::FindCpu(std::size_t cpu_id) const {
+    const auto itr = std::lower_bound(cpus_.begin(), cpus_.end(), cpu_id, [](const Cpu& cpu, std::size_t id) {
+        return cpu.id_ < id;
+    });
+    return itr != cpus_.end() && itr->id_ == cpu_id ? &*itr : nullptr;
+}
+
+std::vector<std::size_t> CpuTopology::CpusOfNumaNode(int numa_node) const {
+    std::vector<std::size_t> cpu_ids;
+    for (const auto& cpu : cpus_) {
+        if (cpu.numa_node_ == numa_node) {
+            cpu_ids.push_back(cpu.id_);
+        }
+    }
+    return cpu_ids;
+}
+
+CpuTopology::Distance CpuTopology::GetDistance(std::size_t cpu_id_a, std::size_t cpu_id_b) const {
+    if (cpu_id_a == cpu_id_b) {
+        return Distance::kSameCpu;
+    }
+    const auto* cpu_a = FindCpu(cpu_id_a);
+    const auto* cpu_b = FindCpu(cpu_id_b);
+    if (!cpu_a || !cpu_b) {
+        return Distance::kRemote;
+    }
+    const auto same = [](const auto& group_a, const auto& group_b) { return group_a && group_a == group_b; };
+    if (same(cpu_a->core_group_, cpu_b->core_group_)) {
+        return Distance::kSmt;
+    }
+    if (same(cpu_a->l3_group_, cpu_b->l3_group_)) {
+        return Distance::kL3;
+    }
+    if (same(cpu_a->package_, cpu_b->package_) || same(cpu_a->numa_node_, cpu_b->numa_node_)) {
+        return Distance::kSocket;
+    }
+    return Distance::kRemote;
+}
+
+std::vector<std::size_t> CpuTopology::ParseCpuList(const std::string& cpu_list) {
+    std::vector<std::size_t> cpu_ids;
+    std::string_view         rest(cpu_list);
+    while (!rest.empty()) {
+        const auto comma = rest.find(',');
+        const auto token = rest.substr(0, comma);
+        rest             = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+
+        const auto dash  = token.find('-');
+        const auto first = ParseInt<std::size_t>(token.substr(0, dash));
+        const auto last  = dash == std::string_view::npos ? first : ParseInt<std::size_t>(token.substr(dash + 1));
+        if (!first || !last) {
+            continue;
+        }
+        for (auto cpu_id = *first; cpu_id <= *last; ++cpu_id) {
+            cpu_ids.push_back(cpu_id);
+        }
+    }
+    std::sort(cpu_ids.begin(), cpu_ids.end());
+    cpu_ids.erase(std::unique(cpu_ids.begin(), cpu_ids.end()), cpu_ids.end());
+    return cpu_ids;
+}
+
+bool SetCurrentThreadAffinity(const std::vector<std::size_t>& cpu_ids) {
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const auto cpu_id : cpu_ids) {
+        if (cpu_id >= CPU_SETSIZE) {
+            LOG(WARNING) << __func__ << ": CPU " << cpu_id << " is out of range.";
+            return false;
+        }
+        CPU_SET(cpu_id, &cpu_set);
+    }
+    if (const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set)) {
+        LOG(WARNING) << __func__ << ": Failed to set CPU affinity, error: " << err;
+        return false;
+    }
+    return true;
+#else
+    (void)cpu_ids;
+    return false;
+#endif
+}
+
+bool SetCurrentThreadName(const std::string& name) {
+#if defined(__linux__)
+    static constexpr std::size_t kMaxThreadNameLength = 15;
+    return pthread_setname_np(pthread_self(), name.substr(0, kMaxThreadNameLength).c_str()) == 0;
+#elif defined(__APPLE__)
+    return pthread_setname_np(name.c_str()) == 0;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+#if defined(CRIS_USE_NUMA) && CRIS_USE_NUMA
+static std::size_t NumaNodeMaskBits() {
+    return static_cast<std::size_t>(numa_num_possible_nodes());
+}
+
+static constexpr std::size_t kBitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+
+static std::vector<unsigned long> MakeEmptyNumaNodeMask() {
+    return std::vector<unsigned long>((NumaNodeMaskBits() + kBitsPerWord - 1) / kBitsPerWord, 0);
+}
+
+static std::vector<unsigned long> MakeNumaNodeMask(int numa_node) {
+    auto       nodemask = MakeEmptyNumaNodeMask();
+    const auto node     = static_cast<std::size_t>(numa_node);
+    if (node / kBitsPerWord < nodemask.size()) {
+        nodemask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+    }
+    return nodemask;
+}
+#endif
+
+bool SetCurrentThreadPreferredNumaNode(int numa_node) {
+#if defined(CRIS_USE_NUMA) && CRIS_USE_NUMA
+    if (numa_node < 0 || numa_available() < 0) {
+        return false;
+    }
+    auto nodemask = MakeNumaNodeMask(numa_node);
+    if (set_mempolicy(MPOL_PREFERRED, nodemask.data(), NumaNodeMaskBits() + 1) != 0) {
+        PLOG(WARNING) << __func__ << ": Failed to prefer NUMA node " << numa_node << ".";
+        return false;
+    }
+    return true;
+#else
+    (void)numa_node;
+    return false;
+#endif
+}
+
+ScopedPreferredNumaNode::ScopedPreferredNumaNode(std::optional<int> numa_node) {
+#if defined(CRIS_USE_NUMA) && CRIS_USE_NUMA
+    if (!numa_node || *numa_node < 0 || numa_available() < 0) {
+        return;
+    }
+    prev_nodemask_ = MakeEmptyNumaNodeMask();
+    if (get_mempolicy(&prev_mode_, prev_nodemask_.data(), NumaNodeMaskBits() + 1, nullptr, 0) != 0) {
+        return;
+    }
+    active_ = SetCurrentThreadPreferredNumaNode(*numa_node);
+#else
+    (void)numa_node;
+#endif
+}
+
+ScopedPreferredNumaNode::~ScopedPreferredNumaNode() {
+#if defined(CRIS_USE_NUMA) && CRIS_USE_NUMA
+    if (!active_) {
+        return;
+    }
+    set_mempolicy(prev_mode_, prev_nodemask_.data(), NumaNodeMaskBits() + 1);
+#endif
+}
+
+}  // namespace cris::core
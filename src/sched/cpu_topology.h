@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cris::core {
+
+// The CPU topology of the machine, read from sysfs.
+class CpuTopology {
+   public:
+    // How close two CPUs are, from the closest to the farthest.
+    enum class Distance {
+        kSameCpu = 0,
+        // Hyper-threads of the same physical core.
+        kSmt,
+        // Sharing the same L3 cache, e.g. the same CCX.
+        kL3,
+        // On the same socket.
+        kSocket,
+        kRemote,
+    };
+
+    struct Cpu {
+        std::size_t id_{0};
+        // Groups are identified by the smallest CPU in them. Unknown ones are `std::nullopt`.
+        std::optional<std::size_t> core_group_{};
+        std::optional<std::size_t> l3_group_{};
+        std::optional<std::size_t> package_{};
+        std::optional<int>         numa_node_{};
+    };
+
+    static constexpr auto kSysfsCpuRoot = "/sys/devices/system/cpu";
+
+    // Read the topology of online CPUs. NUMA nodes are from the `node*` entries of each CPU.
+    static CpuTopology Read(const std::string& sysfs_cpu_root = kSysfsCpuRoot);
+
+    // The topology of this machine, read once.
+    static const CpuTopology& Get();
+
+    const std::vector<Cpu>& Cpus() const { return cpus_; }
+
+    // Nullptr if the CPU is unknown.
+    const Cpu* FindCpu(std::size_t cpu_id) const;
+
+    std::vector<std::size_t> CpusOfNumaNode(int numa_node) const;
+
+    // Unknown CPUs are considered remote to all others.
+    Distance GetDistance(std::size_t cpu_id_a, std::size_t cpu_id_b) const;
+
+    // Parse CPU lists in sysfs format, e.g. "0-3,8,10-11".
+    static std::vector<std::size_t> ParseCpuList(const std::string& cpu_list);
+
+   private:
+    // Sorted by ids.
+    std::vector<Cpu> cpus_;
+};
+
+// Pin the current thread to `cpu_ids`. Returns false if it is not supported or fails.
+bool SetCurrentThreadAffinity(const std::vector<std::size_t>& cpu_ids);
+
+// Linux limits thread names to 15 characters, longer ones are truncated.
+bool SetCurrentThreadName(const std::string& name);
+
+// Prefer allocating memory of the current thread from `numa_node`. Returns false if NUMA is not supported.
+bool SetCurrentThreadPreferredNumaNode(int numa_node);
+
+// Prefer allocating memory of the current thread from `numa_node` within the scope, and restore the previous policy
+// on exit. Only the pages touched in the scope for the first time are affected.
+class ScopedPreferredNumaNode {
+   public:
+    explicit ScopedPreferredNumaNode(std::optional<int> numa_node);
+
+    ScopedPreferredNumaNode(const ScopedPreferredNumaNode&)            = delete;
+    ScopedPreferredNumaNode(ScopedPreferredNumaNode&&)                 = delete;
+    ScopedPreferredNumaNode& operator=(const ScopedPreferredNumaNode&) = delete;
+    ScopedPreferredNumaNode& operator=(ScopedPreferredNumaNode&&)      = delete;
+
+    ~ScopedPreferredNumaNode();
+
+   private:
+    bool                       active_{false};
+    int                        prev_mode_{0};
+    std::vector<unsigned long> prev_nodemask_;
+};
+
+}  // namespace cris::core
@@ -0,0 +1,47 @@
+#include "cris/core/sched/job_deadline_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+namespace cris::core {
+
+JobDeadlineQueue::JobDeadlineQueue(std::size_t init_capacity) {
+    heap_.reserve(init_capacity);
+}
+
+void JobDeadlineQueue::Push(job_t&& job, cr_timestamp_nsec_t deadline_nsec) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    heap_.push_back(Entry{
+        .deadline_nsec_ = deadline_nsec,
+        .seq_           = next_seq_++,
+        .job_           = std::move(job),
+    });
+    std::push_heap(heap_.begin(), heap_.end(), &Later);
+    earliest_deadline_nsec_.store(heap_.front().deadline_nsec_, std::memory_order::release);
+    size_.store(heap_.size(), std::memory_order::relaxed);
+}
+
+bool JobDeadlineQueue::TryPop(job_t& job, cr_timestamp_nsec_t& deadline_nsec) {
+    if (Empty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (heap_.empty()) {
+        return false;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), &Later);
+    job           = std::move(heap_.back().job_);
+    deadline_nsec = heap_.back().deadline_nsec_;
+    heap_.pop_back();
+    earliest_deadline_nsec_.store(
+        heap_.empty() ? kNoDeadline : heap_.front().deadline_nsec_,
+        std::memory_order::release);
+    size_.store(heap_.size(), std::memory_order::relaxed);
+    return true;
+}
+
+}  // namespace cris::core
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "cris/core/sched/job_runner.h"
+#include "cris/core/utils/time.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace cris::core {
+
+// A min-heap of jobs ordered by their absolute deadlines. Jobs with the same deadline are popped in FIFO order.
+//
+// The earliest deadline can be peeked without locking, so that a worker can compare the queues of all the workers
+// cheaply before deciding which one to pop from.
+class JobDeadlineQueue {
+   public:
+    using job_t = JobRunner::job_t;
+
+    static constexpr cr_timestamp_nsec_t kNoDeadline = std::numeric_limits<cr_timestamp_nsec_t>::max();
+
+    explicit JobDeadlineQueue(std::size_t init_capacity = 1024);
+
+    JobDeadlineQueue(const JobDeadlineQueue&)            = delete;
+    JobDeadlineQueue(JobDeadlineQueue&&)                 = delete;
+    JobDeadlineQueue& operator=(const JobDeadlineQueue&) = delete;
+    JobDeadlineQueue& operator=(JobDeadlineQueue&&)      = delete;
+
+    ~JobDeadlineQueue() = default;
+
+    void Push(job_t&& job, cr_timestamp_nsec_t deadline_nsec);
+
+    // Take the job with the earliest deadline.
+    bool TryPop(job_t& job, cr_timestamp_nsec_t& deadline_nsec);
+
+    // The earliest deadline in the queue, or `kNoDeadline` if it is empty. It may be stale as soon as it returns.
+    cr_timestamp_nsec_t EarliestDeadline() const { return earliest_deadline_nsec_.load(std::memory_order::acquire); }
+
+    bool Empty() const { return EarliestDeadline() == kNoDeadline; }
+
+    // It may be stale as soon as it returns.
+    std::size_t SizeApprox() const { return size_.load(std::memory_order::relaxed); }
+
+   private:
+    struct Entry {
+        cr_timestamp_nsec_t deadline_nsec_;
+        std::uint64_t       seq_;
+        job_t               job_;
+    };
+
+    // For `std::push_heap` and `std::pop_heap`, which build max-heaps.
+    static bool Later(const Entry& lhs, const Entry& rhs) {
+        return lhs.deadline_nsec_ != rhs.deadline_nsec_ ? lhs.deadline_nsec_ > rhs.deadline_nsec_ : lhs.seq_ > rhs.seq_;
+    }
+
+    std::mutex         mtx_;
+    std::vector<Entry> heap_;
+    std::uint64_t      next_seq_{0};
+
+    std::atomic<cr_timestamp_nsec_t> earliest_deadline_nsec_{kNoDeadline};
+    std::atomic<std::size_t>         size_{0};
+};
+
+}  // namespace cris::core
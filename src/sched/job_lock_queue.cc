@@ -79,6 +79,19 @@ bool JobLockQueue::ConsumeOne(const std::function<void(job_t&&)>& functor) {
     return true;
 }
 
+bool JobLockQueue::TryPop(job_t& job) {
+    std::lock_guard lck(mtx_);
+    if (size_ == 0) {
+        return false;
+    }
+    job = std::move(jobs_[read_head_]);
+    if (++read_head_ >= jobs_.size()) {
+        read_head_ = 0;
+    }
+    --size_;
+    return true;
+}
+
 bool JobLockQueue::ConsumeAll(const std::function<void(job_t&&)>& functor) {
     std::lock_guard lck(mtx_);
     if (size_ == 0) {
@@ -21,6 +21,8 @@ class JobLockQueue : public JobQueue {
 
     bool ConsumeOne(const std::function<void(job_t&&)>& functor) override;
 
+    bool TryPop(job_t& job) override;
+
     bool ConsumeAll(const std::function<void(job_t&&)>& functor) override;
 
     bool Empty() override;
@@ -12,6 +12,10 @@ void JobQueue::PushBatch(std::vector<job_t> jobs) {
     }
 }
 
+bool JobQueue::TryPop(job_t& job) {
+    return ConsumeOne([&job](job_t&& next) { job = std::move(next); });
+}
+
 bool JobQueue::ConsumeAll(const std::function<void(job_t&&)>& functor) {
     bool consumed = false;
     while (ConsumeOne(functor)) {
@@ -19,6 +19,9 @@ class JobQueue {
 
     virtual bool ConsumeOne(const std::function<void(job_t&&)>& functor) = 0;
 
+    // Move the next job out to `job`, without the indirection of a functor.
+    virtual bool TryPop(job_t& job);
+
     virtual bool ConsumeAll(const std::function<void(job_t&&)>& functor);
 
     virtual bool Empty() = 0;
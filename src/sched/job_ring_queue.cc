@@ -0,0 +1,33 @@
+#include "cris/core/sched/job_ring_queue.h"
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace cris::core {
+
+JobRingQueue::JobRingQueue(std::size_t capacity) : jobs_(capacity) {
+}
+
+void JobRingQueue::Push(job_t job) {
+    jobs_.Push(std::move(job));
+}
+
+bool JobRingQueue::TryPop(job_t& job) {
+    return jobs_.TryPop(job);
+}
+
+bool JobRingQueue::ConsumeOne(const std::function<void(job_t&&)>& functor) {
+    job_t job;
+    if (!jobs_.TryPop(job)) {
+        return false;
+    }
+    functor(std::move(job));
+    return true;
+}
+
+bool JobRingQueue::Empty() {
+    return jobs_.Empty();
+}
+
+}  // namespace cris::core
@@ -0,0 +1,39 @@
+#pragma once
+#include "cris/core/sched/job_queue.h"
+#include "cris/core/sched/ring_queue.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace cris::core {
+
+// Jobs are stored by value in a lock-free ring, see `RingQueue`.
+class JobRingQueue : public JobQueue {
+   public:
+    using job_t = JobQueue::job_t;
+
+    explicit JobRingQueue(std::size_t capacity = 8);
+    ~JobRingQueue() override = default;
+
+    JobRingQueue(const JobRingQueue&)            = delete;
+    JobRingQueue(JobRingQueue&&)                 = delete;
+    JobRingQueue& operator=(const JobRingQueue&) = delete;
+    JobRingQueue& operator=(JobRingQueue&&)      = delete;
+
+    void Push(job_t job) override;
+
+    bool TryPop(job_t& job) override;
+
+    bool ConsumeOne(const std::function<void(job_t&&)>& functor) override;
+
+    bool Empty() override;
+
+    std::size_t Capacity() const { return jobs_.Capacity(); }
+
+    std::size_t SizeApprox() const { return jobs_.SizeApprox(); }
+
+   private:
+    RingQueue<job_t> jobs_;
+};
+
+}  // namespace cris::core
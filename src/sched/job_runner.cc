@@ -1,34 +1,74 @@
 #include "cris/core/sched/job_runner.h"
 
-#include "cris/core/sched/job_lockfree_queue.h"
+#include "cris/core/sched/adaptive_spin.h"
+#include "cris/core/sched/cpu_topology.h"
+#include "cris/core/sched/job_deadline_queue.h"
+#include "cris/core/sched/job_ring_queue.h"
+#include "cris/core/sched/job_work_stealing_queue.h"
+#include "cris/core/sched/parking_lot.h"
+#include "cris/core/sched/ring_queue.h"
 #include "cris/core/sched/spin_impl.h"
-#include "cris/core/sched/spin_mutex.h"
+#include "cris/core/sched/timer_wheel.h"
+#include "cris/core/timer/timer.h"
 #include "cris/core/utils/defs.h"
 #include "cris/core/utils/logging.h"
 #include "cris/core/utils/time.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <condition_variable>
+#include <coroutine>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <random>
+#include <string>
 #include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace cris::core {
 
-static thread_local std::uintptr_t kCurrentThreadJobRunner   = 0;
-static thread_local std::size_t    kCurrentThreadWorkerIndex = 0;
+static thread_local std::uintptr_t kCurrentThreadJobRunner    = 0;
+static thread_local std::size_t    kCurrentThreadWorkerIndex  = 0;
+// How many `WaitForRoom` calls of the current thread are running jobs to help, one inside another.
+static thread_local std::size_t    kCurrentThreadHelpingDepth = 0;
 
-using job_queue_t = JobLockFreeQueue;
+using job_queue_t = JobRingQueue;
+
+// Only the owner writes the counter, so no RMW is needed.
+template<class value_t>
+static void AddToCounter(std::atomic<value_t>& counter, std::type_identity_t<value_t> value) {
+    counter.store(counter.load(std::memory_order::relaxed) + value, std::memory_order::relaxed);
+}
+
+static std::optional<int> WorkerNumaNode(const JobRunner::Config& config, std::size_t idx) {
+    if (config.numa_nodes_.empty() || config.numa_nodes_[idx % config.numa_nodes_.size()] < 0) {
+        return std::nullopt;
+    }
+    return config.numa_nodes_[idx % config.numa_nodes_.size()];
+}
+
+static std::vector<std::size_t> WorkerCpuSet(const JobRunner::Config& config, std::size_t idx) {
+    if (!config.cpu_sets_.empty() && !config.cpu_sets_[idx % config.cpu_sets_.size()].empty()) {
+        return config.cpu_sets_[idx % config.cpu_sets_.size()];
+    }
+    if (const auto numa_node = WorkerNumaNode(config, idx)) {
+        return CpuTopology::Get().CpusOfNumaNode(*numa_node);
+    }
+    return {};
+}
 
 class JobRunnerWorker {
    public:
-    using job_t = JobRunner::job_t;
+    using job_t    = JobRunner::job_t;
+    using Priority = JobRunner::Priority;
 
     explicit JobRunnerWorker(JobRunner* runner, std::size_t idx);
 
@@ -39,10 +79,46 @@ class JobRunnerWorker {
 
     ~JobRunnerWorker();
 
-    std::unique_ptr<job_t> TryGetOneJob();
+    bool TryGetOneJob(job_t& job, Priority priority);
 
+    // Must be called by the worker thread itself.
     bool TryProcessOne();
 
+    // Must be called by the worker thread itself. Run the job with the earliest deadline among all the workers.
+    bool TryProcessEarliestDeadline();
+
+    // Can be called by any thread.
+    bool TryStealOne();
+
+    // Must be called by the worker thread itself. Steal from the closer workers first.
+    bool TryStealFromVictims();
+
+    // Must be called before the runner is ready for stealing, after all the workers are created.
+    void InitStealingVictims();
+
+    // Name, pin and bind the worker thread. Must be called by the worker thread itself.
+    void SetUpThread();
+
+    // Whether any of the queues has jobs.
+    bool HasPendingJobs();
+
+    // The number of jobs in all the queues, approximately.
+    std::size_t QueueDepth() const;
+
+    JobRunner::WorkerTimeStats GetTimeStats() const;
+
+    // Must be called by the worker thread itself, before running a job from its own queues. Producers may not have
+    // woken up enough workers for a burst of jobs, e.g. some were about to sleep at that time, so the backlog is
+    // passed on.
+    void OnJobFound();
+
+    // Must be called by the worker thread itself. Whether the worker is awake but has nothing to do, so producers need
+    // not wake up others for stealing.
+    void SetSpinning(bool spinning);
+
+    // Must be called by the worker thread itself. `job` is moved from only if it returns true.
+    bool TryPushLocal(job_t& job);
+
     void WorkerLoop();
 
     void Stop();
@@ -53,22 +129,84 @@ class JobRunnerWorker {
     // always shorter than the matching runner, so raw pointer is OK here.
     JobRunner* runner_;
 
-    std::size_t             index_;
-    std::atomic<bool>       shutdown_flag_{false};
-    std::atomic<bool>       stopped_flag_{false};
-    std::mutex              inactive_cv_mutex_;
-    std::condition_variable inactive_cv_;
-    job_queue_t             job_queue_{kInitialQueueCapacity};
-    std::thread             thread_;
+    std::size_t              index_;
+    std::optional<int>       numa_node_;
+    std::vector<std::size_t> cpu_set_;
+    std::atomic<bool>        shutdown_flag_{false};
+    std::atomic<bool>        stopped_flag_{false};
+
+    // One queue for each priority, indexed by `Priority`.
+    std::array<job_queue_t, JobRunner::kPriorityNum> job_queues_{
+        job_queue_t{kMinorQueueCapacity},
+        job_queue_t{kInitialQueueCapacity},
+        job_queue_t{kMinorQueueCapacity},
+    };
+
+    // Jobs of the normal priority spawned by this worker itself, only available with `QueueType::kWorkStealing`.
+    std::unique_ptr<JobWorkStealingQueue> local_job_queue_;
+
+    // All the jobs of this worker, only available with `SchedulingPolicy::kEarliestDeadlineFirst`.
+    std::unique_ptr<JobDeadlineQueue> deadline_job_queue_;
+
+    // Only accessed by the worker thread itself, for picking the priority to prefer next.
+    std::size_t pick_round_{0};
+
+    // Indices of the other workers, grouped by their distances to this one in the CPU topology, from the closest.
+    std::vector<std::vector<std::size_t>> victim_groups_;
+
+    // Only accessed by the worker thread itself, for spreading the stealing among the victims in the same group.
+    std::size_t steal_round_{0};
+
+    // The maximum number of rounds to skip stealing after failing to steal repeatedly, which doubles on each failure.
+    static constexpr std::size_t kMaxStealBackoff = 16;
+
+    // Only accessed by the worker thread itself.
+    AdaptiveSpinPolicy spin_policy_;
+    bool               spinning_{false};
+
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    // Written only by the worker thread itself without RMW, and read by `JobRunner::GetStats`. Kept on their own cache
+    // lines, away from the queues that producers and thieves keep touching.
+    struct alignas(kCacheLineSize) Counters {
+        std::atomic<std::uint64_t>      executed_job_num_{0};
+        std::atomic<std::uint64_t>      steal_attempt_num_{0};
+        std::atomic<std::uint64_t>      stolen_job_num_{0};
+        std::atomic<cr_duration_nsec_t> busy_nsec_{0};
+        std::atomic<cr_duration_nsec_t> spin_nsec_{0};
+        std::atomic<cr_duration_nsec_t> parked_nsec_{0};
+        std::atomic<cr_duration_nsec_t> spin_limit_nsec_{0};
+    };
+
+    Counters counters_;
+
+    // Written by producers, when the queues are full, see `JobRunner::Config::max_queue_depth_`.
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> dropped_job_num_{0};
+
+    std::thread thread_;
 
     static constexpr std::size_t kInitialQueueCapacity = 8192;
+    static constexpr std::size_t kMinorQueueCapacity   = 1024;
+    static constexpr std::size_t kLocalQueueCapacity   = 8192;
+
+    // Weighted round robin of the preferred priority, high:normal:low = 4:2:1. When the preferred queue is empty,
+    // the worker falls back to the others from high to low.
+    static constexpr std::array kPrioritySchedule = {
+        Priority::kHigh,
+        Priority::kNormal,
+        Priority::kHigh,
+        Priority::kLow,
+        Priority::kHigh,
+        Priority::kNormal,
+        Priority::kHigh,
+    };
 };
 
 class JobAliveToken {
    public:
-    explicit JobAliveToken(std::weak_ptr<JobRunnerStrand> strand_weak) : strand_weak_(strand_weak) {}
+    explicit JobAliveToken(JobRunnerStrand* strand) : strand_(strand) {}
 
-    ~JobAliveToken();
+    ~JobAliveToken() = default;
 
     JobAliveToken(const JobAliveToken&)            = delete;
     JobAliveToken(JobAliveToken&&)                 = delete;
@@ -76,37 +214,181 @@ class JobAliveToken {
     JobAliveToken& operator=(JobAliveToken&&)      = delete;
 
    private:
-    std::weak_ptr<JobRunnerStrand> strand_weak_;
+    friend class JobRunnerStrand;
+    friend void intrusive_ptr_add_ref(JobAliveToken* token) noexcept;
+    friend void intrusive_ptr_release(JobAliveToken* token) noexcept;
+
+    // The strand owning this token, so it always outlives the token.
+    JobRunnerStrand*         strand_;
+    std::atomic<std::size_t> ref_count_{0};
 };
 
 class JobRunnerStrand : public std::enable_shared_from_this<JobRunnerStrand> {
    public:
     using job_t               = JobRunner::job_t;
+    using strand_job_t        = JobRunner::strand_job_t;
     using ForceRunImmediately = JobRunner::ForceRunImmediately;
+    using Config              = JobRunner::StrandConfig;
 
-    explicit JobRunnerStrand(std::weak_ptr<JobRunner> runner) : runner_weak_(runner) {}
+    JobRunnerStrand(std::weak_ptr<JobRunner> runner_weak, JobRunner* runner, Config config)
+        : runner_weak_(std::move(runner_weak))
+        , runner_(runner)
+        , config_(config)
+        , alive_token_(this) {}
 
     bool AddJob(job_t&& job);
 
-    bool AddJob(std::function<void(JobAliveTokenPtr&&)>&& job);
+    bool AddJob(strand_job_t&& job);
+
+    // Without the limit of pending jobs, for jobs that must not be dropped or blocked.
+    bool AddJobUnbounded(strand_job_t&& job);
+
+    // `job` is consumed unless it returns FULL.
+    JobRunner::NoWait::State AddJob(strand_job_t&& job, JobRunner::NoWait);
+
+    bool HasRoom() const { return config_.max_pending_ == 0 || pending_jobs_.SizeApprox() < config_.max_pending_; }
 
-    bool AddJob(std::function<void(JobAliveTokenPtr&&)> job, ForceRunImmediately);
+    // `job` is consumed only if it returns true.
+    bool AddJob(strand_job_t& job, ForceRunImmediately);
 
-    void PushToRunnerIfNeeded(const bool is_in_running_job);
+    // Called when all the references to the alive token of the running job are released.
+    void OnJobFinished();
 
    private:
+    // Run the next pending jobs, up to the batch limits. `self` keeps the strand alive until the jobs finish.
+    void RunNext(JobRunnerStrandPtr&& self);
+
+    bool ScheduleNext(JobRunnerStrandPtr&& self);
+
+    // Add the job according to `Config::overflow_policy_`, when the pending jobs reach `Config::max_pending_`.
+    bool AddJobWhenFull(strand_job_t&& job);
+
+    JobAliveTokenPtr AcquireAliveToken(JobRunnerStrandPtr&& self);
+
+    // If `token` is the only reference to the alive token, i.e. the job finished without handing it out, release it
+    // without passing the turn on through the runner.
+    bool TryReleaseAliveTokenInline(JobAliveTokenPtr& token);
+
+    // The runner, or nullptr if it is gone. The runner joins its workers before being destroyed, so on them it is used
+    // without a reference, and scheduling the strand never releases the last one there. Elsewhere `locked` holds it.
+    JobRunner* GetRunner(std::shared_ptr<JobRunner>& locked) const;
+
     std::weak_ptr<JobRunner> runner_weak_;
-    HybridSpinMutex          hybrid_spin_mtx_;
-    bool                     has_ready_job_{false};
-    job_queue_t              pending_jobs_{kInitialQueueCapacity};
+    JobRunner* const         runner_;
+    const Config             config_;
 
-    static constexpr std::size_t kInitialQueueCapacity = 8192;
+    // The number of unfinished jobs, i.e. the pending ones plus the running one.
+    std::atomic<std::size_t> job_count_{0};
+
+    RingQueue<strand_job_t> pending_jobs_{kInitialQueueCapacity};
+    JobAliveToken           alive_token_;
+
+    // Keeps the strand alive as long as the alive token is referenced. Only accessed by the owner of the turn, see
+    // `OnJobFinished`.
+    JobRunnerStrandPtr running_self_;
+
+    // Smaller than the worker's, as there can be many strands. Bursts beyond it go to the overflow queue.
+    static constexpr std::size_t kInitialQueueCapacity = 1024;
+};
+
+class JobRunnerTimer {
+   public:
+    using job_t    = JobRunner::job_t;
+    using Priority = JobRunner::Priority;
+
+    JobRunnerTimer(job_t&& job, cr_duration_nsec_t period_nsec, JobRunnerStrandPtr strand, Priority priority)
+        : job_(std::move(job))
+        , period_nsec_(period_nsec)
+        , strand_(std::move(strand))
+        , priority_(priority) {}
+
+    JobRunnerTimer(const JobRunnerTimer&)            = delete;
+    JobRunnerTimer(JobRunnerTimer&&)                 = delete;
+    JobRunnerTimer& operator=(const JobRunnerTimer&) = delete;
+    JobRunnerTimer& operator=(JobRunnerTimer&&)      = delete;
+
+    ~JobRunnerTimer() = default;
+
+    // Run the job, unless cancelled, or the previous run of a periodic job has not finished.
+    void Run();
+
+    bool Cancel();
+
+    bool IsCancelled() const { return state_.load(std::memory_order::acquire) == State::kCancelled; }
+
+    bool IsPeriodic() const { return period_nsec_ > 0; }
+
+   private:
+    friend class JobRunnerTimers;
+
+    enum class State {
+        kPending = 0,
+        kRunning,
+        kFinished,
+        kCancelled,
+    };
+
+    // Only touched by whoever moves the state out of `kPending`, so it is never touched concurrently.
+    job_t job_;
+
+    const cr_duration_nsec_t period_nsec_;
+    const JobRunnerStrandPtr strand_;
+    const Priority           priority_;
+    std::atomic<State>       state_{State::kPending};
+
+    // Only accessed by the timer thread, for periodic jobs.
+    cr_timestamp_nsec_t next_nsec_{0};
+};
+
+class JobRunnerTimers {
+   public:
+    using JobRunnerTimerPtr = std::shared_ptr<JobRunnerTimer>;
+
+    explicit JobRunnerTimers(JobRunner* runner);
+
+    JobRunnerTimers(const JobRunnerTimers&)            = delete;
+    JobRunnerTimers(JobRunnerTimers&&)                 = delete;
+    JobRunnerTimers& operator=(const JobRunnerTimers&) = delete;
+    JobRunnerTimers& operator=(JobRunnerTimers&&)      = delete;
+
+    ~JobRunnerTimers();
+
+    // Returns false if stopped.
+    bool Add(JobRunnerTimerPtr timer, cr_timestamp_nsec_t time_nsec);
+
+    void Stop();
+
+    void Join();
+
+   private:
+    void TimerLoop();
+
+    // Add the job of the timer to the runner, or to its strand.
+    void Dispatch(JobRunnerTimerPtr&& timer);
+
+    JobRunner* runner_;
+
+    std::mutex                    mtx_;
+    std::condition_variable       cv_;
+    TimerWheel<JobRunnerTimerPtr> wheel_;
+    bool                          shutdown_{false};
+
+    // Whether the timer thread is waiting, and until when, if there are timers. New timers due earlier wake it up.
+    bool                               sleeping_{false};
+    std::optional<cr_timestamp_nsec_t> sleep_until_nsec_{};
+
+    // Started on first use.
+    std::thread thread_;
 };
 
-JobAliveToken::~JobAliveToken() {
-    // When the current job is finishing, try pushing the next one.
-    if (auto strand = strand_weak_.lock()) {
-        strand->PushToRunnerIfNeeded(/* is_in_running_job = */ true);
+void intrusive_ptr_add_ref(JobAliveToken* token) noexcept {
+    token->ref_count_.fetch_add(1, std::memory_order::relaxed);
+}
+
+void intrusive_ptr_release(JobAliveToken* token) noexcept {
+    if (token->ref_count_.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+        // When the current job is finishing, try running the next one.
+        token->strand_->OnJobFinished();
     }
 }
 
@@ -114,109 +396,189 @@ bool JobRunnerStrand::AddJob(JobRunnerStrand::job_t&& job) {
     return AddJob([job = std::move(job)](JobAliveTokenPtr&&) { job(); });
 }
 
-bool JobRunnerStrand::AddJob(std::function<void(JobAliveTokenPtr&&)>&& job) {
-    auto serialized_job = [job         = std::move(job),
-                           alive_token = std::make_shared<JobAliveToken>(weak_from_this())]() mutable {
-        job(std::move(alive_token));
-    };
+bool JobRunnerStrand::AddJob(strand_job_t&& job) {
+    if (config_.max_pending_ > 0 && pending_jobs_.SizeApprox() >= config_.max_pending_) [[unlikely]] {
+        return AddJobWhenFull(std::move(job));
+    }
+    return AddJobUnbounded(std::move(job));
+}
 
-    pending_jobs_.Push(std::move(serialized_job));
-    PushToRunnerIfNeeded(/* is_in_running_job = */ false);
+bool JobRunnerStrand::AddJobUnbounded(strand_job_t&& job) {
+    pending_jobs_.Push(std::move(job));
+    if (job_count_.fetch_add(1, std::memory_order::acq_rel) == 0) {
+        return ScheduleNext(shared_from_this());
+    }
     return true;
 }
 
-// Try to get the next job from the pending queue and run it.
-//
-// `is_in_running_job` indicates if this function is called at the end of the running job.
-// Otherwise, it is called after a job is pushed to the pending queue. In either case,
-// this function was called exactly once.
+JobRunner::NoWait::State JobRunnerStrand::AddJob(strand_job_t&& job, JobRunner::NoWait) {
+    using State = JobRunner::NoWait::State;
+    if (!HasRoom()) [[unlikely]] {
+        if (config_.overflow_policy_ == JobRunner::OverflowPolicy::kBlock) {
+            return State::FULL;
+        }
+        return AddJobWhenFull(std::move(job)) ? State::ENQUEUED : State::FAILED;
+    }
+    return AddJobUnbounded(std::move(job)) ? State::ENQUEUED : State::FAILED;
+}
+
+bool JobRunnerStrand::AddJobWhenFull(strand_job_t&& job) {
+    std::shared_ptr<JobRunner> locked;
+    auto*                      runner = GetRunner(locked);
+    if (!runner) {
+        return false;
+    }
+    switch (config_.overflow_policy_) {
+        case JobRunner::OverflowPolicy::kBlock: {
+            runner->blocked_job_num_.fetch_add(1, std::memory_order::relaxed);
+            const bool has_room =
+                runner->WaitForRoom([this] { return HasRoom(); }, [runner] { return runner->IsStopping(); });
+            return has_room && AddJobUnbounded(std::move(job));
+        }
+        case JobRunner::OverflowPolicy::kDropOldest: {
+            // The job takes the place of the popped one, which is counted already, so `job_count_` stays the same. The
+            // owner of the turn may wait for it in the meantime, as for any push claimed but not yet finished.
+            strand_job_t oldest;
+            if (!pending_jobs_.TryPop(oldest)) {
+                return AddJobUnbounded(std::move(job));
+            }
+            pending_jobs_.Push(std::move(job));
+            runner->strand_dropped_job_num_.fetch_add(1, std::memory_order::relaxed);
+            return true;
+        }
+        case JobRunner::OverflowPolicy::kDropNewest:
+            runner->strand_dropped_job_num_.fetch_add(1, std::memory_order::relaxed);
+            return false;
+    }
+    return false;
+}
+
+// The strand is scheduled with `job_count_`, the number of unfinished jobs. A job is always pushed to the pending
+// queue before being counted.
 //
-// This function guarantees the safety and liveness of the strand.
+// This guarantees the safety and liveness of the strand.
 //
 // Safety:
-//   - There are no more than one jobs from the same strand in the matching runner;
-//   - Jobs are added to the runner in the order of being pushed to the pending queue.
+//   - There are no more than one jobs from the same strand running at the same time;
+//   - Jobs run in the order of being pushed to the pending queue.
 // Liveness:
-//   - If there are jobs in the pending queue, there will be one of them being pushed
-//     to the runner, even if there are no more incoming jobs.
+//   - If there are jobs in the pending queue, one of them will run, even if there are no more incoming jobs.
 //
-// The function consists of 2 parts:
-//   - Decision. It is protected by lock and it decides whether Push is needed.
-//   - Push. It pushes the next job to the runner.
-// Let's use + to denote `is_in_running_job == false` and `-` otherwise,
-// use D to denote the D's that changed `has_ready_job_` value and d to those not, then
-//   - D+ only changes the `has_ready_job_` value from false to true
-//   - D- only changes the `has_ready_job_` value from true to false
-//   - P and D/d- has one-to-one matching and P always happen before the correspoding D/d-
-//   - Only D+ and d- generate P.
-//   - Then the D/d who generates a P will be a sequence like this:
-//         [D+ d-* (D-)]*
-//     D- does not generate a P but we add it as a placeholder.
-//   - Then we will prove:
-//       - In this sequence, the P generated by a D/d will always happen before next D/d
-//       - If there is some D/d, its P does not happen before the next D/d:
-//           - If the next D/d is a D/d-, since it must be generated by some P, and all previous P's have a
-//             matched D/d-, there are not enough P's to generate this one, so it is impossible.
-//           - If the next D/d is a D+, then the current one is D-, but D- does not generate P.
-//   - So the sequence is like the following:
-//         D+ [P d-] [P d-] [P D-] D+ [P d-] P ...
-//     Jobs are denoted by brackets. Safety proved.
+// Whoever changes `job_count_` from 0 to 1 owns the turn, and schedules the next job. When a job finishes, i.e. its
+// alive token is released, the turn is passed on to the next job if the counter does not drop to 0 at the same time.
+// So while the counter is non-zero, there is exactly one turn, and only its owner pops and runs jobs. Safety proved,
+// as the pending queue is FIFO.
 //
-//  For liveness, D/d+ add jobs, D+ will push job itself so liveness is trivially hold, for d-, the job will
-//  be visible to the next D/d. If we looks at the non-d- decision before it, it can only be D+/d-, and both
-//  of them comes with a next D/d. Liveness proved.
-void JobRunnerStrand::PushToRunnerIfNeeded(const bool is_in_running_job) {
-    std::unique_ptr<job_t> next;
-
-    // Decision(D/d). It is protected by lock and it decides whether Push is needed.
-    //
-    // `has_ready_job_` indicates if there is a job running in the runner.
-    {
-        std::unique_lock lock(hybrid_spin_mtx_);
+// For liveness, every counted job is pushed before being counted, so when the owner of the turn sees the counter
+// greater than 1 after finishing a job, there is a complete job in the queue. Popping may fail temporarily due to
+// other pushes claimed earlier but not yet finished, the owner waits for them. The job that changes the counter from
+// 0 to 1 starts a new turn by itself. Liveness proved.
+void JobRunnerStrand::OnJobFinished() {
+    // Must be moved out before decrementing, since a new turn may start right after that.
+    auto self = std::move(running_self_);
+    if (job_count_.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+        return;
+    }
+    ScheduleNext(std::move(self));
+}
+
+bool JobRunnerStrand::ScheduleNext(JobRunnerStrandPtr&& self) {
+    std::shared_ptr<JobRunner> locked;
+    if (auto* runner = GetRunner(locked)) {
+        return runner->PushJob(
+            [self = std::move(self)]() mutable {
+                auto* strand = self.get();
+                strand->RunNext(std::move(self));
+            },
+            runner->DefaultSchedulerHint(),
+            config_.priority_);
+    }
+    // Without the runner, the pending jobs will never run, and they will be released along with the strand.
+    return false;
+}
+
+// Jobs in a batch finish inline one after another, which is the same as passing the turn on through the runner,
+// except that the next job skips a round trip of the runner queues. Each of them is counted before being popped, so
+// the proof above still holds.
+void JobRunnerStrand::RunNext(JobRunnerStrandPtr&& self) {
+    const bool                has_time_limit = config_.max_time_.count() > 0;
+    const cr_timestamp_nsec_t batch_deadline =
+        has_time_limit ? GetSystemTimestampNsec() + static_cast<cr_timestamp_nsec_t>(config_.max_time_.count()) : 0;
+
+    for (std::size_t batch_idx = 1;; ++batch_idx) {
+        strand_job_t job;
+        while (!pending_jobs_.TryPop(job)) [[unlikely]] {
+            std::this_thread::yield();
+        }
+        if (config_.max_pending_ > 0 && config_.overflow_policy_ == JobRunner::OverflowPolicy::kBlock) [[unlikely]] {
+            std::shared_ptr<JobRunner> locked;
+            if (auto* runner = GetRunner(locked)) {
+                runner->NotifyRoom();
+            }
+        }
 
-        // Someone else is running or about to run a job.
-        if (!is_in_running_job && has_ready_job_) {
+        auto alive_token = AcquireAliveToken(std::move(self));
+        if (batch_idx >= config_.max_batch_ || (has_time_limit && GetSystemTimestampNsec() >= batch_deadline)) {
+            job(std::move(alive_token));
             return;
         }
 
-        pending_jobs_.ConsumeOne([&next](job_t&& job) { next = std::make_unique<job_t>(std::move(job)); });
+        // Keep one reference, to see whether the job is finished when it returns.
+        job(JobAliveTokenPtr(alive_token));
+        if (!TryReleaseAliveTokenInline(alive_token)) {
+            return;
+        }
 
-        if (!next) {
-            has_ready_job_ = false;
+        // Same as `OnJobFinished`, but continues with the next job in the current thread.
+        self = std::move(running_self_);
+        if (job_count_.fetch_sub(1, std::memory_order::acq_rel) == 1) {
             return;
         }
-        has_ready_job_ = true;
     }
+}
 
-    // Push(P). It pushes the next job to the runner.
-    if (auto runner = runner_weak_.lock()) {
-        runner->AddJob(std::move(*next));
+bool JobRunnerStrand::TryReleaseAliveTokenInline(JobAliveTokenPtr& token) {
+    // No one else can get a new reference without holding one.
+    if (alive_token_.ref_count_.load(std::memory_order::acquire) != 1) {
+        return false;
     }
+    token.detach();
+    alive_token_.ref_count_.store(0, std::memory_order::relaxed);
+    return true;
+}
+
+JobRunner* JobRunnerStrand::GetRunner(std::shared_ptr<JobRunner>& locked) const {
+    if (kCurrentThreadJobRunner == reinterpret_cast<std::uintptr_t>(runner_)) {
+        return runner_weak_.expired() ? nullptr : runner_;
+    }
+    locked = runner_weak_.lock();
+    return locked.get();
+}
+
+JobAliveTokenPtr JobRunnerStrand::AcquireAliveToken(JobRunnerStrandPtr&& self) {
+    running_self_ = std::move(self);
+    return JobAliveTokenPtr(&alive_token_);
 }
 
 // Running job immediately in the same thread.
 //
-// To ensure correctness without performance regression,
-// We only do a quick check to see if it can be run.
-bool JobRunnerStrand::AddJob(std::function<void(JobAliveTokenPtr&&)> job, JobRunner::ForceRunImmediately) {
-    // Decision(D/d). It is protected by lock and it decides whether Push is needed.
-    //
-    // Proceeds only if D+ (changes the `has_ready_job_` value from false to true), and an empty pending queue.
-    // It will not break the order because the pending queue is empty at the point we check.
-    {
-        std::unique_lock lck(hybrid_spin_mtx_, std::try_to_lock);
-        if (!lck.owns_lock() || has_ready_job_ || !pending_jobs_.Empty()) {
-            return false;
-        }
-        has_ready_job_ = true;
+// It starts a turn with a job not in the pending queue, only if there are no unfinished jobs, so the order is kept.
+bool JobRunnerStrand::AddJob(strand_job_t& job, JobRunner::ForceRunImmediately) {
+    std::size_t expected_job_count = 0;
+    if (!job_count_.compare_exchange_strong(
+            expected_job_count,
+            1,
+            std::memory_order::acq_rel,
+            std::memory_order::relaxed)) {
+        return false;
     }
-
-    // Push(P). It is not a real push but run the job immediately.
-    job(std::make_shared<JobAliveToken>(weak_from_this()));
+    job(AcquireAliveToken(shared_from_this()));
     return true;
 }
 
-JobRunner::JobRunner(JobRunner::Config config) : config_(config) {
+JobRunner::JobRunner(JobRunner::Config config)
+    : config_(config)
+    , parking_lot_(std::make_unique<ParkingLot>(config_.thread_num_)) {
     LOG(INFO) << __func__ << ": JobRunner at 0x" << std::hex << reinterpret_cast<std::uintptr_t>(this) << std::dec
               << " initialized with " << config_.thread_num_ << " worker(s). " << config_.always_active_thread_num_
               << " of them always stay active, others go to sleep if stay idle for more than "
@@ -224,8 +586,14 @@ JobRunner::JobRunner(JobRunner::Config config) : config_(config) {
               << " ms." << std::dec;
     workers_.reserve(config_.thread_num_);
     for (std::size_t idx = 0; idx < config_.thread_num_; ++idx) {
+        // So that the queues of the worker are allocated from its NUMA node.
+        ScopedPreferredNumaNode preferred_numa_node(WorkerNumaNode(config_, idx));
         workers_.push_back(std::make_unique<JobRunnerWorker>(this, idx));
     }
+    for (auto& worker : workers_) {
+        worker->InitStealingVictims();
+    }
+    timers_ = std::make_unique<JobRunnerTimers>(this);
     ready_for_stealing_.store(true);
 }
 
@@ -234,11 +602,25 @@ JobRunner::~JobRunner() {
     Stop().Join();
 }
 
-JobRunnerStrandPtr JobRunner::MakeStrand() {
-    return std::make_shared<JobRunnerStrand>(weak_from_this());
+JobRunnerStrandPtr JobRunner::MakeStrand(StrandConfig config) {
+    return std::make_shared<JobRunnerStrand>(weak_from_this(), this, config);
 }
 
-bool JobRunner::AddJob(job_t&& job, std::size_t scheduler_hint) {
+bool JobRunner::AddJob(job_t&& job, std::size_t scheduler_hint, Priority priority) {
+    if (config_.max_queue_depth_ > 0 && !AdmitJobs(scheduler_hint, 1)) [[unlikely]] {
+        return false;
+    }
+    return PushJob(std::move(job), scheduler_hint, priority);
+}
+
+bool JobRunner::PushJob(job_t&& job, std::size_t scheduler_hint, Priority priority) {
+    if (config_.scheduling_policy_ == SchedulingPolicy::kEarliestDeadlineFirst) {
+        return PushJobWithDeadline(
+            std::move(job),
+            GetSystemTimestampNsec() + static_cast<cr_timestamp_nsec_t>(config_.relative_deadline_.count()),
+            scheduler_hint);
+    }
+
     // In default case, modulo operation is not needed because the RNG guarantee the output range.
     // Use conditions to avoid unnecessary modulos.
     const std::size_t worker_idx =
@@ -250,20 +632,68 @@ bool JobRunner::AddJob(job_t&& job, std::size_t scheduler_hint) {
         return false;
     }
 
-    worker->job_queue_.Push(std::move(job));
-    // Notify the scheduled worker first, so that it has better chance to
-    // pick up this job.
-    worker->inactive_cv_.notify_one();
+    if (config_.job_timing_) [[unlikely]] {
+        job = WrapJobForTiming(std::move(job));
+    }
 
-    // Randomly notify another worker, in case all awake workers are busy,
-    // and that worker may steal the jobs.
-    if (!ready_for_stealing_.load()) {
-        NotifyOneWorker();
+    // Jobs spawned by a worker for itself go to its own deque, which is the common case of the default hint.
+    if (priority == Priority::kNormal && kCurrentThreadJobRunner == reinterpret_cast<std::uintptr_t>(this) &&
+        kCurrentThreadWorkerIndex == worker_idx && worker->TryPushLocal(job)) {
+        // The current worker is awake for sure, another one may be woken up to share the spawned jobs.
+        NotifyWorkerOfNewJobs(worker_idx);
+        return true;
+    }
+
+    worker->job_queues_[static_cast<std::size_t>(priority)].Push(std::move(job));
+    NotifyWorkerOfNewJobs(worker_idx);
+    return true;
+}
+
+bool JobRunner::AddJobWithDeadline(job_t&& job, cr_timestamp_nsec_t deadline_nsec, std::size_t scheduler_hint) {
+    if (config_.max_queue_depth_ > 0 && !AdmitJobs(scheduler_hint, 1)) [[unlikely]] {
+        return false;
+    }
+    return PushJobWithDeadline(std::move(job), deadline_nsec, scheduler_hint);
+}
+
+bool JobRunner::PushJobWithDeadline(job_t&& job, cr_timestamp_nsec_t deadline_nsec, std::size_t scheduler_hint) {
+    if (config_.scheduling_policy_ != SchedulingPolicy::kEarliestDeadlineFirst) {
+        return PushJob(std::move(job), scheduler_hint, Priority::kNormal);
+    }
+
+    const std::size_t worker_idx =
+        scheduler_hint < config_.thread_num_ ? scheduler_hint : scheduler_hint % config_.thread_num_;
+    auto& worker = workers_[worker_idx];
+    if (!worker) [[unlikely]] {
+        LOG(ERROR) << __func__ << ": Try to schedule to uninitialized worker " << worker_idx
+                   << ", worker num: " << config_.thread_num_;
+        return false;
+    }
+
+    if (config_.job_timing_) [[unlikely]] {
+        job = WrapJobForTiming(std::move(job));
     }
+    worker->deadline_job_queue_->Push(std::move(job), deadline_nsec);
+    NotifyWorkerOfNewJobs(worker_idx);
     return true;
 }
 
 bool JobRunner::AddJobs(std::vector<job_t>&& jobs, std::size_t scheduler_hint) {
+    // The batch is admitted or dropped as a whole.
+    if (config_.max_queue_depth_ > 0 && !AdmitJobs(scheduler_hint, jobs.size())) [[unlikely]] {
+        return false;
+    }
+
+    if (config_.scheduling_policy_ == SchedulingPolicy::kEarliestDeadlineFirst) {
+        const cr_timestamp_nsec_t deadline_nsec =
+            GetSystemTimestampNsec() + static_cast<cr_timestamp_nsec_t>(config_.relative_deadline_.count());
+        bool succeeded = true;
+        for (auto& job : jobs) {
+            succeeded = PushJobWithDeadline(std::move(job), deadline_nsec, scheduler_hint) && succeeded;
+        }
+        return succeeded;
+    }
+
     // In default case, modulo operation is not needed because the RNG guarantee the output range.
     // Use conditions to avoid unnecessary modulos.
     const std::size_t worker_idx =
@@ -275,37 +705,164 @@ bool JobRunner::AddJobs(std::vector<job_t>&& jobs, std::size_t scheduler_hint) {
         return false;
     }
 
-    worker->job_queue_.PushBatch(std::move(jobs));
-    // Notify the scheduled worker first, so that it has better chance to
-    // pick up this job.
-    worker->inactive_cv_.notify_one();
+    if (config_.job_timing_) [[unlikely]] {
+        for (auto& job : jobs) {
+            job = WrapJobForTiming(std::move(job));
+        }
+    }
+    worker->job_queues_[static_cast<std::size_t>(Priority::kNormal)].PushBatch(std::move(jobs));
+    NotifyWorkerOfNewJobs(worker_idx);
+    return true;
+}
 
-    // Randomly notify another worker, in case all awake workers are busy,
-    // and that worker may steal the jobs.
-    // Note that notifying all workers may be too expensive.
-    if (!ready_for_stealing_.load()) {
-        NotifyOneWorker();
+bool JobRunner::AdmitJobs(std::size_t scheduler_hint, std::size_t job_num) {
+    const std::size_t worker_idx =
+        scheduler_hint < config_.thread_num_ ? scheduler_hint : scheduler_hint % config_.thread_num_;
+    auto* worker = workers_[worker_idx].get();
+    // Uninitialized workers are reported when the jobs are pushed.
+    if (!worker || worker->QueueDepth() < config_.max_queue_depth_) [[likely]] {
+        return true;
+    }
+    if (config_.overflow_policy_ == OverflowPolicy::kBlock) {
+        blocked_job_num_.fetch_add(job_num, std::memory_order::relaxed);
+        return WaitForRoom(
+            [this, worker] { return worker->QueueDepth() < config_.max_queue_depth_; },
+            [this] { return IsStopping(); });
+    }
+    worker->dropped_job_num_.fetch_add(job_num, std::memory_order::relaxed);
+    return false;
+}
+
+JobRunner::NoWait::State JobRunner::AddJob(job_t&& job, std::size_t scheduler_hint, Priority priority, NoWait) {
+    if (config_.max_queue_depth_ > 0 && !HasRoom(scheduler_hint)) [[unlikely]] {
+        if (config_.overflow_policy_ == OverflowPolicy::kBlock) {
+            return NoWait::State::FULL;
+        }
+        if (!AdmitJobs(scheduler_hint, 1)) {
+            return NoWait::State::FAILED;
+        }
+    }
+    return PushJob(std::move(job), scheduler_hint, priority) ? NoWait::State::ENQUEUED : NoWait::State::FAILED;
+}
+
+JobRunner::NoWait::State JobRunner::AddJob(
+    strand_job_t&&     job,
+    JobRunnerStrandPtr strand,
+    std::size_t        scheduler_hint,
+    Priority           priority,
+    NoWait) {
+    if (strand) {
+        return strand->AddJob(std::move(job), NoWait());
+    }
+    if (config_.max_queue_depth_ > 0 && !HasRoom(scheduler_hint) &&
+        config_.overflow_policy_ == OverflowPolicy::kBlock) [[unlikely]] {
+        return NoWait::State::FULL;
+    }
+    return AddJob([job = std::move(job)] { job(nullptr); }, scheduler_hint, priority, NoWait());
+}
+
+bool JobRunner::WaitForRoom(const JobRunnerStrandPtr& strand, std::size_t scheduler_hint) {
+    blocked_job_num_.fetch_add(1, std::memory_order::relaxed);
+    if (strand) {
+        return WaitForRoom([&strand] { return strand->HasRoom(); }, [this] { return IsStopping(); });
+    }
+    return WaitForRoom([this, scheduler_hint] { return HasRoom(scheduler_hint); }, [this] { return IsStopping(); });
+}
+
+bool JobRunner::HasRoom(std::size_t scheduler_hint) const {
+    const std::size_t worker_idx =
+        scheduler_hint < config_.thread_num_ ? scheduler_hint : scheduler_hint % config_.thread_num_;
+    const auto* worker = workers_[worker_idx].get();
+    return config_.max_queue_depth_ == 0 || !worker || worker->QueueDepth() < config_.max_queue_depth_;
+}
+
+bool JobRunner::IsStopping() const {
+    return workers_.empty() || !workers_.front() || workers_.front()->shutdown_flag_.load(std::memory_order::relaxed);
+}
+
+bool JobRunner::WaitForRoom(const std::function<bool()>& has_room, const std::function<bool()>& is_stopping) {
+    static constexpr std::size_t kSpinRounds      = 64;
+    static constexpr std::size_t kMaxHelpingDepth = 4;
+
+    const bool is_worker = kCurrentThreadJobRunner == reinterpret_cast<std::uintptr_t>(this);
+    // Jobs run to help may wait for room again, running more jobs. The nesting is capped to bound the stack. Beyond
+    // that the job goes over the soft limit, as waiting may leave no worker to make room, e.g. with only one.
+    if (is_worker && kCurrentThreadHelpingDepth >= kMaxHelpingDepth) [[unlikely]] {
+        return !is_stopping();
+    }
+
+    std::size_t idle_rounds = 0;
+    while (!has_room()) {
+        if (is_stopping()) {
+            return false;
+        }
+        if (is_worker) {
+            // Workers never sleep here, as the jobs to make room may be in their own queues.
+            ++kCurrentThreadHelpingDepth;
+            const bool has_run = RunOneJob();
+            --kCurrentThreadHelpingDepth;
+            if (has_run) {
+                idle_rounds = 0;
+            } else if (++idle_rounds < kSpinRounds) {
+                impl::CpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        if (++idle_rounds < kSpinRounds) {
+            impl::CpuRelax();
+            continue;
+        }
+        // Like parking, either the room is seen after the fence, or `NotifyRoom` sees the waiter and changes the epoch.
+        room_waiter_num_.fetch_add(1, std::memory_order::seq_cst);
+        const auto epoch = room_epoch_.load(std::memory_order::acquire);
+        std::atomic_thread_fence(std::memory_order::seq_cst);
+        if (!has_room() && !is_stopping()) {
+            room_epoch_.wait(epoch, std::memory_order::acquire);
+        }
+        room_waiter_num_.fetch_sub(1, std::memory_order::relaxed);
     }
     return true;
 }
 
+void JobRunner::NotifyRoom() {
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    if (room_waiter_num_.load(std::memory_order::relaxed) > 0) [[unlikely]] {
+        room_epoch_.fetch_add(1, std::memory_order::release);
+        room_epoch_.notify_all();
+    }
+}
+
 bool JobRunner::AddJob(job_t&& job, JobRunnerStrandPtr strand) {
     return strand ? strand->AddJob(std::move(job)) : AddJob(std::move(job));
 }
 
-bool JobRunner::AddJob(std::function<void(JobAliveTokenPtr&&)>&& job, JobRunnerStrandPtr strand) {
+bool JobRunner::AddJob(strand_job_t&& job, JobRunnerStrandPtr strand) {
     return strand ? strand->AddJob(std::move(job)) : AddJob([job = std::move(job)] { job(nullptr); });
 }
 
+bool JobRunner::AddJob(job_t&& job, JobRunnerStrandPtr strand, Priority priority) {
+    return strand ? strand->AddJob(std::move(job)) : AddJob(std::move(job), priority);
+}
+
+bool JobRunner::AddJob(strand_job_t&& job, JobRunnerStrandPtr strand, Priority priority) {
+    return strand ? strand->AddJob(std::move(job)) : AddJob([job = std::move(job)] { job(nullptr); }, priority);
+}
+
 JobRunner::TryRunImmediately::State JobRunner::AddJob(job_t&& job, JobRunnerStrandPtr strand, TryRunImmediately) {
     return AddJob([job = std::move(job)](JobAliveTokenPtr&&) { return job(); }, std::move(strand), TryRunImmediately());
 }
 
 JobRunner::TryRunImmediately::State JobRunner::AddJob(
-    std::function<void(JobAliveTokenPtr&&)>&& job,
-    JobRunnerStrandPtr                        strand,
+    strand_job_t&&     job,
+    JobRunnerStrandPtr strand,
     TryRunImmediately) {
-    if (AddJob(job, strand, ForceRunImmediately())) {
+    if (!strand) {
+        job(nullptr);
+        return TryRunImmediately::State::FINISHED;
+    }
+    if (strand->AddJob(job, ForceRunImmediately())) {
         return TryRunImmediately::State::FINISHED;
     }
     return strand->AddJob(std::move(job)) ? TryRunImmediately::State::ENQUEUED : TryRunImmediately::State::FAILED;
@@ -318,12 +875,12 @@ bool JobRunner::AddJob(job_t job, JobRunnerStrandPtr strand, ForceRunImmediately
         ForceRunImmediately());
 }
 
-bool JobRunner::AddJob(std::function<void(JobAliveTokenPtr&&)> job, JobRunnerStrandPtr strand, ForceRunImmediately) {
+bool JobRunner::AddJob(strand_job_t job, JobRunnerStrandPtr strand, ForceRunImmediately) {
     if (!strand) {
         job(nullptr);
         return true;
     }
-    return strand->AddJob(std::move(job), ForceRunImmediately());
+    return strand->AddJob(job, ForceRunImmediately());
 }
 
 bool JobRunner::Steal() {
@@ -331,12 +888,13 @@ bool JobRunner::Steal() {
         return false;
     }
 
-    static thread_local std::random_device         random_device;
-    static thread_local std::default_random_engine random_engine(random_device());
-    std::uniform_int_distribution<std::size_t>     random_worker_selector(0, config_.thread_num_);
+    if (kCurrentThreadJobRunner == reinterpret_cast<std::uintptr_t>(this)) {
+        return workers_[kCurrentThreadWorkerIndex]->TryStealFromVictims();
+    }
 
-    DVLOG(1) << __func__ << ": JobRunnerWorker " << kCurrentThreadWorkerIndex << " stealing.";
-    std::size_t idx = random_worker_selector(random_engine);
+    static thread_local std::minstd_rand random_engine(std::random_device{}());
+
+    std::size_t idx = random_engine() % config_.thread_num_;
     for (std::size_t i = 0; i < config_.thread_num_; ++idx, ++i) {
         if (idx >= config_.thread_num_) {
             idx -= config_.thread_num_;
@@ -345,7 +903,10 @@ bool JobRunner::Steal() {
             DLOG(FATAL) << __func__ << ": JobRunnerWorker " << idx << " is unexpectedly uninitialized.";
             continue;
         }
-        if (workers_[idx]->TryProcessOne()) {
+        if (parking_lot_->IsParked(idx)) {
+            continue;
+        }
+        if (workers_[idx]->TryStealOne()) {
             DVLOG(1) << __func__ << ": JobRunnerWorker " << kCurrentThreadWorkerIndex << " stole a job from " << idx
                      << ".";
             return true;
@@ -354,17 +915,38 @@ bool JobRunner::Steal() {
     return false;
 }
 
+bool JobRunner::RunOneJob() {
+    if (!ready_for_stealing_.load()) {
+        return false;
+    }
+
+    if (kCurrentThreadJobRunner == reinterpret_cast<std::uintptr_t>(this)) {
+        auto& worker = workers_[kCurrentThreadWorkerIndex];
+        return worker->TryProcessOne() || worker->TryStealFromVictims();
+    }
+    return Steal();
+}
+
 JobRunner& JobRunner::Stop() {
+    if (timers_) {
+        timers_->Stop();
+    }
     for (auto& worker : workers_) {
         if (!worker) {
             continue;
         }
         worker->Stop();
     }
+    // Threads blocked by full queues see the runner stopping.
+    room_epoch_.fetch_add(1, std::memory_order::release);
+    room_epoch_.notify_all();
     return *this;
 }
 
 void JobRunner::Join() {
+    if (timers_) {
+        timers_->Join();
+    }
     for (auto& worker : workers_) {
         if (!worker) {
             continue;
@@ -374,16 +956,18 @@ void JobRunner::Join() {
 }
 
 void JobRunner::NotifyOneWorker() {
-    static thread_local std::random_device         random_device;
-    static thread_local std::default_random_engine random_engine(random_device());
-    std::uniform_int_distribution<std::size_t>     random_worker_selector(0, config_.thread_num_);
+    parking_lot_->UnparkOne();
+}
 
-    std::size_t idx = random_worker_selector(random_engine);
-    if (!workers_[idx]) [[unlikely]] {
-        DLOG(FATAL) << __func__ << ": JobRunnerWorker " << idx << " is unexpectedly uninitialized.";
+void JobRunner::NotifyWorkerOfNewJobs(std::size_t worker_idx) {
+    if (parking_lot_->Unpark(worker_idx)) {
         return;
     }
-    workers_[idx]->inactive_cv_.notify_one();
+    // The worker is awake, but may be busy with other jobs. Wake up another one to steal the new jobs, unless some are
+    // looking for jobs already. No syscall happens if none is parked.
+    if (spinning_workers_num_.load(std::memory_order::relaxed) == 0) {
+        parking_lot_->UnparkOne();
+    }
 }
 
 std::size_t JobRunner::ThreadNum() const {
@@ -394,94 +978,641 @@ std::size_t JobRunner::ActiveThreadNum() const {
     return active_workers_num_.load();
 }
 
+std::size_t JobRunner::DeadlineMissNum() const {
+    return deadline_miss_num_.load(std::memory_order::relaxed);
+}
+
+std::vector<JobRunner::WorkerTimeStats> JobRunner::GetWorkerTimeStats() const {
+    std::vector<WorkerTimeStats> stats;
+    stats.reserve(workers_.size());
+    for (const auto& worker : workers_) {
+        stats.push_back(worker->GetTimeStats());
+    }
+    return stats;
+}
+
+JobRunner::Stats JobRunner::GetStats() const {
+    Stats stats{
+        .thread_num_          = config_.thread_num_,
+        .active_thread_num_   = active_workers_num_.load(std::memory_order::relaxed),
+        .spinning_thread_num_ = spinning_workers_num_.load(std::memory_order::relaxed),
+        .parked_thread_num_   = parking_lot_->ParkedNum(),
+        .deadline_miss_num_   = deadline_miss_num_.load(std::memory_order::relaxed),
+    };
+    stats.workers_.reserve(workers_.size());
+    for (const auto& worker : workers_) {
+        const auto& counters = worker->counters_;
+        stats.workers_.push_back({
+            .queue_depth_       = worker->QueueDepth(),
+            .executed_job_num_  = counters.executed_job_num_.load(std::memory_order::relaxed),
+            .steal_attempt_num_ = counters.steal_attempt_num_.load(std::memory_order::relaxed),
+            .stolen_job_num_    = counters.stolen_job_num_.load(std::memory_order::relaxed),
+            .dropped_job_num_   = worker->dropped_job_num_.load(std::memory_order::relaxed),
+            .time_              = worker->GetTimeStats(),
+        });
+        stats.queue_depth_ += stats.workers_.back().queue_depth_;
+        stats.executed_job_num_ += stats.workers_.back().executed_job_num_;
+        stats.dropped_job_num_ += stats.workers_.back().dropped_job_num_;
+    }
+    stats.dropped_job_num_ += strand_dropped_job_num_.load(std::memory_order::relaxed);
+    stats.blocked_job_num_ = blocked_job_num_.load(std::memory_order::relaxed);
+    return stats;
+}
+
+// Members must not be touched once the job is added, since the coroutine, along with this awaiter, may have been
+// resumed and destroyed by then.
+bool JobRunner::ScheduleAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    if (auto strand = strand_) {
+        // The job is queued even if it fails, so the coroutine must not be resumed here.
+        if (!strand->AddJobUnbounded([handle](JobAliveTokenPtr&&) { handle.resume(); })) [[unlikely]] {
+            LOG(ERROR) << __func__ << ": The runner of the strand is gone, the coroutine will never resume.";
+        }
+        return true;
+    }
+    // Not held back by `Config::max_queue_depth_`, which would block the thread or resume the coroutine in it.
+    return runner_->PushJob([handle]() { handle.resume(); }, scheduler_hint_, priority_);
+}
+
+bool JobRunner::ScheduleAtAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    return static_cast<bool>(runner_->AddJobAt([handle]() { handle.resume(); }, time_nsec_, priority_));
+}
+
+bool JobRunner::TimerHandle::Cancel() const {
+    return timer_ && timer_->Cancel();
+}
+
+JobRunner::TimerHandle JobRunner::AddJobAt(job_t&& job, cr_timestamp_nsec_t time_nsec, Priority priority) {
+    return AddTimer(std::move(job), time_nsec, 0, nullptr, priority);
+}
+
+JobRunner::TimerHandle JobRunner::AddJobAt(job_t&& job, cr_timestamp_nsec_t time_nsec, JobRunnerStrandPtr strand) {
+    return AddTimer(std::move(job), time_nsec, 0, std::move(strand), Priority::kNormal);
+}
+
+JobRunner::TimerHandle JobRunner::AddPeriodicJob(job_t&& job, std::chrono::nanoseconds period, Priority priority) {
+    return AddTimer(std::move(job), GetSystemTimestampNsec() + period.count(), period.count(), nullptr, priority);
+}
+
+JobRunner::TimerHandle JobRunner::AddPeriodicJob(
+    job_t&&                  job,
+    std::chrono::nanoseconds period,
+    JobRunnerStrandPtr       strand) {
+    return AddTimer(
+        std::move(job),
+        GetSystemTimestampNsec() + period.count(),
+        period.count(),
+        std::move(strand),
+        Priority::kNormal);
+}
+
+JobRunner::TimerHandle JobRunner::AddTimer(
+    job_t&&             job,
+    cr_timestamp_nsec_t time_nsec,
+    cr_duration_nsec_t  period_nsec,
+    JobRunnerStrandPtr  strand,
+    Priority            priority) {
+    if (period_nsec < 0) [[unlikely]] {
+        LOG(ERROR) << __func__ << ": Negative period " << period_nsec << " ns, run once instead.";
+        period_nsec = 0;
+    }
+    auto timer = std::make_shared<JobRunnerTimer>(std::move(job), period_nsec, std::move(strand), priority);
+    if (!timers_->Add(timer, time_nsec)) [[unlikely]] {
+        return {};
+    }
+    return TimerHandle(std::move(timer));
+}
+
+void JobRunnerTimer::Run() {
+    auto expected = State::kPending;
+    if (!state_.compare_exchange_strong(expected, State::kRunning, std::memory_order::acq_rel)) {
+        return;
+    }
+    job_();
+    if (IsPeriodic()) {
+        expected = State::kRunning;
+        if (state_.compare_exchange_strong(expected, State::kPending, std::memory_order::acq_rel)) [[likely]] {
+            return;
+        }
+        // Cancelled while running.
+        job_ = nullptr;
+        return;
+    }
+    job_ = nullptr;
+    state_.store(State::kFinished, std::memory_order::release);
+}
+
+bool JobRunnerTimer::Cancel() {
+    auto state = state_.load(std::memory_order::acquire);
+    while (true) {
+        if (state == State::kPending) {
+            if (state_.compare_exchange_weak(state, State::kCancelled, std::memory_order::acq_rel)) {
+                // Release what the job holds now, rather than when the timer expires.
+                job_ = nullptr;
+                return true;
+            }
+        } else if (state == State::kRunning && IsPeriodic()) {
+            // The run finds it cancelled when it finishes.
+            if (state_.compare_exchange_weak(state, State::kCancelled, std::memory_order::acq_rel)) {
+                return true;
+            }
+        } else {
+            return false;
+        }
+    }
+}
+
+JobRunnerTimers::JobRunnerTimers(JobRunner* runner)
+    : runner_(runner)
+    , wheel_(GetSystemTimestampNsec(), runner->config_.timer_tick_.count()) {
+}
+
+JobRunnerTimers::~JobRunnerTimers() {
+    Stop();
+    Join();
+}
+
+bool JobRunnerTimers::Add(JobRunnerTimerPtr timer, cr_timestamp_nsec_t time_nsec) {
+    timer->next_nsec_ = time_nsec;
+    std::unique_lock lck(mtx_);
+    if (shutdown_) [[unlikely]] {
+        return false;
+    }
+    if (!thread_.joinable()) [[unlikely]] {
+        thread_ = std::thread([this]() { TimerLoop(); });
+    }
+    wheel_.Add(time_nsec, std::move(timer));
+    const bool wake_up = sleeping_ && (!sleep_until_nsec_ || time_nsec < *sleep_until_nsec_);
+    lck.unlock();
+    if (wake_up) {
+        cv_.notify_one();
+    }
+    return true;
+}
+
+void JobRunnerTimers::Stop() {
+    {
+        std::lock_guard lck(mtx_);
+        shutdown_ = true;
+    }
+    cv_.notify_one();
+}
+
+void JobRunnerTimers::Join() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void JobRunnerTimers::TimerLoop() {
+    const auto& config = runner_->config_;
+    if (!config.thread_name_prefix_.empty()) {
+        SetCurrentThreadName(config.thread_name_prefix_ + "timer");
+    }
+
+    std::vector<JobRunnerTimerPtr> expired;
+    std::unique_lock               lck(mtx_);
+    while (!shutdown_) {
+        const auto now = GetSystemTimestampNsec();
+        wheel_.Advance(now, [this, now, &expired](JobRunnerTimerPtr&& timer) {
+            if (timer->IsCancelled()) {
+                return;
+            }
+            if (timer->IsPeriodic()) {
+                // Skip the runs already missed.
+                const auto period = timer->period_nsec_;
+                timer->next_nsec_ += period;
+                if (timer->next_nsec_ <= now) {
+                    timer->next_nsec_ += ((now - timer->next_nsec_) / period + 1) * period;
+                }
+                expired.push_back(timer);
+                wheel_.Add(timer->next_nsec_, std::move(timer));
+                return;
+            }
+            expired.push_back(std::move(timer));
+        });
+
+        if (!expired.empty()) {
+            lck.unlock();
+            for (auto& timer : expired) {
+                Dispatch(std::move(timer));
+            }
+            expired.clear();
+            lck.lock();
+            continue;
+        }
+
+        sleeping_         = true;
+        sleep_until_nsec_ = wheel_.NextCheckNsec();
+        if (sleep_until_nsec_) {
+            cv_.wait_for(lck, std::chrono::nanoseconds(*sleep_until_nsec_ - now));
+        } else {
+            cv_.wait(lck);
+        }
+        sleeping_ = false;
+    }
+}
+
+void JobRunnerTimers::Dispatch(JobRunnerTimerPtr&& timer) {
+    // The timer keeps the strand alive.
+    if (auto* strand = timer->strand_.get()) {
+        strand->AddJobUnbounded([timer = std::move(timer)](JobAliveTokenPtr&&) { timer->Run(); });
+        return;
+    }
+    const auto priority = timer->priority_;
+    runner_->PushJob([timer = std::move(timer)]() { timer->Run(); }, runner_->DefaultSchedulerHint(), priority);
+}
+
+JobRunner::job_t JobRunner::WrapJobForTiming(job_t&& job) {
+    static auto* queueing_delay_section =
+        TimerSection::GetMainSection()->SubSection("JobRunner")->SubSection("QueueingDelay");
+    static auto* execution_section = TimerSection::GetMainSection()->SubSection("JobRunner")->SubSection("Execution");
+
+    return [job = std::move(job), enqueue_timestamp = GetSystemTimestampNsec()]() mutable {
+        const auto start_timestamp = GetSystemTimestampNsec();
+        queueing_delay_section->ReportDurationNsec(start_timestamp - enqueue_timestamp);
+        job();
+        execution_section->ReportDurationNsec(GetSystemTimestampNsec() - start_timestamp);
+    };
+}
+
+void JobRunner::RunDeadlineJob(job_t& job, cr_timestamp_nsec_t deadline_nsec) {
+    job();
+
+    const auto finish_timestamp = GetSystemTimestampNsec();
+    if (finish_timestamp > deadline_nsec) [[unlikely]] {
+        static auto* deadline_miss_section =
+            TimerSection::GetMainSection()->SubSection("JobRunner")->SubSection("DeadlineMiss");
+        deadline_miss_num_.fetch_add(1, std::memory_order::relaxed);
+        deadline_miss_section->ReportDurationNsec(finish_timestamp - deadline_nsec);
+    }
+}
+
 std::size_t JobRunner::DefaultSchedulerHint() {
     static thread_local std::random_device         random_device;
     static thread_local std::default_random_engine random_engine(random_device());
-    std::uniform_int_distribution<std::size_t>     random_worker_selector(0, config_.thread_num_);
+    std::uniform_int_distribution<std::size_t>     random_worker_selector(0, config_.thread_num_ - 1);
 
     return kCurrentThreadJobRunner == reinterpret_cast<std::uintptr_t>(this) ? kCurrentThreadWorkerIndex
                                                                              : random_worker_selector(random_engine);
 }
 
 std::shared_ptr<JobRunner> JobRunner::MakeJobRunner(Config config) {
-    return std::shared_ptr<JobRunner>(new JobRunner(config));
+    // Destroying the runner joins its workers. When the last reference is released by one of them, e.g. by a job
+    // holding it, or by scheduling the next turn of a strand, the runner is destroyed by another thread instead.
+    return std::shared_ptr<JobRunner>(new JobRunner(config), [](JobRunner* runner) {
+        if (kCurrentThreadJobRunner == reinterpret_cast<std::uintptr_t>(runner)) {
+            std::thread([runner]() { delete runner; }).detach();
+            return;
+        }
+        delete runner;
+    });
 }
 
 JobRunnerWorker::JobRunnerWorker(JobRunner* runner, std::size_t idx)
     : runner_(runner)
     , index_(idx)
+    , numa_node_(WorkerNumaNode(runner->config_, idx))
+    , cpu_set_(WorkerCpuSet(runner->config_, idx))
+    , local_job_queue_(
+          runner->config_.queue_type_ == JobRunner::QueueType::kWorkStealing
+              ? std::make_unique<JobWorkStealingQueue>(kLocalQueueCapacity)
+              : nullptr)
+    , deadline_job_queue_(
+          runner->config_.scheduling_policy_ == JobRunner::SchedulingPolicy::kEarliestDeadlineFirst
+              ? std::make_unique<JobDeadlineQueue>(kInitialQueueCapacity)
+              : nullptr)
+    , spin_policy_(std::chrono::duration_cast<std::chrono::nanoseconds>(runner->config_.active_time_).count())
     , thread_([this] { return WorkerLoop(); }) {
+    counters_.spin_limit_nsec_.store(spin_policy_.SpinLimitNsec(), std::memory_order::relaxed);
 }
 
 JobRunnerWorker::~JobRunnerWorker() {
     DCHECK(!thread_.joinable());
 }
 
-std::unique_ptr<JobRunner::job_t> JobRunnerWorker::TryGetOneJob() {
-    std::unique_ptr<job_t> job_ptr{nullptr};
-    job_queue_.ConsumeOne([&job_ptr](job_t&& job) { job_ptr = std::make_unique<job_t>(std::move(job)); });
-    return job_ptr;
+bool JobRunnerWorker::TryGetOneJob(job_t& job, Priority priority) {
+    return job_queues_[static_cast<std::size_t>(priority)].TryPop(job);
 }
 
 bool JobRunnerWorker::TryProcessOne() {
-    if (auto job = TryGetOneJob()) {
-        (*job)();
+    if (deadline_job_queue_) {
+        return TryProcessEarliestDeadline();
+    }
+
+    const auto preferred = kPrioritySchedule[pick_round_++ % kPrioritySchedule.size()];
+
+    job_t job;
+    const auto try_get_one = [this, &job](Priority priority) {
+        if (priority == Priority::kNormal && local_job_queue_ && local_job_queue_->TryPop(job)) {
+            return true;
+        }
+        return TryGetOneJob(job, priority);
+    };
+
+    bool has_job = try_get_one(preferred);
+    for (std::size_t idx = 0; !has_job && idx < JobRunner::kPriorityNum; ++idx) {
+        const auto priority = static_cast<Priority>(idx);
+        has_job             = priority != preferred && try_get_one(priority);
+    }
+    if (has_job) {
+        OnJobFound();
+        job();
+    }
+    return has_job;
+}
+
+bool JobRunnerWorker::TryProcessEarliestDeadline() {
+    // Peek all the workers without locking, and pop from the earliest one. Its earliest job may have been taken by
+    // others in the meantime, then the next one is taken instead, which is still a close approximation.
+    JobRunnerWorker*    target            = this;
+    cr_timestamp_nsec_t earliest_deadline = deadline_job_queue_->EarliestDeadline();
+    // The worker list is still being filled before the runner is ready for stealing.
+    for (std::size_t idx = 0; runner_->ready_for_stealing_.load() && idx < runner_->config_.thread_num_; ++idx) {
+        auto& worker = runner_->workers_[idx];
+        if (!worker) [[unlikely]] {
+            continue;
+        }
+        const auto deadline = worker->deadline_job_queue_->EarliestDeadline();
+        if (deadline < earliest_deadline) {
+            earliest_deadline = deadline;
+            target            = worker.get();
+        }
+    }
+    if (earliest_deadline == JobDeadlineQueue::kNoDeadline) {
+        return false;
+    }
+
+    job_t               job;
+    cr_timestamp_nsec_t deadline_nsec = 0;
+    if (!target->deadline_job_queue_->TryPop(job, deadline_nsec) &&
+        (target == this || !deadline_job_queue_->TryPop(job, deadline_nsec))) {
+        return false;
+    }
+    OnJobFound();
+    runner_->RunDeadlineJob(job, deadline_nsec);
+    return true;
+}
+
+bool JobRunnerWorker::TryStealOne() {
+    job_t job;
+    if (deadline_job_queue_) {
+        cr_timestamp_nsec_t deadline_nsec = 0;
+        if (!deadline_job_queue_->TryPop(job, deadline_nsec)) {
+            return false;
+        }
+        if (runner_->config_.max_queue_depth_ > 0) [[unlikely]] {
+            runner_->NotifyRoom();
+        }
+        runner_->RunDeadlineJob(job, deadline_nsec);
         return true;
     }
+
+    for (std::size_t idx = 0; idx < JobRunner::kPriorityNum; ++idx) {
+        const auto priority = static_cast<Priority>(idx);
+        if ((priority == Priority::kNormal && local_job_queue_ && local_job_queue_->TrySteal(job)) ||
+            TryGetOneJob(job, priority)) {
+            if (runner_->config_.max_queue_depth_ > 0) [[unlikely]] {
+                runner_->NotifyRoom();
+            }
+            job();
+            return true;
+        }
+    }
     return false;
 }
 
-void JobRunnerWorker::WorkerLoop() {
-    cr_timestamp_nsec_t last_active_timestamp = GetSystemTimestampNsec();
+bool JobRunnerWorker::TryStealFromVictims() {
+    // All the other workers are asleep, or about to check their own queues before sleeping.
+    if (runner_->active_workers_num_.load(std::memory_order::relaxed) <= 1) {
+        return false;
+    }
+
+    const auto round = index_ + steal_round_++;
+    for (const auto& group : victim_groups_) {
+        for (std::size_t i = 0, idx = round % group.size(); i < group.size(); ++i, ++idx) {
+            if (idx >= group.size()) {
+                idx -= group.size();
+            }
+            auto& victim = runner_->workers_[group[idx]];
+            if (runner_->parking_lot_->IsParked(group[idx])) {
+                continue;
+            }
+            AddToCounter(counters_.steal_attempt_num_, 1);
+            if (victim->TryStealOne()) {
+                AddToCounter(counters_.executed_job_num_, 1);
+                AddToCounter(counters_.stolen_job_num_, 1);
+                DVLOG(1) << __func__ << ": JobRunnerWorker " << index_ << " stole a job from " << group[idx] << ".";
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void JobRunnerWorker::InitStealingVictims() {
+    static constexpr std::size_t kDistanceNum = static_cast<std::size_t>(CpuTopology::Distance::kRemote) + 1;
+
+    const auto&                                        topology = CpuTopology::Get();
+    std::array<std::vector<std::size_t>, kDistanceNum> groups;
+    for (const auto& worker : runner_->workers_) {
+        if (worker.get() == this) {
+            continue;
+        }
+        // Workers without CPU sets may run anywhere, so they are considered remote to all others.
+        const auto distance = cpu_set_.empty() || worker->cpu_set_.empty()
+            ? CpuTopology::Distance::kRemote
+            : topology.GetDistance(cpu_set_.front(), worker->cpu_set_.front());
+        groups[static_cast<std::size_t>(distance)].push_back(worker->index_);
+    }
+
+    victim_groups_.clear();
+    for (auto& group : groups) {
+        if (!group.empty()) {
+            victim_groups_.push_back(std::move(group));
+        }
+    }
+}
+
+void JobRunnerWorker::SetUpThread() {
+    const auto& config = runner_->config_;
+    if (!config.thread_name_prefix_.empty()) {
+        SetCurrentThreadName(config.thread_name_prefix_ + std::to_string(index_));
+    }
+    if (!cpu_set_.empty() && !SetCurrentThreadAffinity(cpu_set_)) {
+        LOG(WARNING) << __func__ << ": JobRunnerWorker " << index_ << " failed to be pinned to its CPUs.";
+    }
+    if (numa_node_ && !SetCurrentThreadPreferredNumaNode(*numa_node_)) {
+        LOG(WARNING) << __func__ << ": JobRunnerWorker " << index_ << " failed to be bound to NUMA node "
+                     << *numa_node_ << ".";
+    }
+}
+
+bool JobRunnerWorker::HasPendingJobs() {
+    return std::any_of(job_queues_.begin(), job_queues_.end(), [](auto& queue) { return !queue.Empty(); }) ||
+        (local_job_queue_ && !local_job_queue_->Empty()) || (deadline_job_queue_ && !deadline_job_queue_->Empty());
+}
+
+void JobRunnerWorker::OnJobFound() {
+    AddToCounter(counters_.executed_job_num_, 1);
+    if (runner_->config_.max_queue_depth_ > 0) [[unlikely]] {
+        runner_->NotifyRoom();
+    }
+    // The worker is no longer looking for jobs.
+    SetSpinning(false);
+    if (runner_->spinning_workers_num_.load(std::memory_order::relaxed) == 0 &&
+        runner_->parking_lot_->ParkedNum() > 0 && HasPendingJobs()) {
+        runner_->parking_lot_->UnparkOne();
+    }
+}
+
+void JobRunnerWorker::SetSpinning(bool spinning) {
+    if (spinning_ == spinning) [[likely]] {
+        return;
+    }
+    spinning_ = spinning;
+    if (spinning) {
+        runner_->spinning_workers_num_.fetch_add(1, std::memory_order::relaxed);
+    } else {
+        runner_->spinning_workers_num_.fetch_sub(1, std::memory_order::relaxed);
+    }
+}
 
-    const long long active_time_nsec =
-        std::chrono::duration_cast<std::chrono::nanoseconds>(runner_->config_.active_time_).count();
+std::size_t JobRunnerWorker::QueueDepth() const {
+    std::size_t depth = 0;
+    for (const auto& job_queue : job_queues_) {
+        depth += job_queue.SizeApprox();
+    }
+    if (local_job_queue_) {
+        depth += local_job_queue_->SizeApprox();
+    }
+    if (deadline_job_queue_) {
+        depth += deadline_job_queue_->SizeApprox();
+    }
+    return depth;
+}
+
+JobRunner::WorkerTimeStats JobRunnerWorker::GetTimeStats() const {
+    return {
+        .busy_nsec_       = counters_.busy_nsec_.load(std::memory_order::relaxed),
+        .spin_nsec_       = counters_.spin_nsec_.load(std::memory_order::relaxed),
+        .parked_nsec_     = counters_.parked_nsec_.load(std::memory_order::relaxed),
+        .spin_limit_nsec_ = counters_.spin_limit_nsec_.load(std::memory_order::relaxed),
+    };
+}
 
+bool JobRunnerWorker::TryPushLocal(job_t& job) {
+    return local_job_queue_ && local_job_queue_->TryPush(job);
+}
+
+void JobRunnerWorker::WorkerLoop() {
     kCurrentThreadJobRunner   = reinterpret_cast<std::uintptr_t>(runner_);
     kCurrentThreadWorkerIndex = index_;
 
-    bool has_pending_jobs = false;
+    SetUpThread();
+
+    const bool always_active = index_ < runner_->config_.always_active_thread_num_;
+    const bool adaptive      = runner_->config_.adaptive_spinning_;
+
+    // Stealing is skipped for a number of rounds after failures, so that idle workers do not keep probing others.
+    std::size_t steal_backoff   = 0;
+    std::size_t steal_countdown = 0;
+
+    // The start of the current busy period, and of the current idle period, through spinning and parking, until the
+    // next job is found. The latter is zero while busy, so that busy workers read no clock.
+    cr_timestamp_nsec_t busy_since     = GetSystemTimestampNsec();
+    cr_timestamp_nsec_t idle_since     = 0;
+    cr_timestamp_nsec_t spinning_since = 0;
+
+    // Called after running the job found, so the idle period ends at `found_at`, when the worker started looking.
+    const auto end_idle = [&](cr_timestamp_nsec_t found_at) {
+        if (idle_since == 0) [[likely]] {
+            return;
+        }
+        AddToCounter(counters_.spin_nsec_, found_at - spinning_since);
+        SetSpinning(false);
+        if (adaptive) {
+            spin_policy_.OnIdleEnd(found_at - idle_since);
+            counters_.spin_limit_nsec_.store(spin_policy_.SpinLimitNsec(), std::memory_order::relaxed);
+        }
+        busy_since = found_at;
+        idle_since = 0;
+    };
 
     runner_->active_workers_num_.fetch_add(1);
     while (!shutdown_flag_.load()) {
-        if (TryProcessOne() || runner_->Steal()) {
-            has_pending_jobs = true;
+        const auto polled_at = idle_since == 0 ? 0 : GetSystemTimestampNsec();
+        if (TryProcessOne()) {
+            end_idle(polled_at);
             continue;
         }
-        if (index_ < runner_->config_.always_active_thread_num_) {
-            impl::SpinForApprox1us();
+        if (steal_countdown > 0) {
+            --steal_countdown;
+        } else if (runner_->Steal()) {
+            end_idle(polled_at);
+            steal_backoff = 0;
             continue;
+        } else {
+            steal_backoff   = std::clamp<std::size_t>(steal_backoff * 2, 1, kMaxStealBackoff);
+            steal_countdown = steal_backoff;
         }
-        if (has_pending_jobs) {
-            last_active_timestamp = GetSystemTimestampNsec();
-            has_pending_jobs      = false;
+
+        const auto now = polled_at == 0 ? GetSystemTimestampNsec() : polled_at;
+        if (idle_since == 0) {
+            AddToCounter(counters_.busy_nsec_, now - busy_since);
+            idle_since     = now;
+            spinning_since = now;
+            SetSpinning(true);
         }
-        if (GetSystemTimestampNsec() < last_active_timestamp + active_time_nsec) {
+        if (always_active || now < spinning_since + spin_policy_.SpinLimitNsec()) {
             impl::SpinForApprox1us();
             continue;
         }
+
+        AddToCounter(counters_.spin_nsec_, now - spinning_since);
+        SetSpinning(false);
         runner_->active_workers_num_.fetch_sub(1);
         DVLOG(1) << __func__ << ": JobRunnerWorker " << index_ << " is inactive.";
-        std::unique_lock<std::mutex> lock(inactive_cv_mutex_);
-        constexpr auto               kWorkerIdleTime = std::chrono::seconds(1);
-        if (shutdown_flag_.load()) {
-            break;
+        // Jobs pushed to this worker after `PrepareToPark` always unpark it, see `ParkingLot`.
+        auto& parking_lot = *runner_->parking_lot_;
+        parking_lot.PrepareToPark(index_);
+        if (shutdown_flag_.load() || HasPendingJobs()) {
+            parking_lot.CancelPark(index_);
+        } else {
+            parking_lot.Park(index_);
         }
-        inactive_cv_.wait_for(lock, kWorkerIdleTime);
         DVLOG(1) << __func__ << ": JobRunnerWorker " << index_ << " is active.";
         runner_->active_workers_num_.fetch_add(1);
+        steal_countdown = 0;
+
+        // Woken up for new jobs, look for them as a spinning worker again.
+        spinning_since = GetSystemTimestampNsec();
+        AddToCounter(counters_.parked_nsec_, spinning_since - now);
+        SetSpinning(true);
+    }
+
+    const auto now = GetSystemTimestampNsec();
+    if (idle_since == 0) {
+        AddToCounter(counters_.busy_nsec_, now - busy_since);
+    } else {
+        AddToCounter(counters_.spin_nsec_, now - spinning_since);
     }
+    SetSpinning(false);
     runner_->active_workers_num_.fetch_sub(1);
+    DLOG(INFO) << __func__ << ": JobRunnerWorker " << index_ << " was busy for "
+               << static_cast<double>(counters_.busy_nsec_.load(std::memory_order::relaxed)) / 1e6
+               << "ms, spinning for "
+               << static_cast<double>(counters_.spin_nsec_.load(std::memory_order::relaxed)) / 1e6
+               << "ms, and parked for "
+               << static_cast<double>(counters_.parked_nsec_.load(std::memory_order::relaxed)) / 1e6 << "ms.";
     stopped_flag_.store(true);
 }
 
 void JobRunnerWorker::Stop() {
-    bool                         expected_shutdown_flag = false;
-    std::unique_lock<std::mutex> lock(inactive_cv_mutex_);
+    bool expected_shutdown_flag = false;
     if (!shutdown_flag_.compare_exchange_strong(expected_shutdown_flag, true)) {
         return;
     }
-    inactive_cv_.notify_all();
+    runner_->parking_lot_->Unpark(index_);
     DLOG(INFO) << __func__ << ": JobRunnerWorker " << index_ << " is stopping.";
 }
 
@@ -489,6 +1620,10 @@ void JobRunnerWorker::Join() {
     if (!thread_.joinable()) {
         return;
     }
+    if (thread_.get_id() == std::this_thread::get_id()) [[unlikely]] {
+        LOG(ERROR) << __func__ << ": JobRunnerWorker " << index_ << " cannot be joined by a job of itself.";
+        return;
+    }
     DLOG(INFO) << __func__ << ": JobRunnerWorker " << index_ << " is stopped.";
     thread_.join();
     std::atomic_thread_fence(std::memory_order::seq_cst);
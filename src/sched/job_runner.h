@@ -1,33 +1,194 @@
 #pragma once
 
+#include "cris/core/utils/inline_function.h"
+#include "cris/core/utils/time.h"
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+
 #include <atomic>
 #include <chrono>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace cris::core {
 
 class JobRunnerWorker;
 
+class ParkingLot;
+
+// A job to run at some time, or periodically, see `JobRunner::AddJobAt`.
+class JobRunnerTimer;
+
+// The timing wheel and the thread adding the timer jobs when they expire.
+class JobRunnerTimers;
+
 // An object for serialized jobs. The jobs bound to the same strand object must run sequentially.
 class JobRunnerStrand;
 
-// An object for extending the lifecycle of one job in the strand.
+// An object for extending the lifecycle of one job in the strand. The job is considered finished when all the
+// references to its token are released. Each strand owns one token, so handing it out does not allocate.
 class JobAliveToken;
 
+void intrusive_ptr_add_ref(JobAliveToken* token) noexcept;
+void intrusive_ptr_release(JobAliveToken* token) noexcept;
+
 using JobRunnerStrandPtr = std::shared_ptr<JobRunnerStrand>;
-using JobAliveTokenPtr   = std::shared_ptr<JobAliveToken>;
+using JobAliveTokenPtr   = boost::intrusive_ptr<JobAliveToken>;
+
+// `JobAliveTokenPtr` used to be `std::shared_ptr<JobAliveToken>`. Strand jobs spelling that type out, instead of
+// `JobAliveTokenPtr`, no longer compile and must switch to it. Code that still needs a `std::shared_ptr`, e.g. to watch
+// the job with a `std::weak_ptr`, can wrap the token with this. The wrapper allocates, and holds the token until the
+// last copy of it is released.
+inline std::shared_ptr<JobAliveToken> ToSharedAliveToken(JobAliveTokenPtr token) {
+    auto* raw_token = token.get();
+    // Released by the deleter, since the deleter itself lives as long as the weak references.
+    return std::shared_ptr<JobAliveToken>(
+        raw_token,
+        [token = std::move(token)](JobAliveToken*) mutable { token.reset(); });
+}
 
 class JobRunner : public std::enable_shared_from_this<JobRunner> {
    public:
     using Self = JobRunner;
 
+    enum class QueueType {
+        // Each worker owns one lock-free MPMC queue. The owner and the thieves consume it in the same FIFO way.
+        kLockFree = 0,
+        // In addition, each worker owns a Chase-Lev deque for the jobs it spawns. The owner pushes and pops them
+        // LIFO without CAS, for better cache locality, while thieves take the oldest ones FIFO.
+        kWorkStealing,
+    };
+
+    // Workers prefer jobs of higher priorities, while still running the lower ones at a weighted share, so that a
+    // flood of low priority jobs does not delay the high priority ones, and vice versa does not starve them.
+    enum class Priority {
+        kHigh = 0,
+        kNormal,
+        kLow,
+    };
+
+    static constexpr std::size_t kPriorityNum = 3;
+
+    enum class SchedulingPolicy {
+        // Jobs are picked by their priorities, see `Priority`.
+        kPriority = 0,
+        // Every job carries an absolute deadline, and workers pick the earliest one among all the workers. Jobs
+        // added without a deadline are given one of `relative_deadline_` after being added, and their priorities are
+        // ignored.
+        kEarliestDeadlineFirst,
+    };
+
+    // What to do with a job added to a full queue, see `Config::max_queue_depth_` and `StrandConfig::max_pending_`.
+    enum class OverflowPolicy {
+        // Wait until there is room. Workers of the runner run other jobs meanwhile, instead of blocking, so jobs
+        // adding with it must not hold locks that other jobs may take. Jobs nested a few levels deep that way are
+        // added over the limit.
+        kBlock = 0,
+        // Drop the oldest pending job to make room. Only for strands, queues of the workers drop the newest instead,
+        // as they hold turns of strands and resumptions of coroutines, which must not be dropped.
+        kDropOldest,
+        // Reject the job, i.e. adding it returns false.
+        kDropNewest,
+    };
+
     struct Config {
         std::size_t              thread_num_{1};
         std::size_t              always_active_thread_num_{0};
         std::chrono::nanoseconds active_time_{0};
+        QueueType                queue_type_{QueueType::kLockFree};
+        SchedulingPolicy         scheduling_policy_{SchedulingPolicy::kPriority};
+        std::chrono::nanoseconds relative_deadline_{std::chrono::milliseconds(10)};
+
+        // Let each worker adapt how long it spins before sleeping to how soon jobs arrived after it went idle
+        // recently, up to `active_time_`. Otherwise it always spins for `active_time_`.
+        bool adaptive_spinning_{true};
+
+        // Report the queueing delay and the execution time of every job to the timer sections
+        // "JobRunner/QueueingDelay" and "JobRunner/Execution". It costs a heap allocation per job for jobs capturing
+        // more than a few bytes, plus two timestamps.
+        bool job_timing_{false};
+
+        // The resolution of timers. Timer jobs are added up to a tick later than their times, see `AddJobAt`.
+        std::chrono::nanoseconds timer_tick_{std::chrono::microseconds(100)};
+
+        // The maximum number of jobs in the queues of each worker, zero for no limit, and what to do when a worker is
+        // full. It is a soft limit on the approximate depths. Only jobs added by `AddJob`, `AddJobs` and
+        // `AddJobWithDeadline` are held back, while turns of strands, timer jobs and resumptions of coroutines always
+        // go through.
+        std::size_t    max_queue_depth_{0};
+        OverflowPolicy overflow_policy_{OverflowPolicy::kBlock};
+
+        // CPUs to pin the workers to. Worker `i` is pinned to `cpu_sets_[i % cpu_sets_.size()]`. Empty for no pinning.
+        std::vector<std::vector<std::size_t>> cpu_sets_{};
+        // NUMA nodes to bind the workers to, assigned in the same way as `cpu_sets_`. Queues of a worker are allocated
+        // from its node, and it is pinned to the CPUs of the node if it has no CPU set. Negative for no binding.
+        std::vector<int> numa_nodes_{};
+        // Workers are named "<thread_name_prefix_><index>". Empty for no names.
+        std::string thread_name_prefix_{"cr_worker_"};
+    };
+
+    struct StrandConfig {
+        // The maximum number of jobs a worker runs in a row for the strand, before yielding back to the runner.
+        // Only jobs that do not hand out their alive tokens are run in a row.
+        std::size_t max_batch_{1};
+        // The maximum time a worker keeps running jobs in a row for the strand. Zero means no limit.
+        std::chrono::nanoseconds max_time_{0};
+        // The priority of all the jobs in the strand.
+        Priority priority_{Priority::kNormal};
+        // The maximum number of jobs waiting in the strand, zero for no limit, and what to do when it is full. With
+        // `OverflowPolicy::kDropOldest` and a limit of 1, the strand keeps the latest job only, e.g. to coalesce the
+        // messages of a channel to the latest one. Jobs of the strand must not block on it, and coroutines must not
+        // await a strand dropping the oldest jobs, or they may never resume.
+        std::size_t    max_pending_{0};
+        OverflowPolicy overflow_policy_{OverflowPolicy::kBlock};
+    };
+
+    // The time a worker spent in each state since it started, counting finished periods only.
+    struct WorkerTimeStats {
+        // Running jobs, and looking for them in between.
+        cr_duration_nsec_t busy_nsec_{0};
+        // Idle, but spinning for new jobs.
+        cr_duration_nsec_t spin_nsec_{0};
+        cr_duration_nsec_t parked_nsec_{0};
+        // How long the worker currently spins before parking, see `Config::adaptive_spinning_`.
+        cr_duration_nsec_t spin_limit_nsec_{0};
+    };
+
+    struct WorkerStats {
+        // Jobs waiting in the queues of the worker, approximately.
+        std::size_t queue_depth_{0};
+        // Jobs run by the worker, including the stolen ones.
+        std::uint64_t executed_job_num_{0};
+        // Attempts to steal from each of the other workers, and the successful ones.
+        std::uint64_t   steal_attempt_num_{0};
+        std::uint64_t   stolen_job_num_{0};
+        // Jobs dropped or rejected because the queues of the worker were full, see `Config::max_queue_depth_`.
+        std::uint64_t   dropped_job_num_{0};
+        WorkerTimeStats time_{};
+    };
+
+    // A snapshot of the counters, which are updated concurrently, so they may not add up exactly.
+    struct Stats {
+        std::size_t thread_num_{0};
+        std::size_t active_thread_num_{0};
+        std::size_t spinning_thread_num_{0};
+        std::size_t parked_thread_num_{0};
+        std::size_t deadline_miss_num_{0};
+        // Sums of all the workers.
+        std::size_t   queue_depth_{0};
+        std::uint64_t executed_job_num_{0};
+        // Jobs dropped or rejected by the full workers, plus those by the full strands, see `OverflowPolicy`.
+        std::uint64_t dropped_job_num_{0};
+        // Jobs that waited for room in the full workers or strands.
+        std::uint64_t blocked_job_num_{0};
+        // Indexed by workers.
+        std::vector<WorkerStats> workers_{};
     };
 
     struct TryRunImmediately {
@@ -40,6 +201,80 @@ class JobRunner : public std::enable_shared_from_this<JobRunner> {
 
     struct ForceRunImmediately {};
 
+    // Adding a job without waiting for room, for callers that must not block, e.g. in read-side critical sections,
+    // see `RcuReadGuard`. When the queue or the strand is full with `OverflowPolicy::kBlock`, the job is left as it is
+    // and FULL is returned, to be added again after `WaitForRoom`.
+    struct NoWait {
+        enum class State {
+            FAILED = 0,
+            ENQUEUED,
+            FULL,
+        };
+    };
+
+    // Awaited in a coroutine, it resumes the coroutine as a job of the runner, or of the strand. See `Task`.
+    class ScheduleAwaiter {
+       public:
+        ScheduleAwaiter(JobRunner* runner, std::size_t scheduler_hint, Priority priority)
+            : runner_(runner)
+            , scheduler_hint_(scheduler_hint)
+            , priority_(priority) {}
+
+        explicit ScheduleAwaiter(JobRunnerStrandPtr strand) : strand_(std::move(strand)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        // Returns false to resume the coroutine in the current thread, if the job cannot be added.
+        bool await_suspend(std::coroutine_handle<> handle);
+
+        void await_resume() const noexcept {}
+
+       private:
+        JobRunner*         runner_{nullptr};
+        JobRunnerStrandPtr strand_{};
+        std::size_t        scheduler_hint_{0};
+        Priority           priority_{Priority::kNormal};
+    };
+
+    // Awaited in a coroutine, it resumes the coroutine as a job of the runner at some time. See `Task`.
+    class ScheduleAtAwaiter {
+       public:
+        ScheduleAtAwaiter(JobRunner* runner, cr_timestamp_nsec_t time_nsec, Priority priority)
+            : runner_(runner)
+            , time_nsec_(time_nsec)
+            , priority_(priority) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        // Returns false to resume the coroutine in the current thread, if the job cannot be added.
+        bool await_suspend(std::coroutine_handle<> handle);
+
+        void await_resume() const noexcept {}
+
+       private:
+        JobRunner*          runner_;
+        cr_timestamp_nsec_t time_nsec_;
+        Priority            priority_;
+    };
+
+    // For cancelling a job added by `AddJobAt`, `AddJobAfter` or `AddPeriodicJob`. Copies refer to the same job.
+    class TimerHandle {
+       public:
+        TimerHandle() = default;
+
+        explicit TimerHandle(std::shared_ptr<JobRunnerTimer> timer) : timer_(std::move(timer)) {}
+
+        // Returns true if the job will not run from now on. A periodic job can be cancelled while running, then it
+        // finishes the current run only, while a one-shot job cannot.
+        bool Cancel() const;
+
+        // Empty if the job was not added, i.e. the runner was stopped.
+        explicit operator bool() const noexcept { return static_cast<bool>(timer_); }
+
+       private:
+        std::shared_ptr<JobRunnerTimer> timer_{};
+    };
+
     ~JobRunner();
 
     JobRunner(const Self&)       = delete;
@@ -47,9 +282,16 @@ class JobRunner : public std::enable_shared_from_this<JobRunner> {
     Self& operator=(const Self&) = delete;
     Self& operator=(Self&&)      = delete;
 
-    using job_t = std::function<void()>;
+    // Jobs capturing no more than 64 bytes are stored inline, without heap allocation.
+    using job_t = InlineFunction<void()>;
 
-    [[nodiscard]] JobRunnerStrandPtr MakeStrand();
+    // Jobs in strands, holding the alive token until the job is considered finished. Large enough for wrapping a
+    // `job_t` inline.
+    using strand_job_t = InlineFunction<void(JobAliveTokenPtr&&), sizeof(job_t)>;
+
+    [[nodiscard]] JobRunnerStrandPtr MakeStrand(StrandConfig config);
+
+    [[nodiscard]] JobRunnerStrandPtr MakeStrand() { return MakeStrand(StrandConfig{}); }
 
     ///
     /// Add a job to run
@@ -59,18 +301,106 @@ class JobRunner : public std::enable_shared_from_this<JobRunner> {
     ///                       Same integer means the job will assign to the same worker.
     ///                       Note that the jobs are stealable, so the worker that runs the job
     ///                       may be different from the assigned worker.
-    bool AddJob(job_t&& job, std::size_t scheduler_hint);
+    /// @param priority       the priority of the job.
+    bool AddJob(job_t&& job, std::size_t scheduler_hint, Priority priority);
+
+    bool AddJob(job_t&& job, std::size_t scheduler_hint) {
+        return AddJob(std::move(job), scheduler_hint, Priority::kNormal);
+    }
+
+    bool AddJob(job_t&& job, Priority priority) { return AddJob(std::move(job), DefaultSchedulerHint(), priority); }
 
     bool AddJob(job_t&& job) { return AddJob(std::move(job), DefaultSchedulerHint()); }
 
     bool AddJob(job_t&& job, JobRunnerStrandPtr strand);
 
-    bool AddJob(std::function<void(JobAliveTokenPtr&&)>&& job, JobRunnerStrandPtr strand);
+    bool AddJob(strand_job_t&& job, JobRunnerStrandPtr strand);
+
+    // `priority` only applies without strand. Jobs in a strand run with the priority of the strand.
+    bool AddJob(job_t&& job, JobRunnerStrandPtr strand, Priority priority);
+
+    bool AddJob(strand_job_t&& job, JobRunnerStrandPtr strand, Priority priority);
+
+    ///
+    /// Add a job to run before a deadline. Only meaningful with `SchedulingPolicy::kEarliestDeadlineFirst`, otherwise
+    /// it is the same as adding a job of the normal priority.
+    ///
+    /// @param job            a function to run.
+    /// @param deadline_nsec  the absolute timestamp, from `GetSystemTimestampNsec()`, by which the job should finish.
+    ///                       Jobs finishing later are counted as missed deadlines, see `DeadlineMissNum()`.
+    /// @param scheduler_hint same as `AddJob`.
+    bool AddJobWithDeadline(job_t&& job, cr_timestamp_nsec_t deadline_nsec, std::size_t scheduler_hint);
+
+    bool AddJobWithDeadline(job_t&& job, cr_timestamp_nsec_t deadline_nsec) {
+        return AddJobWithDeadline(std::move(job), deadline_nsec, DefaultSchedulerHint());
+    }
 
     bool AddJobs(std::vector<job_t>&& jobs, std::size_t scheduler_hint);
 
     bool AddJobs(std::vector<job_t>&& jobs) { return AddJobs(std::move(jobs), DefaultSchedulerHint()); }
 
+    // `co_await runner->Schedule()` in a coroutine to continue as a job, see `AddJob` for the parameters.
+    [[nodiscard]] ScheduleAwaiter Schedule(std::size_t scheduler_hint, Priority priority = Priority::kNormal) {
+        return ScheduleAwaiter(this, scheduler_hint, priority);
+    }
+
+    [[nodiscard]] ScheduleAwaiter Schedule(Priority priority = Priority::kNormal) {
+        return Schedule(DefaultSchedulerHint(), priority);
+    }
+
+    ///
+    /// Add a job to run at some time. Timers are kept in a timing wheel of the runner, and a timer thread of the
+    /// runner, started on first use, adds them as jobs when they expire, so that there can be millions of them.
+    ///
+    /// @param job       a function to run.
+    /// @param time_nsec the absolute timestamp, from `GetSystemTimestampNsec()`, at which the job is added. It may be
+    ///                  up to a tick, see `Config::timer_tick_`, later, but never earlier.
+    /// @param priority  the priority of the job.
+    ///
+    /// @return          a handle for cancelling the job, empty if the runner is stopped.
+    TimerHandle AddJobAt(job_t&& job, cr_timestamp_nsec_t time_nsec, Priority priority);
+
+    TimerHandle AddJobAt(job_t&& job, cr_timestamp_nsec_t time_nsec) {
+        return AddJobAt(std::move(job), time_nsec, Priority::kNormal);
+    }
+
+    TimerHandle AddJobAt(job_t&& job, cr_timestamp_nsec_t time_nsec, JobRunnerStrandPtr strand);
+
+    TimerHandle AddJobAfter(job_t&& job, std::chrono::nanoseconds delay, Priority priority) {
+        return AddJobAt(std::move(job), GetSystemTimestampNsec() + delay.count(), priority);
+    }
+
+    TimerHandle AddJobAfter(job_t&& job, std::chrono::nanoseconds delay) {
+        return AddJobAfter(std::move(job), delay, Priority::kNormal);
+    }
+
+    TimerHandle AddJobAfter(job_t&& job, std::chrono::nanoseconds delay, JobRunnerStrandPtr strand) {
+        return AddJobAt(std::move(job), GetSystemTimestampNsec() + delay.count(), std::move(strand));
+    }
+
+    ///
+    /// Add a job to run every `period`, starting a period later, until cancelled. A run is skipped if the previous one
+    /// has not finished, and runs missed by a late timer are not made up for.
+    ///
+    TimerHandle AddPeriodicJob(job_t&& job, std::chrono::nanoseconds period, Priority priority);
+
+    TimerHandle AddPeriodicJob(job_t&& job, std::chrono::nanoseconds period) {
+        return AddPeriodicJob(std::move(job), period, Priority::kNormal);
+    }
+
+    TimerHandle AddPeriodicJob(job_t&& job, std::chrono::nanoseconds period, JobRunnerStrandPtr strand);
+
+    // `co_await runner->ScheduleAt(time_nsec)` in a coroutine to continue as a job at the time, see `AddJobAt`.
+    [[nodiscard]] ScheduleAtAwaiter ScheduleAt(cr_timestamp_nsec_t time_nsec, Priority priority = Priority::kNormal) {
+        return ScheduleAtAwaiter(this, time_nsec, priority);
+    }
+
+    [[nodiscard]] ScheduleAtAwaiter ScheduleAfter(
+        std::chrono::nanoseconds delay,
+        Priority                 priority = Priority::kNormal) {
+        return ScheduleAt(GetSystemTimestampNsec() + delay.count(), priority);
+    }
+
     ///
     /// Add a job to run, run the job in the current thread immediately if possible.
     ///
@@ -85,25 +415,45 @@ class JobRunner : public std::enable_shared_from_this<JobRunner> {
     /// Make sure that you know what you are doing before using.
     TryRunImmediately::State AddJob(job_t&& job, JobRunnerStrandPtr strand, TryRunImmediately);
 
-    TryRunImmediately::State AddJob(
-        std::function<void(JobAliveTokenPtr&&)>&& job,
-        JobRunnerStrandPtr                        strand,
-        TryRunImmediately);
+    TryRunImmediately::State AddJob(strand_job_t&& job, JobRunnerStrandPtr strand, TryRunImmediately);
 
     bool AddJob(job_t job, JobRunnerStrandPtr strand, ForceRunImmediately);
 
-    bool AddJob(std::function<void(JobAliveTokenPtr&&)> job, JobRunnerStrandPtr strand, ForceRunImmediately);
+    bool AddJob(strand_job_t job, JobRunnerStrandPtr strand, ForceRunImmediately);
+
+    NoWait::State AddJob(job_t&& job, std::size_t scheduler_hint, Priority priority, NoWait);
+
+    // Without strand, the job is added to the worker of the hint with the priority, and gets a null alive token.
+    NoWait::State AddJob(
+        strand_job_t&&     job,
+        JobRunnerStrandPtr strand,
+        std::size_t        scheduler_hint,
+        Priority           priority,
+        NoWait);
+
+    // Wait until the strand, or the worker of the hint without strand, has room for a job added with `NoWait`. Returns
+    // false if the runner is stopping.
+    bool WaitForRoom(const JobRunnerStrandPtr& strand, std::size_t scheduler_hint);
 
     ///
-    /// Randomly steal a job from the workers and run.
+    /// Steal a job from the workers and run. Workers of this runner try the ones closer to them in the CPU topology
+    /// first, others pick randomly.
     ///
     /// @return true if any job was stolen
     bool Steal();
 
+    ///
+    /// Run a pending job, for threads waiting for jobs of this runner to help instead of blocking. Workers of this
+    /// runner take from their own queues first, then steal like `Steal`.
+    ///
+    /// @return true if any job was run
+    bool RunOneJob();
+
     JobRunner& Stop();
 
     void Join();
 
+    // Wake up one of the sleeping workers, if any.
     void NotifyOneWorker();
 
     std::size_t ThreadNum() const;
@@ -112,19 +462,93 @@ class JobRunner : public std::enable_shared_from_this<JobRunner> {
 
     std::size_t DefaultSchedulerHint();
 
+    // The number of jobs that finished after their deadlines. The lateness of them is also reported to the timer
+    // section "JobRunner/DeadlineMiss".
+    std::size_t DeadlineMissNum() const;
+
+    // Indexed by workers.
+    std::vector<WorkerTimeStats> GetWorkerTimeStats() const;
+
+    // Cheap enough to be called periodically, it only reads relaxed counters.
+    Stats GetStats() const;
+
     static std::shared_ptr<JobRunner> MakeJobRunner(Config config);
 
    private:
     friend class JobRunnerWorker;
+    friend class JobRunnerStrand;
+    friend class JobRunnerTimers;
 
     using worker_list_t = std::vector<std::unique_ptr<JobRunnerWorker>>;
 
     explicit JobRunner(Config config);
 
+    // `AddJob` and `AddJobWithDeadline`, without the limits of the queues.
+    bool PushJob(job_t&& job, std::size_t scheduler_hint, Priority priority);
+
+    bool PushJobWithDeadline(job_t&& job, cr_timestamp_nsec_t deadline_nsec, std::size_t scheduler_hint);
+
+    // Whether jobs can be added to the worker, under `Config::max_queue_depth_`. It blocks until there is room with
+    // `OverflowPolicy::kBlock`, and returns false if the jobs are to be dropped.
+    bool AdmitJobs(std::size_t scheduler_hint, std::size_t job_num);
+
+    // Whether the worker of the hint is under `Config::max_queue_depth_`.
+    bool HasRoom(std::size_t scheduler_hint) const;
+
+    // Whether `Stop` is called.
+    bool IsStopping() const;
+
+    // Wait until `has_room()`, or the runner is stopping. Workers of the runner run other jobs meanwhile, so that
+    // jobs blocked by themselves do not deadlock. If those jobs wait for room again a few levels deep, the worker stops
+    // waiting and lets the job exceed the limit. Other threads sleep until jobs are taken out of the queues with limits,
+    // see `NotifyRoom`. Returns false if stopping.
+    bool WaitForRoom(const std::function<bool()>& has_room, const std::function<bool()>& is_stopping);
+
+    // Called after a job is taken out of a queue with a limit. Wakes up the threads in `WaitForRoom` if there are any,
+    // which costs a fence otherwise.
+    void NotifyRoom();
+
+    // Run a job with `SchedulingPolicy::kEarliestDeadlineFirst`, and account for the deadline.
+    void RunDeadlineJob(job_t& job, cr_timestamp_nsec_t deadline_nsec);
+
+    // Record when the job is added, for `Config::job_timing_`.
+    static job_t WrapJobForTiming(job_t&& job);
+
+    // `period_nsec` is zero for one-shot jobs.
+    TimerHandle AddTimer(
+        job_t&&             job,
+        cr_timestamp_nsec_t time_nsec,
+        cr_duration_nsec_t  period_nsec,
+        JobRunnerStrandPtr  strand,
+        Priority            priority);
+
+    // Wake up the worker for the jobs just pushed to it if it is asleep, or another one to steal them if necessary.
+    void NotifyWorkerOfNewJobs(std::size_t worker_idx);
+
     Config                   config_;
     std::atomic<bool>        ready_for_stealing_{false};
     std::atomic<std::size_t> active_workers_num_{0};
-    worker_list_t            workers_;
+    std::atomic<std::size_t> deadline_miss_num_{0};
+    std::atomic<std::size_t> spinning_workers_num_{0};
+
+    // Counted by producers, for `GetStats`. Drops of the workers are counted by themselves.
+    std::atomic<std::uint64_t> strand_dropped_job_num_{0};
+    std::atomic<std::uint64_t> blocked_job_num_{0};
+
+    // Threads blocked in `WaitForRoom` wait for the epoch to change.
+    std::atomic<std::uint32_t> room_epoch_{0};
+    std::atomic<std::size_t>   room_waiter_num_{0};
+
+    // Where idle workers sleep. Outlives the workers.
+    std::unique_ptr<ParkingLot> parking_lot_;
+    worker_list_t               workers_;
+
+    std::unique_ptr<JobRunnerTimers> timers_;
 };
 
+// `co_await strand` in a coroutine to continue as a job of the strand.
+inline JobRunner::ScheduleAwaiter operator co_await(JobRunnerStrandPtr strand) {
+    return JobRunner::ScheduleAwaiter(std::move(strand));
+}
+
 }  // namespace cris::core
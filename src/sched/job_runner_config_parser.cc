@@ -7,6 +7,9 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
 
 namespace cris::core {
 
@@ -38,6 +41,120 @@ void ConfigDataParser(JobRunner::Config& config, simdjson::ondemand::value& val)
             config.active_time_ = std::chrono::milliseconds(active_ms);
         }
     }
+
+    {
+        bool adaptive_spinning = true;
+        if (obj["adaptive_spinning"].get(adaptive_spinning) == simdjson::error_code::SUCCESS) {
+            config.adaptive_spinning_ = adaptive_spinning;
+        }
+    }
+
+    {
+        bool job_timing = false;
+        if (obj["job_timing"].get(job_timing) == simdjson::error_code::SUCCESS) {
+            config.job_timing_ = job_timing;
+        }
+    }
+
+    {
+        std::string_view queue_type;
+        if (obj["queue_type"].get(queue_type) == simdjson::error_code::SUCCESS) {
+            static const std::map<std::string_view, JobRunner::QueueType> queue_types{
+                {"lockfree", JobRunner::QueueType::kLockFree},
+                {"work_stealing", JobRunner::QueueType::kWorkStealing}};
+
+            const auto itr = queue_types.find(queue_type);
+            RAW_CHECK(itr != queue_types.cend(), R"(Expect "queue_type" be in ["lockfree", "work_stealing"].)");
+            config.queue_type_ = itr->second;
+        }
+    }
+
+    {
+        std::string_view scheduling_policy;
+        if (obj["scheduling"].get(scheduling_policy) == simdjson::error_code::SUCCESS) {
+            static const std::map<std::string_view, JobRunner::SchedulingPolicy> scheduling_policies{
+                {"priority", JobRunner::SchedulingPolicy::kPriority},
+                {"edf", JobRunner::SchedulingPolicy::kEarliestDeadlineFirst}};
+
+            const auto itr = scheduling_policies.find(scheduling_policy);
+            RAW_CHECK(itr != scheduling_policies.cend(), R"(Expect "scheduling" be in ["priority", "edf"].)");
+            config.scheduling_policy_ = itr->second;
+        }
+    }
+
+    {
+        std::uint64_t relative_deadline_us = 0;
+        if (obj["relative_deadline_us"].get(relative_deadline_us) == simdjson::error_code::SUCCESS) {
+            config.relative_deadline_ = std::chrono::microseconds(relative_deadline_us);
+        }
+    }
+
+    {
+        std::uint64_t timer_tick_us = 0;
+        if (obj["timer_tick_us"].get(timer_tick_us) == simdjson::error_code::SUCCESS) {
+            config.timer_tick_ = std::chrono::microseconds(timer_tick_us);
+        }
+    }
+
+    {
+        std::uint64_t max_queue_depth = 0;
+        if (obj["max_queue_depth"].get(max_queue_depth) == simdjson::error_code::SUCCESS) {
+            config.max_queue_depth_ = static_cast<std::size_t>(max_queue_depth);
+        }
+    }
+
+    {
+        std::string_view overflow_policy;
+        if (obj["overflow_policy"].get(overflow_policy) == simdjson::error_code::SUCCESS) {
+            static const std::map<std::string_view, JobRunner::OverflowPolicy> overflow_policies{
+                {"block", JobRunner::OverflowPolicy::kBlock},
+                {"drop_oldest", JobRunner::OverflowPolicy::kDropOldest},
+                {"drop_newest", JobRunner::OverflowPolicy::kDropNewest}};
+
+            const auto itr = overflow_policies.find(overflow_policy);
+            RAW_CHECK(
+                itr != overflow_policies.cend(),
+                R"(Expect "overflow_policy" be in ["block", "drop_oldest", "drop_newest"].)");
+            config.overflow_policy_ = itr->second;
+        }
+    }
+
+    {
+        simdjson::ondemand::array cpu_sets;
+        if (obj["cpu_sets"].get(cpu_sets) == simdjson::error_code::SUCCESS) {
+            static constexpr auto kCpuSetsError = R"(Expect "cpu_sets" be a list of lists of CPU indices.)";
+            for (auto&& cpu_set_val : cpu_sets) {
+                simdjson::ondemand::array cpu_set;
+                RAW_CHECK(cpu_set_val.get(cpu_set) == simdjson::error_code::SUCCESS, kCpuSetsError);
+                auto& worker_cpu_set = config.cpu_sets_.emplace_back();
+                for (auto&& cpu_val : cpu_set) {
+                    std::uint64_t cpu = 0;
+                    RAW_CHECK(cpu_val.get(cpu) == simdjson::error_code::SUCCESS, kCpuSetsError);
+                    worker_cpu_set.push_back(static_cast<std::size_t>(cpu));
+                }
+            }
+        }
+    }
+
+    {
+        simdjson::ondemand::array numa_nodes;
+        if (obj["numa_nodes"].get(numa_nodes) == simdjson::error_code::SUCCESS) {
+            for (auto&& numa_node_val : numa_nodes) {
+                std::int64_t numa_node = 0;
+                RAW_CHECK(
+                    numa_node_val.get(numa_node) == simdjson::error_code::SUCCESS,
+                    R"(Expect "numa_nodes" be a list of NUMA node indices.)");
+                config.numa_nodes_.push_back(static_cast<int>(numa_node));
+            }
+        }
+    }
+
+    {
+        std::string_view thread_name_prefix;
+        if (obj["thread_name"].get(thread_name_prefix) == simdjson::error_code::SUCCESS) {
+            config.thread_name_prefix_ = std::string(thread_name_prefix);
+        }
+    }
 }
 
 }  // namespace cris::core
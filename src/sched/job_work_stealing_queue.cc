@@ -0,0 +1,99 @@
+#include "cris/core/sched/job_work_stealing_queue.h"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace cris::core {
+
+JobWorkStealingQueue::JobWorkStealingQueue(std::size_t capacity)
+    : capacity_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity))
+    , mask_(capacity_ - 1)
+    , slots_(std::make_unique<Slot[]>(capacity_)) {
+}
+
+bool JobWorkStealingQueue::TryPush(job_t& job) {
+    const auto bottom = bottom_.load(std::memory_order::relaxed);
+    const auto top    = top_.load(std::memory_order::acquire);
+    if (bottom - top >= static_cast<std::int64_t>(capacity_)) {
+        return false;
+    }
+
+    auto& slot = SlotAt(bottom);
+    // A thief may have claimed this slot in its previous round but not yet finished moving the job out.
+    while (slot.occupied_.load(std::memory_order::acquire)) {
+        std::this_thread::yield();
+    }
+    slot.job_ = std::move(job);
+    slot.occupied_.store(true, std::memory_order::relaxed);
+
+    // Publish the job to the thieves.
+    bottom_.store(bottom + 1, std::memory_order::release);
+    return true;
+}
+
+bool JobWorkStealingQueue::TryPop(job_t& job) {
+    const auto bottom = bottom_.load(std::memory_order::relaxed) - 1;
+    bottom_.store(bottom, std::memory_order::relaxed);
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    auto top = top_.load(std::memory_order::relaxed);
+
+    if (top > bottom) {
+        // Empty.
+        bottom_.store(bottom + 1, std::memory_order::relaxed);
+        return false;
+    }
+
+    if (top == bottom) {
+        // The last job, compete with thieves.
+        const bool won =
+            top_.compare_exchange_strong(top, top + 1, std::memory_order::seq_cst, std::memory_order::relaxed);
+        bottom_.store(bottom + 1, std::memory_order::relaxed);
+        if (!won) {
+            return false;
+        }
+    }
+
+    auto& slot = SlotAt(bottom);
+    job        = std::move(slot.job_);
+    slot.job_  = nullptr;
+    slot.occupied_.store(false, std::memory_order::relaxed);
+    return true;
+}
+
+bool JobWorkStealingQueue::TrySteal(job_t& job) {
+    auto top = top_.load(std::memory_order::acquire);
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    const auto bottom = bottom_.load(std::memory_order::acquire);
+
+    if (top >= bottom) {
+        return false;
+    }
+
+    // Claim the slot before touching it, since jobs are stored by value.
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order::seq_cst, std::memory_order::relaxed)) {
+        return false;
+    }
+
+    auto& slot = SlotAt(top);
+    job        = std::move(slot.job_);
+    slot.job_  = nullptr;
+    slot.occupied_.store(false, std::memory_order::release);
+    return true;
+}
+
+bool JobWorkStealingQueue::Empty() const {
+    return top_.load(std::memory_order::acquire) >= bottom_.load(std::memory_order::acquire);
+}
+
+std::size_t JobWorkStealingQueue::SizeApprox() const {
+    const auto top    = top_.load(std::memory_order::relaxed);
+    const auto bottom = bottom_.load(std::memory_order::relaxed);
+    return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+}
+
+}  // namespace cris::core
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "cris/core/sched/job_runner.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace cris::core {
+
+// A bounded Chase-Lev work-stealing deque.
+//
+// Only the owner thread may call `TryPush` and `TryPop`, which work on the bottom of the deque (LIFO) and do not
+// involve CAS unless competing with thieves for the last job. Any thread may call `TrySteal`, which takes the oldest
+// job from the top (FIFO).
+//
+// Unlike the original algorithm, jobs are stored by value and the deque never grows, so that a thief never reads a
+// slot before it owns it. When the deque is full, `TryPush` fails and the caller should fall back to another queue.
+class JobWorkStealingQueue {
+   public:
+    using job_t = JobRunner::job_t;
+
+    explicit JobWorkStealingQueue(std::size_t capacity = 8192);
+
+    JobWorkStealingQueue(const JobWorkStealingQueue&)            = delete;
+    JobWorkStealingQueue(JobWorkStealingQueue&&)                 = delete;
+    JobWorkStealingQueue& operator=(const JobWorkStealingQueue&) = delete;
+    JobWorkStealingQueue& operator=(JobWorkStealingQueue&&)      = delete;
+
+    ~JobWorkStealingQueue() = default;
+
+    // Owner only. `job` is moved from only if it returns true.
+    bool TryPush(job_t& job);
+
+    // Owner only. Take the newest job.
+    bool TryPop(job_t& job);
+
+    // Any thread. Take the oldest job. It may fail spuriously when racing with other thieves or the owner.
+    bool TrySteal(job_t& job);
+
+    bool Empty() const;
+
+    // Only a hint, since jobs may be pushed or taken concurrently.
+    std::size_t SizeApprox() const;
+
+    std::size_t Capacity() const { return capacity_; }
+
+   private:
+    struct Slot {
+        // Set by the owner after filling the slot, and cleared by whoever took the job. The owner waits for it to be
+        // cleared before reusing the slot, in case a thief that has claimed the slot is still moving the job out.
+        std::atomic<bool> occupied_{false};
+        job_t             job_;
+    };
+
+    Slot& SlotAt(std::int64_t idx) { return slots_[static_cast<std::size_t>(idx) & mask_]; }
+
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    const std::size_t       capacity_;
+    const std::size_t       mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(kCacheLineSize) std::atomic<std::int64_t> top_{0};
+    alignas(kCacheLineSize) std::atomic<std::int64_t> bottom_{0};
+};
+
+}  // namespace cris::core
@@ -0,0 +1,82 @@
+#include "cris/core/sched/parallel.h"
+
+#include "cris/core/sched/spin_impl.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+
+namespace cris::core {
+
+namespace {
+
+// Waiting callers spin this many rounds without finding jobs to help with before yielding.
+constexpr std::size_t kWaitSpinRounds = 64;
+
+struct ForkJoinState {
+    JobRunner&                                           runner_;
+    const std::function<void(std::size_t, std::size_t)>& body_;
+    const std::size_t                                    grain_;
+    std::atomic<std::size_t>                             pending_{0};
+};
+
+// Fork the upper halves as jobs until the range fits in a grain, then run it.
+void Split(ForkJoinState& state, std::size_t begin, std::size_t end) noexcept {
+    while (end - begin > state.grain_) {
+        const auto mid = begin + (end - begin) / 2;
+        state.pending_.fetch_add(1, std::memory_order::relaxed);
+        const bool added = state.runner_.AddJob([&state, mid, end] {
+            Split(state, mid, end);
+            state.pending_.fetch_sub(1, std::memory_order::release);
+        });
+        if (!added) [[unlikely]] {
+            state.pending_.fetch_sub(1, std::memory_order::relaxed);
+            Split(state, mid, end);
+        }
+        end = mid;
+    }
+    state.body_(begin, end);
+}
+
+}  // namespace
+
+void ParallelFor(
+    JobRunner&                                           runner,
+    std::size_t                                          begin,
+    std::size_t                                          end,
+    const std::function<void(std::size_t, std::size_t)>& body,
+    std::size_t                                          grain) {
+    if (begin >= end) {
+        return;
+    }
+    if (grain == 0) {
+        const auto chunk_num = (runner.ThreadNum() + 1) * cris::libs::execution::kChunksPerThread;
+        grain                = (end - begin + chunk_num - 1) / chunk_num;
+    }
+
+    ForkJoinState state{.runner_ = runner, .body_ = body, .grain_ = grain};
+    Split(state, begin, end);
+
+    // Help with the jobs, which are likely the pieces just forked, until all of them finish.
+    std::size_t idle_rounds = 0;
+    while (state.pending_.load(std::memory_order::acquire) != 0) {
+        if (runner.RunOneJob()) {
+            idle_rounds = 0;
+        } else if (++idle_rounds < kWaitSpinRounds) {
+            impl::CpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobRunnerParallelBackend::ParallelFor(
+    std::size_t                                          begin,
+    std::size_t                                          end,
+    std::size_t                                          grain,
+    const std::function<void(std::size_t, std::size_t)>& body) {
+    cris::core::ParallelFor(*runner_, begin, end, body, grain);
+}
+
+}  // namespace cris::core
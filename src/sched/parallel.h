@@ -0,0 +1,96 @@
+#pragma once
+
+#include "cris/core/sched/job_runner.h"
+#include "cris/core/utils/newcpp/execution.h"
+#include "cris/core/utils/newcpp/parallel.h"
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace cris::core {
+
+// Fork-join on a job runner. The range is split in halves recursively, and the upper halves are added as jobs, so
+// that idle workers steal the larger pieces first. The calling thread runs its own pieces, and helps with the pending
+// jobs of the runner until all the pieces finish, instead of blocking. So it may be called by workers of the runner
+// too, even with a single worker, without deadlocks.
+//
+// `body(chunk_begin, chunk_end)` is called on chunks of at most `grain` elements, or a few chunks per thread if zero.
+// Exceptions escaping from it terminate the program, like the standard parallel algorithms. The runner must not stop
+// before it returns.
+void ParallelFor(
+    JobRunner&                                           runner,
+    std::size_t                                          begin,
+    std::size_t                                          end,
+    const std::function<void(std::size_t, std::size_t)>& body,
+    std::size_t                                          grain = 0);
+
+// Runs the parallel algorithms on a job runner. Set it with `cris::libs::execution::SetParallelBackend` to run the
+// algorithms with `cris::libs::execution::fallback::par` on the runner, as well as with `cris::par` if the standard
+// library has no parallel backend.
+class JobRunnerParallelBackend final : public cris::libs::execution::ParallelBackend {
+   public:
+    explicit JobRunnerParallelBackend(std::shared_ptr<JobRunner> runner) : runner_(std::move(runner)) {}
+
+    void ParallelFor(
+        std::size_t                                          begin,
+        std::size_t                                          end,
+        std::size_t                                          grain,
+        const std::function<void(std::size_t, std::size_t)>& body) override;
+
+    // The workers and the calling thread.
+    std::size_t Concurrency() const override { return runner_->ThreadNum() + 1; }
+
+   private:
+    std::shared_ptr<JobRunner> runner_;
+};
+
+template<std::random_access_iterator iter_t, class value_t, class reduce_op_t>
+value_t ParallelReduce(
+    const std::shared_ptr<JobRunner>& runner,
+    iter_t                            first,
+    iter_t                            last,
+    value_t                           init,
+    reduce_op_t                       reduce_op) {
+    JobRunnerParallelBackend backend(runner);
+    return cris::libs::execution::ParallelReduce(backend, first, last, std::move(init), std::move(reduce_op));
+}
+
+template<std::random_access_iterator iter_t, class value_t, class reduce_op_t, class transform_op_t>
+value_t ParallelTransformReduce(
+    const std::shared_ptr<JobRunner>& runner,
+    iter_t                            first,
+    iter_t                            last,
+    value_t                           init,
+    reduce_op_t                       reduce_op,
+    transform_op_t                    transform_op) {
+    JobRunnerParallelBackend backend(runner);
+    return cris::libs::execution::ParallelTransformReduce(
+        backend,
+        first,
+        last,
+        std::move(init),
+        std::move(reduce_op),
+        std::move(transform_op));
+}
+
+template<std::random_access_iterator in_iter_t, std::random_access_iterator out_iter_t, class op_t>
+out_iter_t ParallelTransform(
+    const std::shared_ptr<JobRunner>& runner,
+    in_iter_t                         first,
+    in_iter_t                         last,
+    out_iter_t                        d_first,
+    op_t                              op) {
+    JobRunnerParallelBackend backend(runner);
+    return cris::libs::execution::ParallelTransform(backend, first, last, d_first, std::move(op));
+}
+
+template<std::random_access_iterator iter_t, class compare_t = std::less<>>
+void ParallelSort(const std::shared_ptr<JobRunner>& runner, iter_t first, iter_t last, compare_t comp = {}) {
+    JobRunnerParallelBackend backend(runner);
+    cris::libs::execution::ParallelSort(backend, first, last, std::move(comp));
+}
+
+}  // namespace cris::core
@@ -0,0 +1,87 @@
+#include "cris/core/sched/parking_lot.h"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace cris::core {
+
+ParkingLot::ParkingLot(std::size_t slot_num)
+    : slot_num_(slot_num)
+    , mask_num_((slot_num + kBitsPerMask - 1) / kBitsPerMask)
+    , slots_(std::make_unique<Slot[]>(slot_num))
+    , parked_masks_(std::make_unique<std::atomic<std::uint64_t>[]>(mask_num_)) {
+}
+
+void ParkingLot::PrepareToPark(std::size_t idx) {
+    parked_masks_[idx / kBitsPerMask].fetch_or(std::uint64_t{1} << (idx % kBitsPerMask), std::memory_order::relaxed);
+    parked_num_.fetch_add(1, std::memory_order::relaxed);
+    slots_[idx].state_.store(kParked, std::memory_order::relaxed);
+    // Pairs with the one in `Unpark` and `UnparkOne`.
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+}
+
+void ParkingLot::CancelPark(std::size_t idx) {
+    slots_[idx].state_.store(kAwake, std::memory_order::relaxed);
+    FinishParking(idx);
+}
+
+void ParkingLot::Park(std::size_t idx) {
+    auto& state = slots_[idx].state_;
+    while (state.load(std::memory_order::acquire) == kParked) {
+        state.wait(kParked, std::memory_order::acquire);
+    }
+    FinishParking(idx);
+}
+
+bool ParkingLot::Unpark(std::size_t idx) {
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    return TryWake(idx);
+}
+
+bool ParkingLot::UnparkOne() {
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    if (parked_num_.load(std::memory_order::relaxed) == 0) [[likely]] {
+        return false;
+    }
+
+    // Rotate the start, so that the slots are woken up evenly.
+    const auto round = unpark_round_.fetch_add(1, std::memory_order::relaxed);
+    const auto shift = static_cast<int>(round % kBitsPerMask);
+    for (std::size_t i = 0, mask_idx = round % mask_num_; i < mask_num_; ++i, ++mask_idx) {
+        if (mask_idx >= mask_num_) {
+            mask_idx -= mask_num_;
+        }
+        for (auto bits = std::rotr(parked_masks_[mask_idx].load(std::memory_order::relaxed), shift); bits != 0;
+             bits &= bits - 1) {
+            const auto bit_idx = (static_cast<std::size_t>(std::countr_zero(bits) + shift)) % kBitsPerMask;
+            const auto idx     = mask_idx * kBitsPerMask + bit_idx;
+            if (idx < slot_num_ && TryWake(idx)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ParkingLot::FinishParking(std::size_t idx) {
+    parked_num_.fetch_sub(1, std::memory_order::relaxed);
+    parked_masks_[idx / kBitsPerMask].fetch_and(
+        ~(std::uint64_t{1} << (idx % kBitsPerMask)),
+        std::memory_order::relaxed);
+}
+
+bool ParkingLot::TryWake(std::size_t idx) {
+    auto&         state    = slots_[idx].state_;
+    std::uint32_t expected = kParked;
+    if (state.load(std::memory_order::relaxed) != kParked ||
+        !state.compare_exchange_strong(expected, kAwake, std::memory_order::acq_rel, std::memory_order::relaxed)) {
+        return false;
+    }
+    state.notify_one();
+    return true;
+}
+
+}  // namespace cris::core
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace cris::core {
+
+// Where idle workers sleep, tracking which of them are sleeping, so that waking one up costs no syscall unless it is
+// actually asleep.
+//
+// Parking takes two phases, like an eventcount. A worker first calls `PrepareToPark`, then checks for new jobs, and
+// either calls `CancelPark` if there are any, or `Park` to sleep. A producer pushes the job first, then calls
+// `Unpark` or `UnparkOne`. With the fences on both sides, either the worker sees the job, or the producer sees the
+// worker parked and wakes it up, so no wakeup is lost.
+class ParkingLot {
+   public:
+    explicit ParkingLot(std::size_t slot_num);
+
+    ParkingLot(const ParkingLot&)            = delete;
+    ParkingLot(ParkingLot&&)                 = delete;
+    ParkingLot& operator=(const ParkingLot&) = delete;
+    ParkingLot& operator=(ParkingLot&&)      = delete;
+
+    ~ParkingLot() = default;
+
+    // Only by the owner of the slot.
+    void PrepareToPark(std::size_t idx);
+
+    // Only by the owner of the slot, after `PrepareToPark`.
+    void CancelPark(std::size_t idx);
+
+    // Only by the owner of the slot, after `PrepareToPark`. Returns when unparked.
+    void Park(std::size_t idx);
+
+    // Returns true if the slot was parked, i.e. this call woke it up.
+    bool Unpark(std::size_t idx);
+
+    // Wake up any one of the parked slots. Returns false if none was parked.
+    bool UnparkOne();
+
+    bool IsParked(std::size_t idx) const { return slots_[idx].state_.load(std::memory_order::relaxed) == kParked; }
+
+    std::size_t ParkedNum() const { return parked_num_.load(std::memory_order::relaxed); }
+
+   private:
+    static constexpr std::uint32_t kAwake  = 0;
+    static constexpr std::uint32_t kParked = 1;
+
+    static constexpr std::size_t kCacheLineSize = 64;
+    static constexpr std::size_t kBitsPerMask   = 64;
+
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<std::uint32_t> state_{kAwake};
+    };
+
+    // Only the owner of a slot updates its bit and the count, so that they never go out of sync with the state.
+    void FinishParking(std::size_t idx);
+
+    // Unpark without the fence.
+    bool TryWake(std::size_t idx);
+
+    const std::size_t                             slot_num_;
+    const std::size_t                             mask_num_;
+    std::unique_ptr<Slot[]>                       slots_;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> parked_masks_;
+
+    alignas(kCacheLineSize) std::atomic<std::size_t> parked_num_{0};
+    std::atomic<std::size_t> unpark_round_{0};
+};
+
+}  // namespace cris::core
@@ -0,0 +1,154 @@
+#include "cris/core/sched/rcu.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cris::core {
+
+namespace {
+
+constexpr std::size_t kCacheLineSize = 64;
+
+// Epoch 0 means the owner thread is not in a critical section.
+constexpr std::uint64_t kQuiescent = 0;
+
+// Slots are never freed, but released when their threads exit, for new threads to reuse. They are linked into a list
+// that only grows, so that neither readers nor writers take a lock to register or scan them.
+struct alignas(kCacheLineSize) RcuReaderSlot {
+    // The epoch when the owner thread entered its outermost critical section.
+    std::atomic<std::uint64_t> epoch_{kQuiescent};
+    std::atomic<bool>          in_use_{true};
+    RcuReaderSlot*             next_{nullptr};
+};
+
+std::atomic<std::uint64_t>  kGlobalEpoch{1};
+std::atomic<RcuReaderSlot*> kReaderSlots{nullptr};
+
+RcuReaderSlot* AcquireReaderSlot() {
+    for (auto* slot = kReaderSlots.load(std::memory_order::acquire); slot; slot = slot->next_) {
+        bool in_use = false;
+        if (!slot->in_use_.load(std::memory_order::relaxed) &&
+            slot->in_use_.compare_exchange_strong(in_use, true, std::memory_order::acquire)) {
+            return slot;
+        }
+    }
+    auto* slot  = new RcuReaderSlot;
+    slot->next_ = kReaderSlots.load(std::memory_order::relaxed);
+    while (!kReaderSlots.compare_exchange_weak(slot->next_, slot, std::memory_order::release)) {
+    }
+    return slot;
+}
+
+class RcuReader {
+   public:
+    RcuReader() : slot_(AcquireReaderSlot()) {}
+
+    RcuReader(const RcuReader&)            = delete;
+    RcuReader(RcuReader&&)                 = delete;
+    RcuReader& operator=(const RcuReader&) = delete;
+    RcuReader& operator=(RcuReader&&)      = delete;
+
+    ~RcuReader() { slot_->in_use_.store(false, std::memory_order::release); }
+
+    void Lock() {
+        if (nesting_++ > 0) {
+            return;
+        }
+        slot_->epoch_.store(kGlobalEpoch.load(std::memory_order::acquire), std::memory_order::relaxed);
+        // Pairs with the one in `RcuSynchronize`. Either the writer sees the epoch, and waits for this critical
+        // section, or this critical section sees what the writer published before it.
+        std::atomic_thread_fence(std::memory_order::seq_cst);
+    }
+
+    void Unlock() {
+        if (--nesting_ > 0) {
+            return;
+        }
+        slot_->epoch_.store(kQuiescent, std::memory_order::release);
+    }
+
+   private:
+    RcuReaderSlot* const slot_;
+    std::size_t          nesting_{0};
+};
+
+RcuReader& GetThreadReader() {
+    static thread_local RcuReader reader;
+    return reader;
+}
+
+// Runs the callbacks of `RcuCall`. Never destroyed, since its thread is detached and may still be running when the
+// process exits.
+class RcuReclaimer {
+   public:
+    RcuReclaimer() { std::thread([this] { Run(); }).detach(); }
+
+    RcuReclaimer(const RcuReclaimer&)            = delete;
+    RcuReclaimer(RcuReclaimer&&)                 = delete;
+    RcuReclaimer& operator=(const RcuReclaimer&) = delete;
+    RcuReclaimer& operator=(RcuReclaimer&&)      = delete;
+
+    void Call(InlineFunction<void()>&& reclaim) {
+        {
+            std::lock_guard lck(mtx_);
+            pending_.push_back(std::move(reclaim));
+        }
+        cv_.notify_one();
+    }
+
+   private:
+    [[noreturn]] void Run() {
+        std::vector<InlineFunction<void()>> batch;
+        while (true) {
+            {
+                std::unique_lock lck(mtx_);
+                cv_.wait(lck, [this] { return !pending_.empty(); });
+                batch.swap(pending_);
+            }
+            RcuSynchronize();
+            for (auto& reclaim : batch) {
+                reclaim();
+            }
+            batch.clear();
+        }
+    }
+
+    std::mutex                          mtx_;
+    std::condition_variable             cv_;
+    std::vector<InlineFunction<void()>> pending_;
+};
+
+}  // namespace
+
+RcuReadGuard::RcuReadGuard() {
+    GetThreadReader().Lock();
+}
+
+RcuReadGuard::~RcuReadGuard() {
+    GetThreadReader().Unlock();
+}
+
+void RcuSynchronize() {
+    // Critical sections entered with the new epoch see what was published before this call.
+    const auto new_epoch = kGlobalEpoch.fetch_add(1, std::memory_order::seq_cst) + 1;
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    for (auto* slot = kReaderSlots.load(std::memory_order::acquire); slot; slot = slot->next_) {
+        for (auto epoch = slot->epoch_.load(std::memory_order::acquire); epoch != kQuiescent && epoch < new_epoch;
+             epoch      = slot->epoch_.load(std::memory_order::acquire)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void RcuCall(InlineFunction<void()> reclaim) {
+    static auto* const reclaimer = new RcuReclaimer;
+    reclaimer->Call(std::move(reclaim));
+}
+
+}  // namespace cris::core
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "cris/core/utils/inline_function.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace cris::core {
+
+// Read-copy-update, for data read on hot paths and rarely updated, e.g. the subscription tables.
+//
+// Readers enter a read-side critical section with `RcuReadGuard`, which costs a store to a slot of the thread and a
+// fence, with no atomic read-modify-write on shared state. Writers publish a new version, and free the old one after
+// `RcuSynchronize`, which waits until every critical section that may still see it has exited, or hand it to `RcuCall`
+// where the writer must not wait. Critical sections may nest, and must not call `RcuSynchronize`, or wait for anything
+// that does.
+class RcuReadGuard {
+   public:
+    RcuReadGuard();
+
+    RcuReadGuard(const RcuReadGuard&)            = delete;
+    RcuReadGuard(RcuReadGuard&&)                 = delete;
+    RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+    RcuReadGuard& operator=(RcuReadGuard&&)      = delete;
+
+    ~RcuReadGuard();
+};
+
+// Wait for a grace period, i.e. until every read-side critical section entered before the call has exited.
+void RcuSynchronize();
+
+// Run `reclaim` after a grace period without waiting for it, e.g. to free what is replaced on paths that must not
+// block. Callbacks run in order on a background thread started by the first call, in batches sharing one grace period.
+// They must not call `RcuSynchronize` either. The ones still pending when the process exits are not run.
+void RcuCall(InlineFunction<void()> reclaim);
+
+// A pointer to an immutable value, replaced by writers with `Update`, and read in read-side critical sections.
+// Updates must be serialized by the callers.
+template<class value_t>
+class RcuPtr {
+   public:
+    explicit RcuPtr(std::unique_ptr<const value_t> value = std::make_unique<const value_t>())
+        : value_(value.release()) {}
+
+    RcuPtr(const RcuPtr&)            = delete;
+    RcuPtr(RcuPtr&&)                 = delete;
+    RcuPtr& operator=(const RcuPtr&) = delete;
+    RcuPtr& operator=(RcuPtr&&)      = delete;
+
+    // Without readers any more.
+    ~RcuPtr() { delete value_.load(std::memory_order::relaxed); }
+
+    // Only in a read-side critical section, and valid until it exits.
+    const value_t& Read() const { return *value_.load(std::memory_order::acquire); }
+
+    // Only by the writer, valid until it updates.
+    const value_t& Get() const { return *value_.load(std::memory_order::relaxed); }
+
+    // Publish the new value, and free the old one after a grace period.
+    void Update(std::unique_ptr<const value_t> value) {
+        std::unique_ptr<const value_t> old_value(value_.exchange(value.release(), std::memory_order::seq_cst));
+        RcuSynchronize();
+    }
+
+    // Publish the new value, and free the old one after a grace period, without waiting for it, see `RcuCall`.
+    void UpdateDeferred(std::unique_ptr<const value_t> value) {
+        RcuCall([old_value = Exchange(std::move(value))]() mutable { old_value.reset(); });
+    }
+
+    // Publish the new value, and return the old one, to be freed by the caller after `RcuSynchronize`. For updating
+    // many pointers with one grace period.
+    [[nodiscard]] std::unique_ptr<const value_t> Exchange(std::unique_ptr<const value_t> value) {
+        return std::unique_ptr<const value_t>(value_.exchange(value.release(), std::memory_order::seq_cst));
+    }
+
+   private:
+    std::atomic<const value_t*> value_;
+};
+
+}  // namespace cris::core
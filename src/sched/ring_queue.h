@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace cris::core {
+
+// A bounded lock-free MPMC ring, storing values in place, so that neither pushing nor popping allocates.
+//
+// Each cell carries a sequence number telling whether it is ready to be written or read in the current round (Dmitry
+// Vyukov's bounded queue). When the ring is full, values overflow to a locked queue. The overflow is only drained after
+// the ring, and no value enters the ring while the overflow is non-empty, so that values pushed one after another are
+// still popped in FIFO order.
+//
+// `TryPop` may fail while a push claimed earlier is still being written, even if later ones are complete.
+template<class value_t>
+class RingQueue {
+   public:
+    explicit RingQueue(std::size_t capacity = 8)
+        : capacity_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity))
+        , mask_(capacity_ - 1)
+        , cells_(std::make_unique<Cell[]>(capacity_)) {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence_.store(i, std::memory_order::relaxed);
+        }
+    }
+
+    RingQueue(const RingQueue&)            = delete;
+    RingQueue(RingQueue&&)                 = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+    RingQueue& operator=(RingQueue&&)      = delete;
+
+    ~RingQueue() = default;
+
+    void Push(value_t&& value) {
+        if (overflow_size_.load(std::memory_order::acquire) == 0 && TryPushToRing(value)) [[likely]] {
+            return;
+        }
+        overflow_size_.fetch_add(1, std::memory_order::acq_rel);
+        std::lock_guard lck(overflow_mtx_);
+        if (overflow_count_ == overflow_.size()) {
+            ExpandOverflowUnsafe();
+        }
+        auto write_head = overflow_head_ + overflow_count_;
+        if (write_head >= overflow_.size()) {
+            write_head -= overflow_.size();
+        }
+        overflow_[write_head] = std::move(value);
+        ++overflow_count_;
+    }
+
+    bool TryPop(value_t& value) {
+        if (TryPopFromRing(value)) [[likely]] {
+            return true;
+        }
+        if (overflow_size_.load(std::memory_order::acquire) == 0) {
+            return false;
+        }
+        // Values in the ring are pushed before the overflowed ones.
+        if (!IsRingDrained()) {
+            return false;
+        }
+        {
+            std::lock_guard lck(overflow_mtx_);
+            if (overflow_count_ == 0) {
+                return false;
+            }
+            value                     = std::move(overflow_[overflow_head_]);
+            overflow_[overflow_head_] = value_t{};
+            if (++overflow_head_ == overflow_.size()) {
+                overflow_head_ = 0;
+            }
+            --overflow_count_;
+        }
+        overflow_size_.fetch_sub(1, std::memory_order::acq_rel);
+        return true;
+    }
+
+    bool Empty() const { return IsRingDrained() && overflow_size_.load(std::memory_order::acquire) == 0; }
+
+    // Only a hint, since values may be pushed or popped concurrently.
+    std::size_t SizeApprox() const {
+        const auto dequeue_pos = dequeue_pos_.load(std::memory_order::relaxed);
+        const auto enqueue_pos = enqueue_pos_.load(std::memory_order::relaxed);
+        return (enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0) +
+            overflow_size_.load(std::memory_order::relaxed);
+    }
+
+    std::size_t Capacity() const { return capacity_; }
+
+   private:
+    struct Cell {
+        std::atomic<std::size_t> sequence_{0};
+        value_t                  value_{};
+    };
+
+    bool TryPushToRing(value_t& value) {
+        auto  pos  = enqueue_pos_.load(std::memory_order::relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell           = &cells_[pos & mask_];
+            const auto seq = cell->sequence_.load(std::memory_order::acquire);
+            const auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order::relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                // Full.
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order::relaxed);
+            }
+        }
+        cell->value_ = std::move(value);
+        cell->sequence_.store(pos + 1, std::memory_order::release);
+        return true;
+    }
+
+    bool TryPopFromRing(value_t& value) {
+        auto  pos  = dequeue_pos_.load(std::memory_order::relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell           = &cells_[pos & mask_];
+            const auto seq = cell->sequence_.load(std::memory_order::acquire);
+            const auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order::relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                // Empty, or the producer of this cell has not finished writing yet.
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order::relaxed);
+            }
+        }
+        value        = std::move(cell->value_);
+        cell->value_ = value_t{};
+        cell->sequence_.store(pos + capacity_, std::memory_order::release);
+        return true;
+    }
+
+    // The overflow queue never shrinks, so that it stops allocating once it is large enough for the bursts.
+    void ExpandOverflowUnsafe() {
+        std::vector<value_t> expanded(std::max(capacity_, overflow_.size() * 2));
+        for (std::size_t i = 0, idx = overflow_head_; i < overflow_count_; ++i) {
+            expanded[i] = std::move(overflow_[idx]);
+            if (++idx == overflow_.size()) {
+                idx = 0;
+            }
+        }
+        overflow_.swap(expanded);
+        overflow_head_ = 0;
+    }
+
+    // No push to the ring is claimed but not yet popped.
+    bool IsRingDrained() const {
+        return dequeue_pos_.load(std::memory_order::acquire) == enqueue_pos_.load(std::memory_order::acquire);
+    }
+
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    const std::size_t       capacity_;
+    const std::size_t       mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(kCacheLineSize) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(kCacheLineSize) std::atomic<std::size_t> dequeue_pos_{0};
+    alignas(kCacheLineSize) std::atomic<std::size_t> overflow_size_{0};
+    std::mutex           overflow_mtx_;
+    std::vector<value_t> overflow_;
+    std::size_t          overflow_head_{0};
+    std::size_t          overflow_count_{0};
+};
+
+}  // namespace cris::core
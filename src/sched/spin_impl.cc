@@ -1,44 +1,24 @@
 #include "cris/core/sched/spin_impl.h"
 
-#include <cstddef>
+#include "cris/core/utils/time.h"
 
-// NOLINTNEXTLINE(cppcoreguidelines-macro-usage,-warnings-as-errors)
-#define _CR_ASM_NOP asm volatile("nop")
-
-// Cannot use `do { } while (0)` here because there would be huge differences between -O0 and -O1.
-// NOLINTNEXTLINE(cppcoreguidelines-macro-usage,-warnings-as-errors)
-#define _CR_2X(statement) \
-    {                     \
-        statement;        \
-        statement;        \
-    }
-
-#define _CR_2X_NOP _CR_2X(_CR_ASM_NOP)   // NOLINT(cppcoreguidelines-macro-usage,-warnings-as-errors)
-#define _CR_4X_NOP _CR_2X(_CR_2X_NOP)    // NOLINT(cppcoreguidelines-macro-usage,-warnings-as-errors)
-#define _CR_8X_NOP _CR_2X(_CR_4X_NOP)    // NOLINT(cppcoreguidelines-macro-usage,-warnings-as-errors)
-#define _CR_16X_NOP _CR_2X(_CR_8X_NOP)   // NOLINT(cppcoreguidelines-macro-usage,-warnings-as-errors)
-#define _CR_32X_NOP _CR_2X(_CR_16X_NOP)  // NOLINT(cppcoreguidelines-macro-usage,-warnings-as-errors)
+#include <algorithm>
 
 namespace cris::core::impl {
 
+void SpinForNsec(cr_duration_nsec_t duration_nsec) {
+    unsigned   cpuid      = 0;
+    const auto start_tick = GetTSCTick(cpuid);
+    const auto tick_num   =
+        static_cast<unsigned long long>(std::max(0.0, static_cast<double>(duration_nsec) / kTscToNsecRatio));
+    do {
+        CpuRelax();
+    } while (GetTSCTick(cpuid) - start_tick < tick_num);
+}
+
 void SpinForApprox1us() {
-    // Each iter takes ~3ns on Intel x86 boosting to 2.9-3.0GHz (measured).
-    // Tested on Skylake Xeon and CoffeeLake Mobile.
-    // Tested on GCC 10/11 and LLVM 12.
-    //
-    // ~= 1us@3GHz between atomic variable checks.
-    constexpr std::size_t kSelfSpinningBetweenChecks = 300;
-    for (std::size_t i = 0; i < kSelfSpinningBetweenChecks; ++i) {
-        _CR_32X_NOP
-    }
+    constexpr cr_duration_nsec_t kOneMicrosecond = 1000;
+    SpinForNsec(kOneMicrosecond);
 }
 
 }  // namespace cris::core::impl
-
-#undef _CR_32X_NOP
-#undef _CR_16X_NOP
-#undef _CR_8X_NOP
-#undef _CR_4X_NOP
-#undef _CR_2X_NOP
-#undef _CR_2X
-#undef _CR_ASM_NOP
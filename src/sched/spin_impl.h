@@ -1,7 +1,29 @@
 #pragma once
 
+#include "cris/core/utils/time.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(__amd64__)
+#include <immintrin.h>
+#endif
+
 namespace cris::core::impl {
 
+// Tell the CPU that the thread is spinning, so that it saves power and yields the pipeline to the sibling
+// hyper-thread. It takes from a few to over a hundred cycles depending on the CPU, so spin loops should be bounded by
+// time instead of counting it.
+inline void CpuRelax() {
+#if defined(__i386__) || defined(__x86_64__) || defined(__amd64__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#else
+    asm volatile("" ::: "memory");
+#endif
+}
+
+// Spin for about `duration_nsec`, timed with TSC, which is calibrated at startup. See `kTscToNsecRatio`.
+void SpinForNsec(cr_duration_nsec_t duration_nsec);
+
 void SpinForApprox1us();
 
 }  // namespace cris::core::impl
@@ -1,27 +1,39 @@
 #include "cris/core/sched/spin_mutex.h"
 
 #include "cris/core/sched/spin_impl.h"
+#include "cris/core/utils/time.h"
 
-#include <cstddef>
+#include <algorithm>
+#include <atomic>
 #include <thread>
 
 namespace cris::core {
 
 void HybridSpinMutex::lock() {
-    // Spinning for about 500us@3GHz.
-    //
-    // TODO(hao.chen, xkszltl): Check clock every 10-100us for better accuracy.
-    constexpr std::size_t kSpinningCheckLimit = 500;
-    for (std::size_t i = 0; i < kSpinningCheckLimit; ++i) {
-        if (try_lock()) {
+    if (try_lock()) [[likely]] {
+        return;
+    }
+
+    // Spin for about twice as long as it recently took to get the lock, within limits, then fall back to yielding.
+    const auto expected_wait_nsec = expected_wait_nsec_.load(std::memory_order::relaxed);
+    const auto spin_limit_nsec    = std::clamp<cr_duration_nsec_t>(2 * expected_wait_nsec, kMinSpinNsec, kMaxSpinNsec);
+    const auto start              = GetSystemTimestampNsec();
+
+    auto now = start;
+    while (now - start < spin_limit_nsec) {
+        // Wait with plain loads, so that spinning does not keep stealing the cache line from the owner.
+        if (!locked_.test(std::memory_order::relaxed) && try_lock()) {
+            UpdateExpectedWait(expected_wait_nsec, GetSystemTimestampNsec() - start);
             return;
         }
-        impl::SpinForApprox1us();
+        impl::CpuRelax();
+        now = GetSystemTimestampNsec();
     }
 
     while (!try_lock()) {
         std::this_thread::yield();
     }
+    UpdateExpectedWait(expected_wait_nsec, GetSystemTimestampNsec() - start);
 }
 
 void HybridSpinMutex::unlock() {
@@ -32,4 +44,11 @@ bool HybridSpinMutex::try_lock() {
     return !locked_.test_and_set();
 }
 
+void HybridSpinMutex::UpdateExpectedWait(cr_duration_nsec_t prev_expected_wait_nsec, cr_duration_nsec_t wait_nsec) {
+    wait_nsec = std::min(wait_nsec, kMaxSpinNsec);
+    expected_wait_nsec_.store(
+        prev_expected_wait_nsec + (wait_nsec - prev_expected_wait_nsec) / 8,
+        std::memory_order::relaxed);
+}
+
 }  // namespace cris::core
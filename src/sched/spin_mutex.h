@@ -1,11 +1,15 @@
 #pragma once
 
+#include "cris/core/utils/time.h"
+
 #include <atomic>
 
 namespace cris::core {
 
 // Unlike `std::unique_lock`, its `try_lock` does not have false-negative, but its `lock` will keep spinning for a
 // while. So it is not recommanded unless you need a strong `try_lock` and will not hold the lock for too long.
+//
+// How long `lock` spins adapts to how long it took to get the lock recently, up to about 500us.
 class HybridSpinMutex {
    public:
     using Self = HybridSpinMutex;
@@ -24,7 +28,14 @@ class HybridSpinMutex {
     bool try_lock();
 
    private:
-    std::atomic_flag locked_ = ATOMIC_FLAG_INIT;
+    static constexpr cr_duration_nsec_t kMinSpinNsec = 10000;
+    static constexpr cr_duration_nsec_t kMaxSpinNsec = 500000;
+
+    // A moving average of the waiting time, racy updates are fine since it is only a hint.
+    void UpdateExpectedWait(cr_duration_nsec_t prev_expected_wait_nsec, cr_duration_nsec_t wait_nsec);
+
+    std::atomic_flag                locked_ = ATOMIC_FLAG_INIT;
+    std::atomic<cr_duration_nsec_t> expected_wait_nsec_{0};
 };
 
 }  // namespace cris::core
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "cris/core/utils/logging.h"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace cris::core {
+
+template<class value_t = void>
+class Task;
+
+namespace impl {
+
+class TaskPromiseBase {
+   public:
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    // Resume the awaiting coroutine right away, without growing the stack, see symmetric transfer.
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template<class promise_t>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> handle) noexcept {
+            auto& promise = handle.promise();
+            if (promise.continuation_) {
+                return promise.continuation_;
+            }
+            if (promise.detached_) {
+                if (promise.exception_) [[unlikely]] {
+                    LOG(FATAL) << __func__ << ": Unhandled exception in a detached task.";
+                }
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+   protected:
+    template<class value_t>
+    friend class cris::core::Task;
+
+    void RethrowIfFailed() const {
+        if (exception_) [[unlikely]] {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+    std::coroutine_handle<> continuation_{};
+    std::exception_ptr      exception_{};
+    bool                    detached_{false};
+};
+
+template<class value_t>
+class TaskPromise : public TaskPromiseBase {
+   public:
+    Task<value_t> get_return_object() noexcept;
+
+    template<class result_t>
+        requires std::is_convertible_v<result_t&&, value_t>
+    void return_value(result_t&& result) {
+        result_.emplace(std::forward<result_t>(result));
+    }
+
+    value_t TakeResult() {
+        RethrowIfFailed();
+        return std::move(*result_);
+    }
+
+   private:
+    std::optional<value_t> result_;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+   public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void TakeResult() const { RethrowIfFailed(); }
+};
+
+}  // namespace impl
+
+// A lazily started coroutine, which runs when awaited, and resumes the awaiting one when it finishes.
+//
+// Where a coroutine runs is decided by what it awaits. After `co_await runner->Schedule()` it continues as a job of the
+// runner, and after `co_await strand` as a job of the strand. Either way it does not block any thread while suspended.
+// A coroutine in a strand leaves the strand when it suspends again, so jobs of the strand may run in between.
+//
+//     Task<int> Compute(std::shared_ptr<JobRunner> runner) {
+//         co_await runner->Schedule();
+//         co_return 42;
+//     }
+//
+// Tasks not awaited by any coroutine are started with `Detach`. Like jobs, tasks suspended on a runner or a strand
+// that stops or goes away never resume.
+template<class value_t>
+class [[nodiscard]] Task {
+   public:
+    using promise_type = impl::TaskPromise<value_t>;
+    using handle_t     = std::coroutine_handle<promise_type>;
+
+    static_assert(!std::is_reference_v<value_t>, "Return by pointer or std::reference_wrapper instead.");
+
+    Task() noexcept = default;
+
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() { Reset(); }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+    bool Done() const noexcept { return !handle_ || handle_.done(); }
+
+    // Start the task in the current thread, and let it release itself when it finishes. It runs until the first
+    // suspension before returning. Exceptions escaping from it are fatal.
+    void Detach() && {
+        if (auto handle = std::exchange(handle_, nullptr)) [[likely]] {
+            handle.promise().detached_ = true;
+            handle.resume();
+        }
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+                handle_.promise().continuation_ = continuation;
+                return handle_;
+            }
+
+            value_t await_resume() { return handle_.promise().TakeResult(); }
+
+            handle_t handle_;
+        };
+        return Awaiter{handle_};
+    }
+
+   private:
+    friend class impl::TaskPromise<value_t>;
+
+    explicit Task(handle_t handle) noexcept : handle_(handle) {}
+
+    void Reset() noexcept {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = nullptr;
+        }
+    }
+
+    handle_t handle_{};
+};
+
+template<class value_t>
+Task<value_t> impl::TaskPromise<value_t>::get_return_object() noexcept {
+    return Task<value_t>(Task<value_t>::handle_t::from_promise(*this));
+}
+
+inline Task<void> impl::TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(Task<void>::handle_t::from_promise(*this));
+}
+
+}  // namespace cris::core
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "cris/core/utils/time.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace cris::core {
+
+// A hierarchical timing wheel, holding values until their expiry times. Not thread-safe.
+//
+// Time is cut into ticks. Each level has 256 slots, and a slot of level `l` spans 256^l ticks. A value is put into the
+// lowest level whose span covers its delay, and moved down a level each time the level below wraps around, so adding
+// a value and advancing a tick both take O(1), no matter how many values there are. Runs of empty ticks are skipped.
+// Values due beyond the top level, i.e. 2^32 ticks, wait in its furthest slot and are put back when it comes.
+//
+// Values expire at the first tick not earlier than their expiry times, i.e. up to a tick late, and never early.
+template<class value_t>
+class TimerWheel {
+   public:
+    TimerWheel(cr_timestamp_nsec_t start_nsec, cr_duration_nsec_t tick_nsec)
+        : start_nsec_(start_nsec)
+        , tick_nsec_(std::max<cr_duration_nsec_t>(tick_nsec, 1)) {}
+
+    TimerWheel(const TimerWheel&)            = delete;
+    TimerWheel(TimerWheel&&)                 = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    TimerWheel& operator=(TimerWheel&&)      = delete;
+
+    ~TimerWheel() = default;
+
+    void Add(cr_timestamp_nsec_t expiry_nsec, value_t&& value) {
+        Place(Entry{.expiry_tick_ = std::max(ToTick(expiry_nsec), current_tick_), .value_ = std::move(value)});
+        ++size_;
+    }
+
+    // Call `on_expired(value_t&&)` with the values expired by `now_nsec`, from the earliest.
+    template<class callback_t>
+    void Advance(cr_timestamp_nsec_t now_nsec, callback_t&& on_expired) {
+        if (now_nsec < start_nsec_) {
+            return;
+        }
+        const auto target_tick =
+            static_cast<std::uint64_t>(now_nsec - start_nsec_) / static_cast<std::uint64_t>(tick_nsec_);
+        while (current_tick_ <= target_tick) {
+            if (size_ == 0) {
+                // Nothing to cascade or fire, skip the empty ticks.
+                current_tick_ = target_tick + 1;
+                break;
+            }
+            if (level_sizes_[0] == 0) {
+                // Nothing to fire until values of the lowest non-empty level come down, at the start of its next slot.
+                std::size_t level = 1;
+                while (level_sizes_[level] == 0) {
+                    ++level;
+                }
+                const auto span_mask = (std::uint64_t{1} << (kLevelBits * level)) - 1;
+                if ((current_tick_ & span_mask) != 0) {
+                    current_tick_ = std::min((current_tick_ | span_mask) + 1, target_tick + 1);
+                    continue;
+                }
+            }
+            Cascade();
+            auto& slot = levels_[0][current_tick_ & kSlotMask];
+            if (!slot.empty()) {
+                // Swapped out, in case `on_expired` adds values.
+                std::swap(slot, expired_);
+                size_ -= expired_.size();
+                level_sizes_[0] -= expired_.size();
+                for (auto& entry : expired_) {
+                    on_expired(std::move(entry.value_));
+                }
+                expired_.clear();
+            }
+            ++current_tick_;
+        }
+    }
+
+    // No value expires before the returned time, and values may expire, or come down from the higher levels, at it,
+    // to wake up for. Empty if there are no values at all.
+    std::optional<cr_timestamp_nsec_t> NextCheckNsec() const {
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+        // Values on a level all come down before any on the higher levels.
+        for (std::size_t level = 0; level < kLevelNum; ++level) {
+            if (level_sizes_[level] == 0) {
+                continue;
+            }
+            const auto shift = kLevelBits * level;
+            const auto round = current_tick_ >> shift;
+            // The current slot has come down already, unless the current tick is where it starts. The top level may
+            // hold values of the next round in it.
+            const bool entered = (current_tick_ & ((std::uint64_t{1} << shift) - 1)) != 0;
+            for (auto slot_round = round + (entered ? 1 : 0); slot_round <= round + kSlotNum; ++slot_round) {
+                if (!levels_[level][slot_round & kSlotMask].empty()) {
+                    return ToNsec(slot_round << shift);
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::size_t Size() const { return size_; }
+
+    bool Empty() const { return size_ == 0; }
+
+   private:
+    static constexpr std::size_t   kLevelBits = 8;
+    static constexpr std::size_t   kLevelNum  = 4;
+    static constexpr std::size_t   kSlotNum   = std::size_t{1} << kLevelBits;
+    static constexpr std::uint64_t kSlotMask  = kSlotNum - 1;
+    static constexpr std::uint64_t kMaxDelay  = (std::uint64_t{1} << (kLevelBits * kLevelNum)) - 1;
+
+    struct Entry {
+        std::uint64_t expiry_tick_;
+        value_t       value_;
+    };
+
+    using slot_t = std::vector<Entry>;
+
+    std::uint64_t ToTick(cr_timestamp_nsec_t nsec) const {
+        if (nsec <= start_nsec_) {
+            return 0;
+        }
+        // Rounded up, so that values never expire early.
+        return (static_cast<std::uint64_t>(nsec - start_nsec_) + static_cast<std::uint64_t>(tick_nsec_) - 1) /
+            static_cast<std::uint64_t>(tick_nsec_);
+    }
+
+    cr_timestamp_nsec_t ToNsec(std::uint64_t tick) const {
+        return start_nsec_ + static_cast<cr_timestamp_nsec_t>(tick) * tick_nsec_;
+    }
+
+    // The expiry tick of `entry` must not be earlier than the current tick.
+    void Place(Entry&& entry) {
+        const auto delay      = entry.expiry_tick_ - current_tick_;
+        const auto place_tick = delay > kMaxDelay ? current_tick_ + kMaxDelay : entry.expiry_tick_;
+        // The lowest level on which the value is in the current round.
+        std::size_t level = 0;
+        while (level + 1 < kLevelNum &&
+               (place_tick >> (kLevelBits * (level + 1))) != (current_tick_ >> (kLevelBits * (level + 1)))) {
+            ++level;
+        }
+        levels_[level][(place_tick >> (kLevelBits * level)) & kSlotMask].push_back(std::move(entry));
+        ++level_sizes_[level];
+    }
+
+    // Move the values of the slots the current tick enters on the higher levels down, from the highest.
+    void Cascade() {
+        std::size_t level = 0;
+        while (level + 1 < kLevelNum && ((current_tick_ >> (kLevelBits * level)) & kSlotMask) == 0) {
+            ++level;
+        }
+        for (; level > 0; --level) {
+            auto& slot = levels_[level][(current_tick_ >> (kLevelBits * level)) & kSlotMask];
+            if (slot.empty()) {
+                continue;
+            }
+            std::swap(slot, cascading_);
+            level_sizes_[level] -= cascading_.size();
+            for (auto& entry : cascading_) {
+                Place(std::move(entry));
+            }
+            cascading_.clear();
+        }
+    }
+
+    const cr_timestamp_nsec_t start_nsec_;
+    const cr_duration_nsec_t  tick_nsec_;
+
+    // The next tick to fire.
+    std::uint64_t current_tick_{0};
+    std::size_t   size_{0};
+
+    std::array<std::array<slot_t, kSlotNum>, kLevelNum> levels_{};
+    std::array<std::size_t, kLevelNum>                  level_sizes_{};
+
+    // Buffers for swapping slots out, keeping the capacities.
+    slot_t expired_;
+    slot_t cascading_;
+};
+
+}  // namespace cris::core
@@ -2,13 +2,18 @@
 
 #include "cris/core/utils/time.h"
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
+#include <ratio>
 #include <shared_mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace cris::core {
@@ -39,6 +44,52 @@ struct TimerStatEntryBucket {
     cr_duration_nsec_t total_duration_ns_{0};
 };
 
+// Number of duration buckets in each Collector/Total Entry
+inline constexpr std::size_t kDurationBucketNum = 32;
+
+// Calculate the upper (exclusive) limit for each bucket.
+// The bucket range grows exponentially. The range of the
+// first bucket is 0 to base_nsec.
+constexpr cr_duration_nsec_t UpperNsecOfBucket(
+    std::size_t        idx,
+    cr_duration_nsec_t base_nsec = 10 * std::ratio_divide<std::micro, std::nano>::num /* 10 us */) {
+    // The upper limit of the last bucket should be INT_MAX to cover everything
+    if (idx >= kDurationBucketNum - 1) {
+        return std::numeric_limits<cr_duration_nsec_t>::max();
+    }
+    auto result = base_nsec;
+    for (std::size_t i = 0; i < idx; ++i) {
+        result *= 2;
+    }
+    return result;
+}
+
+template<cr_duration_nsec_t base_nsec, std::size_t... idx>
+constexpr auto GenerateBucketUpperNsec(std::integer_sequence<std::size_t, idx...>)
+    -> std::array<cr_duration_nsec_t, sizeof...(idx)> {
+    return {UpperNsecOfBucket(idx, base_nsec)...};
+}
+
+// Upper limit nsec (exclusive) of duration buckets, with the first bucket from 0 to base_nsec.
+template<cr_duration_nsec_t base_nsec>
+inline constexpr auto kBucketUpperNsec =
+    GenerateBucketUpperNsec<base_nsec>(std::make_integer_sequence<std::size_t, kDurationBucketNum>{});
+
+// Linear scan is better than binary search here, since shorter
+// durations should react faster, while it is ok for long ones
+// to be a little slower
+template<cr_duration_nsec_t base_nsec>
+std::size_t GetDurationBucketIndex(cr_duration_nsec_t duration) {
+    std::size_t bucket_idx = 0;
+    for (std::size_t i = 0; i < kDurationBucketNum; ++i) {
+        bucket_idx = i;
+        if (duration < kBucketUpperNsec<base_nsec>[i]) {
+            break;
+        }
+    }
+    return bucket_idx;
+}
+
 }  // namespace impl
 
 class TimerReport {
@@ -25,34 +25,12 @@ static constexpr std::size_t       kEmptyCollectorIndex = 0;
 constinit std::atomic<std::size_t> TimerSection::collector_index_count{1};
 
 // Number of duration buckets in each Collector/Total Entry
-static constexpr std::size_t kTimerEntryBucketNum = 32;
-
-// Calculate the upper (exclusive) limit for each bucket.
-// The bucket range grows exponentially. The range of the
-// first bucket is 0 to base_nsec.
-static constexpr cr_duration_nsec_t UpperNsecOfBucket(
-    std::size_t        idx,
-    cr_duration_nsec_t base_nsec = 10 * std::ratio_divide<std::micro, std::nano>::num /* 10 us */) {
-    // The upper limit of the last bucket should be INT_MAX to cover everything
-    if (idx >= kTimerEntryBucketNum - 1) {
-        return std::numeric_limits<cr_duration_nsec_t>::max();
-    }
-    auto result = base_nsec;
-    for (std::size_t i = 0; i < idx; ++i) {
-        result *= 2;
-    }
-    return result;
-}
+static constexpr std::size_t kTimerEntryBucketNum = impl::kDurationBucketNum;
 
-template<std::size_t... idx>
-static constexpr auto GenerateBucketUpperNsec(std::integer_sequence<std::size_t, idx...>)
-    -> std::array<cr_duration_nsec_t, sizeof...(idx)> {
-    return {UpperNsecOfBucket(idx)...};
-}
+static constexpr cr_duration_nsec_t kTimerBucketBaseNsec = impl::UpperNsecOfBucket(0);
 
 // Upper limit nsec (exclusive) of duration buckets of each timer entry
-static constexpr auto kBucketUpperNsec =
-    GenerateBucketUpperNsec(std::make_integer_sequence<std::size_t, kTimerEntryBucketNum>{});
+static constexpr auto& kBucketUpperNsec = impl::kBucketUpperNsec<kTimerBucketBaseNsec>;
 
 static_assert(kBucketUpperNsec[4] == 160000);
 static_assert(kBucketUpperNsec[6] == 640000);
@@ -182,16 +160,7 @@ void TimerStatCollector::Report(std::size_t index, cr_duration_nsec_t duration)
         return;
     }
 
-    // Linear scan is better than binary search here, since shorter
-    // session should react faster, while it is ok for long sessions
-    // to be a little slower
-    std::size_t bucket_idx = 0;
-    for (std::size_t i = 0; i < kTimerEntryBucketNum; ++i) {
-        bucket_idx = i;
-        if (duration < kBucketUpperNsec[i]) {
-            break;
-        }
-    }
+    const std::size_t bucket_idx = impl::GetDurationBucketIndex<kTimerBucketBaseNsec>(duration);
 
     // If another thread is collecting data, then we simply skip this data point.
     //
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cris::core {
+
+// A move-only `std::function` with a fixed inline buffer.
+//
+// Callables fitting in the buffer are stored in place, so constructing, moving and destroying the function object
+// never touch the heap. Larger ones, or ones that may throw when being moved, fall back to heap allocation.
+template<class signature_t, std::size_t kInlineSize = 64>
+class InlineFunction;
+
+template<class return_t, class... args_t, std::size_t kInlineSize>
+class InlineFunction<return_t(args_t...), kInlineSize> {
+   public:
+    using Self = InlineFunction;
+
+    InlineFunction() noexcept = default;
+
+    // NOLINTNEXTLINE(google-explicit-constructor,-warnings-as-errors)
+    InlineFunction(std::nullptr_t) noexcept {}
+
+    template<class func_t>
+        requires(!std::is_same_v<std::remove_cvref_t<func_t>, Self> &&
+                 std::is_invocable_r_v<return_t, std::decay_t<func_t>&, args_t...>)
+    // NOLINTNEXTLINE(google-explicit-constructor,-warnings-as-errors)
+    InlineFunction(func_t&& func) {
+        Emplace(std::forward<func_t>(func));
+    }
+
+    InlineFunction(const Self&)            = delete;
+    InlineFunction& operator=(const Self&) = delete;
+
+    InlineFunction(Self&& other) noexcept { MoveFrom(other); }
+
+    InlineFunction& operator=(Self&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t) noexcept {
+        Reset();
+        return *this;
+    }
+
+    ~InlineFunction() { Reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    return_t operator()(args_t... args) const {
+        if (!ops_) [[unlikely]] {
+            throw std::bad_function_call();
+        }
+        return ops_->invoke_(storage_, std::forward<args_t>(args)...);
+    }
+
+    // Whether a callable of type `func_t` will be stored without heap allocation.
+    template<class func_t>
+    static constexpr bool kIsStoredInline = sizeof(func_t) <= kInlineSize &&
+        alignof(func_t) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<func_t>;
+
+   private:
+    struct Ops {
+        return_t (*invoke_)(void* storage, args_t&&... args);
+        // Move-construct the callable in `dst` from `src`, and destroy the one in `src`.
+        void (*relocate_)(void* dst, void* src) noexcept;
+        void (*destroy_)(void* storage) noexcept;
+    };
+
+    template<class func_t>
+    static func_t* InlineTarget(void* storage) {
+        return std::launder(reinterpret_cast<func_t*>(storage));
+    }
+
+    template<class func_t>
+    static func_t* HeapTarget(void* storage) {
+        return *std::launder(reinterpret_cast<func_t**>(storage));
+    }
+
+    template<class func_t>
+    static return_t Invoke(func_t& func, args_t&&... args) {
+        if constexpr (std::is_void_v<return_t>) {
+            std::invoke(func, std::forward<args_t>(args)...);
+        } else {
+            return std::invoke(func, std::forward<args_t>(args)...);
+        }
+    }
+
+    template<class func_t>
+    static constexpr Ops kInlineOps = {
+        .invoke_ = [](void* storage, args_t&&... args) -> return_t {
+            return Invoke(*InlineTarget<func_t>(storage), std::forward<args_t>(args)...);
+        },
+        .relocate_ =
+            [](void* dst, void* src) noexcept {
+                auto* src_func = InlineTarget<func_t>(src);
+                ::new (dst) func_t(std::move(*src_func));
+                src_func->~func_t();
+            },
+        .destroy_ = [](void* storage) noexcept { InlineTarget<func_t>(storage)->~func_t(); },
+    };
+
+    template<class func_t>
+    static constexpr Ops kHeapOps = {
+        .invoke_ = [](void* storage, args_t&&... args) -> return_t {
+            return Invoke(*HeapTarget<func_t>(storage), std::forward<args_t>(args)...);
+        },
+        .relocate_ = [](void* dst, void* src) noexcept { ::new (dst) func_t*(HeapTarget<func_t>(src)); },
+        .destroy_  = [](void* storage) noexcept { delete HeapTarget<func_t>(storage); },
+    };
+
+    template<class func_t>
+    void Emplace(func_t&& func) {
+        using target_t = std::decay_t<func_t>;
+        if constexpr (std::is_pointer_v<target_t> || std::is_member_pointer_v<target_t>) {
+            if (!func) {
+                return;
+            }
+        }
+        if constexpr (kIsStoredInline<target_t>) {
+            ::new (static_cast<void*>(storage_)) target_t(std::forward<func_t>(func));
+            ops_ = &kInlineOps<target_t>;
+        } else {
+            ::new (static_cast<void*>(storage_)) target_t*(new target_t(std::forward<func_t>(func)));
+            ops_ = &kHeapOps<target_t>;
+        }
+    }
+
+    void MoveFrom(Self& other) noexcept {
+        if (!other.ops_) {
+            return;
+        }
+        other.ops_->relocate_(storage_, other.storage_);
+        ops_ = std::exchange(other.ops_, nullptr);
+    }
+
+    void Reset() noexcept {
+        if (!ops_) {
+            return;
+        }
+        ops_->destroy_(storage_);
+        ops_ = nullptr;
+    }
+
+    alignas(std::max_align_t) mutable std::byte storage_[kInlineSize];
+    const Ops* ops_{nullptr};
+};
+
+}  // namespace cris::core
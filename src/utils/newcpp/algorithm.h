@@ -1,9 +1,12 @@
 #pragma once
 
 #include "cris/core/utils/newcpp/execution.h"
+#include "cris/core/utils/newcpp/parallel.h"
 
 #include <algorithm>
 #include <execution>
+#include <iterator>
+#include <memory>
 #include <utility>
 
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage,-warnings-as-errors)
@@ -108,6 +111,76 @@ _CRIS_ALGORITHM_DEFINE_ADAPTER(std, minmax_element)
 _CRIS_ALGORITHM_DEFINE_ADAPTER(std, equal)
 _CRIS_ALGORITHM_DEFINE_ADAPTER(std, lexicographical_compare)
 
+// With the parallel fallback policies, these run on the parallel backend, if there is one.
+
+template<class iter_t, class func_t>
+void for_each(::cris::libs::execution::fallback_parallel_policy, iter_t first, iter_t last, func_t func) {
+    if constexpr (std::random_access_iterator<iter_t>) {
+        if (auto backend = ::cris::libs::execution::GetParallelBackend()) {
+            return ::cris::libs::execution::ParallelForEach(*backend, first, last, std::move(func));
+        }
+    }
+    ::cris::libs::execution::impl::PrintFallbackWarningOnce();
+    std::for_each(first, last, std::move(func));
+}
+
+template<class in_iter_t, class out_iter_t, class op_t>
+out_iter_t transform(
+    ::cris::libs::execution::fallback_parallel_policy,
+    in_iter_t  first,
+    in_iter_t  last,
+    out_iter_t d_first,
+    op_t       op) {
+    if constexpr (std::random_access_iterator<in_iter_t> && std::random_access_iterator<out_iter_t>) {
+        if (auto backend = ::cris::libs::execution::GetParallelBackend()) {
+            return ::cris::libs::execution::ParallelTransform(*backend, first, last, d_first, std::move(op));
+        }
+    }
+    ::cris::libs::execution::impl::PrintFallbackWarningOnce();
+    return std::transform(first, last, d_first, std::move(op));
+}
+
+template<class in_iter1_t, class in_iter2_t, class out_iter_t, class op_t>
+out_iter_t transform(
+    ::cris::libs::execution::fallback_parallel_policy,
+    in_iter1_t first1,
+    in_iter1_t last1,
+    in_iter2_t first2,
+    out_iter_t d_first,
+    op_t       op) {
+    if constexpr (
+        std::random_access_iterator<in_iter1_t> && std::random_access_iterator<in_iter2_t> &&
+        std::random_access_iterator<out_iter_t>) {
+        if (auto backend = ::cris::libs::execution::GetParallelBackend()) {
+            return ::cris::libs::execution::ParallelTransform(*backend, first1, last1, first2, d_first, std::move(op));
+        }
+    }
+    ::cris::libs::execution::impl::PrintFallbackWarningOnce();
+    return std::transform(first1, last1, first2, d_first, std::move(op));
+}
+
+template<class iter_t, class compare_t = std::less<>>
+void sort(::cris::libs::execution::fallback_parallel_policy, iter_t first, iter_t last, compare_t comp = {}) {
+    if constexpr (std::random_access_iterator<iter_t>) {
+        if (auto backend = ::cris::libs::execution::GetParallelBackend()) {
+            return ::cris::libs::execution::ParallelSort(*backend, first, last, std::move(comp));
+        }
+    }
+    ::cris::libs::execution::impl::PrintFallbackWarningOnce();
+    std::sort(first, last, std::move(comp));
+}
+
+template<class iter_t, class compare_t = std::less<>>
+void stable_sort(::cris::libs::execution::fallback_parallel_policy, iter_t first, iter_t last, compare_t comp = {}) {
+    if constexpr (std::random_access_iterator<iter_t>) {
+        if (auto backend = ::cris::libs::execution::GetParallelBackend()) {
+            return ::cris::libs::execution::ParallelStableSort(*backend, first, last, std::move(comp));
+        }
+    }
+    ::cris::libs::execution::impl::PrintFallbackWarningOnce();
+    std::stable_sort(first, last, std::move(comp));
+}
+
 }  // namespace std
 
 #undef _CRIS_ALGORITHM_DEFINE_ADAPTER
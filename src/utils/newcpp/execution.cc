@@ -3,6 +3,9 @@
 #include "cris/core/utils/logging.h"
 
 #include <execution>
+#include <memory>
+#include <mutex>
+#include <utility>
 
 namespace cris::libs::execution {
 
@@ -17,4 +20,17 @@ void PrintFallbackWarningOnce() {
 
 }  // namespace impl
 
+static std::mutex                       parallel_backend_mtx;
+static std::shared_ptr<ParallelBackend> parallel_backend;
+
+void SetParallelBackend(std::shared_ptr<ParallelBackend> backend) {
+    std::lock_guard lck(parallel_backend_mtx);
+    parallel_backend = std::move(backend);
+}
+
+std::shared_ptr<ParallelBackend> GetParallelBackend() {
+    std::lock_guard lck(parallel_backend_mtx);
+    return parallel_backend;
+}
+
 }  // namespace cris::libs::execution
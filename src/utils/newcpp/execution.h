@@ -4,6 +4,10 @@
 #include <execution>
 #endif
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+
 namespace cris::libs::execution {
 
 namespace impl {
@@ -14,15 +18,51 @@ void PrintFallbackWarningOnce();
 
 class fallback_policy {};
 
+// Algorithms with it run on the parallel backend if there is one, see `SetParallelBackend`.
+class fallback_parallel_policy : public fallback_policy {};
+
 namespace fallback {
 
-inline constexpr fallback_policy seq;
-inline constexpr fallback_policy par;
-inline constexpr fallback_policy par_unseq;
-inline constexpr fallback_policy unseq;
+inline constexpr fallback_policy          seq;
+inline constexpr fallback_parallel_policy par;
+inline constexpr fallback_parallel_policy par_unseq;
+inline constexpr fallback_policy          unseq;
 
 }  // namespace fallback
 
+// Parallel algorithms without a given grain split the work into this many chunks per thread, so that the load balances
+// without too many of them.
+inline constexpr std::size_t kChunksPerThread = 8;
+
+// What runs the algorithms with the parallel fallback policies.
+class ParallelBackend {
+   public:
+    ParallelBackend() = default;
+
+    ParallelBackend(const ParallelBackend&)            = delete;
+    ParallelBackend(ParallelBackend&&)                 = delete;
+    ParallelBackend& operator=(const ParallelBackend&) = delete;
+    ParallelBackend& operator=(ParallelBackend&&)      = delete;
+
+    virtual ~ParallelBackend() = default;
+
+    // Call `body(chunk_begin, chunk_end)` on chunks covering [begin, end), each no larger than `grain`, possibly in
+    // parallel, and return when all of them finish.
+    virtual void ParallelFor(
+        std::size_t                                          begin,
+        std::size_t                                          end,
+        std::size_t                                          grain,
+        const std::function<void(std::size_t, std::size_t)>& body) = 0;
+
+    // The number of threads running the chunks, for sizing them.
+    virtual std::size_t Concurrency() const = 0;
+};
+
+// Without a backend, algorithms with the parallel fallback policies run sequentially.
+void SetParallelBackend(std::shared_ptr<ParallelBackend> backend);
+
+std::shared_ptr<ParallelBackend> GetParallelBackend();
+
 }  // namespace cris::libs::execution
 
 // Feature testing macros: https://en.cppreference.com/w/cpp/feature_test#Library_features
@@ -44,6 +84,15 @@ inline constexpr fallback_policy unseq;
 
 #endif  // defined(__cpp_lib_execution)
 
+// Whether the standard parallel policies really run in parallel. Without a backend they run sequentially. libstdc++
+// picks TBB whenever its headers are found, which also needs linking TBB, so it counts only if built with
+// CRIS_USE_TBB.
+#if defined(_CR_HAS_STD_EXECUTION_PAR) && \
+    ((defined(_PSTL_PAR_BACKEND_TBB) && defined(CRIS_USE_TBB) && CRIS_USE_TBB) || defined(_MSC_VER))
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage,-warnings-as-errors)
+#define _CR_HAS_STD_PARALLEL_BACKEND 1
+#endif
+
 namespace std::execution {
 
 #ifndef _CR_HAS_STD_EXECUTION_SEQ
@@ -63,3 +112,17 @@ using ::cris::libs::execution::fallback::unseq;
 #endif
 
 }  // namespace std::execution
+
+namespace cris {
+
+// The parallel policies to use. They are the standard ones if the standard library runs them in parallel, otherwise
+// the fallback ones, running on the backend set with `cris::libs::execution::SetParallelBackend`, e.g. a `JobRunner`.
+#ifdef _CR_HAS_STD_PARALLEL_BACKEND
+using ::std::execution::par;
+using ::std::execution::par_unseq;
+#else
+using ::cris::libs::execution::fallback::par;
+using ::cris::libs::execution::fallback::par_unseq;
+#endif
+
+}  // namespace cris
@@ -1,8 +1,12 @@
 #pragma once
 
 #include "cris/core/utils/newcpp/execution.h"
+#include "cris/core/utils/newcpp/parallel.h"
 
 #include <execution>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <numeric>
 #include <utility>
 
@@ -24,6 +28,65 @@ _CRIS_NUMERIC_DEFINE_ADAPTER(std, transform_reduce)
 _CRIS_NUMERIC_DEFINE_ADAPTER(std, transform_exclusive_scan)
 _CRIS_NUMERIC_DEFINE_ADAPTER(std, transform_inclusive_scan)
 
+// With the parallel fallback policies, these run on the parallel backend, if there is one.
+
+template<class iter_t, class value_t, class reduce_op_t, class transform_op_t>
+value_t transform_reduce(
+    ::cris::libs::execution::fallback_parallel_policy,
+    iter_t         first,
+    iter_t         last,
+    value_t        init,
+    reduce_op_t    reduce_op,
+    transform_op_t transform_op) {
+    if constexpr (std::random_access_iterator<iter_t>) {
+        if (auto backend = ::cris::libs::execution::GetParallelBackend()) {
+            return ::cris::libs::execution::ParallelTransformReduce(
+                *backend,
+                first,
+                last,
+                std::move(init),
+                std::move(reduce_op),
+                std::move(transform_op));
+        }
+    }
+    ::cris::libs::execution::impl::PrintFallbackWarningOnce();
+    return std::transform_reduce(first, last, std::move(init), std::move(reduce_op), std::move(transform_op));
+}
+
+template<class iter_t, class value_t, class reduce_op_t>
+value_t reduce(
+    ::cris::libs::execution::fallback_parallel_policy,
+    iter_t      first,
+    iter_t      last,
+    value_t     init,
+    reduce_op_t reduce_op) {
+    if constexpr (std::random_access_iterator<iter_t>) {
+        if (auto backend = ::cris::libs::execution::GetParallelBackend()) {
+            return ::cris::libs::execution::ParallelReduce(
+                *backend,
+                first,
+                last,
+                std::move(init),
+                std::move(reduce_op));
+        }
+    }
+    ::cris::libs::execution::impl::PrintFallbackWarningOnce();
+    return std::reduce(first, last, std::move(init), std::move(reduce_op));
+}
+
+template<class iter_t, class value_t>
+value_t reduce(::cris::libs::execution::fallback_parallel_policy policy, iter_t first, iter_t last, value_t init) {
+    return reduce(policy, first, last, std::move(init), std::plus<>());
+}
+
+template<class iter_t>
+typename std::iterator_traits<iter_t>::value_type reduce(
+    ::cris::libs::execution::fallback_parallel_policy policy,
+    iter_t                                            first,
+    iter_t                                            last) {
+    return reduce(policy, first, last, typename std::iterator_traits<iter_t>::value_type{}, std::plus<>());
+}
+
 }  // namespace std
 
 #undef _CRIS_NUMERIC_DEFINE_ADAPTER
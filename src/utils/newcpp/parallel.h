@@ -0,0 +1,179 @@
+#pragma once
+
+#include "cris/core/utils/newcpp/execution.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace cris::libs::execution {
+
+// Parallel algorithms on a backend, for random access iterators. Like the standard ones with `std::execution::par`,
+// the functions may be called concurrently, and the operations of reductions must be associative and commutative.
+
+namespace impl {
+
+// Sorting smaller chunks in parallel does not pay off the merging.
+inline constexpr std::size_t kMinSortChunkSize = 4096;
+
+inline std::size_t ChunkSize(const ParallelBackend& backend, std::size_t size, std::size_t min_chunk_size = 1) {
+    const auto chunk_num = std::max<std::size_t>(backend.Concurrency(), 1) * kChunksPerThread;
+    return std::max((size + chunk_num - 1) / chunk_num, min_chunk_size);
+}
+
+// Call `body(chunk_idx, chunk_begin, chunk_end)` on each chunk of [0, size), in parallel.
+template<class body_t>
+void ForEachChunk(ParallelBackend& backend, std::size_t size, std::size_t chunk_size, const body_t& body) {
+    const auto chunk_num = (size + chunk_size - 1) / chunk_size;
+    backend.ParallelFor(0, chunk_num, 1, [&body, size, chunk_size](std::size_t first_chunk, std::size_t last_chunk) {
+        for (auto chunk_idx = first_chunk; chunk_idx < last_chunk; ++chunk_idx) {
+            body(chunk_idx, chunk_idx * chunk_size, std::min(size, (chunk_idx + 1) * chunk_size));
+        }
+    });
+}
+
+template<bool stable, std::random_access_iterator iter_t, class compare_t>
+void ParallelMergeSort(ParallelBackend& backend, iter_t first, iter_t last, compare_t comp) {
+    const auto size       = static_cast<std::size_t>(last - first);
+    const auto chunk_size = ChunkSize(backend, size, kMinSortChunkSize);
+    const auto sort_chunk = [first, &comp](std::size_t, std::size_t begin, std::size_t end) {
+        using diff_t = std::iter_difference_t<iter_t>;
+        if constexpr (stable) {
+            std::stable_sort(first + static_cast<diff_t>(begin), first + static_cast<diff_t>(end), comp);
+        } else {
+            std::sort(first + static_cast<diff_t>(begin), first + static_cast<diff_t>(end), comp);
+        }
+    };
+    ForEachChunk(backend, size, chunk_size, sort_chunk);
+
+    // Merge the sorted runs pairwise, doubling their lengths each round. Merging is stable.
+    for (auto run_size = chunk_size; run_size < size; run_size *= 2) {
+        const auto merge_runs = [first, &comp, run_size](std::size_t, std::size_t begin, std::size_t end) {
+            using diff_t   = std::iter_difference_t<iter_t>;
+            const auto mid = begin + run_size;
+            if (mid < end) {
+                std::inplace_merge(
+                    first + static_cast<diff_t>(begin),
+                    first + static_cast<diff_t>(mid),
+                    first + static_cast<diff_t>(end),
+                    comp);
+            }
+        };
+        ForEachChunk(backend, size, run_size * 2, merge_runs);
+    }
+}
+
+}  // namespace impl
+
+template<std::random_access_iterator iter_t, class func_t>
+void ParallelForEach(ParallelBackend& backend, iter_t first, iter_t last, func_t func) {
+    using diff_t    = std::iter_difference_t<iter_t>;
+    const auto size = static_cast<std::size_t>(last - first);
+    backend.ParallelFor(0, size, impl::ChunkSize(backend, size), [first, &func](std::size_t begin, std::size_t end) {
+        std::for_each(first + static_cast<diff_t>(begin), first + static_cast<diff_t>(end), func);
+    });
+}
+
+template<std::random_access_iterator in_iter_t, std::random_access_iterator out_iter_t, class op_t>
+out_iter_t ParallelTransform(ParallelBackend& backend, in_iter_t first, in_iter_t last, out_iter_t d_first, op_t op) {
+    const auto size = static_cast<std::size_t>(last - first);
+    backend.ParallelFor(
+        0,
+        size,
+        impl::ChunkSize(backend, size),
+        [first, d_first, &op](std::size_t begin, std::size_t end) {
+            std::transform(
+                first + static_cast<std::iter_difference_t<in_iter_t>>(begin),
+                first + static_cast<std::iter_difference_t<in_iter_t>>(end),
+                d_first + static_cast<std::iter_difference_t<out_iter_t>>(begin),
+                op);
+        });
+    return d_first + static_cast<std::iter_difference_t<out_iter_t>>(size);
+}
+
+template<
+    std::random_access_iterator in_iter1_t,
+    std::random_access_iterator in_iter2_t,
+    std::random_access_iterator out_iter_t,
+    class op_t>
+out_iter_t ParallelTransform(
+    ParallelBackend& backend,
+    in_iter1_t       first1,
+    in_iter1_t       last1,
+    in_iter2_t       first2,
+    out_iter_t       d_first,
+    op_t             op) {
+    const auto size = static_cast<std::size_t>(last1 - first1);
+    backend.ParallelFor(
+        0,
+        size,
+        impl::ChunkSize(backend, size),
+        [first1, first2, d_first, &op](std::size_t begin, std::size_t end) {
+            std::transform(
+                first1 + static_cast<std::iter_difference_t<in_iter1_t>>(begin),
+                first1 + static_cast<std::iter_difference_t<in_iter1_t>>(end),
+                first2 + static_cast<std::iter_difference_t<in_iter2_t>>(begin),
+                d_first + static_cast<std::iter_difference_t<out_iter_t>>(begin),
+                op);
+        });
+    return d_first + static_cast<std::iter_difference_t<out_iter_t>>(size);
+}
+
+template<std::random_access_iterator iter_t, class value_t, class reduce_op_t, class transform_op_t>
+value_t ParallelTransformReduce(
+    ParallelBackend& backend,
+    iter_t           first,
+    iter_t           last,
+    value_t          init,
+    reduce_op_t      reduce_op,
+    transform_op_t   transform_op) {
+    const auto size       = static_cast<std::size_t>(last - first);
+    const auto chunk_size = impl::ChunkSize(backend, size);
+
+    // One partial result for each chunk, combined in order at last.
+    std::vector<std::optional<value_t>> partials((size + chunk_size - 1) / chunk_size);
+    impl::ForEachChunk(
+        backend,
+        size,
+        chunk_size,
+        [first, &partials, &reduce_op, &transform_op](std::size_t chunk_idx, std::size_t begin, std::size_t end) {
+            using diff_t = std::iter_difference_t<iter_t>;
+            value_t partial = transform_op(first[static_cast<diff_t>(begin)]);
+            for (auto idx = begin + 1; idx < end; ++idx) {
+                partial = reduce_op(std::move(partial), transform_op(first[static_cast<diff_t>(idx)]));
+            }
+            partials[chunk_idx].emplace(std::move(partial));
+        });
+
+    for (auto& partial : partials) {
+        init = reduce_op(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
+template<std::random_access_iterator iter_t, class value_t, class reduce_op_t>
+value_t ParallelReduce(ParallelBackend& backend, iter_t first, iter_t last, value_t init, reduce_op_t reduce_op) {
+    return ParallelTransformReduce(
+        backend,
+        first,
+        last,
+        std::move(init),
+        std::move(reduce_op),
+        [](const auto& value) -> decltype(auto) { return value; });
+}
+
+template<std::random_access_iterator iter_t, class compare_t = std::less<>>
+void ParallelSort(ParallelBackend& backend, iter_t first, iter_t last, compare_t comp = {}) {
+    impl::ParallelMergeSort<false>(backend, first, last, std::move(comp));
+}
+
+template<std::random_access_iterator iter_t, class compare_t = std::less<>>
+void ParallelStableSort(ParallelBackend& backend, iter_t first, iter_t last, compare_t comp = {}) {
+    impl::ParallelMergeSort<true>(backend, first, last, std::move(comp));
+}
+
+}  // namespace cris::libs::execution
@@ -0,0 +1,87 @@
+#include "cris/core/sched/cpu_topology.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace cris::core {
+
+// A fake sysfs of 10 CPUs. CPUs 0-7 are on socket 0 and NUMA node 0, in 2-way SMT pairs, with L3 caches shared by
+// 0-3 and 4-7. CPUs 8-9 are an SMT pair on socket 1 and NUMA node 1.
+class CpuTopologyTestFixture : public testing::Test {
+   public:
+    CpuTopologyTestFixture()
+        : sysfs_cpu_root_{
+              fs::temp_directory_path() / (std::string{"CRIS.cpu_topology_test."} + std::to_string(getpid()))} {
+        WriteFile(sysfs_cpu_root_ / "online", "0-9\n");
+        for (std::size_t cpu_id = 0; cpu_id < 10; ++cpu_id) {
+            const auto cpu_dir = sysfs_cpu_root_ / ("cpu" + std::to_string(cpu_id));
+            const auto smt     = cpu_id / 2 * 2;
+            const auto l3      = cpu_id < 4 ? "0-3" : (cpu_id < 8 ? "4-7" : "8-9");
+            WriteFile(cpu_dir / "topology" / "core_cpus_list", std::to_string(smt) + "-" + std::to_string(smt + 1));
+            WriteFile(cpu_dir / "topology" / "physical_package_id", cpu_id < 8 ? "0" : "1");
+            WriteFile(cpu_dir / "cache" / "index2" / "level", "2");
+            WriteFile(cpu_dir / "cache" / "index2" / "shared_cpu_list", std::to_string(cpu_id));
+            WriteFile(cpu_dir / "cache" / "index3" / "level", "3");
+            WriteFile(cpu_dir / "cache" / "index3" / "shared_cpu_list", l3);
+            fs::create_directories(cpu_dir / (cpu_id < 8 ? "node0" : "node1"));
+        }
+    }
+
+    ~CpuTopologyTestFixture() override { fs::remove_all(sysfs_cpu_root_); }
+
+   protected:
+    static void WriteFile(const fs::path& path, const std::string& content) {
+        fs::create_directories(path.parent_path());
+        std::ofstream(path) << content << "\n";
+    }
+
+    const fs::path sysfs_cpu_root_;
+};
+
+TEST(CpuTopologyTest, ParseCpuList) {
+    EXPECT_EQ(CpuTopology::ParseCpuList("0-3,8,10-11\n"), (std::vector<std::size_t>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(CpuTopology::ParseCpuList("5"), (std::vector<std::size_t>{5}));
+    EXPECT_EQ(CpuTopology::ParseCpuList("3,1-2,2"), (std::vector<std::size_t>{1, 2, 3}));
+    EXPECT_TRUE(CpuTopology::ParseCpuList("").empty());
+    EXPECT_TRUE(CpuTopology::ParseCpuList("x-y").empty());
+}
+
+TEST_F(CpuTopologyTestFixture, Read) {
+    const auto topology = CpuTopology::Read(sysfs_cpu_root_.native());
+    ASSERT_EQ(topology.Cpus().size(), 10);
+
+    const auto* cpu = topology.FindCpu(5);
+    ASSERT_NE(cpu, nullptr);
+    EXPECT_EQ(cpu->core_group_, 4);
+    EXPECT_EQ(cpu->l3_group_, 4);
+    EXPECT_EQ(cpu->package_, 0);
+    EXPECT_EQ(cpu->numa_node_, 0);
+    EXPECT_EQ(topology.FindCpu(10), nullptr);
+
+    EXPECT_EQ(topology.CpusOfNumaNode(1), (std::vector<std::size_t>{8, 9}));
+    EXPECT_TRUE(topology.CpusOfNumaNode(2).empty());
+}
+
+TEST_F(CpuTopologyTestFixture, Distance) {
+    using Distance = CpuTopology::Distance;
+
+    const auto topology = CpuTopology::Read(sysfs_cpu_root_.native());
+    EXPECT_EQ(topology.GetDistance(0, 0), Distance::kSameCpu);
+    EXPECT_EQ(topology.GetDistance(0, 1), Distance::kSmt);
+    EXPECT_EQ(topology.GetDistance(0, 3), Distance::kL3);
+    EXPECT_EQ(topology.GetDistance(2, 7), Distance::kSocket);
+    EXPECT_EQ(topology.GetDistance(7, 8), Distance::kRemote);
+    EXPECT_EQ(topology.GetDistance(8, 9), Distance::kSmt);
+    EXPECT_EQ(topology.GetDistance(0, 42), Distance::kRemote);
+}
+
+}  // namespace cris::core
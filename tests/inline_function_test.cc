@@ -0,0 +1,90 @@
+#include "cris/core/utils/inline_function.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cris::core {
+
+TEST(InlineFunctionTest, Empty) {
+    InlineFunction<void()> func;
+    EXPECT_FALSE(func);
+
+    InlineFunction<void()> null_func = nullptr;
+    EXPECT_FALSE(null_func);
+
+    void (*null_ptr)() = nullptr;
+    func               = null_ptr;
+    EXPECT_FALSE(func);
+    EXPECT_THROW(func(), std::bad_function_call);
+}
+
+TEST(InlineFunctionTest, InvokeWithArgs) {
+    InlineFunction<int(int, const std::string&)> func = [](int i, const std::string& str) {
+        return i + static_cast<int>(str.size());
+    };
+    ASSERT_TRUE(func);
+    EXPECT_EQ(func(1, "abc"), 4);
+
+    InlineFunction<std::size_t(std::unique_ptr<int>&&)> take = [](std::unique_ptr<int>&& ptr) {
+        auto owned = std::move(ptr);
+        return static_cast<std::size_t>(*owned);
+    };
+    auto ptr = std::make_unique<int>(42);
+    EXPECT_EQ(take(std::move(ptr)), 42);
+    EXPECT_FALSE(ptr);
+}
+
+TEST(InlineFunctionTest, InlineAndHeapStorage) {
+    using func_t = InlineFunction<int()>;
+
+    std::array<char, 48> small{};
+    small[0]       = 3;
+    auto small_job = [small] { return small[0]; };
+    EXPECT_TRUE(func_t::kIsStoredInline<decltype(small_job)>);
+
+    std::array<char, 256> large{};
+    large[255]     = 5;
+    auto large_job = [large] { return large[255]; };
+    EXPECT_FALSE(func_t::kIsStoredInline<decltype(large_job)>);
+
+    func_t small_func = small_job;
+    func_t large_func = large_job;
+    EXPECT_EQ(small_func(), 3);
+    EXPECT_EQ(large_func(), 5);
+
+    // Moved from is empty, and moved to keeps the callable.
+    func_t moved = std::move(small_func);
+    EXPECT_FALSE(small_func);
+    EXPECT_EQ(moved(), 3);
+    moved = std::move(large_func);
+    EXPECT_FALSE(large_func);
+    EXPECT_EQ(moved(), 5);
+}
+
+TEST(InlineFunctionTest, MoveOnlyCaptureLifetime) {
+    auto counter = std::make_shared<int>(0);
+    {
+        std::vector<InlineFunction<void()>> funcs;
+        for (int i = 0; i < 100; ++i) {
+            // Triggers reallocations, where the callables are relocated.
+            funcs.emplace_back([owned = std::make_unique<int>(i), counter] { *counter += *owned; });
+        }
+        EXPECT_EQ(counter.use_count(), 101);
+        for (auto& func : funcs) {
+            func();
+        }
+        EXPECT_EQ(*counter, 4950);
+
+        funcs[0] = nullptr;
+        EXPECT_EQ(counter.use_count(), 100);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+}  // namespace cris::core
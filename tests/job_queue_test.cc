@@ -1,11 +1,17 @@
+#include "cris/core/sched/job_deadline_queue.h"
 #include "cris/core/sched/job_lock_queue.h"
 #include "cris/core/sched/job_lockfree_queue.h"
+#include "cris/core/sched/job_ring_queue.h"
+#include "cris/core/sched/job_work_stealing_queue.h"
 
 #include "gtest/gtest.h"
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace cris::core {
 
@@ -99,4 +105,163 @@ TEST(JobQueueTest, LockFreeQueue) {
     JobQueueTest(std::make_unique<JobLockFreeQueue>(kInitQueueCapacity));
 }
 
+TEST(JobQueueTest, RingQueue) {
+    JobQueueTest(std::make_unique<JobRingQueue>(kInitQueueCapacity));
+}
+
+TEST(JobQueueTest, RingQueueMultiProducer) {
+    constexpr std::size_t kProducerNum = 3;
+    constexpr std::size_t kJobNum      = 20000;
+
+    JobRingQueue queue(kInitQueueCapacity);
+
+    // Jobs from the same producer are consumed in order, even when some of them overflow the ring.
+    std::vector<std::size_t> next_seq(kProducerNum, 0);
+    std::atomic<std::size_t> consumed{0};
+
+    std::vector<std::thread> producers;
+    for (std::size_t i = 0; i < kProducerNum; ++i) {
+        producers.emplace_back([&queue, &next_seq, i]() {
+            for (std::size_t seq = 0; seq < kJobNum; ++seq) {
+                queue.Push([&next_seq, i, seq]() { EXPECT_EQ(next_seq[i]++, seq); });
+            }
+        });
+    }
+
+    std::thread consumer([&queue, &consumed]() {
+        JobQueue::job_t job;
+        while (consumed.load() < kProducerNum * kJobNum) {
+            if (queue.TryPop(job)) {
+                job();
+                consumed.fetch_add(1);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    consumer.join();
+
+    EXPECT_TRUE(queue.Empty());
+    for (std::size_t i = 0; i < kProducerNum; ++i) {
+        EXPECT_EQ(next_seq[i], kJobNum);
+    }
+}
+
+TEST(JobQueueTest, WorkStealingQueueOrder) {
+    JobWorkStealingQueue queue(kInitQueueCapacity);
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_EQ(queue.Capacity(), kInitQueueCapacity);
+
+    int  tmp = -1;
+    auto job = JobQueue::job_t();
+    for (int i = 0; i < static_cast<int>(kInitQueueCapacity); ++i) {
+        job = [&tmp, i]() { tmp = i; };
+        EXPECT_TRUE(queue.TryPush(job));
+    }
+
+    // Full, and the job is not consumed.
+    job = [&tmp]() { tmp = -2; };
+    EXPECT_FALSE(queue.TryPush(job));
+    ASSERT_TRUE(job);
+
+    // The owner takes the newest.
+    EXPECT_TRUE(queue.TryPop(job));
+    job();
+    EXPECT_EQ(tmp, static_cast<int>(kInitQueueCapacity) - 1);
+
+    // Thieves take the oldest.
+    EXPECT_TRUE(queue.TrySteal(job));
+    job();
+    EXPECT_EQ(tmp, 0);
+
+    for (int i = static_cast<int>(kInitQueueCapacity) - 2; i > 0; --i) {
+        EXPECT_TRUE(queue.TryPop(job));
+        job();
+        EXPECT_EQ(tmp, i);
+    }
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_FALSE(queue.TryPop(job));
+    EXPECT_FALSE(queue.TrySteal(job));
+}
+
+TEST(JobQueueTest, WorkStealingQueueConcurrency) {
+    constexpr std::size_t kThiefNum = 3;
+    constexpr std::size_t kJobNum   = 100000;
+
+    JobWorkStealingQueue queue(kInitQueueCapacity);
+
+    std::vector<std::atomic<int>> executed(kJobNum);
+    std::atomic<bool>             done{false};
+
+    std::vector<std::thread> thieves;
+    for (std::size_t i = 0; i < kThiefNum; ++i) {
+        thieves.emplace_back([&queue, &done]() {
+            JobQueue::job_t job;
+            while (!done.load() || !queue.Empty()) {
+                if (queue.TrySteal(job)) {
+                    job();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Owner, keeps pushing and popping, with the thieves stealing from the other end.
+    JobQueue::job_t job;
+    for (std::size_t i = 0; i < kJobNum; ++i) {
+        job = [&executed, i]() { executed[i].fetch_add(1); };
+        while (!queue.TryPush(job)) {
+            std::this_thread::yield();
+        }
+        if (i % 3 == 0 && queue.TryPop(job)) {
+            job();
+        }
+    }
+    while (queue.TryPop(job)) {
+        job();
+    }
+    done.store(true);
+
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    // Every job runs exactly once.
+    for (std::size_t i = 0; i < kJobNum; ++i) {
+        EXPECT_EQ(executed[i].load(), 1) << "job " << i;
+    }
+}
+
+TEST(JobQueueTest, DeadlineQueueOrder) {
+    JobDeadlineQueue queue;
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_EQ(queue.EarliestDeadline(), JobDeadlineQueue::kNoDeadline);
+
+    // Pairs of (deadline, id). Jobs with the same deadline keep their FIFO order.
+    const std::vector<std::pair<cr_timestamp_nsec_t, int>> jobs{{30, 0}, {10, 1}, {20, 2}, {10, 3}, {40, 4}, {20, 5}};
+    const std::vector<int>                                 expected_order{1, 3, 2, 5, 0, 4};
+
+    int tmp = -1;
+    for (const auto& [deadline, id] : jobs) {
+        queue.Push([&tmp, id = id]() { tmp = id; }, deadline);
+    }
+    EXPECT_EQ(queue.EarliestDeadline(), 10);
+
+    JobQueue::job_t     job;
+    cr_timestamp_nsec_t deadline = 0;
+    for (const int id : expected_order) {
+        ASSERT_TRUE(queue.TryPop(job, deadline));
+        job();
+        EXPECT_EQ(tmp, id);
+    }
+    EXPECT_EQ(deadline, 40);
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_FALSE(queue.TryPop(job, deadline));
+}
+
 }  // namespace cris::core
@@ -1,13 +1,24 @@
 #include "cris/core/sched/job_runner.h"
+#include "cris/core/utils/time.h"
 
 #include "gtest/gtest.h"
 
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <functional>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <ratio>
+#include <set>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -187,6 +198,85 @@ TEST(JobRunnerTest, JobLocality) {
     EVENTUALLY_EQ(call_count->load(), kSpawningJobNum);
 }
 
+// Hints from threads other than the workers pick a worker at random, and must be in range.
+TEST(JobRunnerTest, DefaultSchedulerHint) {
+    static constexpr std::size_t kThreadNum = 2;
+    static constexpr std::size_t kRoundNum  = 1000;
+
+    auto                  runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = kThreadNum});
+    std::set<std::size_t> hints;
+    for (std::size_t i = 0; i < kRoundNum; ++i) {
+        const auto hint = runner->DefaultSchedulerHint();
+        ASSERT_LT(hint, kThreadNum) << "Round " << i;
+        hints.insert(hint);
+    }
+    EXPECT_EQ(hints.size(), kThreadNum);
+}
+
+TEST(JobRunnerTest, WorkStealingQueue) {
+    static constexpr std::size_t kThreadNum = 4;
+    static constexpr std::size_t kJobNum    = 200;
+
+    JobRunner::Config config = {
+        .thread_num_ = kThreadNum,
+        .queue_type_ = JobRunner::QueueType::kWorkStealing,
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+
+    auto call_count = std::make_shared<std::atomic<std::size_t>>(0);
+    auto thread_ids = std::make_shared<std::vector<std::atomic<std::thread::id>>>(kJobNum);
+
+    // All the jobs are spawned to the local deque of one worker, and the others have to steal.
+    EXPECT_TRUE(runner->AddJob(
+        [runner, call_count, thread_ids]() {
+            for (std::size_t i = 0; i < kJobNum; ++i) {
+                EXPECT_TRUE(runner->AddJob([call_count, thread_ids, i]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    (*thread_ids)[i].store(std::this_thread::get_id());
+                    call_count->fetch_add(1);
+                }));
+            }
+        },
+        0));
+
+    EVENTUALLY_EQ(call_count->load(), kJobNum);
+
+    std::set<std::thread::id> worker_threads;
+    for (auto& thread_id : *thread_ids) {
+        worker_threads.insert(thread_id.load());
+    }
+    EXPECT_GT(worker_threads.size(), 1);
+}
+
+TEST(JobRunnerTest, WorkStealingQueueLifo) {
+    static constexpr std::size_t kJobNum = 10;
+
+    JobRunner::Config config = {
+        .thread_num_ = 1,
+        .queue_type_ = JobRunner::QueueType::kWorkStealing,
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+
+    auto order = std::make_shared<std::vector<std::size_t>>();
+    auto done  = std::make_shared<std::atomic<bool>>(false);
+
+    EXPECT_TRUE(runner->AddJob([runner, order, done]() {
+        // The first spawned one runs last.
+        EXPECT_TRUE(runner->AddJob([done]() { done->store(true); }));
+        for (std::size_t i = 0; i < kJobNum; ++i) {
+            EXPECT_TRUE(runner->AddJob([order, i]() { order->push_back(i); }));
+        }
+    }));
+
+    EVENTUALLY_EQ(done->load(), true);
+
+    // The only worker runs its spawned jobs in LIFO order.
+    ASSERT_EQ(order->size(), kJobNum);
+    for (std::size_t i = 0; i < kJobNum; ++i) {
+        EXPECT_EQ((*order)[i], kJobNum - 1 - i);
+    }
+}
+
 TEST(JobRunnerTest, AlwaysActiveThread) {
     constexpr std::size_t kThreadNum             = 4;
     constexpr std::size_t kAlwaysActiveThreadNum = 2;
@@ -213,6 +303,47 @@ TEST(JobRunnerTest, AlwaysActiveThread) {
     EVENTUALLY_EQ(runner->ActiveThreadNum(), kAlwaysActiveThreadNum);
 }
 
+TEST(JobRunnerTest, Priority) {
+    static constexpr std::size_t kJobNumPerPriority = 7;
+
+    JobRunner::Config config = {
+        .thread_num_ = 1,
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+
+    // Hold the only worker until all the jobs are queued.
+    std::atomic<bool> blocked{true};
+    EXPECT_TRUE(runner->AddJob([&blocked]() {
+        while (blocked.load()) {
+            std::this_thread::yield();
+        }
+    }));
+
+    // Only the worker accesses it after being unblocked.
+    std::vector<JobRunner::Priority> executed;
+    std::atomic<std::size_t>         finished_num{0};
+    for (std::size_t i = 0; i < kJobNumPerPriority; ++i) {
+        for (auto priority : {JobRunner::Priority::kLow, JobRunner::Priority::kHigh}) {
+            EXPECT_TRUE(runner->AddJob(
+                [&executed, &finished_num, priority]() {
+                    executed.push_back(priority);
+                    finished_num.fetch_add(1);
+                },
+                priority));
+        }
+    }
+    blocked.store(false);
+    EVENTUALLY_EQ(finished_num.load(), 2 * kJobNumPerPriority);
+
+    // High priority jobs take most of the turns, but the low priority ones are not starved. With the 4:2:1 weights
+    // and no normal priority jobs, any 7 consecutive picks have exactly one low priority job.
+    const auto high_num_in_first_round = static_cast<std::size_t>(std::count(
+        executed.begin(),
+        executed.begin() + static_cast<long>(kJobNumPerPriority),
+        JobRunner::Priority::kHigh));
+    EXPECT_EQ(high_num_in_first_round, kJobNumPerPriority - 1);
+}
+
 TEST(JobRunnerTest, StrandTest) {
     static constexpr std::size_t kThreadNum = 4;
     static constexpr std::size_t kJobNum    = 50000;
@@ -239,6 +370,544 @@ TEST(JobRunnerTest, StrandTest) {
     EVENTUALLY_EQ(finish.load(), true);
 }
 
+TEST(JobRunnerTest, StrandMultiProducer) {
+    static constexpr std::size_t kThreadNum   = 4;
+    static constexpr std::size_t kProducerNum = 4;
+    static constexpr std::size_t kJobNum      = 10000;
+
+    JobRunner::Config config = {
+        .thread_num_ = kThreadNum,
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+    auto strand = runner->MakeStrand();
+
+    // Jobs from the same producer keep their order. No lock needed, jobs in the strand run sequentially.
+    std::vector<std::size_t> next_job_idx(kProducerNum, 0);
+    std::atomic<std::size_t> finished_producer_num{0};
+
+    std::vector<std::thread> producers;
+    for (std::size_t producer_idx = 0; producer_idx < kProducerNum; ++producer_idx) {
+        producers.emplace_back([&, producer_idx]() {
+            for (std::size_t job_idx = 0; job_idx < kJobNum; ++job_idx) {
+                EXPECT_TRUE(runner->AddJob(
+                    [&next_job_idx, producer_idx, job_idx]() { EXPECT_EQ(next_job_idx[producer_idx]++, job_idx); },
+                    strand));
+            }
+            runner->AddJob([&finished_producer_num]() { finished_producer_num.fetch_add(1); }, strand);
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    EVENTUALLY_EQ(finished_producer_num.load(), kProducerNum);
+}
+
+TEST(JobRunnerTest, StrandReleasedWithPendingJobs) {
+    static constexpr std::size_t kThreadNum = 2;
+    static constexpr std::size_t kJobNum    = 1000;
+
+    JobRunner::Config config = {
+        .thread_num_ = kThreadNum,
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+
+    std::size_t       counter = 0;
+    std::atomic<bool> finish{false};
+    {
+        auto strand = runner->MakeStrand();
+        for (std::size_t job_idx = 0; job_idx < kJobNum; ++job_idx) {
+            EXPECT_TRUE(runner->AddJob([&counter]() { ++counter; }, strand));
+        }
+        EXPECT_TRUE(runner->AddJob([&finish]() { finish.store(true); }, strand));
+    }
+
+    // The jobs already added still run after the strand is released by the user.
+    EVENTUALLY_EQ(finish.load(), true);
+    EXPECT_EQ(counter, kJobNum);
+}
+
+TEST(JobRunnerTest, StrandBatch) {
+    static constexpr std::size_t kThreadNum   = 4;
+    static constexpr std::size_t kJobNum      = 10000;
+    static constexpr std::size_t kTokenJobIdx = kJobNum / 2;
+
+    JobRunner::Config config = {
+        .thread_num_ = kThreadNum,
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+    auto strand = runner->MakeStrand({.max_batch_ = 16, .max_time_ = std::chrono::milliseconds(1)});
+
+    std::size_t       expected_current_job_idx = 0;
+    std::atomic<bool> token_released{false};
+    for (std::size_t job_idx = 0; job_idx < kJobNum; ++job_idx) {
+        if (job_idx == kTokenJobIdx) {
+            // A job handing out its token is not finished until the token is released, even in a batch.
+            EXPECT_TRUE(runner->AddJob(
+                [runner, &token_released, &expected_current_job_idx](JobAliveTokenPtr&& alive_token) {
+                    ++expected_current_job_idx;
+                    runner->AddJob([alive_token = std::move(alive_token), &token_released]() {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                        token_released.store(true);
+                    });
+                },
+                strand));
+            continue;
+        }
+        EXPECT_TRUE(runner->AddJob(
+            [job_idx, &expected_current_job_idx, &token_released]() {
+                EXPECT_EQ(job_idx, expected_current_job_idx++);
+                EXPECT_EQ(token_released.load(), job_idx > kTokenJobIdx);
+            },
+            strand));
+    }
+
+    std::atomic<bool> finish{false};
+    EXPECT_TRUE(runner->AddJob([&finish]() { finish.store(true); }, strand));
+
+    EVENTUALLY_EQ(finish.load(), true);
+}
+
+TEST(JobRunnerTest, SharedAliveToken) {
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 2});
+    auto strand = runner->MakeStrand();
+
+    std::shared_ptr<JobAliveToken> shared_token;
+    std::weak_ptr<JobAliveToken>   weak_token;
+    std::atomic<bool>              wrapped{false};
+    std::atomic<bool>              next_job_run{false};
+    EXPECT_TRUE(runner->AddJob(
+        [&](JobAliveTokenPtr&& alive_token) {
+            shared_token = ToSharedAliveToken(std::move(alive_token));
+            weak_token   = shared_token;
+            wrapped.store(true);
+        },
+        strand));
+    EXPECT_TRUE(runner->AddJob([&next_job_run]() { next_job_run.store(true); }, strand));
+    EVENTUALLY_EQ(wrapped.load(), true);
+
+    // The job is not finished while the wrapper holds the token.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(next_job_run.load());
+    EXPECT_FALSE(weak_token.expired());
+    shared_token.reset();
+    EXPECT_TRUE(weak_token.expired());
+    EVENTUALLY_EQ(next_job_run.load(), true);
+}
+
+TEST(JobRunnerTest, EarliestDeadlineFirst) {
+    static constexpr std::size_t kJobNum = 16;
+
+    JobRunner::Config config = {
+        .thread_num_        = 1,
+        .scheduling_policy_ = JobRunner::SchedulingPolicy::kEarliestDeadlineFirst,
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+
+    // Hold the only worker until all the jobs are queued.
+    std::atomic<bool> blocked{true};
+    EXPECT_TRUE(runner->AddJob([&blocked]() {
+        while (blocked.load()) {
+            std::this_thread::yield();
+        }
+    }));
+
+    // Far enough in the future not to be missed. Jobs are added in an order different from their deadlines.
+    const cr_timestamp_nsec_t base_deadline = GetSystemTimestampNsec() + 3600 * std::nano::den;
+
+    // Only the worker accesses it after being unblocked.
+    std::vector<std::size_t> executed;
+    std::atomic<std::size_t> finished_num{0};
+    for (std::size_t i = 0; i < kJobNum; ++i) {
+        const std::size_t order = (i * 7) % kJobNum;
+        EXPECT_TRUE(runner->AddJobWithDeadline(
+            [&executed, &finished_num, order]() {
+                executed.push_back(order);
+                finished_num.fetch_add(1);
+            },
+            base_deadline + static_cast<cr_timestamp_nsec_t>(order)));
+    }
+    blocked.store(false);
+    EVENTUALLY_EQ(finished_num.load(), kJobNum);
+
+    ASSERT_EQ(executed.size(), kJobNum);
+    for (std::size_t i = 0; i < kJobNum; ++i) {
+        EXPECT_EQ(executed[i], i);
+    }
+    EXPECT_EQ(runner->DeadlineMissNum(), 0);
+}
+
+TEST(JobRunnerTest, DeadlineMiss) {
+    JobRunner::Config config = {
+        .thread_num_        = 2,
+        .scheduling_policy_ = JobRunner::SchedulingPolicy::kEarliestDeadlineFirst,
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+
+    std::atomic<std::size_t> finished_num{0};
+    EXPECT_TRUE(runner->AddJobWithDeadline([&finished_num]() { finished_num.fetch_add(1); }, 0));
+    EXPECT_TRUE(runner->AddJobWithDeadline(
+        [&finished_num]() { finished_num.fetch_add(1); },
+        GetSystemTimestampNsec() + 3600 * std::nano::den));
+    EVENTUALLY_EQ(finished_num.load(), 2);
+    EVENTUALLY_EQ(runner->DeadlineMissNum(), 1);
+}
+
+TEST(JobRunnerTest, WorkerPlacement) {
+    static constexpr std::size_t kThreadNum = 2;
+
+    JobRunner::Config config = {
+        .thread_num_         = kThreadNum,
+        .cpu_sets_           = {{0}},
+        .thread_name_prefix_ = "cr_test_",
+    };
+    auto runner = JobRunner::MakeJobRunner(config);
+
+    std::mutex               mtx;
+    std::set<int>            cpus;
+    std::set<std::string>    names;
+    std::atomic<std::size_t> started_num{0};
+    std::atomic<std::size_t> finished_num{0};
+    for (std::size_t i = 0; i < kThreadNum; ++i) {
+        EXPECT_TRUE(runner->AddJob(
+            [&]() {
+                // Held until all the jobs start, so that none of the workers runs more than one of them.
+                started_num.fetch_add(1);
+                while (started_num.load() < kThreadNum) {
+                    std::this_thread::yield();
+                }
+                std::array<char, 16> name{};
+                pthread_getname_np(pthread_self(), name.data(), name.size());
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    cpus.insert(sched_getcpu());
+                    names.insert(name.data());
+                }
+                finished_num.fetch_add(1);
+            },
+            i));
+    }
+    EVENTUALLY_EQ(finished_num.load(), kThreadNum);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    EXPECT_EQ(cpus, std::set<int>{0});
+    EXPECT_EQ(names, (std::set<std::string>{"cr_test_0", "cr_test_1"}));
+}
+
+// Workers without active time go to sleep as soon as they are idle. Jobs added around that moment must still wake
+// them up right away, instead of waiting for the idle timeout.
+TEST(JobRunnerTest, WakeUpSleepingWorker) {
+    static constexpr std::size_t kRoundNum = 200;
+    static constexpr auto        kTimeout  = std::chrono::milliseconds(500);
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 2});
+    for (std::size_t i = 0; i < kRoundNum; ++i) {
+        std::atomic<bool> done{false};
+        const auto        start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(runner->AddJob([&done]() { done.store(true); }, i));
+        while (!done.load() && std::chrono::steady_clock::now() - start < kTimeout) {
+            std::this_thread::yield();
+        }
+        ASSERT_TRUE(done.load()) << "Round " << i;
+    }
+}
+
+TEST(JobRunnerTest, WorkerTimeStats) {
+    static constexpr auto kActiveTime = std::chrono::milliseconds(1);
+    static constexpr auto kJobTime    = std::chrono::milliseconds(20);
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 1, .active_time_ = kActiveTime});
+    for (std::size_t i = 0; i < 2; ++i) {
+        // Let the worker spin and park, so that the job wakes it up.
+        EVENTUALLY_EQ(runner->ActiveThreadNum(), 0);
+
+        std::atomic<bool> done{false};
+        EXPECT_TRUE(runner->AddJob([&done]() {
+            std::this_thread::sleep_for(kJobTime);
+            done.store(true);
+        }));
+        EVENTUALLY_EQ(done.load(), true);
+    }
+    runner->Stop().Join();
+
+    const auto stats = runner->GetWorkerTimeStats();
+    ASSERT_EQ(stats.size(), 1);
+    EXPECT_GE(stats[0].busy_nsec_, 2 * std::chrono::duration_cast<std::chrono::nanoseconds>(kJobTime).count());
+    EXPECT_GT(stats[0].spin_nsec_, 0);
+    EXPECT_GT(stats[0].parked_nsec_, 0);
+    // Jobs arrived long after the worker parked, so there is no point spinning for the whole active time.
+    EXPECT_LT(stats[0].spin_limit_nsec_, std::chrono::duration_cast<std::chrono::nanoseconds>(kActiveTime).count());
+}
+
+TEST(JobRunnerTest, Stats) {
+    static constexpr std::size_t kThreadNum = 2;
+    static constexpr std::size_t kJobNum    = 100;
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = kThreadNum, .job_timing_ = true});
+
+    // Hold the worker, so that the jobs queue up behind it.
+    std::atomic<bool> blocked{true};
+    EXPECT_TRUE(runner->AddJob(
+        [&blocked]() {
+            while (blocked.load()) {
+                std::this_thread::yield();
+            }
+        },
+        std::size_t{0}));
+
+    std::atomic<std::size_t> counter{0};
+    for (std::size_t i = 0; i < kJobNum; ++i) {
+        EXPECT_TRUE(runner->AddJob([&counter]() { ++counter; }, std::size_t{0}));
+    }
+    const auto blocked_stats = runner->GetStats();
+    EXPECT_EQ(blocked_stats.thread_num_, kThreadNum);
+    ASSERT_EQ(blocked_stats.workers_.size(), kThreadNum);
+    EXPECT_LE(blocked_stats.queue_depth_, kJobNum + 1);
+
+    blocked.store(false);
+    EVENTUALLY_EQ(counter.load(), kJobNum);
+    EVENTUALLY_EQ(runner->GetStats().executed_job_num_, kJobNum + 1);
+    runner->Stop().Join();
+
+    const auto stats = runner->GetStats();
+    EXPECT_EQ(stats.queue_depth_, 0);
+    std::uint64_t executed_job_num = 0;
+    for (const auto& worker_stats : stats.workers_) {
+        EXPECT_LE(worker_stats.stolen_job_num_, worker_stats.steal_attempt_num_);
+        EXPECT_LE(worker_stats.stolen_job_num_, worker_stats.executed_job_num_);
+        executed_job_num += worker_stats.executed_job_num_;
+    }
+    EXPECT_EQ(executed_job_num, kJobNum + 1);
+}
+
+TEST(JobRunnerTest, BoundedQueue) {
+    static constexpr std::size_t kMaxQueueDepth = 4;
+    static constexpr std::size_t kJobNum        = 10;
+
+    for (const auto overflow_policy : {JobRunner::OverflowPolicy::kDropNewest, JobRunner::OverflowPolicy::kBlock}) {
+        auto runner = JobRunner::MakeJobRunner(JobRunner::Config{
+            .thread_num_      = 1,
+            .max_queue_depth_ = kMaxQueueDepth,
+            .overflow_policy_ = overflow_policy,
+        });
+
+        // Hold the only worker, so that the jobs queue up behind it.
+        std::atomic<bool> blocked{true};
+        std::atomic<bool> started{false};
+        EXPECT_TRUE(runner->AddJob([&blocked, &started]() {
+            started.store(true);
+            while (blocked.load()) {
+                std::this_thread::yield();
+            }
+        }));
+        EVENTUALLY_EQ(started.load(), true);
+
+        std::atomic<std::size_t> counter{0};
+        std::atomic<std::size_t> added_num{0};
+        std::thread              producer([&runner, &counter, &added_num]() {
+            for (std::size_t i = 0; i < kJobNum; ++i) {
+                if (runner->AddJob([&counter]() { ++counter; })) {
+                    ++added_num;
+                }
+            }
+        });
+
+        if (overflow_policy == JobRunner::OverflowPolicy::kDropNewest) {
+            producer.join();
+            EXPECT_EQ(added_num.load(), kMaxQueueDepth);
+            EXPECT_EQ(runner->GetStats().dropped_job_num_, kJobNum - kMaxQueueDepth);
+            blocked.store(false);
+        } else {
+            // The producer waits for room until the worker is released.
+            EVENTUALLY_EQ(runner->GetStats().blocked_job_num_, 1);
+            EXPECT_EQ(added_num.load(), kMaxQueueDepth);
+            blocked.store(false);
+            producer.join();
+            EXPECT_EQ(added_num.load(), kJobNum);
+            EXPECT_EQ(runner->GetStats().dropped_job_num_, 0);
+        }
+        EVENTUALLY_EQ(counter.load(), added_num.load());
+        runner->Stop().Join();
+    }
+}
+
+// Jobs spawning more jobs into their own full queue help run them, which nests deeper and deeper.
+TEST(JobRunnerTest, BoundedQueueHelpingDepth) {
+    static constexpr std::size_t kJobNum = 10000;
+    // The runner helps up to 4 levels deep, see `JobRunner::WaitForRoom`.
+    static constexpr std::size_t kMaxNesting = 5;
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{
+        .thread_num_      = 1,
+        .max_queue_depth_ = 1,
+        .overflow_policy_ = JobRunner::OverflowPolicy::kBlock,
+    });
+
+    std::atomic<std::size_t> spawned_num{0};
+    std::atomic<std::size_t> finished_num{0};
+    std::size_t              nesting     = 0;
+    std::size_t              max_nesting = 0;
+
+    std::function<void()> spawn = [&]() {
+        max_nesting = std::max(max_nesting, ++nesting);
+        for (std::size_t i = 0; i < 2 && spawned_num.fetch_add(1) < kJobNum; ++i) {
+            EXPECT_TRUE(runner->AddJob([&spawn]() { spawn(); }));
+        }
+        --nesting;
+        ++finished_num;
+    };
+    EXPECT_TRUE(runner->AddJob([&spawn]() { spawn(); }));
+
+    EVENTUALLY_EQ(finished_num.load(), kJobNum + 1);
+    EXPECT_LE(max_nesting, kMaxNesting);
+    runner->Stop().Join();
+}
+
+TEST(JobRunnerTest, BoundedStrand) {
+    static constexpr std::size_t kJobNum = 10;
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 1});
+
+    // Hold the only worker, so that the jobs queue up in the strands.
+    std::atomic<bool> blocked{true};
+    std::atomic<bool> started{false};
+    EXPECT_TRUE(runner->AddJob([&blocked, &started]() {
+        started.store(true);
+        while (blocked.load()) {
+            std::this_thread::yield();
+        }
+    }));
+    EVENTUALLY_EQ(started.load(), true);
+
+    // Not locked, the jobs of each strand run sequentially.
+    std::vector<std::size_t> latest_ran;
+    std::vector<std::size_t> earliest_ran;
+    std::atomic<std::size_t> ran_num{0};
+
+    auto latest_strand =
+        runner->MakeStrand({.max_pending_ = 1, .overflow_policy_ = JobRunner::OverflowPolicy::kDropOldest});
+    auto earliest_strand =
+        runner->MakeStrand({.max_pending_ = 2, .overflow_policy_ = JobRunner::OverflowPolicy::kDropNewest});
+    std::size_t earliest_added_num = 0;
+    for (std::size_t i = 0; i < kJobNum; ++i) {
+        EXPECT_TRUE(runner->AddJob(
+            [&latest_ran, &ran_num, i]() {
+                latest_ran.push_back(i);
+                ++ran_num;
+            },
+            latest_strand));
+        if (runner->AddJob(
+                [&earliest_ran, &ran_num, i]() {
+                    earliest_ran.push_back(i);
+                    ++ran_num;
+                },
+                earliest_strand)) {
+            ++earliest_added_num;
+        }
+    }
+    EXPECT_EQ(earliest_added_num, 2);
+    EXPECT_EQ(runner->GetStats().dropped_job_num_, 2 * kJobNum - 3);
+
+    blocked.store(false);
+    EVENTUALLY_EQ(ran_num.load(), 3);
+    EXPECT_EQ(latest_ran, (std::vector<std::size_t>{kJobNum - 1}));
+    EXPECT_EQ(earliest_ran, (std::vector<std::size_t>{0, 1}));
+    runner->Stop().Join();
+}
+
+TEST(JobRunnerTest, AddJobAt) {
+    static constexpr std::size_t kTimerNum = 100000;
+    static constexpr auto        kDelay    = std::chrono::milliseconds(20);
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 2});
+
+    const auto               start_nsec = GetSystemTimestampNsec();
+    const auto               time_nsec  = start_nsec + std::chrono::nanoseconds(kDelay).count();
+    std::atomic<std::size_t> early_num{0};
+    std::atomic<std::size_t> counter{0};
+    for (std::size_t i = 0; i < kTimerNum; ++i) {
+        // Spread over many ticks.
+        const auto job_time_nsec = time_nsec + static_cast<cr_timestamp_nsec_t>(i % 1000) * 1000;
+        EXPECT_TRUE(runner->AddJobAt(
+            [&early_num, &counter, job_time_nsec]() {
+                if (GetSystemTimestampNsec() < job_time_nsec) {
+                    ++early_num;
+                }
+                ++counter;
+            },
+            job_time_nsec));
+    }
+
+    // Cancelled before running, never runs.
+    std::atomic<bool> cancelled_run{false};
+    auto              handle = runner->AddJobAfter([&cancelled_run]() { cancelled_run.store(true); }, kDelay);
+    ASSERT_TRUE(handle);
+    EXPECT_TRUE(handle.Cancel());
+    EXPECT_FALSE(handle.Cancel());
+
+    EVENTUALLY_EQ(counter.load(), kTimerNum);
+    EXPECT_EQ(early_num.load(), 0);
+    EXPECT_FALSE(cancelled_run.load());
+
+    runner->Stop().Join();
+    EXPECT_FALSE(runner->AddJobAfter([]() {}, kDelay));
+}
+
+TEST(JobRunnerTest, AddPeriodicJob) {
+    static constexpr std::size_t kThreadNum = 4;
+    static constexpr std::size_t kRunNum    = 5;
+    static constexpr auto        kPeriod    = std::chrono::milliseconds(2);
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = kThreadNum});
+    auto strand = runner->MakeStrand();
+
+    // Not atomic on purpose, the jobs run in the strand.
+    std::size_t              strand_counter = 0;
+    std::atomic<std::size_t> counter{0};
+    auto strand_handle = runner->AddPeriodicJob([&strand_counter]() { ++strand_counter; }, kPeriod, strand);
+    auto handle        = runner->AddPeriodicJob([&counter]() { ++counter; }, kPeriod, JobRunner::Priority::kHigh);
+    ASSERT_TRUE(strand_handle);
+    ASSERT_TRUE(handle);
+
+    EVENTUALLY_EQ(counter.load() >= kRunNum, true);
+    EXPECT_TRUE(handle.Cancel());
+
+    std::atomic<bool> strand_checked{false};
+    runner->AddJob(
+        [&strand_counter, &strand_checked]() {
+            EXPECT_GT(strand_counter, 0);
+            strand_checked.store(true);
+        },
+        strand);
+    EVENTUALLY_EQ(strand_checked.load(), true);
+    EXPECT_TRUE(strand_handle.Cancel());
+
+    // No more runs after cancelled, except the one that may have been running.
+    std::this_thread::sleep_for(kPeriod);
+    const auto cancelled_counter = counter.load();
+    std::this_thread::sleep_for(kPeriod * 5);
+    EXPECT_EQ(counter.load(), cancelled_counter);
+    runner->Stop().Join();
+}
+
+TEST(JobRunnerTest, ReleasedByWorker) {
+    auto              runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 2});
+    auto              holder = std::make_shared<std::shared_ptr<JobRunner>>(runner);
+    std::atomic<bool> added{false};
+    std::atomic<bool> released{false};
+    EXPECT_TRUE(runner->AddJob([holder, &added, &released]() {
+        while (!added.load()) {
+            std::this_thread::yield();
+        }
+        // The last reference, released in the worker, which cannot join itself.
+        holder->reset();
+        released.store(true);
+    }));
+    runner.reset();
+    added.store(true);
+    EVENTUALLY_EQ(released.load(), true);
+}
+
 TEST(JobRunnerTest, JobAliveToken) {
     static constexpr std::size_t kThreadNum      = 4;
     static constexpr std::size_t kSpawningJobNum = 100;
@@ -0,0 +1,123 @@
+#include "cris/core/msg/message_pool.h"
+
+#include "cris/core/msg/node.h"
+#include "cris/core/sched/job_runner.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace cris::core {
+
+namespace {
+
+struct PoolTestMessage : public CRMessage<PoolTestMessage> {
+    PoolTestMessage() { live_num_.fetch_add(1); }
+
+    PoolTestMessage(const PoolTestMessage&)            = delete;
+    PoolTestMessage(PoolTestMessage&&)                 = delete;
+    PoolTestMessage& operator=(const PoolTestMessage&) = delete;
+    PoolTestMessage& operator=(PoolTestMessage&&)      = delete;
+
+    ~PoolTestMessage() override { live_num_.fetch_sub(1); }
+
+    std::array<int, 1024> values_{};
+
+    static inline std::atomic<int> live_num_{0};
+};
+
+}  // namespace
+
+TEST(MessagePoolTest, Recycle) {
+    auto pool = CRMessagePool<PoolTestMessage>::MakeMessagePool({.capacity_ = 2});
+    EXPECT_EQ(pool->Capacity(), 2);
+    EXPECT_EQ(pool->FreeNum(), 2);
+    EXPECT_EQ(PoolTestMessage::live_num_.load(), 2);
+
+    auto  message       = pool->Acquire();
+    auto* message_ptr   = message.get();
+    message->values_[0] = 1;
+    EXPECT_EQ(pool->FreeNum(), 1);
+
+    std::weak_ptr<PoolTestMessage> weak_message = message;
+    message.reset();
+    // Not back to the pool, until the weak reference is gone as well.
+    EXPECT_EQ(pool->FreeNum(), 1);
+    weak_message.reset();
+    EXPECT_EQ(pool->FreeNum(), 2);
+
+    // Recycled as it is.
+    message = pool->Acquire();
+    EXPECT_EQ(message.get(), message_ptr);
+    EXPECT_EQ(message->values_[0], 1);
+    EXPECT_EQ(PoolTestMessage::live_num_.load(), 2);
+}
+
+TEST(MessagePoolTest, Exhausted) {
+    auto pool = CRMessagePool<PoolTestMessage>::MakeMessagePool({.capacity_ = 1});
+
+    auto message = pool->Acquire();
+    {
+        auto extra_message = pool->Acquire();
+        EXPECT_NE(extra_message, nullptr);
+        EXPECT_EQ(pool->FreeNum(), 0);
+        EXPECT_EQ(PoolTestMessage::live_num_.load(), 2);
+    }
+    EXPECT_EQ(PoolTestMessage::live_num_.load(), 1);
+    EXPECT_EQ(pool->FreeNum(), 0);
+}
+
+TEST(MessagePoolTest, OutlivedByMessages) {
+    auto pool = CRMessagePool<PoolTestMessage>::MakeMessagePool({.capacity_ = 4});
+
+    auto message = pool->Acquire();
+    pool.reset();
+    EXPECT_EQ(PoolTestMessage::live_num_.load(), 4);
+    message->values_[0] = 1;
+    message.reset();
+    EXPECT_EQ(PoolTestMessage::live_num_.load(), 0);
+}
+
+TEST(MessagePoolTest, Hugepages) {
+    auto pool = CRMessagePool<PoolTestMessage>::MakeMessagePool({.capacity_ = 4, .use_hugepages_ = true});
+    EXPECT_EQ(pool->FreeNum(), 4);
+    auto message = pool->Acquire();
+    message->values_.back() = 1;
+}
+
+TEST(MessagePoolTest, Publish) {
+    constexpr CRMessageBase::channel_subid_t kChannelSubId = 1;
+    constexpr int                            kMessageNum   = 1000;
+
+    auto   runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+    auto   pool   = CRMessagePool<PoolTestMessage>::MakeMessagePool({.capacity_ = 4});
+    CRNode publisher;
+    CRNode subscriber(runner);
+
+    std::atomic<int> sum{0};
+    std::atomic<int> received_num{0};
+    subscriber.Subscribe<PoolTestMessage>(kChannelSubId, [&](const std::shared_ptr<PoolTestMessage>& message) {
+        sum.fetch_add(message->values_[0]);
+        received_num.fetch_add(1);
+    });
+
+    for (int i = 1; i <= kMessageNum; ++i) {
+        auto message        = pool->Acquire();
+        message->values_[0] = i;
+        publisher.Publish(kChannelSubId, std::move(message));
+    }
+    while (received_num.load() != kMessageNum) {
+        std::this_thread::yield();
+    }
+    runner->Stop().Join();
+
+    EXPECT_EQ(sum.load(), kMessageNum * (kMessageNum + 1) / 2);
+    EXPECT_EQ(pool->FreeNum(), 4);
+}
+
+}  // namespace cris::core
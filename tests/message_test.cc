@@ -7,9 +7,15 @@
 
 #include <boost/functional/hash.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <functional>
 #include <memory>
+#include <thread>
+#include <typeindex>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
 
@@ -32,6 +38,16 @@ TEST(MessageTest, Basics) {
     EXPECT_EQ(message->GetMessageTypeName(), GetTypeName<TestMessage<1>>());
 }
 
+TEST(MessageTest, TypeIds) {
+    const auto type_id = CRMessageBase::GetMessageTypeId<TestMessage<1>>();
+    EXPECT_EQ(CRMessageBase::GetMessageTypeId<TestMessage<1>>(), type_id);
+    EXPECT_NE(CRMessageBase::GetMessageTypeId<TestMessage<2>>(), type_id);
+    EXPECT_EQ(CRMessageBase::GetRegisteredMessageType(type_id), std::type_index(typeid(TestMessage<1>)));
+
+    CRMessageBasePtr message = std::make_shared<TestMessage<1>>(1);
+    EXPECT_EQ(message->GetChannelId(), CRMessageBase::MakeChannelId<TestMessage<1>>(message->GetChannelSubId()));
+}
+
 TEST(MessageTest, DeliveredTime) {
     CRNode publisher;
 
@@ -117,4 +133,104 @@ TEST(MessageTest, DeliveredTime) {
     }
 }
 
+TEST(MessageTest, ChannelStats) {
+    constexpr channel_subid_t kChannelSubId = 1;
+    constexpr int             kMessageNum   = 100;
+
+    CRNode publisher;
+
+    // Unknown channel
+    auto stats = CRMessageBase::GetChannelStats<TestMessage<400>>(kChannelSubId);
+    EXPECT_EQ(stats.message_type_, GetTypeName<TestMessage<400>>());
+    EXPECT_EQ(stats.channel_subid_, kChannelSubId);
+    EXPECT_EQ(stats.published_num_, 0);
+    EXPECT_EQ(stats.GetPercentileLatencyNsec(50), 0);
+
+    auto             runner = JobRunner::MakeJobRunner({});
+    CRNode           node1(runner);
+    CRNode           node2(runner);
+    std::atomic<int> received_num{0};
+    node1.Subscribe<TestMessage<400>>(kChannelSubId, [&received_num](auto&&) { received_num.fetch_add(1); });
+    node2.Subscribe<TestMessage<400>>(kChannelSubId, [&received_num](auto&&) { received_num.fetch_add(1); });
+
+    for (int i = 0; i < kMessageNum; ++i) {
+        publisher.Publish(kChannelSubId, std::make_shared<TestMessage<400>>(i));
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received_num.load() < 2 * kMessageNum && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(received_num.load(), 2 * kMessageNum);
+    runner->Stop().Join();
+    runner.reset();
+
+    // The runner is gone.
+    publisher.Publish(kChannelSubId, std::make_shared<TestMessage<400>>(kMessageNum));
+
+    stats = CRMessageBase::GetChannelStats<TestMessage<400>>(kChannelSubId);
+    EXPECT_EQ(stats.published_num_, kMessageNum + 1);
+    EXPECT_EQ(stats.delivered_num_, 2 * kMessageNum);
+    EXPECT_EQ(stats.failed_delivery_num_, 2);
+    EXPECT_EQ(stats.serialized_bytes_, 0);
+
+    unsigned long long latency_hits = 0;
+    for (const auto& bucket : stats.latency_buckets_) {
+        latency_hits += bucket.hits_;
+    }
+    EXPECT_EQ(latency_hits, 2 * kMessageNum);
+    EXPECT_GT(stats.max_latency_ns_, 0);
+    EXPECT_LE(stats.GetPercentileLatencyNsec(50), stats.GetPercentileLatencyNsec(99));
+    EXPECT_LE(stats.GetPercentileLatencyNsec(99), stats.GetPercentileLatencyNsec(100));
+
+    const auto all_stats = CRMessageBase::GetChannelStats();
+    EXPECT_TRUE(std::any_of(all_stats.begin(), all_stats.end(), [](const CRMessageBase::ChannelStats& channel_stats) {
+        return channel_stats.message_type_ == GetTypeName<TestMessage<400>>() &&
+               channel_stats.channel_subid_ == kChannelSubId && channel_stats.published_num_ == kMessageNum + 1;
+    }));
+}
+
+TEST(MessageTest, ChannelStatsRepublished) {
+    constexpr channel_subid_t kChannelSubId1 = 1;
+    constexpr channel_subid_t kChannelSubId2 = 2;
+
+    auto             runner = JobRunner::MakeJobRunner({.thread_num_ = 1});
+    CRNode           publisher;
+    CRNode           node(runner);
+    std::atomic<int> received_num{0};
+    node.Subscribe<TestMessage<401>>(kChannelSubId1, [&received_num](auto&&) { received_num.fetch_add(1); });
+    node.Subscribe<TestMessage<401>>(kChannelSubId2, [&received_num](auto&&) { received_num.fetch_add(1); });
+
+    // The only worker is busy, so that the message is published again before its first delivery runs.
+    std::atomic<bool> release{false};
+    runner->AddJob([&release] {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    const auto message = std::make_shared<TestMessage<401>>(0);
+    publisher.Publish(kChannelSubId1, message);
+    publisher.Publish(kChannelSubId2, message);
+    release.store(true);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received_num.load() < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(received_num.load(), 2);
+    runner->Stop().Join();
+
+    // Each delivery is counted in the channel it was published to.
+    for (const auto subid : {kChannelSubId1, kChannelSubId2}) {
+        const auto stats = CRMessageBase::GetChannelStats<TestMessage<401>>(subid);
+        EXPECT_EQ(stats.published_num_, 1);
+        EXPECT_EQ(stats.delivered_num_, 1);
+
+        unsigned long long latency_hits = 0;
+        for (const auto& bucket : stats.latency_buckets_) {
+            latency_hits += bucket.hits_;
+        }
+        EXPECT_EQ(latency_hits, 1);
+    }
+}
+
 }  // namespace cris::core
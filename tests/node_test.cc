@@ -2,7 +2,9 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
 #include <functional>
@@ -11,6 +13,7 @@
 #include <numeric>
 #include <thread>
 #include <utility>
+#include <vector>
 
 namespace cris::core {
 
@@ -378,4 +381,386 @@ TEST(NodeTest, SubscribeWhenPublishing) {
     producer_thread.join();
     runner->Stop().Join();
 }
+
+TEST(NodeTest, SubscriptionPriority) {
+    using HighMessageType = TestMessage<1>;
+    using LowMessageType  = TestMessage<2>;
+
+    constexpr std::size_t    kMessageNum   = 7;
+    const channel_subid_t    channel_subid = 1;
+    auto                     runner        = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 1});
+    CRNode                   publisher;
+    CRNode                   subscriber(runner);
+    std::vector<int>         received;
+    std::atomic<std::size_t> received_num{0};
+    std::atomic<bool>        blocked{true};
+
+    subscriber.Subscribe<HighMessageType>(
+        channel_subid,
+        [&received, &received_num](const std::shared_ptr<HighMessageType>&) {
+            received.push_back(1);
+            received_num.fetch_add(1);
+        },
+        CRNode::SubscriptionOptions{.allow_concurrency_ = false, .priority_ = JobRunner::Priority::kHigh});
+    subscriber.Subscribe<LowMessageType>(
+        channel_subid,
+        [&received, &received_num](const std::shared_ptr<LowMessageType>&) {
+            received.push_back(2);
+            received_num.fetch_add(1);
+        },
+        CRNode::SubscriptionOptions{.priority_ = JobRunner::Priority::kLow});
+
+    // Hold the only worker until all the messages are published.
+    subscriber.AddJobToRunner([&blocked]() {
+        while (blocked.load()) {
+            std::this_thread::yield();
+        }
+    });
+    for (std::size_t i = 0; i < kMessageNum; ++i) {
+        publisher.Publish(channel_subid, std::make_shared<LowMessageType>(0));
+        publisher.Publish(channel_subid, std::make_shared<HighMessageType>(0));
+    }
+    blocked.store(false);
+
+    while (received_num.load() < 2 * kMessageNum) {
+        std::this_thread::yield();
+    }
+
+    // Callbacks inherit the priority of their subscriptions.
+    EXPECT_EQ(std::count(received.begin(), received.begin() + kMessageNum, 1), kMessageNum - 1);
+
+    runner->Stop().Join();
+}
+
+TEST(NodeTest, LatestMessageSubscriber) {
+    using TestMessageType = TestMessage<13>;
+
+    constexpr std::size_t    kMessageNum   = 10;
+    const channel_subid_t    channel_subid = 1;
+    auto                     runner        = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 1});
+    CRNode                   publisher;
+    CRNode                   subscriber(runner);
+    std::vector<int>         received;
+    std::atomic<std::size_t> received_num{0};
+    std::atomic<bool>        blocked{true};
+
+    subscriber.Subscribe<TestMessageType>(
+        channel_subid,
+        [&received, &received_num](const std::shared_ptr<TestMessageType>& message) {
+            received.push_back(message->value_);
+            received_num.fetch_add(1);
+        },
+        CRNode::SubscriptionOptions{
+            .allow_concurrency_ = false,
+            .max_pending_       = 1,
+            .overflow_policy_   = JobRunner::OverflowPolicy::kDropOldest,
+        });
+
+    // Hold the only worker until all the messages are published.
+    subscriber.AddJobToRunner([&blocked]() {
+        while (blocked.load()) {
+            std::this_thread::yield();
+        }
+    });
+    for (std::size_t i = 0; i < kMessageNum; ++i) {
+        publisher.Publish(channel_subid, std::make_shared<TestMessageType>(static_cast<int>(i)));
+    }
+    blocked.store(false);
+
+    while (received_num.load() < 1) {
+        std::this_thread::yield();
+    }
+    runner->Stop().Join();
+
+    // Stale messages are replaced by the latest one.
+    EXPECT_EQ(received, (std::vector<int>{static_cast<int>(kMessageNum) - 1}));
+    EXPECT_EQ(runner->GetStats().dropped_job_num_, kMessageNum - 1);
+}
+
+TEST(NodeTest, LatestOnlySubscriber) {
+    using TestMessageType = TestMessage<14>;
+
+    constexpr std::size_t    kMessageNum   = 10;
+    const channel_subid_t    channel_subid = 1;
+    auto                     runner        = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 1});
+    CRNode                   publisher;
+    CRNode                   subscriber(runner);
+    std::vector<int>         received;
+    std::atomic<std::size_t> received_num{0};
+    std::atomic<bool>        blocked{true};
+
+    subscriber.Subscribe<TestMessageType>(
+        channel_subid,
+        [&received, &received_num](const std::shared_ptr<TestMessageType>& message) {
+            received.push_back(message->value_);
+            received_num.fetch_add(1);
+        },
+        CRNode::SubscriptionOptions{.allow_concurrency_ = false, .latest_only_ = true});
+
+    // Hold the only worker until all the messages are published.
+    subscriber.AddJobToRunner([&blocked]() {
+        while (blocked.load()) {
+            std::this_thread::yield();
+        }
+    });
+    for (std::size_t i = 0; i < kMessageNum; ++i) {
+        publisher.Publish(channel_subid, std::make_shared<TestMessageType>(static_cast<int>(i)));
+    }
+    blocked.store(false);
+
+    while (received_num.load() < 1) {
+        std::this_thread::yield();
+    }
+
+    // Messages after the delivery are delivered again.
+    publisher.Publish(channel_subid, std::make_shared<TestMessageType>(static_cast<int>(kMessageNum)));
+    while (received_num.load() < 2) {
+        std::this_thread::yield();
+    }
+    runner->Stop().Join();
+
+    // Only one job was in flight, which took the latest message, and nothing was dropped from the queues.
+    EXPECT_EQ(received, (std::vector<int>{static_cast<int>(kMessageNum) - 1, static_cast<int>(kMessageNum)}));
+    EXPECT_EQ(runner->GetStats().dropped_job_num_, 0);
+}
+
+TEST(NodeTest, BlockingSubscriberInWorker) {
+    using TestMessageType   = TestMessage<18>;
+    using SubscribedMessage  = TestMessage<19>;
+
+    constexpr std::size_t    kMessageNum   = 3;
+    const channel_subid_t    channel_subid = 1;
+    auto                     runner        = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 1});
+    CRNode                   publisher;
+    CRNode                   subscriber(runner);
+    CRNode                   late_subscriber(runner);
+    std::vector<int>         received;
+    std::atomic<std::size_t> received_num{0};
+    std::atomic<bool>        subscribed{false};
+
+    subscriber.Subscribe<TestMessageType>(
+        channel_subid,
+        [&received, &received_num](const std::shared_ptr<TestMessageType>& message) {
+            received.push_back(message->value_);
+            received_num.fetch_add(1);
+        },
+        CRNode::SubscriptionOptions{
+            .allow_concurrency_ = false,
+            .max_pending_       = 1,
+            .overflow_policy_   = JobRunner::OverflowPolicy::kBlock,
+        });
+
+    // Publishing in the only worker waits for room by running the queued jobs, one of which subscribes, and so
+    // waits for all the read-side critical sections.
+    subscriber.AddJobToRunner([&]() {
+        late_subscriber.AddJobToRunner([&]() {
+            late_subscriber.Subscribe<SubscribedMessage>(
+                channel_subid,
+                [](const std::shared_ptr<SubscribedMessage>&) {});
+            subscribed.store(true);
+        });
+        for (std::size_t i = 0; i < kMessageNum; ++i) {
+            publisher.Publish(channel_subid, std::make_shared<TestMessageType>(static_cast<int>(i)));
+        }
+    });
+
+    while (received_num.load() < kMessageNum || !subscribed.load()) {
+        std::this_thread::yield();
+    }
+    runner->Stop().Join();
+
+    // Nothing is dropped with `OverflowPolicy::kBlock`.
+    EXPECT_EQ(received, (std::vector<int>{0, 1, 2}));
+    EXPECT_EQ(runner->GetStats().dropped_job_num_, 0);
+}
+
+TEST(NodeTest, Publisher) {
+    using TestMessageType = TestMessage<15>;
+
+    const channel_subid_t channel_subid = 5;
+    auto                  runner        = JobRunner::MakeJobRunner(JobRunner::Config{});
+
+    // Made before anyone subscribes.
+    const auto publisher = CRNode::MakePublisher<TestMessageType>(channel_subid);
+    ASSERT_TRUE(publisher);
+    EXPECT_EQ(publisher.GetChannelSubId(), channel_subid);
+    publisher.Publish(std::make_shared<TestMessageType>(0));
+
+    std::atomic<int> received_sum{0};
+    std::atomic<int> received_num{0};
+    const auto       callback = [&received_sum, &received_num, channel_subid](const auto& message) {
+        EXPECT_EQ(message->GetChannelSubId(), channel_subid);
+        received_sum.fetch_add(message->value_);
+        received_num.fetch_add(1);
+    };
+
+    CRNode subscriber(runner);
+    subscriber.Subscribe<TestMessageType>(channel_subid, callback);
+    {
+        CRNode another_subscriber(runner);
+        another_subscriber.Subscribe<TestMessageType>(channel_subid, callback);
+
+        const auto start_time = GetSystemTimestampNsec();
+        publisher.Publish(std::make_shared<TestMessageType>(1));
+        EXPECT_GE(CRMessageBase::GetLatestDeliveredTime<TestMessageType>(channel_subid), start_time);
+
+        // Publishing without the handle reaches the same subscribers.
+        CRNode().Publish(channel_subid, std::make_shared<TestMessageType>(10));
+        while (received_num.load() < 4) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Unsubscribed when the node goes away.
+    CRPublisher<TestMessageType>(publisher).Publish(std::make_shared<TestMessageType>(100));
+    while (received_num.load() < 5) {
+        std::this_thread::yield();
+    }
+    runner->Stop().Join();
+
+    EXPECT_EQ(received_num.load(), 5);
+    EXPECT_EQ(received_sum.load(), 122);
+}
+
+TEST(NodeTest, RangeSubscriber) {
+    using TestMessageType = TestMessage<16>;
+
+    constexpr channel_subid_t kFirstSubId = 100;
+    constexpr channel_subid_t kLastSubId  = 199;
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{});
+
+    // Added before subscribing.
+    const auto publisher = CRNode::MakePublisher<TestMessageType>(kFirstSubId);
+
+    std::atomic<int> received_sum{0};
+    std::atomic<int> received_num{0};
+    std::atomic<int> all_received_num{0};
+    {
+        CRNode subscriber(runner);
+        subscriber.SubscribeRange<TestMessageType>(kFirstSubId, kLastSubId, [&](const auto& message) {
+            EXPECT_GE(message->GetChannelSubId(), kFirstSubId);
+            EXPECT_LE(message->GetChannelSubId(), kLastSubId);
+            received_sum.fetch_add(message->value_);
+            received_num.fetch_add(1);
+        });
+        // Ignored, since the channel is in the range.
+        subscriber.Subscribe<TestMessageType>(kFirstSubId, [](const auto&) { ADD_FAILURE(); });
+        CRNode all_subscriber(runner);
+        all_subscriber.SubscribeAll<TestMessageType>([&](const auto&) { all_received_num.fetch_add(1); });
+
+        auto message = std::make_shared<TestMessageType>(1);
+        publisher.Publish(std::shared_ptr<TestMessageType>(message));
+        // Handed to the node again, and taken by the range as well.
+        EXPECT_TRUE(subscriber.AddMessageToRunner(message));
+        // Added after subscribing, by publishing or by making a publisher.
+        CRNode().Publish(kLastSubId, std::make_shared<TestMessageType>(10));
+        CRNode::MakePublisher<TestMessageType>(150).Publish(std::make_shared<TestMessageType>(100));
+        // Out of the range.
+        CRNode().Publish(kLastSubId + 1, std::make_shared<TestMessageType>(1000));
+        CRNode().Publish(kFirstSubId - 1, std::make_shared<TestMessageType>(1000));
+        while (received_num.load() < 4 || all_received_num.load() < 5) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Unsubscribed when the nodes go away.
+    publisher.Publish(std::make_shared<TestMessageType>(100000));
+    CRNode().Publish(kLastSubId, std::make_shared<TestMessageType>(100000));
+    runner->Stop().Join();
+
+    EXPECT_EQ(received_num.load(), 4);
+    EXPECT_EQ(received_sum.load(), 112);
+    EXPECT_EQ(all_received_num.load(), 5);
+}
+
+TEST(NodeTest, RangeSubscriberStrandPerChannel) {
+    using TestMessageType = TestMessage<17>;
+
+    constexpr std::size_t kChannelNum = 8;
+    constexpr int         kMessageNum = 1000;
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{.thread_num_ = 4});
+
+    std::mutex                                received_mtx;
+    std::array<std::vector<int>, kChannelNum> received;
+    std::atomic<int>                          received_num{0};
+    std::array<std::atomic<int>, kChannelNum> running_num{};
+    CRNode                                    subscriber(runner);
+    subscriber.SubscribeRange<TestMessageType>(
+        0,
+        kChannelNum - 1,
+        [&](const std::shared_ptr<TestMessageType>& message) {
+            const auto subid = message->GetChannelSubId();
+            // Each channel runs sequentially.
+            EXPECT_EQ(running_num[subid].fetch_add(1), 0);
+            {
+                std::lock_guard lck(received_mtx);
+                received[subid].push_back(message->value_);
+            }
+            running_num[subid].fetch_sub(1);
+            received_num.fetch_add(1);
+        },
+        CRNode::SubscriptionOptions{.allow_concurrency_ = false, .strand_per_channel_ = true});
+
+    CRNode publisher;
+    for (int i = 0; i < kMessageNum; ++i) {
+        for (channel_subid_t subid = 0; subid < kChannelNum; ++subid) {
+            publisher.Publish(subid, std::make_shared<TestMessageType>(i));
+        }
+    }
+    while (received_num.load() < kMessageNum * static_cast<int>(kChannelNum)) {
+        std::this_thread::yield();
+    }
+    runner->Stop().Join();
+
+    std::vector<int> expected(kMessageNum);
+    std::iota(expected.begin(), expected.end(), 0);
+    for (const auto& channel_received : received) {
+        EXPECT_EQ(channel_received, expected);
+    }
+}
+
+TEST(NodeTest, CoroutineSubscriber) {
+    static constexpr std::size_t kThreadNum     = 4;
+    constexpr std::size_t        kMessageNumber = 1000;
+    const channel_subid_t        channel_subid  = 3;
+
+    using TestMessageType = TestMessage<12>;
+
+    auto runner = JobRunner::MakeJobRunner(JobRunner::Config{
+        .thread_num_ = kThreadNum,
+    });
+
+    CRNode publisher;
+    CRNode subscriber(runner);
+
+    std::mutex              cv_mtx;
+    std::condition_variable cv;
+    std::size_t             counter  = 0;
+    bool                    complete = false;
+
+    subscriber.Subscribe<TestMessageType>(
+        channel_subid,
+        [&counter, &complete, &cv_mtx, &cv, runner](const std::shared_ptr<TestMessageType>& message) -> Task<void> {
+            // Messages are still handled one by one, even though the coroutines are suspended in between.
+            const auto expected = counter;
+            co_await runner->Schedule();
+            EXPECT_EQ(expected, static_cast<std::size_t>(message->value_));
+            if (++counter == kMessageNumber) {
+                std::unique_lock cv_lck(cv_mtx);
+                complete = true;
+                cv.notify_all();
+            }
+        },
+        /* allow_concurrency = */ false);
+
+    for (std::size_t msg_idx = 0; msg_idx < kMessageNumber; ++msg_idx) {
+        publisher.Publish(channel_subid, std::make_shared<TestMessageType>(static_cast<int>(msg_idx)));
+    }
+
+    std::unique_lock cv_lck(cv_mtx);
+    cv.wait(cv_lck, [&complete]() { return complete; });
+}
+
 }  // namespace cris::core
@@ -0,0 +1,222 @@
+#include "cris/core/sched/parallel.h"
+
+#include "cris/core/sched/job_runner.h"
+#include "cris/core/utils/newcpp/algorithm.h"
+#include "cris/core/utils/newcpp/execution.h"
+#include "cris/core/utils/newcpp/numeric.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cris::core {
+
+static constexpr std::size_t kElementNum = 100000;
+
+static std::vector<std::uint64_t> MakeRandomValues(std::size_t size) {
+    std::mt19937_64            random_engine(42);
+    std::vector<std::uint64_t> values(size);
+    for (auto& value : values) {
+        value = random_engine() % 1000;
+    }
+    return values;
+}
+
+TEST(ParallelTest, ParallelFor) {
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 4});
+
+    for (const std::size_t grain : {std::size_t{0}, std::size_t{1}, std::size_t{7}, kElementNum}) {
+        std::vector<std::atomic<std::size_t>> visits(kElementNum);
+        ParallelFor(
+            *runner,
+            0,
+            kElementNum,
+            [&visits, grain](std::size_t begin, std::size_t end) {
+                EXPECT_LT(begin, end);
+                if (grain != 0) {
+                    EXPECT_LE(end - begin, grain);
+                }
+                for (auto idx = begin; idx < end; ++idx) {
+                    visits[idx].fetch_add(1);
+                }
+            },
+            grain);
+        for (const auto& visit : visits) {
+            ASSERT_EQ(visit.load(), 1);
+        }
+    }
+
+    bool called = false;
+    ParallelFor(*runner, 5, 5, [&called](std::size_t, std::size_t) { called = true; });
+    EXPECT_FALSE(called);
+
+    runner->Stop();
+    runner->Join();
+}
+
+TEST(ParallelTest, Algorithms) {
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 4});
+
+    const auto values = MakeRandomValues(kElementNum);
+
+    EXPECT_EQ(
+        ParallelReduce(runner, values.begin(), values.end(), std::uint64_t{1}, std::plus<>()),
+        std::reduce(values.begin(), values.end(), std::uint64_t{1}));
+
+    EXPECT_EQ(
+        ParallelTransformReduce(
+            runner,
+            values.begin(),
+            values.end(),
+            std::uint64_t{0},
+            std::plus<>(),
+            [](std::uint64_t value) { return value * value; }),
+        std::transform_reduce(
+            values.begin(),
+            values.end(),
+            std::uint64_t{0},
+            std::plus<>(),
+            [](std::uint64_t value) { return value * value; }));
+
+    std::vector<std::uint64_t> doubled(kElementNum);
+    const auto                 doubled_end = ParallelTransform(
+        runner,
+        values.begin(),
+        values.end(),
+        doubled.begin(),
+        [](std::uint64_t value) { return value * 2; });
+    EXPECT_EQ(doubled_end, doubled.end());
+    for (std::size_t idx = 0; idx < kElementNum; ++idx) {
+        ASSERT_EQ(doubled[idx], values[idx] * 2);
+    }
+
+    auto sorted          = values;
+    auto expected_sorted = values;
+    ParallelSort(runner, sorted.begin(), sorted.end());
+    std::sort(expected_sorted.begin(), expected_sorted.end());
+    EXPECT_EQ(sorted, expected_sorted);
+
+    ParallelSort(runner, sorted.begin(), sorted.end(), std::greater<>());
+    EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end(), std::greater<>()));
+
+    runner->Stop();
+    runner->Join();
+}
+
+// Callers running on the only worker of the runner help with the forked jobs, instead of waiting for themselves.
+TEST(ParallelTest, CalledByWorker) {
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 1});
+
+    std::atomic<std::uint64_t> sum{0};
+    std::atomic<bool>          done{false};
+    runner->AddJob([&runner, &sum, &done] {
+        const auto values = MakeRandomValues(kElementNum);
+        sum.store(ParallelReduce(runner, values.begin(), values.end(), std::uint64_t{0}, std::plus<>()));
+        done.store(true);
+    });
+
+    constexpr auto kTimeout = std::chrono::seconds(10);
+    const auto     start    = std::chrono::steady_clock::now();
+    while (!done.load() && std::chrono::steady_clock::now() - start < kTimeout) {
+        std::this_thread::yield();
+    }
+    ASSERT_TRUE(done.load());
+
+    const auto values = MakeRandomValues(kElementNum);
+    EXPECT_EQ(sum.load(), std::reduce(values.begin(), values.end(), std::uint64_t{0}));
+
+    runner->Stop();
+    runner->Join();
+}
+
+TEST(ParallelTest, FallbackPolicies) {
+    namespace execution = cris::libs::execution;
+
+    const auto values = MakeRandomValues(kElementNum);
+
+    auto check = [&values] {
+        auto sorted = values;
+        std::sort(execution::fallback::par, sorted.begin(), sorted.end());
+        EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+
+        std::vector<std::pair<std::uint64_t, std::size_t>> indexed(kElementNum);
+        for (std::size_t idx = 0; idx < kElementNum; ++idx) {
+            indexed[idx] = {values[idx] % 10, idx};
+        }
+        std::stable_sort(
+            execution::fallback::par_unseq,
+            indexed.begin(),
+            indexed.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        EXPECT_TRUE(std::is_sorted(indexed.begin(), indexed.end()));
+
+        std::vector<std::uint64_t> doubled(kElementNum);
+        std::transform(
+            execution::fallback::par,
+            values.begin(),
+            values.end(),
+            doubled.begin(),
+            [](std::uint64_t value) { return value * 2; });
+        EXPECT_EQ(
+            std::reduce(execution::fallback::par, doubled.begin(), doubled.end()),
+            2 * std::reduce(values.begin(), values.end()));
+
+        std::atomic<std::uint64_t> sum{0};
+        std::for_each(execution::fallback::par, values.begin(), values.end(), [&sum](std::uint64_t value) {
+            sum.fetch_add(value);
+        });
+        EXPECT_EQ(sum.load(), std::reduce(values.begin(), values.end()));
+    };
+
+    // Sequentially without a backend.
+    ASSERT_EQ(execution::GetParallelBackend(), nullptr);
+    check();
+
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 4});
+    execution::SetParallelBackend(std::make_shared<JobRunnerParallelBackend>(runner));
+    check();
+    execution::SetParallelBackend(nullptr);
+
+    runner->Stop();
+    runner->Join();
+}
+
+TEST(ParallelTest, Policies) {
+    namespace execution = cris::libs::execution;
+
+#ifndef _CR_HAS_STD_PARALLEL_BACKEND
+    // The standard parallel policies would run sequentially.
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(cris::par)>, execution::fallback_parallel_policy>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(cris::par_unseq)>, execution::fallback_parallel_policy>);
+#endif
+
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 4});
+    execution::SetParallelBackend(std::make_shared<JobRunnerParallelBackend>(runner));
+
+    auto sorted = MakeRandomValues(kElementNum);
+    std::sort(cris::par, sorted.begin(), sorted.end());
+    EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+
+    const auto                 values = MakeRandomValues(kElementNum);
+    std::atomic<std::uint64_t> sum{0};
+    std::for_each(cris::par_unseq, values.begin(), values.end(), [&sum](std::uint64_t value) { sum.fetch_add(value); });
+    EXPECT_EQ(sum.load(), std::reduce(values.begin(), values.end()));
+
+    execution::SetParallelBackend(nullptr);
+    runner->Stop();
+    runner->Join();
+}
+
+}  // namespace cris::core
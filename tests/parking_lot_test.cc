@@ -0,0 +1,98 @@
+#include "cris/core/sched/parking_lot.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace cris::core {
+
+TEST(ParkingLotTest, CancelPark) {
+    ParkingLot parking_lot(2);
+    EXPECT_FALSE(parking_lot.UnparkOne());
+
+    parking_lot.PrepareToPark(1);
+    EXPECT_TRUE(parking_lot.IsParked(1));
+    EXPECT_EQ(parking_lot.ParkedNum(), 1);
+
+    parking_lot.CancelPark(1);
+    EXPECT_FALSE(parking_lot.IsParked(1));
+    EXPECT_EQ(parking_lot.ParkedNum(), 0);
+    EXPECT_FALSE(parking_lot.Unpark(1));
+    EXPECT_FALSE(parking_lot.UnparkOne());
+}
+
+// Unparked between `PrepareToPark` and `Park`, then `Park` returns immediately.
+TEST(ParkingLotTest, UnparkBeforePark) {
+    ParkingLot parking_lot(1);
+    parking_lot.PrepareToPark(0);
+    EXPECT_TRUE(parking_lot.Unpark(0));
+    EXPECT_FALSE(parking_lot.Unpark(0));
+    parking_lot.Park(0);
+    EXPECT_EQ(parking_lot.ParkedNum(), 0);
+}
+
+TEST(ParkingLotTest, UnparkOne) {
+    // More than one mask of slots.
+    constexpr std::size_t kSlotNum = 70;
+
+    ParkingLot               parking_lot(kSlotNum);
+    std::atomic<std::size_t> woken_num{0};
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < kSlotNum; ++i) {
+        parking_lot.PrepareToPark(i);
+        threads.emplace_back([&parking_lot, &woken_num, i]() {
+            parking_lot.Park(i);
+            ++woken_num;
+        });
+    }
+
+    for (std::size_t i = 0; i < kSlotNum; ++i) {
+        EXPECT_TRUE(parking_lot.UnparkOne());
+    }
+    EXPECT_FALSE(parking_lot.UnparkOne());
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(woken_num.load(), kSlotNum);
+    EXPECT_EQ(parking_lot.ParkedNum(), 0);
+}
+
+// A producer publishing an item races with a consumer about to park, the item is never missed.
+TEST(ParkingLotTest, NoLostWakeup) {
+    constexpr std::size_t kRounds = 10000;
+
+    ParkingLot               parking_lot(1);
+    std::atomic<std::size_t> published{0};
+    std::atomic<std::size_t> consumed{0};
+
+    std::thread consumer([&]() {
+        while (consumed.load() < kRounds) {
+            if (published.load() > consumed.load()) {
+                ++consumed;
+                continue;
+            }
+            parking_lot.PrepareToPark(0);
+            if (published.load() > consumed.load()) {
+                parking_lot.CancelPark(0);
+            } else {
+                parking_lot.Park(0);
+            }
+        }
+    });
+
+    for (std::size_t i = 0; i < kRounds; ++i) {
+        ++published;
+        parking_lot.UnparkOne();
+        while (consumed.load() <= i) {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    EXPECT_EQ(consumed.load(), kRounds);
+}
+
+}  // namespace cris::core
@@ -0,0 +1,146 @@
+#include "cris/core/sched/rcu.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace cris::core {
+
+TEST(RcuTest, Basic) {
+    RcuPtr<int> ptr(std::make_unique<const int>(1));
+    {
+        RcuReadGuard guard;
+        EXPECT_EQ(ptr.Read(), 1);
+        {
+            RcuReadGuard nested_guard;
+            EXPECT_EQ(ptr.Read(), 1);
+        }
+    }
+    ptr.Update(std::make_unique<const int>(2));
+    EXPECT_EQ(ptr.Get(), 2);
+
+    RcuReadGuard guard;
+    EXPECT_EQ(ptr.Read(), 2);
+}
+
+TEST(RcuTest, SynchronizeWaitsForReaders) {
+    std::atomic<bool> entered{false};
+    std::atomic<bool> exiting{false};
+    std::atomic<bool> synchronized{false};
+
+    std::thread reader([&entered, &exiting]() {
+        RcuReadGuard guard;
+        {
+            // Exiting a nested critical section does not end the outer one.
+            RcuReadGuard nested_guard;
+        }
+        entered.store(true);
+        while (!exiting.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!entered.load()) {
+        std::this_thread::yield();
+    }
+
+    std::thread writer([&synchronized]() {
+        RcuSynchronize();
+        synchronized.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(synchronized.load());
+
+    exiting.store(true);
+    writer.join();
+    EXPECT_TRUE(synchronized.load());
+    reader.join();
+}
+
+// Readers always see a consistent value, which is not freed while they are reading it.
+TEST(RcuTest, ConcurrentUpdates) {
+    constexpr std::size_t kReaderNum = 4;
+    constexpr std::size_t kUpdateNum = 1000;
+
+    struct Value {
+        explicit Value(std::size_t value) : value_(value), check_(~value) {}
+
+        ~Value() { check_ = value_; }
+
+        std::size_t value_;
+        std::size_t check_;
+    };
+
+    RcuPtr<Value>            ptr(std::make_unique<const Value>(0));
+    std::atomic<bool>        done{false};
+    std::atomic<std::size_t> inconsistent_num{0};
+    std::vector<std::thread> readers;
+    for (std::size_t i = 0; i < kReaderNum; ++i) {
+        readers.emplace_back([&ptr, &done, &inconsistent_num]() {
+            std::size_t last_value = 0;
+            while (!done.load()) {
+                RcuReadGuard guard;
+                const auto&  value = ptr.Read();
+                if (value.check_ != ~value.value_ || value.value_ < last_value) {
+                    inconsistent_num.fetch_add(1);
+                }
+                last_value = value.value_;
+            }
+        });
+    }
+
+    for (std::size_t i = 1; i <= kUpdateNum; ++i) {
+        ptr.Update(std::make_unique<const Value>(i));
+    }
+    done.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(inconsistent_num.load(), 0);
+    EXPECT_EQ(ptr.Get().value_, kUpdateNum);
+}
+
+TEST(RcuTest, UpdateDeferred) {
+    struct Value {
+        explicit Value(std::atomic<std::size_t>& freed_num) : freed_num_(freed_num) {}
+
+        ~Value() { freed_num_.fetch_add(1); }
+
+        std::atomic<std::size_t>& freed_num_;
+    };
+
+    std::atomic<std::size_t> freed_num{0};
+    std::atomic<bool>        entered{false};
+    std::atomic<bool>        exiting{false};
+    RcuPtr<Value>            ptr(std::make_unique<const Value>(freed_num));
+
+    std::thread reader([&entered, &exiting]() {
+        RcuReadGuard guard;
+        entered.store(true);
+        while (!exiting.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!entered.load()) {
+        std::this_thread::yield();
+    }
+
+    // Returns at once, while the old value is still being read.
+    ptr.UpdateDeferred(std::make_unique<const Value>(freed_num));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(freed_num.load(), 0);
+
+    exiting.store(true);
+    reader.join();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (freed_num.load() < 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(freed_num.load(), 1);
+}
+
+}  // namespace cris::core
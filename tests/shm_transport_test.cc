@@ -0,0 +1,250 @@
+#include "cris/core/msg_shm/transport.h"
+
+#include "cris/core/msg/node.h"
+#include "cris/core/msg_shm/ring.h"
+#include "cris/core/sched/job_runner.h"
+
+#include "gtest/gtest.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace cris::core {
+
+struct ShmTestPose : public CRMessage<ShmTestPose> {
+    struct Payload {
+        double x_;
+        double y_;
+        int    seq_;
+    };
+
+    Payload payload_{};
+};
+
+struct ShmTestText : public CRMessage<ShmTestText> {
+    std::string text_;
+};
+
+std::string MessageToStr(const ShmTestText& message) {
+    return message.text_;
+}
+
+void MessageFromStr(ShmTestText& message, const std::string& serialized_message) {
+    message.text_ = serialized_message;
+}
+
+static_assert(CRTrivialMessageType<ShmTestPose>);
+static_assert(!CRTrivialMessageType<ShmTestText> && CRSerializableMessageType<ShmTestText>);
+
+static std::string GetTestRingName(const std::string& name) {
+    return "cris_test." + std::to_string(getpid()) + "." + name;
+}
+
+// Forked first, before any test starts threads.
+TEST(ShmTransportTest, AcrossProcesses) {
+    constexpr CRNode::channel_subid_t kChannelSubId = 1;
+    constexpr int                     kMessageNum   = 1000;
+    constexpr auto                    kTimeout      = std::chrono::seconds(10);
+
+    const ShmTransport::Config config{.name_prefix_ = GetTestRingName("transport")};
+
+    int ready_pipe[2];
+    ASSERT_EQ(pipe(ready_pipe), 0);
+
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        // The subscribing process, exiting with the number of missing or unexpected messages.
+        auto         runner = JobRunner::MakeJobRunner({.thread_num_ = 1});
+        ShmTransport transport(config, runner);
+        CRNode       subscriber(runner);
+
+        std::atomic<int> pose_num{0};
+        std::atomic<int> text_num{0};
+        std::atomic<int> error_num{0};
+        subscriber.Subscribe<ShmTestPose>(
+            kChannelSubId,
+            [&](const std::shared_ptr<ShmTestPose>& pose) {
+                const auto seq = pose_num.fetch_add(1);
+                if (pose->payload_.seq_ != seq || pose->payload_.x_ != seq * 0.5) {
+                    error_num.fetch_add(1);
+                }
+            },
+            CRNode::SubscriptionOptions{.allow_concurrency_ = false});
+        subscriber.Subscribe<ShmTestText>(
+            kChannelSubId,
+            [&](const std::shared_ptr<ShmTestText>& text) {
+                if (text->text_ != "text " + std::to_string(text_num.fetch_add(1))) {
+                    error_num.fetch_add(1);
+                }
+            },
+            CRNode::SubscriptionOptions{.allow_concurrency_ = false});
+        const bool imported =
+            transport.Import<ShmTestPose>(kChannelSubId) && transport.Import<ShmTestText>(kChannelSubId);
+
+        const char                  ready   = imported ? 1 : 0;
+        [[maybe_unused]] const auto written = write(ready_pipe[1], &ready, 1);
+
+        const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+        while ((pose_num.load() < kMessageNum || text_num.load() < kMessageNum) &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        transport.StopMainLoop();
+        runner->Stop().Join();
+        const int missing_num = 2 * kMessageNum - pose_num.load() - text_num.load();
+        _exit(std::min(error_num.load() + missing_num + static_cast<int>(transport.GetLostMessageNum()), 255));
+    }
+
+    char ready = 0;
+    ASSERT_EQ(read(ready_pipe[0], &ready, 1), 1);
+    ASSERT_EQ(ready, 1);
+
+    auto         runner = JobRunner::MakeJobRunner({.thread_num_ = 1});
+    ShmTransport transport(config, runner);
+    CRNode       publisher;
+    ASSERT_TRUE(transport.Export<ShmTestPose>(kChannelSubId));
+    ASSERT_TRUE(transport.Export<ShmTestText>(kChannelSubId));
+    // Exported or imported only once.
+    EXPECT_FALSE(transport.Import<ShmTestPose>(kChannelSubId));
+
+    for (int i = 0; i < kMessageNum; ++i) {
+        auto pose           = std::make_shared<ShmTestPose>();
+        pose->payload_.seq_ = i;
+        pose->payload_.x_   = i * 0.5;
+        publisher.Publish(kChannelSubId, std::move(pose));
+
+        auto text   = std::make_shared<ShmTestText>();
+        text->text_ = "text " + std::to_string(i);
+        publisher.Publish(kChannelSubId, std::move(text));
+        // Not to overrun the ring.
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    runner->Stop().Join();
+    ShmRing::Unlink(transport.GetRingName<ShmTestPose>(kChannelSubId));
+    ShmRing::Unlink(transport.GetRingName<ShmTestText>(kChannelSubId));
+}
+
+TEST(ShmRingTest, WriteRead) {
+    const auto name   = GetTestRingName("ring");
+    auto       writer = ShmRing::Open(name, {.slot_num_ = 4, .slot_size_ = sizeof(int)});
+    auto       reader = ShmRing::Open(name, {.slot_num_ = 4, .slot_size_ = sizeof(int)});
+    ASSERT_NE(writer, nullptr);
+    ASSERT_NE(reader, nullptr);
+    // The config must match.
+    EXPECT_EQ(ShmRing::Open(name, {.slot_num_ = 8, .slot_size_ = sizeof(int)}), nullptr);
+
+    const auto write_value = [&writer](int value) {
+        return writer->Write(sizeof(value), [value](void* data) { std::memcpy(data, &value, sizeof(value)); });
+    };
+    int        value      = 0;
+    const auto read_value = [&value](const void* data, std::size_t size) { std::memcpy(&value, data, size); };
+
+    std::uint64_t position = reader->GetWritePosition();
+    EXPECT_EQ(reader->Read(position, read_value), ShmRing::ReadStatus::kNoMessage);
+    EXPECT_TRUE(write_value(1));
+    EXPECT_TRUE(write_value(2));
+    EXPECT_EQ(reader->Read(position, read_value), ShmRing::ReadStatus::kRead);
+    EXPECT_EQ(value, 1);
+    EXPECT_EQ(reader->Read(position, read_value), ShmRing::ReadStatus::kRead);
+    EXPECT_EQ(value, 2);
+    EXPECT_EQ(reader->Read(position, read_value), ShmRing::ReadStatus::kNoMessage);
+
+    // Too large.
+    EXPECT_FALSE(writer->Write(sizeof(int) + 1, [](void*) {}));
+
+    // Overrun by 2 messages.
+    for (int i = 3; i <= 8; ++i) {
+        EXPECT_TRUE(write_value(i));
+    }
+    EXPECT_EQ(reader->Read(position, read_value), ShmRing::ReadStatus::kOverwritten);
+    EXPECT_EQ(position, 4);
+    for (int i = 5; i <= 8; ++i) {
+        EXPECT_EQ(reader->Read(position, read_value), ShmRing::ReadStatus::kRead);
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_EQ(reader->Read(position, read_value), ShmRing::ReadStatus::kNoMessage);
+
+    EXPECT_TRUE(ShmRing::Unlink(name));
+}
+
+TEST(ShmRingTest, Lapped) {
+    const auto name = GetTestRingName("lapped");
+    auto       ring = ShmRing::Open(name, {.slot_num_ = 2, .slot_size_ = sizeof(int)});
+    ASSERT_NE(ring, nullptr);
+
+    const auto write_value = [&ring](int value) {
+        return ring->Write(sizeof(value), [value](void* data) { std::memcpy(data, &value, sizeof(value)); });
+    };
+    int        value      = 0;
+    const auto read_value = [&value](const void* data, std::size_t size) { std::memcpy(&value, data, size); };
+
+    std::uint64_t position = ring->GetWritePosition();
+    // Other writers go a whole ring ahead while the first one is writing. The one reaching its slot drops the message.
+    EXPECT_TRUE(ring->Write(sizeof(int), [&write_value](void* data) {
+        EXPECT_TRUE(write_value(2));
+        EXPECT_FALSE(write_value(3));
+        const int first_value = 1;
+        std::memcpy(data, &first_value, sizeof(first_value));
+    }));
+    for (int expected_value : {1, 2}) {
+        EXPECT_EQ(ring->Read(position, read_value), ShmRing::ReadStatus::kRead);
+        EXPECT_EQ(value, expected_value);
+    }
+    // Readers wait at the dropped message until its slot is overwritten.
+    EXPECT_EQ(ring->Read(position, read_value), ShmRing::ReadStatus::kWriting);
+    EXPECT_TRUE(write_value(4));
+    EXPECT_TRUE(write_value(5));
+    EXPECT_EQ(ring->Read(position, read_value), ShmRing::ReadStatus::kOverwritten);
+    for (int expected_value : {4, 5}) {
+        EXPECT_EQ(ring->Read(position, read_value), ShmRing::ReadStatus::kRead);
+        EXPECT_EQ(value, expected_value);
+    }
+
+    EXPECT_TRUE(ShmRing::Unlink(name));
+}
+
+TEST(ShmRingTest, Wait) {
+    const auto name = GetTestRingName("wait");
+    auto       ring = ShmRing::Open(name, {.slot_num_ = 4, .slot_size_ = 8});
+    ASSERT_NE(ring, nullptr);
+
+    // Times out without messages.
+    const auto start = std::chrono::steady_clock::now();
+    ring->Wait(ring->GetNotifySeq(), std::chrono::milliseconds(10));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+
+    std::atomic<bool> woken{false};
+    const auto        notify_seq = ring->GetNotifySeq();
+    std::thread       waiter([&]() {
+        ring->Wait(notify_seq, std::chrono::seconds(10));
+        woken.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ring->Write(0, [](void*) {});
+    waiter.join();
+    EXPECT_TRUE(woken.load());
+
+    // Not missed if written before waiting.
+    ring->Wait(notify_seq, std::chrono::seconds(10));
+
+    EXPECT_TRUE(ShmRing::Unlink(name));
+}
+
+}  // namespace cris::core
@@ -0,0 +1,188 @@
+#include "cris/core/msg_bridge/socket_bridge.h"
+
+#include "cris/core/msg/node.h"
+#include "cris/core/sched/job_runner.h"
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace cris::core {
+
+struct BridgeTestText : public CRMessage<BridgeTestText> {
+    std::string text_;
+};
+
+std::string MessageToStr(const BridgeTestText& message) {
+    return message.text_;
+}
+
+void MessageFromStr(BridgeTestText& message, const std::string& serialized_message) {
+    message.text_ = serialized_message;
+}
+
+class SocketBridgeTest : public testing::TestWithParam<std::string> {
+   protected:
+    static constexpr CRNode::channel_subid_t kExportSubId = 1;
+    static constexpr CRNode::channel_subid_t kImportSubId = 2;
+    static constexpr int                     kMessageNum  = 1000;
+
+    static std::string GetListenAddress() {
+        if (GetParam() == "unix") {
+            return "unix:///tmp/cris_test." + std::to_string(getpid()) + ".sock";
+        }
+        return "tcp://127.0.0.1:0";
+    }
+
+    // Both bridges are in this process, sending to each other, and the messages come back on another sub ID.
+    void RunLoopback(SocketBridge::Config config) {
+        auto         runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+        SocketBridge server(config, runner);
+        SocketBridge client(config, runner);
+        CRNode       node(runner);
+
+        std::atomic<int> received_num{0};
+        std::atomic<int> error_num{0};
+        node.Subscribe<BridgeTestText>(
+            kImportSubId,
+            [&](const std::shared_ptr<BridgeTestText>& text) {
+                if (text->text_ != "text " + std::to_string(received_num.fetch_add(1))) {
+                    error_num.fetch_add(1);
+                }
+            },
+            CRNode::SubscriptionOptions{.allow_concurrency_ = false});
+
+        server.Export<BridgeTestText>(kExportSubId);
+        client.Import<BridgeTestText>(kExportSubId, kImportSubId);
+
+        const auto address = GetListenAddress();
+        if (address.starts_with("unix://")) {
+            unlink(address.substr(7).c_str());
+        }
+        ASSERT_TRUE(server.Listen(address));
+        ASSERT_TRUE(client.Connect(server.GetListenAddress()));
+
+        // Pending until connected.
+        for (int i = 0; i < kMessageNum; ++i) {
+            auto text   = std::make_shared<BridgeTestText>();
+            text->text_ = "text " + std::to_string(i);
+            node.Publish(kExportSubId, std::move(text));
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (received_num.load() < kMessageNum && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(received_num.load(), kMessageNum);
+        EXPECT_EQ(error_num.load(), 0);
+
+        const auto server_stats = server.GetStats();
+        EXPECT_EQ(server_stats.sent_message_num_, kMessageNum);
+        EXPECT_EQ(server_stats.dropped_message_num_, 0);
+        EXPECT_GE(server_stats.sent_frame_num_, 1);
+        EXPECT_LE(server_stats.sent_frame_num_, kMessageNum);
+        EXPECT_EQ(client.GetStats().received_message_num_, kMessageNum);
+        EXPECT_GT(CRMessageBase::GetChannelStats<BridgeTestText>(kExportSubId).serialized_bytes_, 0);
+
+        server.StopMainLoop();
+        client.StopMainLoop();
+        EXPECT_FALSE(server.IsConnected());
+        runner->Stop().Join();
+        if (address.starts_with("unix://")) {
+            unlink(address.substr(7).c_str());
+        }
+    }
+};
+
+TEST_P(SocketBridgeTest, Batched) {
+    RunLoopback({});
+}
+
+TEST_P(SocketBridgeTest, Unbatched) {
+    RunLoopback({.max_batch_bytes_ = 0, .max_batch_delay_ = std::chrono::nanoseconds(0)});
+}
+
+INSTANTIATE_TEST_SUITE_P(Sockets, SocketBridgeTest, testing::Values("tcp", "unix"));
+
+TEST(SocketBridgeDropTest, PendingLimit) {
+    constexpr CRNode::channel_subid_t kChannelSubId = 1;
+
+    auto         runner = JobRunner::MakeJobRunner({.thread_num_ = 1});
+    SocketBridge bridge({.max_pending_bytes_ = 64}, runner);
+    CRNode       node(runner);
+    bridge.Export<BridgeTestText>(kChannelSubId);
+
+    // Never connected, so that only the first fits.
+    for (int i = 0; i < 2; ++i) {
+        auto text   = std::make_shared<BridgeTestText>();
+        text->text_ = std::string(32, 'x');
+        node.Publish(kChannelSubId, std::move(text));
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (bridge.GetStats().dropped_message_num_ < 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(bridge.GetStats().dropped_message_num_, 1);
+    EXPECT_EQ(bridge.GetStats().sent_message_num_, 0);
+
+    bridge.StopMainLoop();
+    runner->Stop().Join();
+}
+
+TEST(SocketBridgeReconnectTest, Reconnect) {
+    constexpr CRNode::channel_subid_t kExportSubId = 3;
+    constexpr CRNode::channel_subid_t kImportSubId = 4;
+    constexpr std::size_t             kFrameLimit  = 1024;
+
+    const auto wait_until = [](const auto& done) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return done();
+    };
+    const auto publish = [](CRNode& node, std::string&& text) {
+        auto message   = std::make_shared<BridgeTestText>();
+        message->text_ = std::move(text);
+        node.Publish(kExportSubId, std::move(message));
+    };
+
+    auto             runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+    SocketBridge     server({.max_pending_bytes_ = kFrameLimit}, runner);
+    SocketBridge     client({}, runner);
+    CRNode           node(runner);
+    std::atomic<int> received_num{0};
+    node.Subscribe<BridgeTestText>(kImportSubId, [&received_num](const auto&) { received_num.fetch_add(1); });
+    server.Import<BridgeTestText>(kExportSubId, kImportSubId);
+    client.Export<BridgeTestText>(kExportSubId);
+    ASSERT_TRUE(server.Listen("tcp://127.0.0.1:0"));
+
+    // Frames beyond the limit close the connection, and none of the messages are received.
+    ASSERT_TRUE(client.Connect(server.GetListenAddress()));
+    ASSERT_TRUE(wait_until([&server] { return server.IsConnected(); }));
+    publish(node, std::string(kFrameLimit, 'x'));
+    EXPECT_TRUE(wait_until([&server, &client] { return !server.IsConnected() && !client.IsConnected(); }));
+    EXPECT_EQ(server.GetStats().received_message_num_, 0);
+
+    // Connected again, and accepted again.
+    ASSERT_TRUE(client.Connect(server.GetListenAddress()));
+    ASSERT_TRUE(wait_until([&server] { return server.IsConnected(); }));
+    publish(node, "text");
+    EXPECT_TRUE(wait_until([&received_num] { return received_num.load() == 1; }));
+    EXPECT_EQ(server.GetStats().received_message_num_, 1);
+
+    client.StopMainLoop();
+    server.StopMainLoop();
+    runner->Stop().Join();
+}
+
+}  // namespace cris::core
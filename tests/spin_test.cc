@@ -0,0 +1,77 @@
+#include "cris/core/sched/adaptive_spin.h"
+#include "cris/core/sched/spin_impl.h"
+#include "cris/core/sched/spin_mutex.h"
+#include "cris/core/utils/time.h"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cris::core {
+
+TEST(SpinTest, SpinForNsec) {
+    static constexpr cr_duration_nsec_t kSpinNsec = 100000;
+
+    const auto start = GetSystemTimestampNsec();
+    impl::SpinForNsec(kSpinNsec);
+    EXPECT_GE(GetSystemTimestampNsec() - start, kSpinNsec);
+
+    // Returns soon for non-positive durations.
+    impl::SpinForNsec(0);
+    impl::SpinForNsec(-1);
+}
+
+TEST(SpinTest, AdaptiveSpinPolicy) {
+    static constexpr cr_duration_nsec_t kMaxSpinNsec = 1000000;
+
+    AdaptiveSpinPolicy policy(kMaxSpinNsec);
+    EXPECT_EQ(policy.SpinLimitNsec(), kMaxSpinNsec);
+
+    // Jobs keep arriving soon, spinning a bit longer than that is enough.
+    for (std::size_t i = 0; i < 100; ++i) {
+        policy.OnIdleEnd(kMaxSpinNsec / 10);
+    }
+    EXPECT_GE(policy.SpinLimitNsec(), kMaxSpinNsec / 10);
+    EXPECT_LT(policy.SpinLimitNsec(), kMaxSpinNsec / 2);
+
+    // Jobs keep arriving after the limit, spinning is a waste.
+    for (std::size_t i = 0; i < 100; ++i) {
+        policy.OnIdleEnd(10 * kMaxSpinNsec);
+    }
+    EXPECT_LT(policy.SpinLimitNsec(), kMaxSpinNsec / 10);
+
+    // Never spins if not allowed to.
+    AdaptiveSpinPolicy no_spin_policy(0);
+    no_spin_policy.OnIdleEnd(kMaxSpinNsec);
+    EXPECT_EQ(no_spin_policy.SpinLimitNsec(), 0);
+}
+
+TEST(SpinTest, HybridSpinMutex) {
+    static constexpr std::size_t kThreadNum    = 4;
+    static constexpr std::size_t kIncrementNum = 10000;
+
+    HybridSpinMutex          mutex;
+    std::size_t              counter = 0;
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < kThreadNum; ++i) {
+        threads.emplace_back([&mutex, &counter]() {
+            for (std::size_t j = 0; j < kIncrementNum; ++j) {
+                std::lock_guard lock(mutex);
+                ++counter;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counter, kThreadNum * kIncrementNum);
+
+    EXPECT_TRUE(mutex.try_lock());
+    EXPECT_FALSE(mutex.try_lock());
+    mutex.unlock();
+}
+
+}  // namespace cris::core
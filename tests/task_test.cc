@@ -0,0 +1,198 @@
+#include "cris/core/sched/task.h"
+
+#include "cris/core/sched/job_runner.h"
+#include "cris/core/utils/time.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace cris::core {
+
+static constexpr std::size_t kStrandTaskNum  = 100;
+static constexpr std::size_t kStrandRoundNum = 10;
+
+static void WaitUntil(const std::atomic<bool>& flag) {
+    constexpr auto kTimeout = std::chrono::seconds(10);
+    const auto     start    = std::chrono::steady_clock::now();
+    while (!flag.load() && std::chrono::steady_clock::now() - start < kTimeout) {
+        std::this_thread::yield();
+    }
+    ASSERT_TRUE(flag.load());
+}
+
+static Task<int> Add(int lhs, int rhs) {
+    co_return lhs + rhs;
+}
+
+static Task<int> AddTwice(int value) {
+    const int once = co_await Add(value, value);
+    co_return co_await Add(once, once);
+}
+
+static Task<void> StoreAddTwice(int value, int* result) {
+    *result = co_await AddTwice(value);
+}
+
+static Task<void> SetFlag(bool* flag) {
+    *flag = true;
+    co_return;
+}
+
+static Task<int> Throw() {
+    throw std::runtime_error("failed");
+    co_return 0;
+}
+
+static Task<void> CatchThrow(bool* caught) {
+    try {
+        co_await Throw();
+    } catch (const std::runtime_error&) {
+        *caught = true;
+    }
+}
+
+static Task<void> RecordWorkerThread(std::shared_ptr<JobRunner> runner,
+    std::thread::id*                                            thread_id,
+    std::atomic<bool>*                                          done) {
+    co_await runner->Schedule();
+    *thread_id = std::this_thread::get_id();
+    done->store(true);
+}
+
+static Task<void> RecordResumeTime(std::shared_ptr<JobRunner> runner,
+    std::chrono::nanoseconds                                  delay,
+    cr_timestamp_nsec_t*                                      resume_nsec,
+    std::atomic<bool>*                                        done) {
+    co_await runner->ScheduleAfter(delay);
+    *resume_nsec = GetSystemTimestampNsec();
+    done->store(true);
+}
+
+static Task<void> IncreaseInStrand(std::shared_ptr<JobRunner> runner,
+    JobRunnerStrandPtr                                        strand,
+    std::size_t*                                              counter,
+    std::atomic<std::size_t>*                                 finished,
+    std::atomic<bool>*                                        done) {
+    for (std::size_t round = 0; round < kStrandRoundNum; ++round) {
+        co_await strand;
+        ++*counter;
+        // Leave the strand, so that others get their turns.
+        co_await runner->Schedule();
+    }
+    if (finished->fetch_add(1) + 1 == kStrandTaskNum) {
+        done->store(true);
+    }
+}
+
+static Task<void> CheckInStrand(JobRunnerStrandPtr strand, const std::size_t* counter, std::atomic<bool>* done) {
+    co_await strand;
+    EXPECT_EQ(*counter, kStrandTaskNum * kStrandRoundNum);
+    done->store(true);
+}
+
+TEST(TaskTest, Nested) {
+    int result = 0;
+    StoreAddTwice(3, &result).Detach();
+    EXPECT_EQ(result, 12);
+}
+
+TEST(TaskTest, Lazy) {
+    bool started = false;
+    {
+        auto task = SetFlag(&started);
+        EXPECT_TRUE(task);
+        EXPECT_FALSE(task.Done());
+    }
+    // Destroyed before being started.
+    EXPECT_FALSE(started);
+}
+
+TEST(TaskTest, Exception) {
+    bool caught = false;
+    CatchThrow(&caught).Detach();
+    EXPECT_TRUE(caught);
+}
+
+TEST(TaskTest, Schedule) {
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+
+    std::thread::id   thread_id;
+    std::atomic<bool> done{false};
+    RecordWorkerThread(runner, &thread_id, &done).Detach();
+    WaitUntil(done);
+    EXPECT_NE(thread_id, std::this_thread::get_id());
+    runner->Stop().Join();
+}
+
+TEST(TaskTest, ScheduleFullRunner) {
+    auto runner = JobRunner::MakeJobRunner({
+        .thread_num_      = 1,
+        .max_queue_depth_ = 1,
+        .overflow_policy_ = JobRunner::OverflowPolicy::kDropNewest,
+    });
+
+    // Hold the only worker, and fill its queue.
+    std::atomic<bool> blocked{true};
+    std::atomic<bool> started{false};
+    EXPECT_TRUE(runner->AddJob([&blocked, &started]() {
+        started.store(true);
+        while (blocked.load()) {
+            std::this_thread::yield();
+        }
+    }));
+    WaitUntil(started);
+    EXPECT_TRUE(runner->AddJob([]() {}));
+    EXPECT_FALSE(runner->AddJob([]() {}));
+
+    // Resumptions are not dropped, i.e. the coroutine still continues in the worker.
+    std::thread::id   thread_id;
+    std::atomic<bool> done{false};
+    RecordWorkerThread(runner, &thread_id, &done).Detach();
+    EXPECT_FALSE(done.load());
+    blocked.store(false);
+    WaitUntil(done);
+    EXPECT_NE(thread_id, std::this_thread::get_id());
+    runner->Stop().Join();
+}
+
+TEST(TaskTest, ScheduleAfter) {
+    static constexpr auto kDelay = std::chrono::milliseconds(10);
+
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 2});
+
+    const auto          start_nsec  = GetSystemTimestampNsec();
+    cr_timestamp_nsec_t resume_nsec = 0;
+    std::atomic<bool>   done{false};
+    RecordResumeTime(runner, kDelay, &resume_nsec, &done).Detach();
+    EXPECT_FALSE(done.load());
+    WaitUntil(done);
+    EXPECT_GE(resume_nsec - start_nsec, std::chrono::nanoseconds(kDelay).count());
+    runner->Stop().Join();
+}
+
+TEST(TaskTest, Strand) {
+    auto runner = JobRunner::MakeJobRunner({.thread_num_ = 4});
+    auto strand = runner->MakeStrand();
+
+    // Not atomic on purpose, it is only accessed in the strand.
+    std::size_t              counter = 0;
+    std::atomic<std::size_t> finished{0};
+    std::atomic<bool>        done{false};
+    for (std::size_t i = 0; i < kStrandTaskNum; ++i) {
+        IncreaseInStrand(runner, strand, &counter, &finished, &done).Detach();
+    }
+    WaitUntil(done);
+
+    std::atomic<bool> checked{false};
+    CheckInStrand(strand, &counter, &checked).Detach();
+    WaitUntil(checked);
+    runner->Stop().Join();
+}
+
+}  // namespace cris::core
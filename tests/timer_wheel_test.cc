@@ -0,0 +1,100 @@
+#include "cris/core/sched/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace cris::core {
+
+TEST(TimerWheelTest, Basic) {
+    static constexpr cr_timestamp_nsec_t kStart = 1000;
+    static constexpr cr_duration_nsec_t  kTick  = 10;
+
+    TimerWheel<int> wheel(kStart, kTick);
+    EXPECT_TRUE(wheel.Empty());
+    EXPECT_FALSE(wheel.NextCheckNsec());
+
+    wheel.Add(kStart + 25, 1);
+    wheel.Add(kStart + 10, 2);
+    wheel.Add(kStart, 3);
+    EXPECT_EQ(wheel.Size(), 3);
+    EXPECT_EQ(wheel.NextCheckNsec(), kStart);
+
+    std::vector<int> expired;
+    auto             on_expired = [&expired](int&& value) { expired.push_back(value); };
+
+    wheel.Advance(kStart + 9, on_expired);
+    EXPECT_EQ(expired, (std::vector<int>{3}));
+    EXPECT_EQ(wheel.NextCheckNsec(), kStart + 10);
+
+    wheel.Advance(kStart + 29, on_expired);
+    EXPECT_EQ(expired, (std::vector<int>{3, 2}));
+
+    // Rounded up to the next tick.
+    wheel.Advance(kStart + 30, on_expired);
+    EXPECT_EQ(expired, (std::vector<int>{3, 2, 1}));
+    EXPECT_TRUE(wheel.Empty());
+
+    // Already expired.
+    wheel.Add(0, 4);
+    wheel.Advance(kStart + 40, on_expired);
+    EXPECT_EQ(expired, (std::vector<int>{3, 2, 1, 4}));
+}
+
+TEST(TimerWheelTest, NeverEarly) {
+    static constexpr std::size_t        kValueNum = 100000;
+    static constexpr cr_duration_nsec_t kTick     = 7;
+    // Covering all the levels, and beyond.
+    static constexpr cr_duration_nsec_t kMaxDelay = kTick << 34;
+
+    std::default_random_engine                        random_engine(42);
+    std::uniform_int_distribution<cr_duration_nsec_t> delay_dist(0, kMaxDelay);
+    std::uniform_int_distribution<cr_duration_nsec_t> step_dist(0, kTick * 2);
+    std::vector<cr_timestamp_nsec_t>                  expiries(kValueNum);
+    TimerWheel<std::size_t>                           wheel(0, kTick);
+
+    for (std::size_t idx = 0; idx < kValueNum; ++idx) {
+        expiries[idx] = delay_dist(random_engine);
+        wheel.Add(expiries[idx], std::size_t{idx});
+    }
+
+    std::size_t         expired_num = 0;
+    cr_timestamp_nsec_t now         = 0;
+    cr_timestamp_nsec_t last_expiry = 0;
+    while (!wheel.Empty()) {
+        const auto next_check = wheel.NextCheckNsec();
+        ASSERT_TRUE(next_check);
+        ASSERT_GT(*next_check + kTick, now);
+        now = std::max(now, *next_check) + step_dist(random_engine);
+        wheel.Advance(now, [&](std::size_t&& idx) {
+            ++expired_num;
+            EXPECT_LE(expiries[idx], now);
+            // Late by up to a tick, plus the step.
+            EXPECT_GE(expiries[idx] + kTick * 3, now);
+            // From the earliest.
+            EXPECT_GE(expiries[idx] + kTick, last_expiry);
+            last_expiry = std::max(last_expiry, expiries[idx]);
+        });
+    }
+    EXPECT_EQ(expired_num, kValueNum);
+}
+
+TEST(TimerWheelTest, AddWhenExpiring) {
+    TimerWheel<int> wheel(0, 1);
+    wheel.Add(5, 0);
+
+    std::vector<int> expired;
+    wheel.Advance(1000, [&](int&& value) {
+        expired.push_back(value);
+        if (value < 3) {
+            wheel.Add(300 * (value + 1), value + 1);
+        }
+    });
+    EXPECT_EQ(expired, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_TRUE(wheel.Empty());
+}
+
+}  // namespace cris::core